@@ -313,6 +313,13 @@ LIBVLC_API int libvlc_event_attach( libvlc_event_manager_t *p_event_manager,
 /**
  * Unregister an event notification.
  *
+ * When this function returns, the callback is not running and will not be
+ * called anymore, so that its data can be freed, with two exceptions:
+ * - if this function is called from the callback, that invocation is still
+ *   in progress;
+ * - another thread may still be running the callback, if the callback is
+ *   itself unregistering a notification of the same event manager.
+ *
  * \param p_event_manager the event manager
  * \param i_event_type the desired event to which we want to unregister
  * \param f_callback the function to call when i_event_type occurs
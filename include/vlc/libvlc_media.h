@@ -149,6 +149,36 @@ typedef struct libvlc_media_stats_t
     int         i_sent_bytes;
     float       f_send_bitrate;
 } libvlc_media_stats_t;
+
+/** Number of buckets of a libvlc_histogram_t */
+#define LIBVLC_HISTOGRAM_BUCKETS 24
+
+/**
+ * Histogram with power of two buckets: bucket 0 counts the samples below 1,
+ * bucket n the samples in [2^(n-1), 2^n) and the last bucket all the others.
+ */
+typedef struct libvlc_histogram_t
+{
+    uint64_t    i_count;    /**< number of samples */
+    int64_t     i_total;    /**< sum of the samples */
+    int64_t     i_max;      /**< largest sample */
+    uint64_t    pi_buckets[LIBVLC_HISTOGRAM_BUCKETS];
+} libvlc_histogram_t;
+
+/**
+ * Latency and queueing statistics of one elementary stream.
+ * Durations are in microseconds.
+ */
+typedef struct libvlc_media_es_stats_t
+{
+    int                 i_id;           /**< ES id, as in the track ids */
+    libvlc_track_type_t i_type;
+
+    libvlc_histogram_t  decode_time;    /**< time spent decoding a block */
+    libvlc_histogram_t  fifo_depth;     /**< blocks waiting for the decoder */
+    libvlc_histogram_t  picture_age;    /**< video: time from decoding to display */
+    libvlc_histogram_t  audio_drift;    /**< audio: drift of each correction */
+} libvlc_media_es_stats_t;
 /** @}*/
 
 typedef struct libvlc_media_track_info_t
@@ -246,6 +276,11 @@ typedef enum libvlc_media_parse_flag_t
      * Fetch meta and covert art using network resources
      */
     libvlc_media_fetch_network  = 0x04,
+    /**
+     * Process this media before media queued earlier (e.g. because it is
+     * currently visible in a list view)
+     */
+    libvlc_media_parse_priority = 0x08,
 } libvlc_media_parse_flag_t;
 
 /**
@@ -472,6 +507,34 @@ LIBVLC_API libvlc_state_t libvlc_media_get_state(
 LIBVLC_API int libvlc_media_get_stats( libvlc_media_t *p_md,
                                            libvlc_media_stats_t *p_stats );
 
+/**
+ * Get the latency and queueing statistics of the elementary streams
+ * decoded so far.
+ *
+ * Statistics are only collected when the "stats" option is enabled.
+ *
+ * \version LibVLC 3.0.0 and later.
+ *
+ * \param p_md media descriptor object
+ * \param pp_stats address to store an allocated array of statistics
+ *        (must be freed with libvlc_media_es_stats_release) [OUT]
+ *
+ * \return the number of elementary streams (zero on error)
+ */
+LIBVLC_API
+unsigned libvlc_media_es_stats_get( libvlc_media_t *p_md,
+                                    libvlc_media_es_stats_t **pp_stats );
+
+/**
+ * Release the array returned by libvlc_media_es_stats_get()
+ *
+ * \version LibVLC 3.0.0 and later.
+ *
+ * \param p_stats array of statistics
+ */
+LIBVLC_API
+void libvlc_media_es_stats_release( libvlc_media_es_stats_t *p_stats );
+
 /* The following method uses libvlc_media_list_t, however, media_list usage is optionnal
  * and this is here for convenience */
 #define VLC_FORWARD_DECLARE_OBJECT(a) struct a
@@ -582,6 +645,36 @@ libvlc_media_parse_with_options( libvlc_media_t *p_md,
 LIBVLC_API int
    libvlc_media_is_parsed( libvlc_media_t *p_md );
 
+/**
+ * Extract a thumbnail from a media, without playing it.
+ *
+ * The media is demuxed and decoded in the calling thread, without audio or
+ * video output, and the video is seeked to the keyframe preceding the
+ * requested time. This function is blocking; several thumbnails can be
+ * extracted concurrently from different threads with the same instance.
+ *
+ * \version LibVLC 3.0.0 and later.
+ *
+ * \param p_md media descriptor object
+ * \param i_time time of the thumbnail (in ms), or -1 to use f_pos
+ * \param f_pos position of the thumbnail (between 0.0 and 1.0), used only
+ *        if i_time is negative
+ * \param i_width thumbnail width, or 0 to deduce it from i_height
+ * \param i_height thumbnail height, or 0 to deduce it from i_width
+ *        (if both are 0, the original video size is used)
+ * \param psz_format image format ("png", "jpg", ...), or NULL for PNG
+ * \param i_timeout maximum duration (in ms), or 0 for no limit
+ * \param pp_data address to store the encoded image (must be freed with
+ *        libvlc_free() by the caller) [OUT]
+ * \param pi_size address to store the size of the encoded image [OUT]
+ * \return 0 on success, -1 on error
+ */
+LIBVLC_API int
+   libvlc_media_thumbnail( libvlc_media_t *p_md, libvlc_time_t i_time,
+                           float f_pos, unsigned i_width, unsigned i_height,
+                           const char *psz_format, libvlc_time_t i_timeout,
+                           unsigned char **pp_data, size_t *pi_size );
+
 /**
  * Sets media descriptor's user_data. user_data is specialized data
  * accessed by the host application, VLC.framework uses it as a pointer to
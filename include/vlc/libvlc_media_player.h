@@ -357,6 +357,75 @@ void libvlc_video_set_callbacks( libvlc_media_player_t *mp,
                                  libvlc_video_display_cb display,
                                  void *opaque );
 
+/**
+ * Opaque handle to a decoded video frame held by the application.
+ * \see libvlc_video_set_buffer_callbacks()
+ */
+typedef struct libvlc_video_frame_t libvlc_video_frame_t;
+
+/**
+ * Callback prototype to hand a decoded picture over to the application.
+ *
+ * When the video frame needs to be shown, as determined by the media playback
+ * clock, the frame callback is invoked. The picture buffer is owned by the
+ * application until it calls libvlc_video_frame_release(), which can be done
+ * at any time later and from any thread. Meanwhile, LibVLC keeps decoding
+ * into the other buffers.
+ *
+ * \note The same picture buffer may be handed over more than once (e.g. when
+ * the last frame is redisplayed while paused). Each invocation must be
+ * matched by exactly one libvlc_video_frame_release() call.
+ *
+ * \param opaque private pointer as passed to
+ *               libvlc_video_set_buffer_callbacks() [IN]
+ * \param picture private pointer returned from the @ref libvlc_video_lock_cb
+ *                callback for this buffer [IN]
+ * \param frame handle to release the buffer [IN]
+ */
+typedef void (*libvlc_video_frame_cb)(void *opaque, void *picture,
+                                      libvlc_video_frame_t *frame);
+
+/**
+ * Set callbacks and private data to render decoded video directly into
+ * a ring of application-provided buffers, without copies.
+ *
+ * The number of buffers and their layout are defined by the
+ * @ref libvlc_video_format_cb callback of
+ * libvlc_video_set_format_callbacks(), which is required. The lock callback
+ * is then invoked exactly once per buffer, when the video output starts,
+ * to obtain its pixel planes. Decoders render into those buffers in place,
+ * and displayed frames are handed over with the frame callback.
+ *
+ * The cleanup callback is invoked only after the video output has stopped
+ * \b and all frames have been released, so the buffers must remain valid
+ * until then.
+ *
+ * \note If too few buffers are provided for the decoder to render into them
+ * directly (about 20 for common codecs), LibVLC decodes into internal
+ * buffers and copies the pictures into the application buffers instead.
+ *
+ * \param mp the media player
+ * \param lock callback to provide the planes of each buffer (cannot be NULL)
+ * \param frame callback to receive displayed frames (cannot be NULL)
+ * \param opaque private pointer for the callbacks (as first parameter)
+ * \version LibVLC 3.0.0 or later
+ */
+LIBVLC_API
+void libvlc_video_set_buffer_callbacks( libvlc_media_player_t *mp,
+                                        libvlc_video_lock_cb lock,
+                                        libvlc_video_frame_cb frame,
+                                        void *opaque );
+
+/**
+ * Release a frame received from a @ref libvlc_video_frame_cb callback,
+ * so that its buffer can be decoded into again.
+ *
+ * \param frame frame handle
+ * \version LibVLC 3.0.0 or later
+ */
+LIBVLC_API
+void libvlc_video_frame_release( libvlc_video_frame_t *frame );
+
 /**
  * Set decoded video chroma and dimensions.
  * This only works in combination with libvlc_video_set_callbacks(),
@@ -783,6 +852,31 @@ LIBVLC_API float libvlc_media_player_get_rate( libvlc_media_player_t *p_mi );
  */
 LIBVLC_API int libvlc_media_player_set_rate( libvlc_media_player_t *p_mi, float rate );
 
+/**
+ * Enable or disable scrubbing mode, for instance while the user drags
+ * a timeline slider.
+ *
+ * In scrubbing mode, a seek cancels any pending seek, seeks land on the
+ * nearest key frame, and video is decoded at reduced quality, key frames
+ * only. Only the first picture after each seek is displayed, so that only
+ * the last requested position is rendered whatever the GOP length.
+ *
+ * \param p_mi the Media Player
+ * \param scrub true to enable scrubbing, false to resume normal playback
+ * \version LibVLC 3.0.0 or later
+ */
+LIBVLC_API void libvlc_media_player_set_scrub( libvlc_media_player_t *p_mi,
+                                               int scrub );
+
+/**
+ * Get whether scrubbing mode is enabled.
+ *
+ * \param p_mi the Media Player
+ * \return true if scrubbing is enabled, false otherwise
+ * \version LibVLC 3.0.0 or later
+ */
+LIBVLC_API int libvlc_media_player_get_scrub( libvlc_media_player_t *p_mi );
+
 /**
  * Get current movie state
  *
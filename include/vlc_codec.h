@@ -69,6 +69,12 @@ struct decoder_t
     /* Tell the decoder if it is allowed to drop frames */
     bool                b_pace_control;
 
+    /* Hints from the owner, that the decoder may ignore: only the key
+     * frames are needed, at reduced quality (e.g. scrubbing, thumbnails) */
+    bool                b_key_frames_only;
+    /* The pictures are read from system memory: no hardware decoding */
+    bool                b_software_only;
+
     /* */
     picture_t *         ( * pf_decode_video )( decoder_t *, block_t ** );
     block_t *           ( * pf_decode_audio )( decoder_t *, block_t ** );
@@ -499,6 +499,9 @@ VLC_API void input_Stop( input_thread_t * );
 VLC_API int input_Read( vlc_object_t *, input_item_t * );
 #define input_Read(a,b) input_Read(VLC_OBJECT(a),b)
 
+VLC_API block_t * input_Thumbnail( vlc_object_t *, input_item_t *, mtime_t i_time, double f_pos, vlc_fourcc_t i_format, int i_width, int i_height, mtime_t i_timeout ) VLC_USED;
+#define input_Thumbnail(a,b,c,d,e,f,g,h) input_Thumbnail(VLC_OBJECT(a),b,c,d,e,f,g,h)
+
 VLC_API int input_vaControl( input_thread_t *, int i_query, va_list  );
 
 VLC_API int input_Control( input_thread_t *, int i_query, ...  );
@@ -289,7 +289,8 @@ typedef enum input_item_meta_request_option_t
     META_REQUEST_OPTION_NONE          = 0x00,
     META_REQUEST_OPTION_SCOPE_LOCAL   = 0x01,
     META_REQUEST_OPTION_SCOPE_NETWORK = 0x02,
-    META_REQUEST_OPTION_SCOPE_ANY     = 0x03
+    META_REQUEST_OPTION_SCOPE_ANY     = 0x03,
+    META_REQUEST_OPTION_PRIORITY      = 0x04 /**< Queue ahead of pending requests */
 } input_item_meta_request_option_t;
 
 VLC_API int libvlc_MetaRequest(libvlc_int_t *, input_item_t *,
@@ -300,6 +301,68 @@ VLC_API int libvlc_ArtRequest(libvlc_int_t *, input_item_t *,
 /******************
  * Input stats
  ******************/
+
+/**
+ * Histogram with power of two buckets.
+ *
+ * Bucket 0 counts the values below 1, bucket n the values in
+ * [2^(n-1), 2^n) and the last bucket everything above.
+ */
+#define INPUT_HISTOGRAM_BUCKETS 24
+
+typedef struct
+{
+    uint64_t i_count;   /**< Number of samples */
+    int64_t  i_total;   /**< Sum of the samples */
+    int64_t  i_max;     /**< Largest sample */
+    uint64_t pi_buckets[INPUT_HISTOGRAM_BUCKETS];
+} input_histogram_t;
+
+static inline void input_histogram_Add( input_histogram_t *p_h, int64_t i_value )
+{
+    unsigned i_bucket = 0;
+
+    if( i_value > 0 )
+    {
+        if( i_value >= (INT64_C(1) << (INPUT_HISTOGRAM_BUCKETS - 2)) )
+            i_bucket = INPUT_HISTOGRAM_BUCKETS - 1;
+        else
+            i_bucket = 32 - clz32( (uint32_t)i_value );
+    }
+    p_h->pi_buckets[i_bucket]++;
+    p_h->i_count++;
+    p_h->i_total += i_value;
+    if( p_h->i_count == 1 || i_value > p_h->i_max )
+        p_h->i_max = i_value;
+}
+
+static inline void input_histogram_Merge( input_histogram_t *p_dst,
+                                          const input_histogram_t *p_src )
+{
+    if( p_src->i_count == 0 )
+        return;
+    if( p_dst->i_count == 0 || p_src->i_max > p_dst->i_max )
+        p_dst->i_max = p_src->i_max;
+    p_dst->i_count += p_src->i_count;
+    p_dst->i_total += p_src->i_total;
+    for( unsigned i = 0; i < INPUT_HISTOGRAM_BUCKETS; i++ )
+        p_dst->pi_buckets[i] += p_src->pi_buckets[i];
+}
+
+/**
+ * Latency and queueing statistics of one elementary stream
+ */
+typedef struct
+{
+    int i_id;                       /**< ES id */
+    int i_cat;                      /**< ES category */
+
+    input_histogram_t decode_time;  /**< Time spent decoding a block (us) */
+    input_histogram_t fifo_depth;   /**< Blocks queued in the decoder fifo */
+    input_histogram_t picture_age;  /**< Time from decoding to display (us) */
+    input_histogram_t audio_drift;  /**< Drift of each audio correction (us) */
+} input_es_stats_t;
+
 struct input_stats_t
 {
     vlc_mutex_t         lock;
@@ -334,6 +397,10 @@ struct input_stats_t
     /* Aout */
     int64_t i_played_abuffers;
     int64_t i_lost_abuffers;
+
+    /* Elementary streams */
+    int i_es;
+    input_es_stats_t *p_es;
 };
 
 #endif
@@ -162,6 +162,10 @@ void picture_pool_NonEmpty( picture_pool_t * );
  * When the new pool is released, pictures are returned to the master pool.
  * If the master pool was already released, pictures will be destroyed.
  *
+ * If the master pool has a lock callback but no unlock callback, the lock
+ * callback merely checks whether a picture can be used. It then applies to
+ * the new pool as well.
+ *
  * @param count number of picture to reserve
  *
  * @return the new pool, or NULL if there were not enough pictures available
@@ -179,6 +183,19 @@ VLC_USED;
  */
 VLC_API unsigned picture_pool_GetSize(const picture_pool_t *);
 
+/**
+ * Counts the pictures of a pool that are currently allocated.
+ *
+ * Pools created by picture_pool_Reserve() keep their own count, which gives
+ * the number of pictures held by each consumer of a shared pool.
+ *
+ * @return the number of pictures obtained with picture_pool_Get() and not
+ * released yet
+ * @note This function is thread-safe, but the value may be stale as soon as
+ * it is returned if other threads use the pool.
+ */
+VLC_API unsigned picture_pool_GetInFlight(picture_pool_t *);
+
 
 #endif /* VLC_PICTURE_POOL_H */
 
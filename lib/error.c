@@ -19,6 +19,7 @@
  *****************************************************************************/
 
 #include "libvlc_internal.h"
+#include "event_internal.h"
 
 #include <stdarg.h>
 #include <stdio.h>
@@ -53,7 +54,10 @@ void libvlc_threads_init (void)
 {
     vlc_mutex_lock (&lock);
     if (refs++ == 0)
+    {
         vlc_threadvar_create (&context, free_msg);
+        libvlc_event_threads_init ();
+    }
     vlc_mutex_unlock (&lock);
 }
 
@@ -65,6 +69,7 @@ void libvlc_threads_deinit (void)
     {
         free_error ();
         vlc_threadvar_delete (&context);
+        libvlc_event_threads_deinit ();
     }
     vlc_mutex_unlock (&lock);
 }
@@ -34,34 +34,178 @@
 #include <assert.h>
 #include <errno.h>
 
+/* Immutable copy of the listeners of a group, as seen by event senders */
+typedef struct libvlc_event_listeners_t
+{
+    int i_count;
+    libvlc_event_listener_t *pp_listeners[];
+} libvlc_event_listeners_t;
+
 typedef struct libvlc_event_listeners_group_t
 {
     libvlc_event_type_t event_type;
-    vlc_array_t listeners;
-    bool b_sublistener_removed;
+    vlc_array_t listeners; /* protected by object_lock */
+    atomic_uintptr_t snapshot; /* libvlc_event_listeners_t * */
 } libvlc_event_listeners_group_t;
 
+/* Event managers the calling thread is sending events for */
+typedef struct libvlc_event_dispatch_t
+{
+    libvlc_event_manager_t *p_em;
+    unsigned epoch;
+    struct libvlc_event_dispatch_t *p_prev;
+} libvlc_event_dispatch_t;
+
+static vlc_threadvar_t dispatch_key;
+
 /*
  * Private functions
  */
 
 static bool
-group_contains_listener( libvlc_event_listeners_group_t * group,
-                         libvlc_event_listener_t * searched_listener )
+snapshot_contains_listener( const libvlc_event_listeners_t * snapshot,
+                            const libvlc_event_listener_t * listener )
 {
-    int i;
-    for( i = 0; i < vlc_array_count(&group->listeners); i++ )
-    {
-        if( listeners_are_equal(searched_listener, vlc_array_item_at_index(&group->listeners, i)) )
+    if( snapshot == NULL )
+        return false;
+
+    for( int i = 0; i < snapshot->i_count; i++ )
+        if( snapshot->pp_listeners[i] == listener )
             return true;
-    }
     return false;
 }
 
+/* Counts the readers of the calling thread in each epoch */
+static void own_readers( libvlc_event_manager_t * p_em, unsigned own[2] )
+{
+    own[0] = own[1] = 0;
+    for( libvlc_event_dispatch_t *p_dispatch = vlc_threadvar_get( dispatch_key );
+         p_dispatch != NULL; p_dispatch = p_dispatch->p_prev )
+        if( p_dispatch->p_em == p_em )
+            own[p_dispatch->epoch]++;
+}
+
+/*
+ * Senders never lock: they only announce themselves in one of two reader
+ * counters, selected by the current epoch. Writers replace the snapshot of
+ * the listeners under object_lock, retire the old one, and wait for the
+ * readers of both epochs in turn (read-copy-update) whenever they need to
+ * know that no sender can still see a detached listener.
+ */
+static unsigned rcu_read_lock( libvlc_event_manager_t * p_em )
+{
+    unsigned epoch = atomic_load( &p_em->epoch ) & 1;
+
+    atomic_fetch_add( &p_em->readers[epoch], 1 );
+    return epoch;
+}
+
+static void rcu_read_unlock( libvlc_event_manager_t * p_em, unsigned epoch )
+{
+    /* The writer does not wait for the parked readers: wake it up whenever
+     * a reader leaves, not only the last one */
+    atomic_fetch_sub( &p_em->readers[epoch], 1 );
+    if( atomic_load( &p_em->waiting ) )
+    {
+        vlc_mutex_lock( &p_em->sync_lock );
+        vlc_cond_broadcast( &p_em->sync_wait );
+        vlc_mutex_unlock( &p_em->sync_lock );
+    }
+}
+
+/*
+ * A writer called from a callback is a reader itself, and does not wait for
+ * its own reads: the sender rechecks the current snapshot before each call.
+ * Nor does it wait for the readers parked here by other threads, otherwise
+ * two callbacks detaching at the same time would wait for each other.
+ */
+static void rcu_synchronize( libvlc_event_manager_t * p_em )
+{
+    unsigned own[2];
+
+    own_readers( p_em, own );
+
+    vlc_mutex_lock( &p_em->sync_lock );
+    p_em->parked[0] += own[0];
+    p_em->parked[1] += own[1];
+    vlc_cond_broadcast( &p_em->sync_wait );
+
+    /* The epochs are flipped by one writer at a time */
+    while( p_em->syncing )
+        vlc_cond_wait( &p_em->sync_wait, &p_em->sync_lock );
+    p_em->syncing = true;
+
+    for( int i = 0; i < 2; i++ )
+    {
+        unsigned epoch = atomic_fetch_xor( &p_em->epoch, 1 ) & 1;
+
+        atomic_store( &p_em->waiting, true );
+        while( atomic_load( &p_em->readers[epoch] ) > p_em->parked[epoch] )
+            vlc_cond_wait( &p_em->sync_wait, &p_em->sync_lock );
+        atomic_store( &p_em->waiting, false );
+    }
+
+    p_em->syncing = false;
+    p_em->parked[0] -= own[0];
+    p_em->parked[1] -= own[1];
+    vlc_cond_broadcast( &p_em->sync_wait );
+    vlc_mutex_unlock( &p_em->sync_lock );
+}
+
+/* object_lock must be held */
+static void rcu_reclaim( libvlc_event_manager_t * p_em )
+{
+    /* Readers entering now can only see the current snapshots. */
+    if( atomic_load( &p_em->readers[0] ) != 0
+     || atomic_load( &p_em->readers[1] ) != 0 )
+        return;
+
+    for( int i = 0; i < vlc_array_count( &p_em->garbage ); i++ )
+        free( vlc_array_item_at_index( &p_em->garbage, i ) );
+    vlc_array_clear( &p_em->garbage );
+    atomic_store( &p_em->garbage_pending, false );
+}
+
+/* object_lock must be held */
+static void group_publish( libvlc_event_manager_t * p_em,
+                           libvlc_event_listeners_group_t * group )
+{
+    int i_count = vlc_array_count( &group->listeners );
+    libvlc_event_listeners_t *snapshot = NULL;
+
+    if( i_count > 0 )
+    {
+        snapshot = xmalloc( sizeof( *snapshot )
+                            + i_count * sizeof( snapshot->pp_listeners[0] ) );
+        snapshot->i_count = i_count;
+        for( int i = 0; i < i_count; i++ )
+            snapshot->pp_listeners[i] =
+                vlc_array_item_at_index( &group->listeners, i );
+    }
+
+    void *old = (void *)atomic_exchange( &group->snapshot,
+                                         (uintptr_t)snapshot );
+    if( old != NULL )
+    {
+        vlc_array_append( &p_em->garbage, old );
+        atomic_store( &p_em->garbage_pending, true );
+    }
+}
+
 /*
  * Internal libvlc functions
  */
 
+void libvlc_event_threads_init( void )
+{
+    vlc_threadvar_create( &dispatch_key, NULL );
+}
+
+void libvlc_event_threads_deinit( void )
+{
+    vlc_threadvar_delete( &dispatch_key );
+}
+
 /**************************************************************************
  *       libvlc_event_manager_new (internal) :
  *
@@ -80,14 +224,27 @@ libvlc_event_manager_new( void * p_obj, libvlc_instance_t * p_libvlc_inst )
     }
 
     p_em->p_obj = p_obj;
-    p_em->p_obj = p_obj;
-    p_em->async_event_queue = NULL;
     p_em->p_libvlc_instance = p_libvlc_inst;
+    if( libvlc_event_async_init( p_em ) )
+    {
+        libvlc_printerr( "Not enough memory" );
+        free( p_em );
+        return NULL;
+    }
 
     libvlc_retain( p_libvlc_inst );
     vlc_array_init( &p_em->listeners_groups );
+    vlc_array_init( &p_em->garbage );
     vlc_mutex_init( &p_em->object_lock );
-    vlc_mutex_init_recursive( &p_em->event_sending_lock );
+    vlc_mutex_init( &p_em->sync_lock );
+    vlc_cond_init( &p_em->sync_wait );
+    atomic_init( &p_em->readers[0], 0 );
+    atomic_init( &p_em->readers[1], 0 );
+    atomic_init( &p_em->epoch, 0 );
+    atomic_init( &p_em->waiting, false );
+    p_em->parked[0] = p_em->parked[1] = 0;
+    p_em->syncing = false;
+    atomic_init( &p_em->garbage_pending, false );
     return p_em;
 }
 
@@ -103,7 +260,8 @@ void libvlc_event_manager_release( libvlc_event_manager_t * p_em )
 
     libvlc_event_async_fini(p_em);
 
-    vlc_mutex_destroy( &p_em->event_sending_lock );
+    vlc_cond_destroy( &p_em->sync_wait );
+    vlc_mutex_destroy( &p_em->sync_lock );
     vlc_mutex_destroy( &p_em->object_lock );
 
     for( i = 0; i < vlc_array_count(&p_em->listeners_groups); i++)
@@ -114,8 +272,12 @@ void libvlc_event_manager_release( libvlc_event_manager_t * p_em )
             free( vlc_array_item_at_index( &p_lg->listeners, j ) );
 
         vlc_array_clear( &p_lg->listeners );
+        free( (void *)atomic_load( &p_lg->snapshot ) );
         free( p_lg );
     }
+    for( i = 0; i < vlc_array_count(&p_em->garbage); i++ )
+        free( vlc_array_item_at_index( &p_em->garbage, i ) );
+    vlc_array_clear( &p_em->garbage );
     vlc_array_clear( &p_em->listeners_groups );
     libvlc_release( p_em->p_libvlc_instance );
     free( p_em );
@@ -124,7 +286,8 @@ void libvlc_event_manager_release( libvlc_event_manager_t * p_em )
 /**************************************************************************
  *       libvlc_event_manager_register_event_type (internal) :
  *
- * Init an object's event manager.
+ * Init an object's event manager. Event types must all be registered
+ * before the first event is sent.
  **************************************************************************/
 void libvlc_event_manager_register_event_type(
         libvlc_event_manager_t * p_em,
@@ -134,6 +297,7 @@ void libvlc_event_manager_register_event_type(
     listeners_group = xmalloc(sizeof(libvlc_event_listeners_group_t));
     listeners_group->event_type = event_type;
     vlc_array_init( &listeners_group->listeners );
+    atomic_init( &listeners_group->snapshot, (uintptr_t)NULL );
 
     vlc_mutex_lock( &p_em->object_lock );
     vlc_array_append( &p_em->listeners_groups, listeners_group );
@@ -149,95 +313,67 @@ void libvlc_event_send( libvlc_event_manager_t * p_em,
                         libvlc_event_t * p_event )
 {
     libvlc_event_listeners_group_t * listeners_group = NULL;
-    libvlc_event_listener_t * listener_cached;
-    libvlc_event_listener_t * listener;
-    libvlc_event_listener_t * array_listeners_cached = NULL;
-    int i, i_cached_listeners = 0;
 
     /* Fill event with the sending object now */
     p_event->p_obj = p_em->p_obj;
 
-    vlc_mutex_lock( &p_em->event_sending_lock );
-    vlc_mutex_lock( &p_em->object_lock );
-    for( i = 0; i < vlc_array_count(&p_em->listeners_groups); i++)
+    /* The groups are all registered when the object is created */
+    for( int i = 0; i < vlc_array_count(&p_em->listeners_groups); i++)
     {
-        listeners_group = vlc_array_item_at_index(&p_em->listeners_groups, i);
-        if( listeners_group->event_type == p_event->type )
+        libvlc_event_listeners_group_t *group =
+            vlc_array_item_at_index(&p_em->listeners_groups, i);
+        if( group->event_type == p_event->type )
         {
-            if( vlc_array_count( &listeners_group->listeners ) <= 0 )
-                break;
-
-            /* Cache a copy of the listener to avoid locking issues,
-             * and allow that edition of listeners during callbacks will garantee immediate effect. */
-            i_cached_listeners = vlc_array_count(&listeners_group->listeners);
-            array_listeners_cached = malloc(sizeof(libvlc_event_listener_t)*(i_cached_listeners));
-            if( !array_listeners_cached )
-            {
-                vlc_mutex_unlock( &p_em->object_lock );
-                vlc_mutex_unlock( &p_em->event_sending_lock );
-                fprintf(stderr, "Can't alloc memory in libvlc_event_send" );
-                return;
-            }
-
-            listener_cached = array_listeners_cached;
-            for( i = 0; i < vlc_array_count(&listeners_group->listeners); i++)
-            {
-                listener = vlc_array_item_at_index(&listeners_group->listeners, i);
-                memcpy( listener_cached, listener, sizeof(libvlc_event_listener_t) );
-                listener_cached++;
-            }
+            listeners_group = group;
             break;
         }
     }
 
-    if( !listeners_group )
-    {
-        free( array_listeners_cached );
-        vlc_mutex_unlock( &p_em->object_lock );
-        vlc_mutex_unlock( &p_em->event_sending_lock );
+    if( listeners_group == NULL
+     || atomic_load( &listeners_group->snapshot ) == (uintptr_t)NULL )
         return;
-    }
 
-    /* Track item removed from *this* thread, with a simple flag. Indeed
-     * event_sending_lock is a recursive lock. This has the advantage of
-     * allowing to remove an event listener from within a callback */
-    listeners_group->b_sublistener_removed = false;
+    unsigned epoch = rcu_read_lock( p_em );
 
-    vlc_mutex_unlock( &p_em->object_lock );
+    /* Track this manager in the calling thread, so that listeners can be
+     * detached from within a callback without waiting for ourselves. */
+    libvlc_event_dispatch_t dispatch = {
+        .p_em = p_em,
+        .epoch = epoch,
+        .p_prev = vlc_threadvar_get( dispatch_key ),
+    };
+    vlc_threadvar_set( dispatch_key, &dispatch );
+    libvlc_event_listeners_t *snapshot =
+        (void *)atomic_load( &listeners_group->snapshot );
 
-    listener_cached = array_listeners_cached;
-    for( i = 0; i < i_cached_listeners; i++ )
+    for( int i = 0; snapshot != NULL && i < snapshot->i_count; i++ )
     {
-        if(listener_cached->is_asynchronous)
-        {
+        libvlc_event_listener_t *listener = snapshot->pp_listeners[i];
+        libvlc_event_listeners_t *current =
+            (void *)atomic_load( &listeners_group->snapshot );
+
+        /* Edition of listeners during callbacks takes immediate effect */
+        if( current != snapshot
+         && !snapshot_contains_listener( current, listener ) )
+            continue;
+
+        if( listener->is_asynchronous )
             /* The listener wants not to block the emitter during event callback */
-            libvlc_event_async_dispatch(p_em, listener_cached, p_event);
-        }
+            libvlc_event_async_dispatch( p_em, listener, p_event );
         else
-        {
             /* The listener wants to block the emitter during event callback */
+            listener->pf_callback( p_event, listener->p_user_data );
+    }
 
-            listener_cached->pf_callback( p_event, listener_cached->p_user_data );
-            listener_cached++;
+    vlc_threadvar_set( dispatch_key, dispatch.p_prev );
+    rcu_read_unlock( p_em, epoch );
 
-            if( listeners_group->b_sublistener_removed )
-            {
-                /* If a callback was removed, this gets called */
-                bool valid_listener;
-                vlc_mutex_lock( &p_em->object_lock );
-                valid_listener = group_contains_listener( listeners_group, listener_cached );
-                vlc_mutex_unlock( &p_em->object_lock );
-                if( !valid_listener )
-                {
-                    listener_cached++;
-                    continue;
-                }
-            }
-        }
+    if( atomic_load( &p_em->garbage_pending ) )
+    {
+        vlc_mutex_lock( &p_em->object_lock );
+        rcu_reclaim( p_em );
+        vlc_mutex_unlock( &p_em->object_lock );
     }
-    vlc_mutex_unlock( &p_em->event_sending_lock );
-
-    free( array_listeners_cached );
 }
 
 /*
@@ -357,13 +493,22 @@ int event_attach( libvlc_event_manager_t * p_event_manager,
     listener->pf_callback = pf_callback;
     listener->is_asynchronous = is_asynchronous;
 
+    if( is_asynchronous && libvlc_event_async_start( p_event_manager ) )
+    {
+        free( listener );
+        return ENOMEM;
+    }
+
     vlc_mutex_lock( &p_event_manager->object_lock );
+
     for( i = 0; i < vlc_array_count(&p_event_manager->listeners_groups); i++ )
     {
         listeners_group = vlc_array_item_at_index(&p_event_manager->listeners_groups, i);
         if( listeners_group->event_type == listener->event_type )
         {
             vlc_array_append( &listeners_group->listeners, listener );
+            group_publish( p_event_manager, listeners_group );
+            rcu_reclaim( p_event_manager );
             vlc_mutex_unlock( &p_event_manager->object_lock );
             return 0;
         }
@@ -420,7 +565,6 @@ void libvlc_event_detach( libvlc_event_manager_t *p_event_manager,
     int i, j;
     bool found = false;
 
-    vlc_mutex_lock( &p_event_manager->event_sending_lock );
     vlc_mutex_lock( &p_event_manager->object_lock );
     for( i = 0; i < vlc_array_count(&p_event_manager->listeners_groups); i++)
     {
@@ -434,14 +578,11 @@ void libvlc_event_detach( libvlc_event_manager_t *p_event_manager,
                     listener->pf_callback == pf_callback &&
                     listener->p_user_data == p_user_data )
                 {
-                    /* that's our listener */
-
-                    /* Mark this group as edited so that libvlc_event_send
-                     * will recheck what listener to call */
-                    listeners_group->b_sublistener_removed = true;
-
-                    free( listener );
+                    /* that's our listener: senders may still be using it,
+                     * so it is only retired along with the old snapshot */
                     vlc_array_remove( &listeners_group->listeners, j );
+                    group_publish( p_event_manager, listeners_group );
+                    vlc_array_append( &p_event_manager->garbage, listener );
                     found = true;
                     break;
                 }
@@ -449,7 +590,13 @@ void libvlc_event_detach( libvlc_event_manager_t *p_event_manager,
         }
     }
     vlc_mutex_unlock( &p_event_manager->object_lock );
-    vlc_mutex_unlock( &p_event_manager->event_sending_lock );
+
+    /* Wait for the other senders that may still call the listener */
+    rcu_synchronize( p_event_manager );
+
+    vlc_mutex_lock( &p_event_manager->object_lock );
+    rcu_reclaim( p_event_manager );
+    vlc_mutex_unlock( &p_event_manager->object_lock );
 
     /* Now make sure any pending async event won't get fired after that point */
     libvlc_event_listener_t listener_to_remove;
@@ -37,13 +37,25 @@ struct queue_elmt {
     libvlc_event_listener_t listener;
     libvlc_event_t event;
     struct queue_elmt * next;
+    struct queue_elmt * next_pending; /* in the coalescing slot */
+};
+
+/* Events that only report the latest value of a continuous state */
+enum {
+    SLOT_BUFFERING,
+    SLOT_TIME,
+    SLOT_POSITION,
+    SLOT_COUNT
 };
 
 struct libvlc_event_async_queue {
     struct queue_elmt *first_elmt, *last_elmt;
+    /* Pending events of each coalescable type, at most one per listener */
+    struct queue_elmt *pending[SLOT_COUNT];
     vlc_mutex_t lock;
     vlc_cond_t signal;
     vlc_thread_t thread;
+    bool is_started;
     bool is_idle;
     vlc_cond_t signal_idle;
     vlc_threadvar_t is_asynch_dispatch_thread_var;
@@ -60,25 +72,73 @@ static inline struct libvlc_event_async_queue * queue(libvlc_event_manager_t * p
     return p_em->async_event_queue;
 }
 
-static inline bool is_queue_initialized(libvlc_event_manager_t * p_em)
-{
-    return queue(p_em) != NULL;
-}
-
 static inline bool current_thread_is_asynch_thread(libvlc_event_manager_t * p_em)
 {
     return vlc_threadvar_get(queue(p_em)->is_asynch_dispatch_thread_var)
             != NULL;
 }
 
+static int coalescing_slot(libvlc_event_type_t type)
+{
+    switch (type)
+    {
+        case libvlc_MediaPlayerBuffering:
+            return SLOT_BUFFERING;
+        case libvlc_MediaPlayerTimeChanged:
+            return SLOT_TIME;
+        case libvlc_MediaPlayerPositionChanged:
+            return SLOT_POSITION;
+        default:
+            return -1;
+    }
+}
+
+/* Lock must be held */
+static void unlink_pending(libvlc_event_manager_t * p_em,
+                           struct queue_elmt * elmt)
+{
+    int slot = coalescing_slot(elmt->event.type);
+    if (slot < 0)
+        return;
+
+    struct queue_elmt ** pp = &queue(p_em)->pending[slot];
+    while (*pp != elmt)
+        pp = &(*pp)->next_pending;
+    *pp = elmt->next_pending;
+}
+
 /* Lock must be held */
 static void push(libvlc_event_manager_t * p_em,
                  libvlc_event_listener_t * listener, libvlc_event_t * event)
 {
+    int slot = coalescing_slot(event->type);
+    if (slot >= 0)
+    {
+        /* A listener only receives events of its own type: a pending event
+         * for the same listener is superseded by the new one, which takes
+         * its place. The order of the events seen by each listener is
+         * preserved. */
+        for (struct queue_elmt * iter = queue(p_em)->pending[slot]; iter;
+             iter = iter->next_pending)
+            if (listeners_are_equal(&iter->listener, listener))
+            {
+                iter->event = *event;
+                return;
+            }
+    }
+
     struct queue_elmt * elmt = malloc(sizeof(struct queue_elmt));
+    if (unlikely(elmt == NULL))
+        return;
     elmt->listener = *listener;
     elmt->event = *event;
     elmt->next = NULL;
+    elmt->next_pending = NULL;
+    if (slot >= 0)
+    {
+        elmt->next_pending = queue(p_em)->pending[slot];
+        queue(p_em)->pending[slot] = elmt;
+    }
 
     /* Append to the end of the queue */
     if(!queue(p_em)->first_elmt)
@@ -112,6 +172,7 @@ static bool pop(libvlc_event_manager_t * p_em,
     queue(p_em)->first_elmt = elmt->next;
     if( !elmt->next ) queue(p_em)->last_elmt=NULL;
 
+    unlink_pending(p_em, elmt);
     free(elmt);
     return true;
 }
@@ -130,6 +191,7 @@ static void pop_listener(libvlc_event_manager_t * p_em, libvlc_event_listener_t
             else
                 prev->next = to_delete->next;
             iter = to_delete->next;
+            unlink_pending(p_em, to_delete);
             free(to_delete);
         }
         else {
@@ -148,19 +210,16 @@ static void pop_listener(libvlc_event_manager_t * p_em, libvlc_event_listener_t
 void
 libvlc_event_async_fini(libvlc_event_manager_t * p_em)
 {
-    if(!is_queue_initialized(p_em)) return;
-
     if(current_thread_is_asynch_thread(p_em))
     {
         fprintf(stderr, "*** Error: releasing the last reference of the observed object from its callback thread is not (yet!) supported\n");
         abort();
     }
 
-    vlc_thread_t thread = queue(p_em)->thread;
-    if(thread)
+    if(queue(p_em)->is_started)
     {
-        vlc_cancel(thread);
-        vlc_join(thread, NULL);
+        vlc_cancel(queue(p_em)->thread);
+        vlc_join(queue(p_em)->thread, NULL);
     }
 
     vlc_mutex_destroy(&queue(p_em)->lock);
@@ -179,30 +238,52 @@ libvlc_event_async_fini(libvlc_event_manager_t * p_em)
 }
 
 /**************************************************************************
- *       libvlc_event_async_init (private) :
+ *       libvlc_event_async_init (internal) :
  *
- * Destroy what might have been created by.
+ * Create the queue, along with the event manager. The queue is not modified
+ * afterwards, so that senders need not lock the event manager to use it.
  **************************************************************************/
-static void
+int
 libvlc_event_async_init(libvlc_event_manager_t * p_em)
 {
-    p_em->async_event_queue = calloc(1, sizeof(struct libvlc_event_async_queue));
+    struct libvlc_event_async_queue * q = calloc(1, sizeof(*q));
+    if(unlikely(q == NULL))
+        return VLC_ENOMEM;
 
-    int error = vlc_threadvar_create(&queue(p_em)->is_asynch_dispatch_thread_var, NULL);
-    assert(!error);
+    if(vlc_threadvar_create(&q->is_asynch_dispatch_thread_var, NULL))
+    {
+        free(q);
+        return VLC_ENOMEM;
+    }
 
-    vlc_mutex_init(&queue(p_em)->lock);
-    vlc_cond_init(&queue(p_em)->signal);
-    vlc_cond_init(&queue(p_em)->signal_idle);
+    vlc_mutex_init(&q->lock);
+    vlc_cond_init(&q->signal);
+    vlc_cond_init(&q->signal_idle);
+    p_em->async_event_queue = q;
+    return VLC_SUCCESS;
+}
 
-    error = vlc_clone (&queue(p_em)->thread, event_async_loop, p_em, VLC_THREAD_PRIORITY_LOW);
-    if(error)
+/**************************************************************************
+ *       libvlc_event_async_start (internal) :
+ *
+ * Create the asynchronous dispatch thread, if not done yet. This is done
+ * when the first asynchronous listener is attached, so that the thread is
+ * not created when not needed.
+ **************************************************************************/
+int
+libvlc_event_async_start(libvlc_event_manager_t * p_em)
+{
+    int error = VLC_SUCCESS;
+
+    queue_lock(p_em);
+    if(!queue(p_em)->is_started)
     {
-        free(p_em->async_event_queue);
-        p_em->async_event_queue = NULL;
-        return;
+        error = vlc_clone(&queue(p_em)->thread, event_async_loop, p_em,
+                          VLC_THREAD_PRIORITY_LOW);
+        queue(p_em)->is_started = !error;
     }
-
+    queue_unlock(p_em);
+    return error;
 }
 
 /**************************************************************************
@@ -213,13 +294,11 @@ libvlc_event_async_init(libvlc_event_manager_t * p_em)
 void
 libvlc_event_async_ensure_listener_removal(libvlc_event_manager_t * p_em, libvlc_event_listener_t * listener)
 {
-    if(!is_queue_initialized(p_em)) return;
-
     queue_lock(p_em);
     pop_listener(p_em, listener);
 
     // Wait for the asynch_loop to have processed all events.
-    if(!current_thread_is_asynch_thread(p_em))
+    if(queue(p_em)->is_started && !current_thread_is_asynch_thread(p_em))
     {
         while(!queue(p_em)->is_idle)
             vlc_cond_wait(&queue(p_em)->signal_idle, &queue(p_em)->lock);
@@ -235,12 +314,6 @@ libvlc_event_async_ensure_listener_removal(libvlc_event_manager_t * p_em, libvlc
 void
 libvlc_event_async_dispatch(libvlc_event_manager_t * p_em, libvlc_event_listener_t * listener, libvlc_event_t * event)
 {
-    // We do a lazy init here, to prevent constructing the thread when not needed.
-    vlc_mutex_lock(&p_em->object_lock);
-    if(!queue(p_em))
-        libvlc_event_async_init(p_em);
-    vlc_mutex_unlock(&p_em->object_lock);
-
     queue_lock(p_em);
     push(p_em, listener, event);
     vlc_cond_signal(&queue(p_em)->signal);
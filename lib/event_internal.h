@@ -34,6 +34,7 @@
 #include <vlc/libvlc_events.h>
 
 #include <vlc_common.h>
+#include <vlc_atomic.h>
 
 
 /*
@@ -90,8 +91,18 @@ typedef struct libvlc_event_manager_t
     struct libvlc_instance_t * p_libvlc_instance;
     vlc_array_t listeners_groups;
     vlc_mutex_t object_lock;
-    vlc_mutex_t event_sending_lock;
     struct libvlc_event_async_queue * async_event_queue;
+
+    /* Lock-less senders, see libvlc_event_send() */
+    atomic_uint readers[2];
+    atomic_uint epoch;
+    atomic_bool waiting;
+    unsigned parked[2]; /* readers waiting in rcu_synchronize(), sync_lock */
+    bool syncing; /* protected by sync_lock */
+    vlc_mutex_t sync_lock;
+    vlc_cond_t sync_wait;
+    vlc_array_t garbage; /* retired snapshots and listeners */
+    atomic_bool garbage_pending;
 } libvlc_event_sender_t;
 
 
@@ -105,7 +116,13 @@ listeners_are_equal( libvlc_event_listener_t * listener1,
     listener1->is_asynchronous == listener2->is_asynchronous;
 }
 
+/* event.c */
+void libvlc_event_threads_init(void);
+void libvlc_event_threads_deinit(void);
+
 /* event_async.c */
+int libvlc_event_async_init(libvlc_event_manager_t * p_em);
+int libvlc_event_async_start(libvlc_event_manager_t * p_em);
 void libvlc_event_async_fini(libvlc_event_manager_t * p_em);
 void libvlc_event_async_dispatch(libvlc_event_manager_t * p_em, libvlc_event_listener_t * listener, libvlc_event_t * event);
 void libvlc_event_async_ensure_listener_removal(libvlc_event_manager_t * p_em, libvlc_event_listener_t * listener);
@@ -38,6 +38,8 @@
 #include <vlc_meta.h>
 #include <vlc_playlist.h> /* For the preparser */
 #include <vlc_url.h>
+#include <vlc_block.h>
+#include <vlc_image.h>
 
 #include "../src/libvlc.h"
 
@@ -665,6 +667,79 @@ int libvlc_media_get_stats( libvlc_media_t *p_md,
     return true;
 }
 
+static void media_histogram_Copy( libvlc_histogram_t *p_dst,
+                                  const input_histogram_t *p_src )
+{
+    static_assert( LIBVLC_HISTOGRAM_BUCKETS == INPUT_HISTOGRAM_BUCKETS,
+                   "histogram size mismatch" );
+
+    p_dst->i_count = p_src->i_count;
+    p_dst->i_total = p_src->i_total;
+    p_dst->i_max = p_src->i_max;
+    memcpy( p_dst->pi_buckets, p_src->pi_buckets, sizeof( p_dst->pi_buckets ) );
+}
+
+unsigned libvlc_media_es_stats_get( libvlc_media_t *p_md,
+                                    libvlc_media_es_stats_t **pp_stats )
+{
+    assert( p_md );
+
+    *pp_stats = NULL;
+
+    input_item_t *p_item = p_md->p_input_item;
+    if( p_item == NULL || p_item->p_stats == NULL )
+        return 0;
+
+    input_stats_t *p_itm_stats = p_item->p_stats;
+    vlc_mutex_lock( &p_itm_stats->lock );
+
+    const int i_es = p_itm_stats->i_es;
+    libvlc_media_es_stats_t *p_stats = NULL;
+    if( i_es > 0 )
+        p_stats = calloc( i_es, sizeof( *p_stats ) );
+    if( p_stats == NULL )
+    {
+        vlc_mutex_unlock( &p_itm_stats->lock );
+        return 0;
+    }
+
+    for( int i = 0; i < i_es; i++ )
+    {
+        const input_es_stats_t *p_es = &p_itm_stats->p_es[i];
+        libvlc_media_es_stats_t *p_mes = &p_stats[i];
+
+        p_mes->i_id = p_es->i_id;
+        switch( p_es->i_cat )
+        {
+        case AUDIO_ES:
+            p_mes->i_type = libvlc_track_audio;
+            break;
+        case VIDEO_ES:
+            p_mes->i_type = libvlc_track_video;
+            break;
+        case SPU_ES:
+            p_mes->i_type = libvlc_track_text;
+            break;
+        default:
+            p_mes->i_type = libvlc_track_unknown;
+            break;
+        }
+        media_histogram_Copy( &p_mes->decode_time, &p_es->decode_time );
+        media_histogram_Copy( &p_mes->fifo_depth, &p_es->fifo_depth );
+        media_histogram_Copy( &p_mes->picture_age, &p_es->picture_age );
+        media_histogram_Copy( &p_mes->audio_drift, &p_es->audio_drift );
+    }
+    vlc_mutex_unlock( &p_itm_stats->lock );
+
+    *pp_stats = p_stats;
+    return i_es;
+}
+
+void libvlc_media_es_stats_release( libvlc_media_es_stats_t *p_stats )
+{
+    free( p_stats );
+}
+
 /**************************************************************************
  * event_manager
  **************************************************************************/
@@ -719,6 +794,8 @@ static int media_parse(libvlc_media_t *media, bool b_async,
         if (parse_flag & libvlc_media_fetch_network)
             art_scope |= META_REQUEST_OPTION_SCOPE_NETWORK;
         if (art_scope != META_REQUEST_OPTION_NONE) {
+            if (parse_flag & libvlc_media_parse_priority)
+                art_scope |= META_REQUEST_OPTION_PRIORITY;
             ret = libvlc_ArtRequest(libvlc, item, art_scope);
             if (ret != VLC_SUCCESS)
                 return ret;
@@ -726,6 +803,8 @@ static int media_parse(libvlc_media_t *media, bool b_async,
 
         if (parse_flag & libvlc_media_parse_network)
             parse_scope |= META_REQUEST_OPTION_SCOPE_NETWORK;
+        if (parse_flag & libvlc_media_parse_priority)
+            parse_scope |= META_REQUEST_OPTION_PRIORITY;
         ret = libvlc_MetaRequest(libvlc, item, parse_scope);
         if (ret != VLC_SUCCESS)
             return ret;
@@ -785,6 +864,54 @@ libvlc_media_is_parsed(libvlc_media_t *media)
     return parsed;
 }
 
+/**************************************************************************
+ * Extract a thumbnail, without playing the media.
+ **************************************************************************/
+int
+libvlc_media_thumbnail( libvlc_media_t *p_md, libvlc_time_t i_time,
+                        float f_pos, unsigned i_width, unsigned i_height,
+                        const char *psz_format, libvlc_time_t i_timeout,
+                        unsigned char **pp_data, size_t *pi_size )
+{
+    assert( p_md );
+
+    vlc_fourcc_t i_format = image_Type2Fourcc( psz_format ? psz_format
+                                                          : "png" );
+    if( i_format == 0 )
+    {
+        libvlc_printerr( "Unknown image format: %s", psz_format );
+        return -1;
+    }
+
+    /* Keep the original size if no dimension is given */
+    int i_override_width = i_width, i_override_height = i_height;
+    if( i_width == 0 && i_height == 0 )
+        i_override_width = i_override_height = -1;
+
+    block_t *p_image = input_Thumbnail( p_md->p_libvlc_instance->p_libvlc_int,
+                                        p_md->p_input_item,
+                                        i_time >= 0 ? i_time * 1000 : -1,
+                                        f_pos, i_format, i_override_width,
+                                        i_override_height, i_timeout * 1000 );
+    if( p_image == NULL )
+    {
+        libvlc_printerr( "Thumbnail extraction failed" );
+        return -1;
+    }
+
+    *pp_data = malloc( p_image->i_buffer );
+    if( unlikely(*pp_data == NULL) )
+    {
+        block_Release( p_image );
+        libvlc_printerr( "Not enough memory" );
+        return -1;
+    }
+    memcpy( *pp_data, p_image->p_buffer, p_image->i_buffer );
+    *pi_size = p_image->i_buffer;
+    block_Release( p_image );
+    return 0;
+}
+
 /**************************************************************************
  * Sets media descriptor's user_data. user_data is specialized data
  * accessed by the host application, VLC.framework uses it as a pointer to
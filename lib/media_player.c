@@ -492,6 +492,7 @@ libvlc_media_player_new( libvlc_instance_t *instance )
 
     /* Input */
     var_Create (mp, "rate", VLC_VAR_FLOAT|VLC_VAR_DOINHERIT);
+    var_Create (mp, "scrub", VLC_VAR_BOOL);
 
     /* Video */
     var_Create (mp, "vout", VLC_VAR_STRING|VLC_VAR_DOINHERIT);
@@ -499,6 +500,7 @@ libvlc_media_player_new( libvlc_instance_t *instance )
     var_Create (mp, "vmem-lock", VLC_VAR_ADDRESS);
     var_Create (mp, "vmem-unlock", VLC_VAR_ADDRESS);
     var_Create (mp, "vmem-display", VLC_VAR_ADDRESS);
+    var_Create (mp, "vmem-frame", VLC_VAR_ADDRESS);
     var_Create (mp, "vmem-data", VLC_VAR_ADDRESS);
     var_Create (mp, "vmem-setup", VLC_VAR_ADDRESS);
     var_Create (mp, "vmem-cleanup", VLC_VAR_ADDRESS);
@@ -863,6 +865,9 @@ int libvlc_media_player_play( libvlc_media_player_t *p_mi )
     var_AddCallback( p_input_thread, "intf-event", input_event_changed, p_mi );
     add_es_callbacks( p_input_thread, p_mi );
 
+    if( var_GetBool( p_mi, "scrub" ) )
+        var_SetBool( p_input_thread, "scrub", true );
+
     if( input_Start( p_input_thread ) )
     {
         unlock_input(p_mi);
@@ -962,11 +967,34 @@ void libvlc_video_set_callbacks( libvlc_media_player_t *mp,
     var_SetAddress( mp, "vmem-lock", lock_cb );
     var_SetAddress( mp, "vmem-unlock", unlock_cb );
     var_SetAddress( mp, "vmem-display", display_cb );
+    var_SetAddress( mp, "vmem-frame", NULL );
+    var_SetAddress( mp, "vmem-data", opaque );
+    var_SetString( mp, "vout", "vmem" );
+    var_SetString( mp, "avcodec-hw", "none" );
+}
+
+void libvlc_video_set_buffer_callbacks( libvlc_media_player_t *mp,
+                                        libvlc_video_lock_cb lock_cb,
+                                        libvlc_video_frame_cb frame_cb,
+                                        void *opaque )
+{
+    var_SetAddress( mp, "vmem-lock", lock_cb );
+    var_SetAddress( mp, "vmem-unlock", NULL );
+    var_SetAddress( mp, "vmem-display", NULL );
+    var_SetAddress( mp, "vmem-frame", frame_cb );
     var_SetAddress( mp, "vmem-data", opaque );
     var_SetString( mp, "vout", "vmem" );
     var_SetString( mp, "avcodec-hw", "none" );
 }
 
+void libvlc_video_frame_release( libvlc_video_frame_t *frame )
+{
+    /* The frame handle starts with its release function (see vmem) */
+    void (**release)( void * ) = (void *)frame;
+
+    (*release)( frame );
+}
+
 void libvlc_video_set_format_callbacks( libvlc_media_player_t *mp,
                                         libvlc_video_format_cb setup,
                                         libvlc_video_cleanup_cb cleanup )
@@ -1401,6 +1429,22 @@ float libvlc_media_player_get_rate( libvlc_media_player_t *p_mi )
     return var_GetFloat (p_mi, "rate");
 }
 
+void libvlc_media_player_set_scrub( libvlc_media_player_t *p_mi, int scrub )
+{
+    var_SetBool (p_mi, "scrub", scrub != 0);
+
+    input_thread_t *p_input_thread = libvlc_get_input_thread ( p_mi );
+    if( !p_input_thread )
+        return;
+    var_SetBool( p_input_thread, "scrub", scrub != 0 );
+    vlc_object_release( p_input_thread );
+}
+
+int libvlc_media_player_get_scrub( libvlc_media_player_t *p_mi )
+{
+    return var_GetBool (p_mi, "scrub");
+}
+
 libvlc_state_t libvlc_media_player_get_state( libvlc_media_player_t *p_mi )
 {
     lock(p_mi);
@@ -46,14 +46,22 @@
 #include <vlc_url.h>
 #include <vlc_strings.h>
 #include <vlc_charset.h>
+#include <vlc_md5.h>
+#include <vlc_atomic.h>
 
 enum
 {
+    ENTRY_UNKNOWN   = 1,
     ENTRY_DIR       = 0,
     ENTRY_ENOTDIR   = -1,
     ENTRY_EACCESS   = -2,
 };
 
+/* Number of threads probing the entries of a directory in parallel, and
+ * minimum number of entries per thread */
+#define PROBE_THREADS       8
+#define PROBE_MIN_ENTRIES   16
+
 enum
 {
     MODE_NONE,
@@ -61,13 +69,19 @@ enum
     MODE_EXPAND,
 };
 
+typedef struct
+{
+    char        *name; /* first member, so that compar() can sort entries */
+    int          type; /* ENTRY_* */
+} directory_entry;
+
 typedef struct directory directory;
 struct directory
 {
     directory   *parent;
     DIR         *handle;
     char        *uri;
-    char       **filev;
+    directory_entry *filev;
     int          filec, i;
 #ifdef HAVE_OPENAT
     dev_t        device;
@@ -81,6 +95,7 @@ struct access_sys_t
 {
     directory *current;
     char      *ignored_exts;
+    char      *cache_dir; /* listing cache directory, NULL if disabled */
     char       mode;
     int        (*compar) (const char **a, const char **b);
 };
@@ -158,6 +173,314 @@ static bool has_inode_loop (const directory *dir, dev_t dev, ino_t inode)
 }
 #endif
 
+static void entries_free (directory_entry *entries, int count)
+{
+    for (int i = 0; i < count; i++)
+        free (entries[i].name);
+    free (entries);
+}
+
+/* Appends an entry of the given type, returns false on error */
+static bool entries_append (directory_entry **entriesp, int *countp,
+                            int *sizep, const char *name, int type)
+{
+    if (*countp >= *sizep)
+    {
+        int size = *sizep ? (2 * *sizep) : 16;
+        directory_entry *entries = realloc (*entriesp,
+                                            size * sizeof (*entries));
+        if (unlikely(entries == NULL))
+            return false;
+        *entriesp = entries;
+        *sizep = size;
+    }
+
+    char *dup = strdup (name);
+    if (unlikely(dup == NULL))
+        return false;
+    (*entriesp)[*countp].name = dup;
+    (*entriesp)[*countp].type = type;
+    (*countp)++;
+    return true;
+}
+
+/* Reads the visible entries of a directory, whose type is not known yet */
+static int directory_list (DIR *handle, directory_entry **entriesp)
+{
+    directory_entry *entries = NULL;
+    int count = 0, size = 0;
+
+    for (;;)
+    {
+        errno = 0;
+        const char *entry = vlc_readdir (handle);
+        if (entry == NULL)
+        {
+            if (errno)
+                goto error;
+            break;
+        }
+
+        if (!visible (entry))
+            continue;
+        if (!entries_append (&entries, &count, &size, entry, ENTRY_UNKNOWN))
+            goto error;
+    }
+
+    *entriesp = entries;
+    return count;
+
+error:
+    entries_free (entries, count);
+    return -1;
+}
+
+#ifdef HAVE_OPENAT
+/*
+ * Listing cache: the entries of a directory and whether they are
+ * directories are kept in a file, along with the directory modification
+ * time. Adding, removing or renaming an entry updates the latter, so the
+ * cached listing remains valid as long as it does not change.
+ */
+/* Creates the cache directory and its parents */
+static void directory_cache_mkdir (char *psz_dir)
+{
+    for (char *psz = psz_dir + 1; *psz; psz++)
+    {
+        if (*psz != DIR_SEP_CHAR)
+            continue;
+        *psz = '\0';
+        vlc_mkdir (psz_dir, 0700);
+        *psz = DIR_SEP_CHAR;
+    }
+    vlc_mkdir (psz_dir, 0700);
+}
+
+static char *directory_cache_path (access_sys_t *p_sys, const char *uri)
+{
+    struct md5_s md5;
+    char *hash, *path;
+
+    InitMD5 (&md5);
+    AddMD5 (&md5, uri, strlen (uri));
+    EndMD5 (&md5);
+    hash = psz_md5_hash (&md5);
+    if (unlikely(hash == NULL))
+        return NULL;
+
+    if (asprintf (&path, "%s"DIR_SEP"%s", p_sys->cache_dir, hash) == -1)
+        path = NULL;
+    free (hash);
+    return path;
+}
+
+static int directory_cache_load (access_sys_t *p_sys, const directory *p_dir,
+                                 time_t mtime, directory_entry **entriesp)
+{
+    char *path = directory_cache_path (p_sys, p_dir->uri);
+    if (path == NULL)
+        return -1;
+
+    FILE *stream = vlc_fopen (path, "rt");
+    free (path);
+    if (stream == NULL)
+        return -1;
+
+    directory_entry *entries = NULL;
+    int count = 0, size = 0;
+    char *line = NULL;
+    size_t linesize = 0;
+    ssize_t len;
+    uintmax_t dev, ino;
+    intmax_t cached_mtime;
+
+    /* Header: device, inode and modification time of the directory */
+    if (fscanf (stream, "%ju %ju %jd\n", &dev, &ino, &cached_mtime) != 3
+     || dev != (uintmax_t)p_dir->device || ino != (uintmax_t)p_dir->inode
+     || cached_mtime != (intmax_t)mtime)
+        goto error;
+
+    while ((len = getline (&line, &linesize, stream)) != -1)
+    {
+        int type;
+
+        if (len < 3 || line[len - 1] != '\n')
+            goto error;
+        line[len - 1] = '\0';
+
+        switch (line[0])
+        {
+            case 'd': type = ENTRY_DIR;     break;
+            case 'f': type = ENTRY_ENOTDIR; break;
+            case 'u': type = ENTRY_UNKNOWN; break;
+            default:  goto error;
+        }
+        if (!entries_append (&entries, &count, &size, line + 1, type))
+            goto error;
+    }
+
+    free (line);
+    fclose (stream);
+    *entriesp = entries;
+    return count;
+
+error:
+    free (line);
+    fclose (stream);
+    entries_free (entries, count);
+    return -1;
+}
+
+static void directory_cache_save (access_sys_t *p_sys, const directory *p_dir,
+                                  time_t mtime)
+{
+    /* A change within the same second would not update the time */
+    if (mtime >= time (NULL))
+        return;
+
+    char *path = directory_cache_path (p_sys, p_dir->uri), *tmp;
+    if (path == NULL)
+        return;
+    if (asprintf (&tmp, "%s.XXXXXX", path) == -1)
+    {
+        free (path);
+        return;
+    }
+
+    int fd = vlc_mkstemp (tmp);
+    FILE *stream = (fd != -1) ? fdopen (fd, "wt") : NULL;
+    if (stream == NULL)
+    {
+        if (fd != -1)
+        {
+            close (fd);
+            vlc_unlink (tmp);
+        }
+        goto out;
+    }
+
+    bool ok = fprintf (stream, "%ju %ju %jd\n", (uintmax_t)p_dir->device,
+                       (uintmax_t)p_dir->inode, (intmax_t)mtime) > 0;
+
+    for (int i = 0; ok && i < p_dir->filec; i++)
+    {
+        const directory_entry *p_entry = &p_dir->filev[i];
+        char type;
+
+        if (strchr (p_entry->name, '\n') != NULL)
+        {
+            ok = false;
+            break;
+        }
+
+        /* Inaccessible entries may become accessible without any change of
+         * the directory, so they are probed again. */
+        switch (p_entry->type)
+        {
+            case ENTRY_DIR:     type = 'd'; break;
+            case ENTRY_ENOTDIR: type = 'f'; break;
+            default:            type = 'u'; break;
+        }
+        ok = fprintf (stream, "%c%s\n", type, p_entry->name) > 0;
+    }
+
+    if (fclose (stream) || !ok || vlc_rename (tmp, path))
+        vlc_unlink (tmp);
+out:
+    free (tmp);
+    free (path);
+}
+
+/* Finds the type of an entry without opening it, unless check_dir is set
+ * and the entry is a directory. This runs in parallel threads. */
+static int directory_probe (const directory *p_dir, const char *psz_entry,
+                            bool check_dir)
+{
+    struct stat st;
+
+    if (fstatat (dirfd (p_dir->handle), psz_entry, &st, 0))
+        return ENTRY_EACCESS;
+    if (!S_ISDIR (st.st_mode))
+        return ENTRY_ENOTDIR;
+    if (has_inode_loop (p_dir, st.st_dev, st.st_ino))
+        return ENTRY_EACCESS;
+
+    if (check_dir)
+    {
+        int fd = vlc_openat (dirfd (p_dir->handle), psz_entry,
+                             O_RDONLY | O_DIRECTORY);
+        if (fd == -1)
+            return ENTRY_EACCESS;
+        close (fd);
+    }
+    return ENTRY_DIR;
+}
+
+struct directory_prober
+{
+    directory   *dir;
+    bool         check_dirs;
+    atomic_uint  next;
+};
+
+static bool directory_needs_probe (const directory_entry *p_entry,
+                                   bool check_dirs)
+{
+    return p_entry->type == ENTRY_UNKNOWN
+        || (p_entry->type == ENTRY_DIR && check_dirs);
+}
+
+static void *directory_prober_thread (void *data)
+{
+    struct directory_prober *prober = data;
+    directory *p_dir = prober->dir;
+    unsigned i;
+
+    while ((i = atomic_fetch_add (&prober->next, 1)) < (unsigned)p_dir->filec)
+    {
+        directory_entry *p_entry = &p_dir->filev[i];
+
+        if (directory_needs_probe (p_entry, prober->check_dirs))
+            p_entry->type = directory_probe (p_dir, p_entry->name,
+                                             prober->check_dirs);
+    }
+    return NULL;
+}
+
+/* Probes the entries of unknown type, using several threads for large
+ * directories so that the latency of network file systems overlaps. */
+static void directory_probe_all (access_sys_t *p_sys, directory *p_dir)
+{
+    struct directory_prober prober = {
+        .dir = p_dir,
+        /* Collapsed subdirectories are only listed if they can be opened */
+        .check_dirs = p_sys->mode == MODE_COLLAPSE,
+    };
+    vlc_thread_t threads[PROBE_THREADS - 1];
+    unsigned count = 0, nthreads = 0;
+
+    atomic_init (&prober.next, 0);
+
+    for (int i = 0; i < p_dir->filec; i++)
+        if (directory_needs_probe (&p_dir->filev[i], prober.check_dirs))
+            count++;
+
+    while (nthreads < ARRAY_SIZE(threads)
+        && count > (nthreads + 1) * PROBE_MIN_ENTRIES)
+    {
+        if (vlc_clone (&threads[nthreads], directory_prober_thread, &prober,
+                       VLC_THREAD_PRIORITY_LOW))
+            break;
+        nthreads++;
+    }
+
+    directory_prober_thread (&prober);
+
+    for (unsigned i = 0; i < nthreads; i++)
+        vlc_join (threads[i], NULL);
+}
+#endif
+
 /* success -> returns ENTRY_DIR and the handle parameter is set to the handle,
  * error -> return ENTRY_ENOTDIR or ENTRY_EACCESS */
 static int directory_open (directory *p_dir, char *psz_entry, DIR **handle)
@@ -212,31 +535,51 @@ static bool directory_push (access_sys_t *p_sys, DIR *handle, char *psz_uri)
     p_dir->parent = p_sys->current;
     p_dir->handle = handle;
     p_dir->uri = psz_uri;
-    p_dir->filec = vlc_loaddir (handle, &p_dir->filev, visible, p_sys->compar);
-    if (p_dir->filec < 0)
-        p_dir->filev = NULL;
+    p_dir->filev = NULL;
+    p_dir->filec = -1;
     p_dir->i = 0;
 
 #ifdef HAVE_OPENAT
     struct stat st;
     if (fstat (dirfd (handle), &st))
-        goto error_filev;
+        goto error;
     p_dir->device = st.st_dev;
     p_dir->inode = st.st_ino;
+
+    bool cached = false;
+    if (p_sys->cache_dir != NULL)
+    {
+        p_dir->filec = directory_cache_load (p_sys, p_dir, st.st_mtime,
+                                             &p_dir->filev);
+        cached = p_dir->filec >= 0;
+    }
 #else
     p_dir->path = make_path (psz_uri);
     if (p_dir->path == NULL)
-        goto error_filev;
+        goto error;
+#endif
+
+    if (p_dir->filec < 0)
+        p_dir->filec = directory_list (handle, &p_dir->filev);
+    if (p_dir->filec < 0)
+    {
+        p_dir->filev = NULL;
+        p_dir->filec = 0;
+    }
+
+    if (p_sys->compar != NULL && p_dir->filec > 0)
+        qsort (p_dir->filev, p_dir->filec, sizeof (*p_dir->filev),
+               (int (*)(const void *, const void *))p_sys->compar);
+
+#ifdef HAVE_OPENAT
+    directory_probe_all (p_sys, p_dir);
+    if (p_sys->cache_dir != NULL && !cached)
+        directory_cache_save (p_sys, p_dir, st.st_mtime);
 #endif
 
     p_sys->current = p_dir;
     return true;
 
-error_filev:
-    for (int i = 0; i < p_dir->filec; i++)
-        free (p_dir->filev[i]);
-    free (p_dir->filev);
-
 error:
     closedir (handle);
     free (p_dir);
@@ -254,9 +597,7 @@ static bool directory_pop (access_sys_t *p_sys)
     p_sys->current = p_old->parent;
     closedir (p_old->handle);
     free (p_old->uri);
-    for (int i = 0; i < p_old->filec; i++)
-        free (p_old->filev[i]);
-    free (p_old->filev);
+    entries_free (p_old->filev, p_old->filec);
 #ifndef HAVE_OPENAT
     free (p_old->path);
 #endif
@@ -300,6 +641,24 @@ int DirInit (access_t *p_access, DIR *handle)
         p_sys->compar = collate;
     free(psz_sort);
 
+    p_sys->cache_dir = NULL;
+#ifdef HAVE_OPENAT
+    if (var_InheritBool (p_access, "directory-cache"))
+    {
+        char *psz_cachedir = config_GetUserDir (VLC_CACHE_DIR);
+
+        if (psz_cachedir != NULL)
+        {
+            if (asprintf (&p_sys->cache_dir, "%s"DIR_SEP"directory",
+                          psz_cachedir) == -1)
+                p_sys->cache_dir = NULL;
+            else
+                directory_cache_mkdir (p_sys->cache_dir);
+            free (psz_cachedir);
+        }
+    }
+#endif
+
     char *uri;
     if (!strcmp (p_access->psz_access, "fd"))
     {
@@ -314,6 +673,16 @@ int DirInit (access_t *p_access, DIR *handle)
         goto error;
     }
 
+    /* Handle mode */
+    char *psz_rec = var_InheritString (p_access, "recursive");
+    if (psz_rec == NULL || !strcasecmp (psz_rec, "none"))
+        p_sys->mode = MODE_NONE;
+    else if (!strcasecmp (psz_rec, "collapse"))
+        p_sys->mode = MODE_COLLAPSE;
+    else
+        p_sys->mode = MODE_EXPAND;
+    free (psz_rec);
+
     /* "Open" the base directory */
     p_sys->current = NULL;
     if (!directory_push (p_sys, handle, uri))
@@ -326,23 +695,14 @@ int DirInit (access_t *p_access, DIR *handle)
     p_access->p_sys = p_sys;
     p_sys->ignored_exts = var_InheritString (p_access, "ignore-filetypes");
 
-
-    /* Handle mode */
-    char *psz_rec = var_InheritString (p_access, "recursive");
-    if (psz_rec == NULL || !strcasecmp (psz_rec, "none"))
-        p_sys->mode = MODE_NONE;
-    else if (!strcasecmp (psz_rec, "collapse"))
-        p_sys->mode = MODE_COLLAPSE;
-    else
-        p_sys->mode = MODE_EXPAND;
-    free (psz_rec);
-
     p_access->pf_readdir = DirRead;
     p_access->pf_control = DirControl;
 
     return VLC_SUCCESS;
 
 error:
+    if (p_sys != NULL)
+        free (p_sys->cache_dir);
     free (p_sys);
     return VLC_EGENERIC;
 }
@@ -359,6 +719,7 @@ void DirClose( vlc_object_t * p_this )
         ;
 
     free (p_sys->ignored_exts);
+    free (p_sys->cache_dir);
     free (p_sys);
 }
 
@@ -382,14 +743,18 @@ int DirRead (access_t *p_access, input_item_node_t *p_current_node)
             continue;
         }
 
-        char *psz_entry = p_current->filev[p_current->i++];
+        directory_entry *p_entry = &p_current->filev[p_current->i++];
+        char *psz_entry = p_entry->name;
         char *psz_full_uri, *psz_uri;
-        DIR *handle;
+        DIR *handle = NULL;
         input_item_t *p_new = NULL;
-        int i_res;
+        int i_res = p_entry->type;
 
-        /* Check if it is a directory or even readable */
-        i_res = directory_open (p_current, psz_entry, &handle);
+        /* Check if it is a directory or even readable, unless already probed;
+         * directories are only opened to expand them */
+        if (i_res == ENTRY_UNKNOWN
+         || (i_res == ENTRY_DIR && p_sys->mode == MODE_EXPAND))
+            i_res = directory_open (p_current, psz_entry, &handle);
 
         if (i_res == ENTRY_EACCESS
             || (i_res == ENTRY_DIR && p_sys->mode == MODE_NONE)
@@ -406,7 +771,8 @@ int DirRead (access_t *p_access, input_item_node_t *p_current_node)
         free (psz_uri);
         if (psz_full_uri == NULL)
         {
-            closedir (handle);
+            if (handle != NULL)
+                closedir (handle);
             continue;
         }
 
@@ -416,7 +782,8 @@ int DirRead (access_t *p_access, input_item_node_t *p_current_node)
         if (p_new == NULL)
         {
             free (psz_full_uri);
-            closedir (handle);
+            if (handle != NULL)
+                closedir (handle);
             continue;
         }
 
@@ -424,14 +791,13 @@ int DirRead (access_t *p_access, input_item_node_t *p_current_node)
         input_item_node_t *p_new_node = input_item_node_AppendItem (p_current_node, p_new);
 
         /* Handle directory flags and recursion if in EXPAND mode  */
-        if (i_res == ENTRY_DIR)
+        if (i_res == ENTRY_DIR && p_sys->mode == MODE_EXPAND)
         {
-            if (p_sys->mode == MODE_EXPAND
-                && directory_push (p_sys, handle, psz_full_uri))
-            {
+            if (directory_push (p_sys, handle, psz_full_uri))
                 p_current_node = p_new_node;
-            }
         }
+        else if (handle != NULL)
+            closedir (handle);
 
         free (psz_full_uri);
         input_item_Release (p_new);
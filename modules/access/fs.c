@@ -58,6 +58,12 @@ static const char *const psz_sort_list_text[] = {
 #define SORT_LONGTEXT N_( \
     "Define the sort algorithm used when adding items from a directory." )
 
+#define CACHE_TEXT N_("Cache directory listings")
+#define CACHE_LONGTEXT N_( \
+    "Keep the listings of the opened directories, and reuse them as long " \
+    "as the directories are not modified. This speeds up opening large " \
+    "directories on network file systems again." )
+
 vlc_module_begin ()
     set_description( N_("File input") )
     set_shortname( N_("File") )
@@ -78,6 +84,7 @@ vlc_module_begin ()
                 IGNORE_TEXT, IGNORE_LONGTEXT, false )
     add_string( "directory-sort", "collate", SORT_TEXT, SORT_LONGTEXT, false )
       change_string_list( psz_sort_list, psz_sort_list_text )
+    add_bool( "directory-cache", false, CACHE_TEXT, CACHE_LONGTEXT, true )
 #ifndef HAVE_FDOPENDIR
     add_shortcut( "file", "directory", "dir" )
 #else
@@ -55,6 +55,8 @@
 #include <assert.h>
 #include <limits.h>
 
+#include "http_cache.h"
+
 /*****************************************************************************
  * Module descriptor
  *****************************************************************************/
@@ -88,6 +90,23 @@ static void Close( vlc_object_t * );
 #define REFERER_TEXT N_("HTTP referer value")
 #define REFERER_LONGTEXT N_("Customize the HTTP referer, simulating a previous document")
 
+#define CACHE_TEXT N_("Range cache size (MiB)")
+#define CACHE_LONGTEXT N_( \
+    "Memory used to cache seekable resources of known size. When set, " \
+    "data is fetched in blocks with ranged requests over persistent " \
+    "connections, so that seeking back to data already downloaded is " \
+    "free. 0 disables the cache." )
+
+#define CACHE_CONNECTIONS_TEXT N_("Range cache connections")
+#define CACHE_CONNECTIONS_LONGTEXT N_( \
+    "Number of parallel connections fetching data ahead of the reading " \
+    "position when the range cache is enabled." )
+
+#define CACHE_SPILL_TEXT N_("Spill range cache to disk")
+#define CACHE_SPILL_LONGTEXT N_( \
+    "Keep data evicted from the range cache memory in a temporary file, " \
+    "so that it is never downloaded twice." )
+
 #define UA_TEXT N_("User Agent")
 #define UA_LONGTEXT N_("The name and version of the program will be " \
     "provided to the HTTP server. They must be separated by a forward " \
@@ -118,6 +137,13 @@ vlc_module_begin ()
         change_safe()
     add_bool( "http-forward-cookies", true, FORWARD_COOKIES_TEXT,
               FORWARD_COOKIES_LONGTEXT, true )
+    add_integer( "http-cache", 0, CACHE_TEXT, CACHE_LONGTEXT, true )
+        change_integer_range( 0, 1024 )
+    add_integer( "http-cache-connections", 2, CACHE_CONNECTIONS_TEXT,
+                 CACHE_CONNECTIONS_LONGTEXT, true )
+        change_integer_range( 1, 8 )
+    add_bool( "http-cache-spill", false, CACHE_SPILL_TEXT,
+              CACHE_SPILL_LONGTEXT, true )
     /* 'itpc' = iTunes Podcast */
     add_shortcut( "http", "https", "unsv", "itpc", "icyx" )
     set_callbacks( Open, Close )
@@ -187,6 +213,9 @@ struct access_sys_t
     bool b_pace_control;
     bool b_persist;
     bool b_has_size;
+
+    /* Range cache, if used */
+    http_cache_t *p_cache;
 };
 
 /* */
@@ -204,6 +233,10 @@ static int Connect( access_t *, uint64_t );
 static int Request( access_t *p_access, uint64_t i_tell );
 static void Disconnect( access_t * );
 
+static void OpenCache( access_t * );
+static ssize_t ReadCached( access_t *, uint8_t *, size_t );
+static int SeekCached( access_t *, uint64_t );
+
 
 static void AuthReply( access_t *p_acces, const char *psz_prefix,
                        vlc_url_t *p_url, http_auth_t *p_auth );
@@ -274,6 +307,7 @@ static int OpenRedirected( vlc_object_t *p_this, const char *psz_access,
     p_sys->b_persist = false;
     p_sys->b_has_size = false;
     p_sys->size = 0;
+    p_sys->p_cache = NULL;
     p_access->info.i_pos  = 0;
     p_access->info.b_eof  = false;
 
@@ -580,6 +614,8 @@ connect:
 
     if( p_sys->b_reconnect ) msg_Dbg( p_access, "auto re-connect enabled" );
 
+    OpenCache( p_access );
+
     return VLC_SUCCESS;
 
 error:
@@ -626,6 +662,8 @@ static void Close( vlc_object_t *p_this )
     free( p_sys->psz_user_agent );
     free( p_sys->psz_referrer );
 
+    if( p_sys->p_cache != NULL )
+        http_cache_Delete( p_sys->p_cache );
     Disconnect( p_access );
     vlc_tls_Delete( p_sys->p_creds );
 
@@ -950,7 +988,7 @@ static int Control( access_t *p_access, int i_query, va_list args )
             break;
         case ACCESS_CAN_FASTSEEK:
             pb_bool = (bool*)va_arg( args, bool* );
-            *pb_bool = false;
+            *pb_bool = p_sys->p_cache != NULL;
             break;
         case ACCESS_CAN_PAUSE:
         case ACCESS_CAN_CONTROL_PACE:
@@ -1548,6 +1586,296 @@ static void Disconnect( access_t *p_access )
 
 }
 
+/*****************************************************************************
+ * Range cache
+ *****************************************************************************
+ * Once a seekable resource of known size has been opened, it can be read
+ * through a block cache. Blocks are fetched by ranged requests over
+ * persistent connections (one per cache thread), independently of the
+ * main connection which is then closed.
+ *****************************************************************************/
+typedef struct
+{
+    int         fd;
+    vlc_tls_t  *p_tls;
+    v_socket_t *p_vs;
+    bool        b_persist;
+} http_range_conn_t;
+
+static void RangeClose( void *opaque, void *data )
+{
+    http_range_conn_t *conn = data;
+    (void) opaque;
+
+    if( conn->p_tls != NULL )
+        vlc_tls_SessionDelete( conn->p_tls );
+    net_Close( conn->fd );
+    free( conn );
+}
+
+static void RangeCleanup( void *data )
+{
+    RangeClose( NULL, data );
+}
+
+static http_range_conn_t *RangeConnect( access_t *p_access )
+{
+    access_sys_t *p_sys = p_access->p_sys;
+    http_range_conn_t *conn = malloc( sizeof(*conn) );
+    if( unlikely(conn == NULL) )
+        return NULL;
+
+    conn->p_tls = NULL;
+    conn->p_vs = NULL;
+    conn->b_persist = true;
+    conn->fd = net_ConnectTCP( p_access, p_sys->url.psz_host,
+                               p_sys->url.i_port );
+    if( conn->fd == -1 )
+    {
+        free( conn );
+        return NULL;
+    }
+    setsockopt( conn->fd, SOL_SOCKET, SO_KEEPALIVE, &(int){ 1 }, sizeof (int) );
+    return conn;
+}
+
+/* Sets up TLS if needed, sends the request and parses the answer headers.
+ * This is a cancellation point: the caller must clean the connection up. */
+static int RangeSend( access_t *p_access, http_range_conn_t *conn,
+                      uint64_t i_offset, uint64_t i_length )
+{
+    access_sys_t *p_sys = p_access->p_sys;
+
+    if( p_sys->p_creds != NULL && conn->p_tls == NULL )
+    {
+        const char *alpn[] = { "http/1.1", NULL };
+
+        conn->p_tls = vlc_tls_ClientSessionCreate( p_sys->p_creds, conn->fd,
+                                  p_sys->url.psz_host, "https", alpn, NULL );
+        if( conn->p_tls == NULL )
+            return VLC_EGENERIC;
+        conn->p_vs = &conn->p_tls->sock;
+    }
+
+    const char *psz_path = p_sys->url.psz_path;
+    if( !psz_path || !*psz_path )
+        psz_path = "/";
+
+    char psz_port[sizeof (":65535")] = "";
+    if( p_sys->url.i_port != (p_sys->p_creds != NULL ? 443 : 80) )
+        snprintf( psz_port, sizeof (psz_port), ":%d", p_sys->url.i_port );
+
+    char *psz_cookies = NULL;
+    if( p_sys->cookies )
+        psz_cookies = vlc_http_cookies_for_url( p_sys->cookies, &p_sys->url );
+
+    int val;
+    vlc_cleanup_push( free, psz_cookies );
+    val = net_Printf( p_access, conn->fd, conn->p_vs,
+                          "GET %s HTTP/1.1\r\n"
+                          "Host: %s%s\r\n"
+                          "User-Agent: %s\r\n"
+                          "%s%s%s"
+                          "%s%s%s"
+                          "Range: bytes=%"PRIu64"-%"PRIu64"\r\n"
+                          "\r\n",
+                          psz_path, p_sys->url.psz_host, psz_port,
+                          p_sys->psz_user_agent,
+                          p_sys->psz_referrer ? "Referer: " : "",
+                          p_sys->psz_referrer ? p_sys->psz_referrer : "",
+                          p_sys->psz_referrer ? "\r\n" : "",
+                          psz_cookies ? "Cookie: " : "",
+                          psz_cookies ? psz_cookies : "",
+                          psz_cookies ? "\r\n" : "",
+                          i_offset, i_offset + i_length - 1 );
+    vlc_cleanup_run();
+    if( val < 0 )
+        return VLC_EGENERIC;
+
+    char *psz = net_Gets( p_access, conn->fd, conn->p_vs );
+    if( psz == NULL )
+        return VLC_EGENERIC;
+
+    int i_code = 0;
+    if( !strncmp( psz, "HTTP/1.", 7 ) )
+    {
+        conn->b_persist = psz[7] != '0';
+        i_code = atoi( &psz[9] );
+    }
+    free( psz );
+    if( i_code != 206 )
+    {
+        msg_Err( p_access, "unexpected answer code %d to range request",
+                 i_code );
+        return VLC_EGENERIC;
+    }
+
+    uint64_t i_start = UINT64_MAX;
+    uint64_t i_size = UINT64_MAX;
+    bool b_chunked = false;
+
+    for( ;; )
+    {
+        psz = net_Gets( p_access, conn->fd, conn->p_vs );
+        if( psz == NULL )
+            return VLC_EGENERIC;
+        if( *psz == '\0' )
+        {
+            free( psz );
+            break;
+        }
+
+        char *p = strchr( psz, ':' );
+        if( p != NULL )
+        {
+            *p++ = '\0';
+            p += strspn( p, " \t" );
+
+            if( !strcasecmp( psz, "Content-Length" ) )
+                i_size = strtoull( p, NULL, 10 );
+            else if( !strcasecmp( psz, "Content-Range" ) )
+                sscanf( p, "bytes %"SCNu64, &i_start );
+            else if( !strcasecmp( psz, "Connection" ) )
+            {
+                if( !strncasecmp( p, "close", 5 ) )
+                    conn->b_persist = false;
+            }
+            else if( !strcasecmp( psz, "Transfer-Encoding" ) )
+                b_chunked = strncasecmp( p, "identity", 8 ) != 0;
+        }
+        free( psz );
+    }
+
+    if( i_start != i_offset || i_size != i_length || b_chunked )
+    {
+        msg_Err( p_access, "unexpected range %"PRIu64"/%"PRIu64
+                 " instead of %"PRIu64"/%"PRIu64, i_start, i_size,
+                 i_offset, i_length );
+        return VLC_EGENERIC;
+    }
+    return VLC_SUCCESS;
+}
+
+/* Runs the request with a cleanup handler, so that the connection is not
+ * leaked if the cache worker thread is cancelled. */
+static int RangeStart( access_t *p_access, http_range_conn_t *conn,
+                       void **connp, uint64_t i_offset, uint64_t i_length )
+{
+    int val;
+
+    vlc_cleanup_push( RangeCleanup, conn );
+    val = RangeSend( p_access, conn, i_offset, i_length );
+    vlc_cleanup_pop();
+    if( val != VLC_SUCCESS )
+    {
+        RangeClose( p_access, conn );
+        return VLC_EGENERIC;
+    }
+
+    *connp = conn;
+    return VLC_SUCCESS;
+}
+
+static int RangeRequest( void *opaque, void **connp,
+                         uint64_t i_offset, uint64_t i_length )
+{
+    access_t *p_access = opaque;
+    http_range_conn_t *conn = *connp;
+
+    /* The connection belongs to this request until it succeeds: the caller
+     * must not close it again if the request fails or is cancelled. */
+    *connp = NULL;
+    if( conn != NULL && !conn->b_persist )
+    {
+        RangeClose( p_access, conn );
+        conn = NULL;
+    }
+    if( conn == NULL )
+        conn = RangeConnect( p_access );
+    if( conn == NULL )
+        return VLC_EGENERIC;
+
+    return RangeStart( p_access, conn, connp, i_offset, i_length );
+}
+
+static ssize_t RangeRead( void *opaque, void *data, uint8_t *p_buffer,
+                          size_t i_len )
+{
+    access_t *p_access = opaque;
+    http_range_conn_t *conn = data;
+
+    return net_Read( p_access, conn->fd, conn->p_vs, p_buffer, i_len, false );
+}
+
+static const http_cache_ops_t range_ops =
+{
+    RangeRequest,
+    RangeRead,
+    RangeClose,
+};
+
+static void OpenCache( access_t *p_access )
+{
+    access_sys_t *p_sys = p_access->p_sys;
+    int64_t i_cache = var_InheritInteger( p_access, "http-cache" );
+
+    if( i_cache <= 0 )
+        return;
+
+    /* Only plain byte ranges of a fixed resource can be cached. Proxies and
+     * authentication are left to the main connection. */
+    if( p_sys->i_code != 206 || !p_sys->b_seekable || !p_sys->b_has_size
+     || p_sys->i_version == 0 || p_sys->b_proxy || p_sys->b_continuous
+     || p_sys->b_chunked || p_sys->i_icy_meta > 0
+     || p_sys->url.psz_username != NULL
+#ifdef HAVE_ZLIB_H
+     || p_sys->b_compressed
+#endif
+      )
+    {
+        msg_Dbg( p_access, "range cache not usable" );
+        return;
+    }
+
+    p_sys->p_cache = http_cache_New( VLC_OBJECT(p_access), &range_ops,
+                                     p_access, p_sys->size, i_cache << 20,
+                        var_InheritInteger( p_access, "http-cache-connections" ),
+                        var_InheritBool( p_access, "http-cache-spill" ) );
+    if( p_sys->p_cache == NULL )
+        return;
+
+    /* The main connection answered an open-ended range request, it cannot
+     * be reused for other ranges. */
+    Disconnect( p_access );
+    p_access->pf_read = ReadCached;
+    p_access->pf_seek = SeekCached;
+}
+
+static ssize_t ReadCached( access_t *p_access, uint8_t *p_buffer,
+                           size_t i_len )
+{
+    access_sys_t *p_sys = p_access->p_sys;
+    ssize_t i_read = http_cache_Read( p_sys->p_cache, p_access->info.i_pos,
+                                      p_buffer, i_len );
+    if( i_read <= 0 )
+    {
+        if( i_read < 0 )
+            p_sys->b_error = true;
+        p_access->info.b_eof = true;
+        return 0;
+    }
+
+    p_access->info.i_pos += i_read;
+    return i_read;
+}
+
+static int SeekCached( access_t *p_access, uint64_t i_pos )
+{
+    p_access->info.i_pos = i_pos;
+    p_access->info.b_eof = false;
+    return VLC_SUCCESS;
+}
+
 /*****************************************************************************
  * HTTP authentication
  *****************************************************************************/
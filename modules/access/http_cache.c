@@ -0,0 +1,554 @@
+/*****************************************************************************
+ * http_cache.c: HTTP byte range block cache
+ *****************************************************************************
+ * Copyright (C) 2015 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+/*****************************************************************************
+ * Preamble
+ *****************************************************************************/
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <assert.h>
+#include <errno.h>
+#include <limits.h>
+#include <unistd.h>
+
+#include <vlc_common.h>
+#include <vlc_fs.h>
+#include <vlc_configuration.h>
+
+#include "http_cache.h"
+
+/* The resource is split into fixed size blocks. Each block is fetched with
+ * one ranged request, and is readable as soon as its first bytes arrive. */
+#define BLOCK_SIZE (256 * 1024)
+#define CHUNK_SIZE (16 * 1024)
+
+enum
+{
+    BLOCK_FREE,
+    BLOCK_QUEUED,
+    BLOCK_LOADING,
+    BLOCK_READY,
+    BLOCK_FAILED,
+};
+
+typedef struct
+{
+    uint64_t index;     /* block number within the resource */
+    int      state;
+    size_t   length;    /* block length (shorter at end of resource) */
+    size_t   filled;    /* bytes received so far */
+    uint64_t seq;       /* fetch order, 0 for blocks being waited for */
+    uint64_t last_use;
+    uint8_t *data;
+} http_block_t;
+
+typedef struct
+{
+    http_cache_t *cache;
+    vlc_thread_t  thread;
+    void         *conn;
+} http_worker_t;
+
+struct http_cache_t
+{
+    vlc_object_t *obj;
+    const http_cache_ops_t *ops;
+    void         *opaque;
+    uint64_t      size;
+    uint64_t      block_total;
+
+    vlc_mutex_t   lock;
+    vlc_cond_t    work;     /* a block was queued */
+    vlc_cond_t    progress; /* a block received data, completed or failed */
+
+    http_block_t *blocks;
+    unsigned      block_count;
+    unsigned      read_ahead;
+    uint64_t      seq;
+    uint64_t      tick;
+
+    /* Spill file: a sparse copy of the resource, with one bit per block.
+     * It is removed as soon as it is created, where the system allows it. */
+    int           spill_fd;
+    char         *spill_path; /* NULL once removed */
+    uint8_t      *spilled;
+
+    http_worker_t *workers;
+    unsigned      worker_count;
+};
+
+static size_t BlockLength( const http_cache_t *cache, uint64_t index )
+{
+    uint64_t remaining = cache->size - index * BLOCK_SIZE;
+
+    return remaining < BLOCK_SIZE ? remaining : BLOCK_SIZE;
+}
+
+static http_block_t *BlockFind( http_cache_t *cache, uint64_t index )
+{
+    for( unsigned i = 0; i < cache->block_count; i++ )
+    {
+        http_block_t *b = &cache->blocks[i];
+
+        if( b->state != BLOCK_FREE && b->index == index )
+            return b;
+    }
+    return NULL;
+}
+
+/*****************************************************************************
+ * Spill file
+ *****************************************************************************/
+static bool SpillHas( const http_cache_t *cache, uint64_t index )
+{
+    return cache->spilled != NULL
+        && (cache->spilled[index / 8] >> (index % 8)) & 1;
+}
+
+static void SpillWrite( http_cache_t *cache, const http_block_t *b )
+{
+    if( cache->spilled == NULL || SpillHas( cache, b->index ) )
+        return;
+
+    if( lseek( cache->spill_fd, b->index * BLOCK_SIZE, SEEK_SET ) == -1
+     || write( cache->spill_fd, b->data, b->length ) != (ssize_t)b->length )
+    {
+        msg_Warn( cache->obj, "cannot spill cached data: %s",
+                  vlc_strerror_c(errno) );
+        return;
+    }
+    cache->spilled[b->index / 8] |= 1 << (b->index % 8);
+}
+
+static bool SpillRead( http_cache_t *cache, http_block_t *b )
+{
+    if( lseek( cache->spill_fd, b->index * BLOCK_SIZE, SEEK_SET ) == -1
+     || read( cache->spill_fd, b->data, b->length ) != (ssize_t)b->length )
+    {
+        msg_Warn( cache->obj, "cannot read spilled data: %s",
+                  vlc_strerror_c(errno) );
+        cache->spilled[b->index / 8] &= ~(1 << (b->index % 8));
+        return false;
+    }
+    return true;
+}
+
+static void SpillOpen( http_cache_t *cache )
+{
+    char *dir = config_GetUserDir( VLC_CACHE_DIR );
+    if( dir == NULL )
+        return;
+
+    if( vlc_mkdir( dir, 0700 ) && errno != EEXIST )
+        goto error;
+
+    if( asprintf( &cache->spill_path, "%s"DIR_SEP"http-XXXXXX", dir ) == -1 )
+    {
+        cache->spill_path = NULL;
+        goto error;
+    }
+
+    cache->spill_fd = vlc_mkstemp( cache->spill_path );
+    if( cache->spill_fd == -1 )
+        goto error;
+
+    msg_Dbg( cache->obj, "spilling cached data to %s", cache->spill_path );
+    if( vlc_unlink( cache->spill_path ) == 0 )
+    {
+        free( cache->spill_path );
+        cache->spill_path = NULL;
+    }
+
+    cache->spilled = calloc( (cache->block_total + 7) / 8, 1 );
+    if( cache->spilled == NULL )
+    {
+        close( cache->spill_fd );
+        if( cache->spill_path != NULL )
+            vlc_unlink( cache->spill_path );
+        goto error;
+    }
+    free( dir );
+    return;
+
+error:
+    msg_Warn( cache->obj, "cannot create cache spill file in %s", dir );
+    free( cache->spill_path );
+    cache->spill_path = NULL;
+    cache->spill_fd = -1;
+    free( dir );
+}
+
+/*****************************************************************************
+ * Block allocation
+ *****************************************************************************/
+
+/* Finds a slot for a new block, evicting the least recently used block if
+ * the cache is full. Blocks being fetched are never evicted. */
+static http_block_t *BlockAlloc( http_cache_t *cache, uint64_t index )
+{
+    http_block_t *b = NULL;
+
+    for( unsigned i = 0; i < cache->block_count; i++ )
+    {
+        http_block_t *cand = &cache->blocks[i];
+
+        if( cand->state == BLOCK_FREE || cand->state == BLOCK_FAILED )
+        {
+            b = cand;
+            break;
+        }
+        if( cand->state == BLOCK_READY
+         && (b == NULL || cand->last_use < b->last_use) )
+            b = cand;
+    }
+
+    if( b == NULL )
+        return NULL;
+
+    if( b->state == BLOCK_READY )
+        SpillWrite( cache, b );
+
+    if( b->data == NULL )
+    {
+        b->data = malloc( BLOCK_SIZE );
+        if( unlikely(b->data == NULL) )
+        {
+            b->state = BLOCK_FREE;
+            return NULL;
+        }
+    }
+
+    b->index = index;
+    b->state = BLOCK_FREE;
+    b->length = BlockLength( cache, index );
+    b->filled = 0;
+    b->last_use = ++cache->tick;
+    return b;
+}
+
+/* Makes a block available, from the spill file or by queuing its fetch */
+static http_block_t *BlockLoad( http_cache_t *cache, uint64_t index,
+                                bool wanted )
+{
+    http_block_t *b = BlockAlloc( cache, index );
+    if( b == NULL )
+        return NULL;
+
+    if( SpillHas( cache, index ) && SpillRead( cache, b ) )
+    {
+        b->state = BLOCK_READY;
+        b->filled = b->length;
+        return b;
+    }
+
+    b->state = BLOCK_QUEUED;
+    b->seq = wanted ? 0 : ++cache->seq;
+    vlc_cond_signal( &cache->work );
+    return b;
+}
+
+/* Drops queued read-ahead blocks after a jump, so the wanted block is
+ * fetched first and stale read-ahead does not occupy the connections. */
+static void CancelReadAhead( http_cache_t *cache )
+{
+    for( unsigned i = 0; i < cache->block_count; i++ )
+    {
+        http_block_t *b = &cache->blocks[i];
+
+        if( b->state == BLOCK_QUEUED )
+            b->state = BLOCK_FREE;
+    }
+}
+
+static void ReadAhead( http_cache_t *cache, uint64_t index )
+{
+    for( unsigned i = 0; i < cache->read_ahead; i++, index++ )
+    {
+        if( index >= cache->block_total )
+            break;
+        if( BlockFind( cache, index ) != NULL || SpillHas( cache, index ) )
+            continue;
+        if( BlockLoad( cache, index, false ) == NULL )
+            break;
+    }
+}
+
+/*****************************************************************************
+ * Fetching threads
+ *****************************************************************************/
+static http_block_t *NextQueued( http_cache_t *cache )
+{
+    http_block_t *next = NULL;
+
+    for( unsigned i = 0; i < cache->block_count; i++ )
+    {
+        http_block_t *b = &cache->blocks[i];
+
+        if( b->state == BLOCK_QUEUED && (next == NULL || b->seq < next->seq) )
+            next = b;
+    }
+    return next;
+}
+
+static int Request( http_worker_t *w, uint64_t offset, uint64_t length )
+{
+    http_cache_t *cache = w->cache;
+    bool reused = w->conn != NULL;
+
+    if( cache->ops->request( cache->opaque, &w->conn, offset, length ) == 0 )
+        return 0;
+
+    /* The server may have closed an idle persistent connection: retry once
+     * on a new connection. */
+    if( !reused )
+        return -1;
+    return cache->ops->request( cache->opaque, &w->conn, offset, length );
+}
+
+static bool Fetch( http_worker_t *w, http_block_t *b, uint64_t index,
+                   size_t length )
+{
+    http_cache_t *cache = w->cache;
+    size_t filled = 0;
+
+    if( Request( w, index * BLOCK_SIZE, length ) )
+        return false;
+
+    while( filled < length )
+    {
+        size_t len = length - filled;
+        if( len > CHUNK_SIZE )
+            len = CHUNK_SIZE;
+
+        /* Only this thread writes past b->filled, no locking needed */
+        ssize_t val = cache->ops->read( cache->opaque, w->conn,
+                                        b->data + filled, len );
+        if( val <= 0 )
+        {
+            cache->ops->close( cache->opaque, w->conn );
+            w->conn = NULL;
+            return false;
+        }
+        filled += val;
+
+        vlc_mutex_lock( &cache->lock );
+        b->filled = filled;
+        vlc_cond_broadcast( &cache->progress );
+        vlc_mutex_unlock( &cache->lock );
+    }
+    return true;
+}
+
+static void *Worker( void *data )
+{
+    http_worker_t *w = data;
+    http_cache_t *cache = w->cache;
+
+    for( ;; )
+    {
+        http_block_t *b;
+
+        vlc_mutex_lock( &cache->lock );
+        mutex_cleanup_push( &cache->lock );
+        while( (b = NextQueued( cache )) == NULL )
+            vlc_cond_wait( &cache->work, &cache->lock );
+        b->state = BLOCK_LOADING;
+        vlc_cleanup_pop();
+
+        uint64_t index = b->index;
+        size_t length = b->length;
+        vlc_mutex_unlock( &cache->lock );
+
+        bool ok = Fetch( w, b, index, length );
+
+        vlc_mutex_lock( &cache->lock );
+        b->state = ok ? BLOCK_READY : BLOCK_FAILED;
+        vlc_cond_broadcast( &cache->progress );
+        vlc_mutex_unlock( &cache->lock );
+
+        if( !ok )
+            msg_Warn( cache->obj, "cannot fetch block %"PRIu64, index );
+    }
+    vlc_assert_unreachable();
+}
+
+/*****************************************************************************
+ * Public functions
+ *****************************************************************************/
+http_cache_t *http_cache_New( vlc_object_t *obj, const http_cache_ops_t *ops,
+                              void *opaque, uint64_t size, size_t memory,
+                              unsigned threads, bool spill )
+{
+    assert( size > 0 && threads > 0 );
+
+    http_cache_t *cache = malloc( sizeof(*cache) );
+    if( unlikely(cache == NULL) )
+        return NULL;
+
+    cache->obj = obj;
+    cache->ops = ops;
+    cache->opaque = opaque;
+    cache->size = size;
+    cache->block_total = (size + BLOCK_SIZE - 1) / BLOCK_SIZE;
+
+    /* Keep room for each thread to fetch one block ahead and one behind */
+    cache->block_count = memory / BLOCK_SIZE;
+    if( cache->block_count < 4 * threads )
+        cache->block_count = 4 * threads;
+    cache->read_ahead = 2 * threads;
+    cache->seq = 0;
+    cache->tick = 0;
+    cache->blocks = calloc( cache->block_count, sizeof(*cache->blocks) );
+    if( unlikely(cache->blocks == NULL) )
+    {
+        free( cache );
+        return NULL;
+    }
+
+    cache->spill_fd = -1;
+    cache->spill_path = NULL;
+    cache->spilled = NULL;
+    if( spill )
+        SpillOpen( cache );
+
+    vlc_mutex_init( &cache->lock );
+    vlc_cond_init( &cache->work );
+    vlc_cond_init( &cache->progress );
+
+    cache->workers = malloc( threads * sizeof(*cache->workers) );
+    cache->worker_count = 0;
+    if( unlikely(cache->workers == NULL) )
+        goto error;
+
+    for( unsigned i = 0; i < threads; i++ )
+    {
+        http_worker_t *w = &cache->workers[i];
+
+        w->cache = cache;
+        w->conn = NULL;
+        if( vlc_clone( &w->thread, Worker, w, VLC_THREAD_PRIORITY_INPUT ) )
+            break;
+        cache->worker_count++;
+    }
+    if( cache->worker_count == 0 )
+        goto error;
+
+    msg_Dbg( obj, "caching %u blocks of %u KiB with %u connection(s)",
+             cache->block_count, BLOCK_SIZE / 1024, cache->worker_count );
+    return cache;
+
+error:
+    http_cache_Delete( cache );
+    return NULL;
+}
+
+void http_cache_Delete( http_cache_t *cache )
+{
+    for( unsigned i = 0; i < cache->worker_count; i++ )
+        vlc_cancel( cache->workers[i].thread );
+
+    for( unsigned i = 0; i < cache->worker_count; i++ )
+    {
+        http_worker_t *w = &cache->workers[i];
+
+        vlc_join( w->thread, NULL );
+        if( w->conn != NULL )
+            cache->ops->close( cache->opaque, w->conn );
+    }
+    free( cache->workers );
+
+    if( cache->spilled != NULL )
+    {
+        close( cache->spill_fd );
+        if( cache->spill_path != NULL )
+            vlc_unlink( cache->spill_path );
+        free( cache->spill_path );
+        free( cache->spilled );
+    }
+
+    for( unsigned i = 0; i < cache->block_count; i++ )
+        free( cache->blocks[i].data );
+    free( cache->blocks );
+
+    vlc_cond_destroy( &cache->progress );
+    vlc_cond_destroy( &cache->work );
+    vlc_mutex_destroy( &cache->lock );
+    free( cache );
+}
+
+ssize_t http_cache_Read( http_cache_t *cache, uint64_t offset,
+                         uint8_t *buf, size_t len )
+{
+    if( offset >= cache->size )
+        return 0;
+
+    uint64_t index = offset / BLOCK_SIZE;
+    size_t skip = offset % BLOCK_SIZE;
+    unsigned retries = 1;
+    http_block_t *b;
+
+    vlc_mutex_lock( &cache->lock );
+    for( ;; )
+    {
+        b = BlockFind( cache, index );
+        if( b == NULL )
+        {
+            CancelReadAhead( cache );
+            b = BlockLoad( cache, index, true );
+        }
+        else if( b->state == BLOCK_QUEUED )
+            b->seq = 0; /* fetch it first */
+        else if( b->state == BLOCK_FAILED )
+        {
+            if( retries-- == 0 )
+                break;
+            b->state = BLOCK_FREE;
+            continue;
+        }
+
+        if( b != NULL && b->filled > skip )
+            break;
+
+        /* Wait for data, or for a slot to become free */
+        vlc_cond_wait( &cache->progress, &cache->lock );
+    }
+
+    ssize_t ret = -1;
+
+    if( b->state != BLOCK_FAILED )
+    {
+        ret = b->filled - skip;
+        if( (size_t)ret > len )
+            ret = len;
+        memcpy( buf, b->data + skip, ret );
+        b->last_use = ++cache->tick;
+
+        ReadAhead( cache, index + 1 );
+    }
+    else
+    {
+        b->state = BLOCK_FREE;
+        msg_Err( cache->obj, "cannot read at offset %"PRIu64, offset );
+    }
+    vlc_mutex_unlock( &cache->lock );
+    return ret;
+}
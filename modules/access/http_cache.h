@@ -0,0 +1,66 @@
+/*****************************************************************************
+ * http_cache.h: HTTP byte range block cache
+ *****************************************************************************
+ * Copyright (C) 2015 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifndef VLC_HTTP_CACHE_H
+#define VLC_HTTP_CACHE_H 1
+
+/**
+ * Byte range fetching callbacks.
+ *
+ * Each fetching thread owns one connection handle, initially NULL, which is
+ * kept across requests so that persistent connections can be reused.
+ */
+typedef struct
+{
+    /** Requests a byte range, (re)opening the connection if needed.
+     * On error, the connection is closed and *connp is set to NULL. */
+    int     (*request)( void *opaque, void **connp,
+                        uint64_t offset, uint64_t length );
+    /** Reads data from the current range; returns 0 at end of range */
+    ssize_t (*read)( void *opaque, void *conn, uint8_t *buf, size_t len );
+    /** Closes a connection */
+    void    (*close)( void *opaque, void *conn );
+} http_cache_ops_t;
+
+typedef struct http_cache_t http_cache_t;
+
+/**
+ * Creates a block cache for a resource of known size.
+ *
+ * @param memory maximum memory used for cached blocks (bytes)
+ * @param threads number of parallel fetching threads (and connections)
+ * @param spill whether blocks evicted from memory are kept in a temporary
+ *              file
+ */
+http_cache_t *http_cache_New( vlc_object_t *, const http_cache_ops_t *,
+                              void *opaque, uint64_t size, size_t memory,
+                              unsigned threads, bool spill );
+void http_cache_Delete( http_cache_t * );
+
+/**
+ * Reads data at a given offset, waiting for it to be fetched if needed.
+ * Blocks following the read data are fetched ahead in the background.
+ *
+ * @return the number of bytes read, 0 at end of resource, -1 on error
+ */
+ssize_t http_cache_Read( http_cache_t *, uint64_t offset,
+                         uint8_t *buf, size_t len );
+
+#endif
@@ -321,6 +321,15 @@ int InitVideoDec( decoder_t *p_dec, AVCodecContext *p_context,
     else if( i_val == -1 ) p_context->skip_idct = AVDISCARD_NONE;
     else p_context->skip_idct = AVDISCARD_DEFAULT;
 
+    /* Only the key frames are needed: skip the others, and the costly
+     * parts of the decoding of the key frames */
+    if( p_dec->b_key_frames_only )
+    {
+        p_context->skip_frame = p_sys->i_skip_frame = AVDISCARD_NONKEY;
+        p_context->skip_idct = AVDISCARD_NONKEY;
+        p_context->skip_loop_filter = AVDISCARD_ALL;
+    }
+
     /* ***** libavcodec direct rendering ***** */
     p_sys->b_direct_rendering = false;
     p_sys->i_direct_rendering_used = -1;
@@ -403,7 +412,8 @@ int InitVideoDec( decoder_t *p_dec, AVCodecContext *p_context,
      * causes major image corruption. */
 # if defined(_WIN32)
     char *avcodec_hw = var_InheritString( p_dec, "avcodec-hw" );
-    if( avcodec_hw == NULL || strcasecmp( avcodec_hw, "none" ) )
+    if( !p_dec->b_software_only
+     && (avcodec_hw == NULL || strcasecmp( avcodec_hw, "none" )) )
     {
         msg_Warn( p_dec, "threaded frame decoding is not compatible with DXVA2, disabled" );
         p_context->thread_type &= ~FF_THREAD_FRAME;
@@ -1330,7 +1340,7 @@ static enum PixelFormat ffmpeg_GetFormat( AVCodecContext *p_context,
             can_hwaccel = true;
     }
 
-    if (!can_hwaccel)
+    if (!can_hwaccel || p_dec->b_software_only)
         goto end;
 
     /* Profile and level information is needed now.
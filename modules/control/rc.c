@@ -1734,6 +1734,29 @@ static int Statistics ( vlc_object_t *p_this, char const *psz_cmd,
     return VLC_SUCCESS;
 }
 
+static void updateHistogram( intf_thread_t *p_intf, const char *psz_name,
+                             const input_histogram_t *p_h )
+{
+    if( p_h->i_count == 0 )
+        return;
+
+    msg_rc( "| %-16s : %8"PRIu64" samples, avg %"PRId64", max %"PRId64,
+            psz_name, p_h->i_count, p_h->i_total / (int64_t)p_h->i_count,
+            p_h->i_max );
+
+    /* Power of two buckets, up to the last used one */
+    char psz_buckets[INPUT_HISTOGRAM_BUCKETS * 21 + 1];
+    size_t i_len = 0;
+    int i_last = INPUT_HISTOGRAM_BUCKETS - 1;
+    while( i_last > 0 && p_h->pi_buckets[i_last] == 0 )
+        i_last--;
+    psz_buckets[0] = '\0';
+    for( int i = 0; i <= i_last; i++ )
+        i_len += snprintf( psz_buckets + i_len, sizeof( psz_buckets ) - i_len,
+                           " %"PRIu64, p_h->pi_buckets[i] );
+    msg_rc( "| %-16s  log2 buckets:%s", "", psz_buckets );
+}
+
 static int updateStatistics( intf_thread_t *p_intf, input_item_t *p_item )
 {
     if( !p_item ) return VLC_EGENERIC;
@@ -1784,6 +1807,19 @@ static int updateStatistics( intf_thread_t *p_intf, input_item_t *p_item )
     msg_rc(_("| sending bitrate  :   %6.0f kb/s"),
             (float)(p_item->p_stats->f_send_bitrate*8)*1000 );
     msg_rc("|");
+    /* Elementary streams */
+    for( int i = 0; i < p_item->p_stats->i_es; i++ )
+    {
+        const input_es_stats_t *p_es = &p_item->p_stats->p_es[i];
+
+        msg_rc(_("+-[Elementary stream %d (%s)]"), p_es->i_id,
+               p_es->i_cat == VIDEO_ES ? _("video") : _("audio"));
+        updateHistogram( p_intf, _("decode time (us)"), &p_es->decode_time );
+        updateHistogram( p_intf, _("decoder queue"), &p_es->fifo_depth );
+        updateHistogram( p_intf, _("picture age (us)"), &p_es->picture_age );
+        updateHistogram( p_intf, _("audio drift (us)"), &p_es->audio_drift );
+        msg_rc("|");
+    }
     msg_rc( "+----[ end of statistical info ]" );
     vlc_mutex_unlock( &p_item->p_stats->lock );
     vlc_mutex_unlock( &p_item->lock );
@@ -118,6 +118,7 @@ struct demux_sys_t
 static void MP4_TrackCreate ( demux_t *, mp4_track_t *, MP4_Box_t  *, bool b_force_enable );
 static int MP4_frg_TrackCreate( demux_t *, mp4_track_t *, MP4_Box_t *);
 static void MP4_TrackDestroy(  mp4_track_t * );
+static int TrackLoadChunkTables( demux_t *, mp4_track_t *, uint32_t );
 
 static block_t * MP4_Block_Read( demux_t *, const mp4_track_t *, int );
 static void MP4_Block_Send( demux_t *, mp4_track_t *, block_t * );
@@ -238,13 +239,16 @@ static inline int64_t MP4_TrackGetDTS( demux_t *p_demux, mp4_track_t *p_track )
     if( p_sys->b_fragmented )
         p_chunk = p_track->cchunk;
     else
+    {
         p_chunk = &p_track->chunk[p_track->i_chunk];
+        TrackLoadChunkTables( p_demux, p_track, p_track->i_chunk );
+    }
 
     unsigned int i_index = 0;
     unsigned int i_sample = p_track->i_sample - p_chunk->i_sample_first;
     int64_t i_dts = p_chunk->i_first_dts;
 
-    while( i_sample > 0 )
+    while( i_sample > 0 && p_chunk->p_sample_count_dts )
     {
         if( i_sample > p_chunk->p_sample_count_dts[i_index] )
         {
@@ -292,7 +296,10 @@ static inline bool MP4_TrackGetPTSDelta( demux_t *p_demux, mp4_track_t *p_track,
     if( p_sys->b_fragmented )
         ck = p_track->cchunk;
     else
+    {
         ck = &p_track->chunk[p_track->i_chunk];
+        TrackLoadChunkTables( p_demux, p_track, p_track->i_chunk );
+    }
 
     unsigned int i_index = 0;
     unsigned int i_sample = p_track->i_sample - ck->i_sample_first;
@@ -1862,6 +1869,11 @@ static int TrackCreateChunksIndex( demux_t *p_demux,
     {
         return VLC_ENOMEM;
     }
+    memset( p_demux_track->pi_chunk_tables, 0,
+            sizeof( p_demux_track->pi_chunk_tables ) );
+    p_demux_track->i_chunk_tables_next = 0;
+    p_demux_track->p_stts = NULL;
+    p_demux_track->p_ctts = NULL;
 
     /* first we read chunk offset */
     for( i_chunk = 0; i_chunk < p_demux_track->i_chunk_count; i_chunk++ )
@@ -1973,6 +1985,129 @@ static int xTTS_CountEntries( demux_t *p_demux, uint32_t *pi_entry /* out */,
     return VLC_SUCCESS;
 }
 
+/* Gives the next run of at most i_sample_count samples sharing the same
+ * stts/ctts entry, and moves (*pi_index, *pi_index_samples_left) past it */
+static int xTTS_NextRun( demux_t *p_demux, uint32_t *pi_index,
+                         uint32_t *pi_index_samples_left,
+                         uint32_t i_sample_count,
+                         const uint32_t *pi_index_sample_count,
+                         const uint32_t i_table_count,
+                         uint32_t *pi_run /* out */ )
+{
+    if ( *pi_index >= i_table_count )
+    {
+        msg_Err( p_demux, "invalid index counting total samples %u %u",
+                 *pi_index, i_table_count );
+        return VLC_EGENERIC;
+    }
+
+    uint32_t i_left = *pi_index_samples_left ? *pi_index_samples_left
+                                             : pi_index_sample_count[*pi_index];
+    if ( i_left > i_sample_count )
+    {
+        *pi_run = i_sample_count;
+        *pi_index_samples_left = i_left - i_sample_count;
+    }
+    else
+    {
+        *pi_run = i_left;
+        *pi_index_samples_left = 0;
+        *pi_index += 1;
+    }
+
+    return VLC_SUCCESS;
+}
+
+static void TrackFreeChunkTables( mp4_chunk_t *ck )
+{
+    FREENULL( ck->p_sample_count_dts );
+    FREENULL( ck->p_sample_delta_dts );
+    FREENULL( ck->p_sample_count_pts );
+    FREENULL( ck->p_sample_offset_pts );
+}
+
+/* Expand the stts/ctts extract of a chunk, only the last
+ * MP4_CHUNK_TABLES_CACHE chunks used are kept */
+static int TrackLoadChunkTables( demux_t *p_demux, mp4_track_t *p_track,
+                                 uint32_t i_chunk )
+{
+    mp4_chunk_t *ck = &p_track->chunk[i_chunk];
+    uint32_t i_entry, i_index, i_left, i_sample_count;
+
+    if( ck->p_sample_count_dts != NULL )
+        return VLC_SUCCESS;
+
+    uint32_t *pi_slot = &p_track->pi_chunk_tables[p_track->i_chunk_tables_next];
+    if( *pi_slot )
+        TrackFreeChunkTables( &p_track->chunk[*pi_slot - 1] );
+    *pi_slot = 0;
+
+    const MP4_Box_data_stts_t *stts = p_track->p_stts->data.p_stts;
+
+    i_entry = 0;
+    if( xTTS_CountEntries( p_demux, &i_entry, ck->i_stts_index,
+                           ck->i_stts_left, ck->i_sample_count,
+                           stts->pi_sample_count, stts->i_entry_count ) )
+        return VLC_EGENERIC;
+
+    ck->p_sample_count_dts = calloc( __MAX( i_entry, 1 ), sizeof( uint32_t ) );
+    ck->p_sample_delta_dts = calloc( __MAX( i_entry, 1 ), sizeof( uint32_t ) );
+    if( !ck->p_sample_count_dts || !ck->p_sample_delta_dts )
+        goto error;
+
+    i_index = ck->i_stts_index;
+    i_left = ck->i_stts_left;
+    i_sample_count = ck->i_sample_count;
+    for( uint32_t i = 0; i < i_entry; i++ )
+    {
+        ck->p_sample_delta_dts[i] = stts->pi_sample_delta[i_index];
+        if( xTTS_NextRun( p_demux, &i_index, &i_left, i_sample_count,
+                          stts->pi_sample_count, stts->i_entry_count,
+                          &ck->p_sample_count_dts[i] ) )
+            goto error;
+        i_sample_count -= ck->p_sample_count_dts[i];
+    }
+
+    if( p_track->p_ctts )
+    {
+        const MP4_Box_data_ctts_t *ctts = p_track->p_ctts->data.p_ctts;
+
+        i_entry = 0;
+        if( xTTS_CountEntries( p_demux, &i_entry, ck->i_ctts_index,
+                               ck->i_ctts_left, ck->i_sample_count,
+                               ctts->pi_sample_count, ctts->i_entry_count ) )
+            goto error;
+
+        ck->p_sample_count_pts = calloc( __MAX( i_entry, 1 ), sizeof( uint32_t ) );
+        ck->p_sample_offset_pts = calloc( __MAX( i_entry, 1 ), sizeof( int32_t ) );
+        if( !ck->p_sample_count_pts || !ck->p_sample_offset_pts )
+            goto error;
+
+        i_index = ck->i_ctts_index;
+        i_left = ck->i_ctts_left;
+        i_sample_count = ck->i_sample_count;
+        for( uint32_t i = 0; i < i_entry; i++ )
+        {
+            ck->p_sample_offset_pts[i] = ctts->pi_sample_offset[i_index];
+            if( xTTS_NextRun( p_demux, &i_index, &i_left, i_sample_count,
+                              ctts->pi_sample_count, ctts->i_entry_count,
+                              &ck->p_sample_count_pts[i] ) )
+                goto error;
+            i_sample_count -= ck->p_sample_count_pts[i];
+        }
+    }
+
+    *pi_slot = i_chunk + 1;
+    p_track->i_chunk_tables_next = ( p_track->i_chunk_tables_next + 1 ) %
+                                   MP4_CHUNK_TABLES_CACHE;
+    return VLC_SUCCESS;
+
+error:
+    msg_Err( p_demux, "can't expand sample tables of chunk %"PRIu32, i_chunk );
+    TrackFreeChunkTables( ck );
+    return VLC_EGENERIC;
+}
+
 static int TrackCreateSamplesIndex( demux_t *p_demux,
                                     mp4_track_t *p_demux_track )
 {
@@ -2007,16 +2142,7 @@ static int TrackCreateSamplesIndex( demux_t *p_demux,
     {
         /* 2: each sample can have a different size */
         p_demux_track->i_sample_size = 0;
-        p_demux_track->p_sample_size =
-            calloc( p_demux_track->i_sample_count, sizeof( uint32_t ) );
-        if( p_demux_track->p_sample_size == NULL )
-            return VLC_ENOMEM;
-
-        for( uint32_t i_sample = 0; i_sample < p_demux_track->i_sample_count; i_sample++ )
-        {
-            p_demux_track->p_sample_size[i_sample] =
-                    stsz->i_entry_size[i_sample];
-        }
+        p_demux_track->p_sample_size = stsz->i_entry_size;
     }
 
     if ( p_demux_track->i_chunk_count )
@@ -2049,12 +2175,9 @@ static int TrackCreateSamplesIndex( demux_t *p_demux,
 
     /* Use stts table to create a sample number -> dts table.
      * XXX: if we don't want to waste too much memory, we can't expand
-     *  the box! so each chunk will contain an "extract" of this table
-     *  for fast research (problem with raw stream where a sample is sometime
-     *  just channels*bits_per_sample/8 */
-
-     /* FIXME: refactor STTS & CTTS, STTS having now only few extra lines and
-      *        differing in 2/2 fields and 1 signedness */
+     *  the box! so each chunk only records where it starts in the stts
+     *  and ctts tables, and its "extract" of them is built when the chunk
+     *  is read (see TrackLoadChunkTables) */
 
     mtime_t i_next_dts = 0;
     /* Find stts
@@ -2072,98 +2195,40 @@ static int TrackCreateSamplesIndex( demux_t *p_demux,
 
         msg_Warn( p_demux, "STTS table of %"PRIu32" entries", stts->i_entry_count );
 
-        /* Create sample -> dts table per chunk */
+        p_demux_track->p_stts = p_box;
+
+        /* Compute first/last dts and stts position of each chunk */
         uint32_t i_index = 0;
         uint32_t i_current_index_samples_left = 0;
 
         for( uint32_t i_chunk = 0; i_chunk < p_demux_track->i_chunk_count; i_chunk++ )
         {
             mp4_chunk_t *ck = &p_demux_track->chunk[i_chunk];
-            uint32_t i_entry, i_sample_count;
+            uint32_t i_sample_count = ck->i_sample_count;
 
             /* save first dts */
             ck->i_first_dts = i_next_dts;
             ck->i_last_dts  = i_next_dts;
+            ck->i_stts_index = i_index;
+            ck->i_stts_left  = i_current_index_samples_left;
 
-            /* count how many entries are needed for this chunk
-             * for p_sample_delta_dts and p_sample_count_dts */
-            i_entry = 0;
-
-            int i_ret = xTTS_CountEntries( p_demux, &i_entry, i_index,
-                                           i_current_index_samples_left,
-                                           ck->i_sample_count,
-                                           stts->pi_sample_count,
-                                           stts->i_entry_count );
-            if ( i_ret != VLC_SUCCESS )
-                return i_ret;
-
-            /* allocate them */
-            ck->p_sample_count_dts = calloc( i_entry, sizeof( uint32_t ) );
-            ck->p_sample_delta_dts = calloc( i_entry, sizeof( uint32_t ) );
-            if( !ck->p_sample_count_dts || !ck->p_sample_delta_dts )
+            while( i_sample_count > 0 )
             {
-                msg_Err( p_demux, "can't allocate memory for i_entry=%"PRIu32, i_entry );
-                return VLC_ENOMEM;
-            }
-
-            /* now copy */
-            i_sample_count = ck->i_sample_count;
+                uint32_t i_entry = i_index, i_run;
 
-            for( uint32_t i = 0; i < i_entry; i++ )
-            {
-                if ( i_current_index_samples_left )
-                {
-                    if ( i_current_index_samples_left > i_sample_count )
-                    {
-                        if ( i_sample_count ) ck->i_last_dts = i_next_dts;
-                        ck->p_sample_count_dts[i] = i_sample_count;
-                        ck->p_sample_delta_dts[i] = stts->pi_sample_delta[i_index];
-                        i_next_dts += ck->p_sample_count_dts[i] * stts->pi_sample_delta[i_index];
-                        i_current_index_samples_left -= i_sample_count;
-                        i_sample_count = 0;
-                        assert( i == i_entry - 1 );
-                        break;
-                    }
-                    else
-                    {
-                        if ( i_current_index_samples_left ) ck->i_last_dts = i_next_dts;
-                        ck->p_sample_count_dts[i] = i_current_index_samples_left;
-                        ck->p_sample_delta_dts[i] = stts->pi_sample_delta[i_index];
-                        i_next_dts += ck->p_sample_count_dts[i] * stts->pi_sample_delta[i_index];
-                        i_sample_count -= i_current_index_samples_left;
-                        i_current_index_samples_left = 0;
-                        i_index++;
-                    }
-                }
-                else
-                {
-                    if ( stts->pi_sample_count[i_index] > i_sample_count )
-                    {
-                        if ( i_sample_count ) ck->i_last_dts = i_next_dts;
-                        ck->p_sample_count_dts[i] = i_sample_count;
-                        ck->p_sample_delta_dts[i] = stts->pi_sample_delta[i_index];
-                        i_next_dts += ck->p_sample_count_dts[i] * stts->pi_sample_delta[i_index];
-                        i_current_index_samples_left = stts->pi_sample_count[i_index] - i_sample_count;
-                        i_sample_count = 0;
-                        assert( i == i_entry - 1 );
-                        // keep building from same index
-                    }
-                    else
-                    {
-                        if ( stts->pi_sample_count[i_index] ) ck->i_last_dts = i_next_dts;
-                        ck->p_sample_count_dts[i] = stts->pi_sample_count[i_index];
-                        ck->p_sample_delta_dts[i] = stts->pi_sample_delta[i_index];
-                        i_next_dts += ck->p_sample_count_dts[i] * stts->pi_sample_delta[i_index];
-                        i_sample_count -= stts->pi_sample_count[i_index];
-                        i_index++;
-                    }
-                }
+                if( xTTS_NextRun( p_demux, &i_index,
+                                  &i_current_index_samples_left,
+                                  i_sample_count, stts->pi_sample_count,
+                                  stts->i_entry_count, &i_run ) )
+                    return VLC_EGENERIC;
 
+                if ( i_run ) ck->i_last_dts = i_next_dts;
+                i_next_dts += i_run * stts->pi_sample_delta[i_entry];
+                i_sample_count -= i_run;
             }
         }
     }
 
-
     /* Find ctts
      *  Gives the delta between decoding time (dts) and composition table (pts)
      */
@@ -2174,81 +2239,31 @@ static int TrackCreateSamplesIndex( demux_t *p_demux,
 
         msg_Warn( p_demux, "CTTS table of %"PRIu32" entries", ctts->i_entry_count );
 
-        /* Create pts-dts table per chunk */
+        p_demux_track->p_ctts = p_box;
+
+        /* Compute ctts position of each chunk */
         uint32_t i_index = 0;
         uint32_t i_current_index_samples_left = 0;
 
         for( uint32_t i_chunk = 0; i_chunk < p_demux_track->i_chunk_count; i_chunk++ )
         {
             mp4_chunk_t *ck = &p_demux_track->chunk[i_chunk];
-            uint32_t i_entry, i_sample_count;
-
-            /* count how many entries are needed for this chunk
-             * for p_sample_offset_pts and p_sample_count_pts */
-            i_entry = 0;
-            int i_ret = xTTS_CountEntries( p_demux, &i_entry, i_index,
-                                           i_current_index_samples_left,
-                                           ck->i_sample_count,
-                                           ctts->pi_sample_count,
-                                           ctts->i_entry_count );
-            if ( i_ret != VLC_SUCCESS )
-                return i_ret;
-
-            /* allocate them */
-            ck->p_sample_count_pts = calloc( i_entry, sizeof( uint32_t ) );
-            ck->p_sample_offset_pts = calloc( i_entry, sizeof( int32_t ) );
-            if( !ck->p_sample_count_pts || !ck->p_sample_offset_pts )
-            {
-                msg_Err( p_demux, "can't allocate memory for i_entry=%"PRIu32, i_entry );
-                return VLC_ENOMEM;
-            }
+            uint32_t i_sample_count = ck->i_sample_count;
 
-            /* now copy */
-            i_sample_count = ck->i_sample_count;
+            ck->i_ctts_index = i_index;
+            ck->i_ctts_left  = i_current_index_samples_left;
 
-            for( uint32_t i = 0; i < i_entry; i++ )
+            while( i_sample_count > 0 )
             {
-                if ( i_current_index_samples_left )
-                {
-                    if ( i_current_index_samples_left > i_sample_count )
-                    {
-                        ck->p_sample_count_pts[i] = i_sample_count;
-                        ck->p_sample_offset_pts[i] = ctts->pi_sample_offset[i_index];
-                        i_current_index_samples_left -= i_sample_count;
-                        i_sample_count = 0;
-                        assert( i == i_entry - 1 );
-                        break;
-                    }
-                    else
-                    {
-                        ck->p_sample_count_pts[i] = i_current_index_samples_left;
-                        ck->p_sample_offset_pts[i] = ctts->pi_sample_offset[i_index];
-                        i_sample_count -= i_current_index_samples_left;
-                        i_current_index_samples_left = 0;
-                        i_index++;
-                    }
-                }
-                else
-                {
-                    if ( ctts->pi_sample_count[i_index] > i_sample_count )
-                    {
-                        ck->p_sample_count_pts[i] = i_sample_count;
-                        ck->p_sample_offset_pts[i] = ctts->pi_sample_offset[i_index];
-                        i_current_index_samples_left = ctts->pi_sample_count[i_index] - i_sample_count;
-                        i_sample_count = 0;
-                        assert( i == i_entry - 1 );
-                        // keep building from same index
-                    }
-                    else
-                    {
-                        ck->p_sample_count_pts[i] = ctts->pi_sample_count[i_index];
-                        ck->p_sample_offset_pts[i] = ctts->pi_sample_offset[i_index];
-                        i_sample_count -= ctts->pi_sample_count[i_index];
-                        i_index++;
-                    }
-                }
+                uint32_t i_run;
 
+                if( xTTS_NextRun( p_demux, &i_index,
+                                  &i_current_index_samples_left,
+                                  i_sample_count, ctts->pi_sample_count,
+                                  ctts->i_entry_count, &i_run ) )
+                    return VLC_EGENERIC;
 
+                i_sample_count -= i_run;
             }
         }
     }
@@ -2459,49 +2474,47 @@ static int TrackTimeToSampleChunk( demux_t *p_demux, mp4_track_t *p_track,
         i_start = i_start * p_track->i_timescale / CLOCK_FREQ;
     }
 
-    /* we start from sample 0/chunk 0, hope it won't take too much time */
-    /* *** find good chunk *** */
-    for( i_chunk = 0; ; i_chunk++ )
+    /* *** find good chunk ***
+     * the last one starting before i_start, chunks are in dts order */
+    uint32_t i_low = 0, i_high = p_track->i_chunk_count;
+    while( i_high - i_low > 1 )
     {
-        if( i_chunk + 1 >= p_track->i_chunk_count )
-        {
-            /* at the end and can't check if i_start in this chunk,
-               it will be check while searching i_sample */
-            i_chunk = p_track->i_chunk_count - 1;
-            break;
-        }
-
-        if( (uint64_t)i_start >= p_track->chunk[i_chunk].i_first_dts &&
-            (uint64_t)i_start <  p_track->chunk[i_chunk + 1].i_first_dts )
-        {
-            break;
-        }
+        uint32_t i_mid = i_low + ( i_high - i_low ) / 2;
+        if( p_track->chunk[i_mid].i_first_dts <= (uint64_t)i_start )
+            i_low = i_mid;
+        else
+            i_high = i_mid;
     }
+    i_chunk = i_low;
 
     /* *** find sample in the chunk *** */
-    i_sample = p_track->chunk[i_chunk].i_sample_first;
-    i_dts    = p_track->chunk[i_chunk].i_first_dts;
-    for( i_index = 0; i_sample < p_track->chunk[i_chunk].i_sample_count; )
+    const mp4_chunk_t *ck = &p_track->chunk[i_chunk];
+    if( TrackLoadChunkTables( p_demux, p_track, i_chunk ) )
+        return VLC_EGENERIC;
+
+    i_sample = ck->i_sample_first;
+    i_dts    = ck->i_first_dts;
+    for( i_index = 0; i_sample < ck->i_sample_first + ck->i_sample_count; )
     {
         if( i_dts +
-            p_track->chunk[i_chunk].p_sample_count_dts[i_index] *
-            p_track->chunk[i_chunk].p_sample_delta_dts[i_index] < (uint64_t)i_start )
+            ck->p_sample_count_dts[i_index] *
+            ck->p_sample_delta_dts[i_index] < (uint64_t)i_start )
         {
             i_dts    +=
-                p_track->chunk[i_chunk].p_sample_count_dts[i_index] *
-                p_track->chunk[i_chunk].p_sample_delta_dts[i_index];
+                ck->p_sample_count_dts[i_index] *
+                ck->p_sample_delta_dts[i_index];
 
-            i_sample += p_track->chunk[i_chunk].p_sample_count_dts[i_index];
+            i_sample += ck->p_sample_count_dts[i_index];
             i_index++;
         }
         else
         {
-            if( p_track->chunk[i_chunk].p_sample_delta_dts[i_index] <= 0 )
+            if( ck->p_sample_delta_dts[i_index] <= 0 )
             {
                 break;
             }
             i_sample += ( i_start - i_dts ) /
-                p_track->chunk[i_chunk].p_sample_delta_dts[i_index];
+                ck->p_sample_delta_dts[i_index];
             break;
         }
     }
@@ -2905,13 +2918,7 @@ static void MP4_TrackDestroy( mp4_track_t *p_track )
     for( i_chunk = 0; i_chunk < p_track->i_chunk_count; i_chunk++ )
     {
         if( p_track->chunk )
-        {
-           FREENULL(p_track->chunk[i_chunk].p_sample_count_dts);
-           FREENULL(p_track->chunk[i_chunk].p_sample_delta_dts );
-
-           FREENULL(p_track->chunk[i_chunk].p_sample_count_pts);
-           FREENULL(p_track->chunk[i_chunk].p_sample_offset_pts );
-        }
+            TrackFreeChunkTables( &p_track->chunk[i_chunk] );
     }
     FREENULL( p_track->chunk );
     if( p_track->cchunk ) {
@@ -2919,10 +2926,7 @@ static void MP4_TrackDestroy( mp4_track_t *p_track )
         FREENULL( p_track->cchunk );
     }
 
-    if( !p_track->i_sample_size )
-    {
-        FREENULL( p_track->p_sample_size );
-    }
+    p_track->p_sample_size = NULL;
 
     if ( p_track->asfinfo.p_frame )
         block_ChainRelease( p_track->asfinfo.p_frame );
@@ -4657,6 +4661,8 @@ static int LeafParseMDATwithMOOV( demux_t *p_demux )
         /**/
 
         mp4_chunk_t *p_chunk = &p_track->chunk[i_chunk];
+        if( TrackLoadChunkTables( p_demux, p_track, i_chunk ) )
+            goto error;
 
         uint32_t i_nb_samples_at_chunk_start = p_chunk->i_sample_first;
         uint32_t i_nb_samples_in_chunk = p_chunk->i_sample_count;
@@ -33,6 +33,9 @@
 #include "libmp4.h"
 #include "../asf/asfpacket.h"
 
+/* Number of chunks per track whose dts/pts tables are kept expanded */
+#define MP4_CHUNK_TABLES_CACHE 4
+
 /* Contain all information about a chunk */
 typedef struct
 {
@@ -48,6 +51,12 @@ typedef struct
     /* with this we can calculate dts/pts without waste memory */
     uint64_t     i_first_dts;   /* DTS of the first sample */
     uint64_t     i_last_dts;    /* DTS of the last sample */
+    /* stts/ctts entry and samples left in it at the chunk start, the tables
+     * below are only expanded from there when the chunk is being read */
+    uint32_t     i_stts_index;
+    uint32_t     i_stts_left;
+    uint32_t     i_ctts_index;
+    uint32_t     i_ctts_left;
     uint32_t     *p_sample_count_dts;
     uint32_t     *p_sample_delta_dts;   /* dts delta */
 
@@ -105,11 +114,18 @@ typedef struct
     mp4_chunk_t    *chunk; /* always defined  for each chunk */
     mp4_chunk_t    *cchunk; /* current chunk if b_fragmented is true */
 
+    MP4_Box_t      *p_stts;
+    MP4_Box_t      *p_ctts; /* could be NULL */
+    /* chunks with expanded dts/pts tables (index + 1, 0 if unused) */
+    uint32_t        pi_chunk_tables[MP4_CHUNK_TABLES_CACHE];
+    unsigned        i_chunk_tables_next;
+
     /* sample size, p_sample_size defined only if i_sample_size == 0
         else i_sample_size is size for all sample */
     uint32_t         i_sample_size;
-    uint32_t         *p_sample_size; /* XXX perhaps add file offset if take
-                                    too much time to do sumations each time*/
+    uint32_t         *p_sample_size; /* points to the stsz table, XXX perhaps
+                        add file offset if take too much time to do sumations
+                        each time*/
 
     uint32_t     i_sample_first; /* i_sample_first value
                                                    of the next chunk */
@@ -340,6 +340,9 @@ typedef struct
 #define FROM_SCALE(x) (VLC_TS_0 + ((x) * 100 / 9))
 #define TO_SCALE(x)   (((x) - VLC_TS_0) * 9 / 100)
 
+/* Number of packets descrambled at once */
+#define CSA_BATCH_PACKETS 128
+
 struct demux_sys_t
 {
     stream_t   *stream;
@@ -388,6 +391,12 @@ struct demux_sys_t
     bool        b_es_id_pid;
     csa_t       *csa;
     int         i_csa_pkt_size;
+    struct
+    {
+        uint8_t *p_data;  /* copy of i_count packets descrambled ahead */
+        int64_t  i_pos;   /* stream offset of the first packet */
+        int      i_count;
+    } csa_batch;
     bool        b_split_es;
 
     bool        b_trust_pcr;
@@ -1146,6 +1155,8 @@ static int Open( vlc_object_t *p_this )
             else
                 p_sys->i_csa_pkt_size = i_pkt;
             msg_Dbg( p_demux, "decrypting %d bytes of packet", p_sys->i_csa_pkt_size );
+
+            p_sys->csa_batch.p_data = malloc( CSA_BATCH_PACKETS * i_packet_size );
         }
         free( psz_csa2 );
     }
@@ -1241,6 +1252,7 @@ static void Close( vlc_object_t *p_this )
         var_DelCallback( p_demux, "ts-csa-ck", ChangeKeyCallback, NULL );
         var_DelCallback( p_demux, "ts-csa2-ck", ChangeKeyCallback, NULL );
         csa_Delete( p_sys->csa );
+        free( p_sys->csa_batch.p_data );
     }
     vlc_mutex_unlock( &p_sys->csa_lock );
 
@@ -1280,6 +1292,8 @@ static int ChangeKeyCallback( vlc_object_t *p_this, char const *psz_cmd,
         i_tmp = csa_SetCW( p_this, p_sys->csa, newval.psz_string, true );
     else
         i_tmp = csa_SetCW( p_this, p_sys->csa, newval.psz_string, false );
+    /* packets descrambled ahead used the previous key */
+    p_sys->csa_batch.i_count = 0;
 
     vlc_mutex_unlock( &p_sys->csa_lock );
     return i_tmp;
@@ -2497,11 +2511,85 @@ static void ParseData( demux_t *p_demux, ts_pid_t *pid )
     }
 }
 
+static bool CSAIsWanted( demux_sys_t *p_sys, const uint8_t *p )
+{
+    /* Only scrambled packets that GatherData() will see */
+    const ts_pid_t *pid = &p_sys->pid[((p[1]&0x1f)<<8)|p[2]];
+    return (p[3]&0x80) && pid->b_valid && !pid->psi;
+}
+
+/**
+ * Descrambles a packet read at i_pos, along with the following packets
+ * which are kept aside until they are read, so that the CSA engine
+ * always works on batches.
+ */
+static void CSADescramble( demux_t *p_demux, block_t *p_pkt, int64_t i_pos )
+{
+    demux_sys_t *p_sys = p_demux->p_sys;
+    const int i_size = p_sys->i_packet_size;
+
+    if( !CSAIsWanted( p_sys, p_pkt->p_buffer ) )
+        return;
+
+    vlc_mutex_lock( &p_sys->csa_lock );
+    const int64_t i_offset = i_pos - p_sys->csa_batch.i_pos;
+    if( i_offset >= 0 && i_offset % i_size == 0 &&
+        i_offset / i_size < p_sys->csa_batch.i_count )
+    {
+        /* descrambled ahead (or left untouched if unwanted at that time,
+         * in which case GatherData() will descramble it) */
+        memcpy( p_pkt->p_buffer, &p_sys->csa_batch.p_data[i_offset] +
+                p_sys->i_packet_header_size,
+                p_pkt->i_buffer );
+        vlc_mutex_unlock( &p_sys->csa_lock );
+        return;
+    }
+
+    /* On live inputs, only take the packets that already arrived, as
+     * peeking further would block until the whole batch is received */
+    int i_ahead = CSA_BATCH_PACKETS;
+    if( !p_sys->b_canfastseek )
+    {
+        uint64_t i_buffered;
+        if( stream_Control( p_sys->stream, STREAM_GET_BUFFERED_SIZE,
+                            &i_buffered ) )
+            i_buffered = 0;
+        i_ahead = __MIN( i_buffered / i_size, CSA_BATCH_PACKETS );
+    }
+
+    const uint8_t *p_peek;
+    uint8_t *pp_pkt[CSA_BATCH_PACKETS + 1];
+    int i_pkt = 0;
+    int i_count = 0;
+    if( i_ahead > 0 )
+    {
+        int i_peek = stream_Peek( p_sys->stream, &p_peek, i_ahead * i_size );
+        i_count = __MAX( i_peek, 0 ) / i_size;
+    }
+
+    if( i_count > 0 )
+        memcpy( p_sys->csa_batch.p_data, p_peek, i_count * i_size );
+    p_sys->csa_batch.i_pos = i_pos + i_size;
+    p_sys->csa_batch.i_count = i_count;
+
+    pp_pkt[i_pkt++] = p_pkt->p_buffer;
+    for( int i = 0; i < i_count; i++ )
+    {
+        uint8_t *p = &p_sys->csa_batch.p_data[i * i_size +
+                                              p_sys->i_packet_header_size];
+        if( p[0] == 0x47 && CSAIsWanted( p_sys, p ) )
+            pp_pkt[i_pkt++] = p;
+    }
+    csa_DecryptBatch( p_sys->csa, pp_pkt, i_pkt, p_sys->i_csa_pkt_size );
+    vlc_mutex_unlock( &p_sys->csa_lock );
+}
+
 static block_t* ReadTSPacket( demux_t *p_demux )
 {
     demux_sys_t *p_sys = p_demux->p_sys;
 
     block_t     *p_pkt;
+    const int64_t i_pos = stream_Tell( p_sys->stream );
 
     /* Get a new TS packet */
     if( !( p_pkt = stream_Block( p_sys->stream, p_sys->i_packet_size ) ) )
@@ -2567,6 +2655,8 @@ static block_t* ReadTSPacket( demux_t *p_demux )
             return NULL;
         }
     }
+    else if( p_sys->csa && p_sys->csa_batch.p_data )
+        CSADescramble( p_demux, p_pkt, i_pos );
     return p_pkt;
 }
 
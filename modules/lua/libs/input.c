@@ -172,6 +172,24 @@ static int vlclua_input_metas_internal( lua_State *L, input_item_t *p_item )
     return 1;
 }
 
+static void vlclua_push_histogram( lua_State *L, const input_histogram_t *p_h )
+{
+    lua_newtable( L );
+    lua_pushinteger( L, p_h->i_count );
+    lua_setfield( L, -2, "count" );
+    lua_pushinteger( L, p_h->i_total );
+    lua_setfield( L, -2, "total" );
+    lua_pushinteger( L, p_h->i_max );
+    lua_setfield( L, -2, "max" );
+    lua_newtable( L );
+    for( int i = 0; i < INPUT_HISTOGRAM_BUCKETS; i++ )
+    {
+        lua_pushinteger( L, p_h->pi_buckets[i] );
+        lua_rawseti( L, -2, i + 1 );
+    }
+    lua_setfield( L, -2, "buckets" );
+}
+
 static int vlclua_input_item_stats( lua_State *L )
 {
     input_item_t *p_item = vlclua_input_item_get_internal( L );
@@ -204,6 +222,29 @@ static int vlclua_input_item_stats( lua_State *L )
         STATS_INT( lost_abuffers )
 #undef STATS_INT
 #undef STATS_FLOAT
+
+        lua_newtable( L );
+        for( int i = 0; i < p_item->p_stats->i_es; i++ )
+        {
+            const input_es_stats_t *p_es = &p_item->p_stats->p_es[i];
+
+            lua_newtable( L );
+            lua_pushinteger( L, p_es->i_id );
+            lua_setfield( L, -2, "id" );
+            lua_pushstring( L, p_es->i_cat == VIDEO_ES ? "video" :
+                               p_es->i_cat == AUDIO_ES ? "audio" : "unknown" );
+            lua_setfield( L, -2, "type" );
+            vlclua_push_histogram( L, &p_es->decode_time );
+            lua_setfield( L, -2, "decode_time" );
+            vlclua_push_histogram( L, &p_es->fifo_depth );
+            lua_setfield( L, -2, "fifo_depth" );
+            vlclua_push_histogram( L, &p_es->picture_age );
+            lua_setfield( L, -2, "picture_age" );
+            vlclua_push_histogram( L, &p_es->audio_drift );
+            lua_setfield( L, -2, "audio_drift" );
+            lua_rawseti( L, -2, i + 1 );
+        }
+        lua_setfield( L, -2, "es" );
         vlc_mutex_unlock( &p_item->p_stats->lock );
     }
     return 1;
@@ -54,6 +54,12 @@
     "Create \"Fast Start\" files. " \
     "\"Fast Start\" files are optimized for downloads and allow the user " \
     "to start previewing the file while it is downloading.")
+#define RESERVE_TEXT N_("Reserved header space (KiB)")
+#define RESERVE_LONGTEXT N_(\
+    "Space reserved ahead of the media data for the \"Fast Start\" " \
+    "header, so that it can be written in place when the file is closed. " \
+    "If the header does not fit, the media data is moved as usual. " \
+    "0 disables the reservation.")
 
 static int  Open   (vlc_object_t *);
 static void Close  (vlc_object_t *);
@@ -71,6 +77,8 @@ vlc_module_begin ()
     add_bool(SOUT_CFG_PREFIX "faststart", true,
               FASTSTART_TEXT, FASTSTART_LONGTEXT,
               true)
+    add_integer_with_range(SOUT_CFG_PREFIX "moov-reserve", 0, 0, 1048576,
+                           RESERVE_TEXT, RESERVE_LONGTEXT, true)
     set_capability("sout mux", 5)
     add_shortcut("mp4", "mov", "3gp")
     set_callbacks(Open, Close)
@@ -90,7 +98,7 @@ vlc_module_end ()
  * Exported prototypes
  *****************************************************************************/
 static const char *const ppsz_sout_options[] = {
-    "faststart", NULL
+    "faststart", "moov-reserve", NULL
 };
 
 static int Control(sout_mux_t *, int, va_list);
@@ -193,6 +201,10 @@ struct sout_mux_sys_t
     uint64_t i_pos;
     mtime_t  i_read_duration;
 
+    /* space reserved for the moov (fast start files) */
+    uint64_t i_reserve_pos;
+    uint64_t i_reserve_size;
+
     unsigned int   i_nb_streams;
     mp4_stream_t **pp_streams;
 
@@ -244,6 +256,8 @@ static int Open(vlc_object_t *p_this)
     p_sys->b_3gp        = p_mux->psz_mux && !strcmp(p_mux->psz_mux, "3gp");
     p_sys->i_read_duration   = 0;
     p_sys->b_fragmented = false;
+    p_sys->b_fast_start = var_GetBool(p_this, SOUT_CFG_PREFIX "faststart");
+    p_sys->i_reserve_size = 0;
 
     if (!p_sys->b_mov) {
         /* Now add ftyp header */
@@ -266,6 +280,25 @@ static int Open(vlc_object_t *p_this)
         box_send(p_mux, box);
     }
 
+    /* Leave room for the moov, so that it does not need to be inserted
+     * in front of the data when closing */
+    p_sys->i_reserve_pos = p_sys->i_pos;
+    if (p_sys->b_fast_start) {
+        uint64_t i_reserve =
+            1024 * var_GetInteger(p_this, SOUT_CFG_PREFIX "moov-reserve");
+        block_t *p_free = i_reserve > 0 ? block_Alloc(i_reserve) : NULL;
+        if (p_free) {
+            memset(p_free->p_buffer, 0, i_reserve);
+            SetDWBE(p_free->p_buffer, i_reserve);
+            memcpy(&p_free->p_buffer[4], "free", 4);
+            sout_AccessOutWrite(p_mux->p_access, p_free);
+
+            p_sys->i_reserve_size = i_reserve;
+            p_sys->i_pos += i_reserve;
+            p_sys->i_mdat_pos = p_sys->i_pos;
+        }
+    }
+
     /* FIXME FIXME
      * Quicktime actually doesn't like the 64 bits extensions !!! */
     p_sys->b_64_ext = false;
@@ -281,6 +314,73 @@ static int Open(vlc_object_t *p_this)
     return VLC_SUCCESS;
 }
 
+/*****************************************************************************
+ * MoveData: shift the data further in the file (fast start)
+ *****************************************************************************/
+#define MP4_MOVE_CHUNK (4 * 1024 * 1024)
+
+static int ReadAt(sout_access_out_t *p_access, block_t *p_buf, uint64_t i_pos)
+{
+    uint8_t *p_data = p_buf->p_buffer;
+    size_t   i_data = p_buf->i_buffer;
+    int      i_ret  = VLC_SUCCESS;
+
+    sout_AccessOutSeek(p_access, i_pos);
+    while (p_buf->i_buffer > 0) {
+        ssize_t i_read = sout_AccessOutRead(p_access, p_buf);
+        if (i_read <= 0) {
+            i_ret = VLC_EGENERIC;
+            break;
+        }
+        p_buf->p_buffer += i_read;
+        p_buf->i_buffer -= i_read;
+    }
+    p_buf->p_buffer = p_data;
+    p_buf->i_buffer = i_data;
+    return i_ret;
+}
+
+/* Data is moved front to back with large chunks: each chunk is written
+ * back only once the following one has been read, so reads and writes
+ * both progress sequentially. The chunk size must be at least the shift
+ * for the write not to overwrite unread data. */
+static int MoveData(sout_mux_t *p_mux, uint64_t i_pos, uint64_t i_size,
+                    uint64_t i_shift)
+{
+    const size_t i_chunk = __MAX(MP4_MOVE_CHUNK, i_shift);
+    block_t *p_cur = NULL;
+    uint64_t i_cur_pos = i_pos;
+
+    for (uint64_t i_offset = 0;;) {
+        block_t *p_next = NULL;
+        if (i_offset < i_size) {
+            p_next = block_Alloc(__MIN(i_chunk, i_size - i_offset));
+            if (!p_next || ReadAt(p_mux->p_access, p_next,
+                                  i_pos + i_offset) != VLC_SUCCESS) {
+                if (p_next)
+                    block_Release(p_next);
+                if (p_cur)
+                    block_Release(p_cur);
+                if (i_cur_pos > i_pos) /* some data was already moved */
+                    msg_Err(p_mux, "cannot move data, file is corrupted");
+                return VLC_EGENERIC;
+            }
+        }
+
+        if (p_cur) {
+            sout_AccessOutSeek(p_mux->p_access, i_cur_pos + i_shift);
+            sout_AccessOutWrite(p_mux->p_access, p_cur);
+        }
+        if (!p_next)
+            break;
+
+        p_cur = p_next;
+        i_cur_pos = i_pos + i_offset;
+        i_offset += p_next->i_buffer;
+    }
+    return VLC_SUCCESS;
+}
+
 /*****************************************************************************
  * Close:
  *****************************************************************************/
@@ -312,67 +412,71 @@ static void Close(vlc_object_t *p_this)
 
     /* Create MOOV header */
     uint64_t i_moov_pos = p_sys->i_pos;
+    uint64_t i_skip = 0;
     bo_t *moov = GetMoovBox(p_mux);
 
     /* Check we need to create "fast start" files */
-    p_sys->b_fast_start = var_GetBool(p_this, SOUT_CFG_PREFIX "faststart");
-    while (p_sys->b_fast_start) {
-        /* Move data to the end of the file so we can fit the moov header
-         * at the start */
-        int64_t i_size = p_sys->i_pos - p_sys->i_mdat_pos;
-        int i_moov_size = moov->len;
-
-        while (i_size > 0) {
-            int64_t i_chunk = __MIN(32768, i_size);
-            block_t *p_buf = block_Alloc(i_chunk);
-            sout_AccessOutSeek(p_mux->p_access,
-                                p_sys->i_mdat_pos + i_size - i_chunk);
-            if (sout_AccessOutRead(p_mux->p_access, p_buf) < i_chunk) {
-                msg_Warn(p_this, "read() not supported by access output, "
-                          "won't create a fast start file");
-                p_sys->b_fast_start = false;
-                block_Release(p_buf);
-                break;
-            }
-            sout_AccessOutSeek(p_mux->p_access, p_sys->i_mdat_pos + i_size +
-                                i_moov_size - i_chunk);
-            sout_AccessOutWrite(p_mux->p_access, p_buf);
-            i_size -= i_chunk;
+    if (p_sys->b_fast_start) {
+        /* Move the data further if the moov does not fit in the reserved
+         * space, keeping at least a free box header for any remainder */
+        uint64_t i_shift = 0;
+        if (moov->len > p_sys->i_reserve_size)
+            i_shift = moov->len - p_sys->i_reserve_size;
+        uint64_t i_free = p_sys->i_reserve_size + i_shift - moov->len;
+        if (i_free > 0 && i_free < 8) {
+            i_shift += 8 - i_free;
+            i_free = 8;
         }
 
-        if (!p_sys->b_fast_start)
-            break;
-
-        /* Fix-up samples to chunks table in MOOV header */
-        for (unsigned int i_trak = 0; i_trak < p_sys->i_nb_streams; i_trak++) {
-            mp4_stream_t *p_stream = p_sys->pp_streams[i_trak];
-
-            moov->len = p_stream->i_stco_pos;
-            for (unsigned i = 0; i < p_stream->i_entry_count; ) {
-                mp4_entry_t *entry = p_stream->entry;
-                if (p_stream->b_stco64)
-                    bo_add_64be(moov, entry[i].i_pos + i_moov_size);
-                else
-                    bo_add_32be(moov, entry[i].i_pos + i_moov_size);
-
-                for (; i < p_stream->i_entry_count; i++)
-                    if (i >= p_stream->i_entry_count - 1 ||
-                        entry[i].i_pos + entry[i].i_size != entry[i+1].i_pos) {
-                        i++;
-                        break;
-                    }
+        if (i_shift > 0 && MoveData(p_mux, p_sys->i_mdat_pos,
+                                    p_sys->i_pos - p_sys->i_mdat_pos,
+                                    i_shift) != VLC_SUCCESS) {
+            /* The reserved space, if any, remains as a free box */
+            msg_Warn(p_this, "read() not supported by access output, "
+                      "won't create a fast start file");
+        } else {
+            /* Fix-up samples to chunks table in MOOV header */
+            int i_moov_size = moov->len;
+            for (unsigned int i_trak = 0; i_shift > 0 &&
+                                          i_trak < p_sys->i_nb_streams; i_trak++) {
+                mp4_stream_t *p_stream = p_sys->pp_streams[i_trak];
+
+                moov->len = p_stream->i_stco_pos;
+                for (unsigned i = 0; i < p_stream->i_entry_count; ) {
+                    mp4_entry_t *entry = p_stream->entry;
+                    if (p_stream->b_stco64)
+                        bo_add_64be(moov, entry[i].i_pos + i_shift);
+                    else
+                        bo_add_32be(moov, entry[i].i_pos + i_shift);
+
+                    for (; i < p_stream->i_entry_count; i++)
+                        if (i >= p_stream->i_entry_count - 1 ||
+                            entry[i].i_pos + entry[i].i_size != entry[i+1].i_pos) {
+                            i++;
+                            break;
+                        }
+                }
             }
-        }
+            moov->len = i_moov_size;
 
-        moov->len = i_moov_size;
-        i_moov_pos = p_sys->i_mdat_pos;
-        p_sys->b_fast_start = false;
+            msg_Dbg(p_mux, "moov of %d bytes written %s", i_moov_size,
+                    i_shift > 0 ? "after moving the data" : "in place");
+            i_moov_pos = p_sys->i_reserve_pos;
+            i_skip = i_free;
+        }
     }
 
     /* Write MOOV header */
     sout_AccessOutSeek(p_mux->p_access, i_moov_pos);
     box_send(p_mux, moov);
 
+    /* Skip the remainder of the reserved space */
+    if (i_skip > 0) {
+        bo_t *skip = box_new("free");
+        bo_swap_32be(skip, 0, i_skip);
+        box_send(p_mux, skip);
+    }
+
     /* Clean-up */
     for (unsigned int i_trak = 0; i_trak < p_sys->i_nb_streams; i_trak++) {
         mp4_stream_t *p_stream = p_sys->pp_streams[i_trak];
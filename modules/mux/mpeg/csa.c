@@ -26,10 +26,16 @@
 # include "config.h"
 #endif
 
+#include <assert.h>
+
 #include <vlc_common.h>
+#include <vlc_cpu.h>
 
 #include "csa.h"
 
+/* Largest payload, in bytes, of key stream needed for one packet */
+#define CSA_STREAM_MAX ((188 - 4) / 8 * 8)
+
 struct csa_t
 {
     /* odd and even keys */
@@ -47,6 +53,9 @@ struct csa_t
     int     p, q, r;
 
     bool    use_odd;
+
+    /* key stream of batched packets, CSA_BATCH_MAX * CSA_STREAM_MAX bytes */
+    uint8_t *p_stream;
 };
 
 static void csa_ComputeKey( uint8_t kk[57], uint8_t ck[8] );
@@ -54,6 +63,8 @@ static void csa_ComputeKey( uint8_t kk[57], uint8_t ck[8] );
 static void csa_StreamCypher( csa_t *c, int b_init, uint8_t *ck, uint8_t *sb, uint8_t *cb );
 
 static void csa_BlockDecypher( uint8_t kk[57], uint8_t ib[8], uint8_t bd[8] );
+static void csa_BlockDecypherBlocks( const uint8_t kk[57], uint8_t *p_blocks,
+                                     int n );
 static void csa_BlockCypher( uint8_t kk[57], uint8_t bd[8], uint8_t ib[8] );
 
 /*****************************************************************************
@@ -69,6 +80,7 @@ csa_t *csa_New( void )
  *****************************************************************************/
 void csa_Delete( csa_t *c )
 {
+    free( c->p_stream );
     free( c );
 }
 
@@ -307,6 +319,215 @@ void csa_Encrypt( csa_t *c, uint8_t *pkt, int i_pkt_size )
     }
 }
 
+/*****************************************************************************
+ * Batch processing
+ *****************************************************************************
+ * The stream cypher is run bitsliced for many packets at once: each packet
+ * is a bit lane of a machine (or vector) word. The block cypher is still
+ * run one packet at a time as its 8-bit s-box does not bitslice cheaply.
+ *****************************************************************************/
+typedef struct
+{
+    uint8_t *pkt;
+    int      i_hdr;
+    int      n;
+    int      i_residue;
+} csa_lane_t;
+
+static void csa_StreamCypherLanes( csa_t *, const uint8_t ck[8],
+                                   const csa_lane_t *, int i_lanes,
+                                   int i_stream );
+
+/* Below this many packets, the scalar cypher is faster */
+#define CSA_BATCH_MIN 4
+
+static bool csa_PrepareLane( csa_lane_t *l, uint8_t *pkt, int i_pkt_size )
+{
+    l->pkt = pkt;
+    l->i_hdr = 4;
+    if( pkt[3]&0x20 )
+    {
+        /* skip adaption field */
+        l->i_hdr += pkt[4] + 1;
+    }
+    if( 188 - l->i_hdr < 8 )
+        return false;
+
+    l->n = (i_pkt_size - l->i_hdr) / 8;
+    l->i_residue = (i_pkt_size - l->i_hdr) % 8;
+    return l->n > 0;
+}
+
+static void csa_DecryptLanes( csa_t *c, const csa_lane_t *lanes, int i_lanes,
+                              bool b_odd )
+{
+    uint8_t *ck = b_odd ? c->o_ck : c->e_ck;
+    uint8_t *kk = b_odd ? c->o_kk : c->e_kk;
+    int i_stream = 0;
+
+    for( int i = 0; i < i_lanes; i++ )
+        i_stream = __MAX( i_stream, 8 * (lanes[i].n - 1 + (lanes[i].i_residue > 0)) );
+
+    /* the key stream only depends on the first (still scrambled) block */
+    csa_StreamCypherLanes( c, ck, lanes, i_lanes, i_stream );
+
+    for( int l = 0; l < i_lanes; l++ )
+    {
+        const csa_lane_t *p_lane = &lanes[l];
+        uint8_t *pkt = p_lane->pkt + p_lane->i_hdr;
+        const uint8_t *stream = &c->p_stream[l * i_stream];
+        uint8_t ib[CSA_STREAM_MAX + 8], block[CSA_STREAM_MAX];
+        const int n = p_lane->n;
+
+        /* unlike scrambling, the block cypher inputs are all known
+         * beforehand, so the blocks are decyphered side by side */
+        memcpy( ib, pkt, 8 );
+        for( int j = 8; j < 8 * n; j++ )
+            ib[j] = pkt[j] ^ stream[j-8];
+        memset( &ib[8*n], 0, 8 );
+        memcpy( block, ib, 8 * n );
+        csa_BlockDecypherBlocks( kk, block, n );
+        for( int j = 0; j < 8 * n; j++ )
+            pkt[j] = ib[j+8] ^ block[j];
+
+        for( int j = 0; j < p_lane->i_residue; j++ )
+            pkt[8*n+j] ^= stream[8*(n-1)+j];
+    }
+}
+
+/*****************************************************************************
+ * csa_DecryptBatch:
+ *****************************************************************************
+ * Same as csa_Decrypt() on each of the i_pkt packets.
+ *****************************************************************************/
+void csa_DecryptBatch( csa_t *c, uint8_t **pp_pkt, int i_pkt, int i_pkt_size )
+{
+    csa_lane_t lanes[2][CSA_BATCH_MAX];
+    int i_lanes[2] = { 0, 0 };
+
+    if( c->p_stream == NULL )
+        c->p_stream = malloc( CSA_BATCH_MAX * CSA_STREAM_MAX );
+    if( i_pkt < CSA_BATCH_MIN || unlikely(c->p_stream == NULL) )
+    {
+        for( int i = 0; i < i_pkt; i++ )
+            csa_Decrypt( c, pp_pkt[i], i_pkt_size );
+        return;
+    }
+
+    /* packets are grouped by control word (even/odd) */
+    for( int i = 0; i < i_pkt; i++ )
+    {
+        uint8_t *pkt = pp_pkt[i];
+
+        /* transport scrambling control */
+        if( (pkt[3]&0x80) == 0 )
+            continue;
+
+        const bool b_odd = pkt[3]&0x40;
+        csa_lane_t *p_lane = &lanes[b_odd][i_lanes[b_odd]];
+        if( !csa_PrepareLane( p_lane, pkt, i_pkt_size ) )
+        {
+            csa_Decrypt( c, pkt, i_pkt_size );
+            continue;
+        }
+
+        /* clear transport scrambling control */
+        pkt[3] &= 0x3f;
+
+        if( ++i_lanes[b_odd] == CSA_BATCH_MAX )
+        {
+            csa_DecryptLanes( c, lanes[b_odd], CSA_BATCH_MAX, b_odd );
+            i_lanes[b_odd] = 0;
+        }
+    }
+
+    for( int i = 0; i < 2; i++ )
+        if( i_lanes[i] > 0 )
+            csa_DecryptLanes( c, lanes[i], i_lanes[i], i );
+}
+
+static void csa_EncryptLanes( csa_t *c, const csa_lane_t *lanes, int i_lanes )
+{
+    uint8_t *ck = c->use_odd ? c->o_ck : c->e_ck;
+    uint8_t *kk = c->use_odd ? c->o_kk : c->e_kk;
+    int i_stream = 0;
+
+    /* block cypher, last block first; ib[i] replaces block i in place */
+    for( int l = 0; l < i_lanes; l++ )
+    {
+        const csa_lane_t *p_lane = &lanes[l];
+        uint8_t *pkt = p_lane->pkt + p_lane->i_hdr;
+        uint8_t ib[8] = { 0 }, block[8];
+
+        for( int i = p_lane->n; i > 0; i-- )
+        {
+            for( int j = 0; j < 8; j++ )
+                block[j] = pkt[8*(i-1)+j] ^ ib[j];
+            csa_BlockCypher( kk, block, ib );
+            memcpy( &pkt[8*(i-1)], ib, 8 );
+        }
+        i_stream = __MAX( i_stream, 8 * (p_lane->n - 1 + (p_lane->i_residue > 0)) );
+    }
+
+    /* the stream cypher is initialised with the first cyphered block */
+    csa_StreamCypherLanes( c, ck, lanes, i_lanes, i_stream );
+
+    for( int l = 0; l < i_lanes; l++ )
+    {
+        const csa_lane_t *p_lane = &lanes[l];
+        uint8_t *pkt = p_lane->pkt + p_lane->i_hdr;
+        const uint8_t *stream = &c->p_stream[l * i_stream];
+        const int i_len = 8 * (p_lane->n - 1) + p_lane->i_residue;
+
+        for( int j = 0; j < i_len; j++ )
+            pkt[8+j] ^= stream[j];
+    }
+}
+
+/*****************************************************************************
+ * csa_EncryptBatch:
+ *****************************************************************************
+ * Same as csa_Encrypt() on each of the i_pkt packets.
+ *****************************************************************************/
+void csa_EncryptBatch( csa_t *c, uint8_t **pp_pkt, int i_pkt, int i_pkt_size )
+{
+    csa_lane_t lanes[CSA_BATCH_MAX];
+    int i_lanes = 0;
+
+    if( c->p_stream == NULL )
+        c->p_stream = malloc( CSA_BATCH_MAX * CSA_STREAM_MAX );
+    if( i_pkt < CSA_BATCH_MIN || unlikely(c->p_stream == NULL) )
+    {
+        for( int i = 0; i < i_pkt; i++ )
+            csa_Encrypt( c, pp_pkt[i], i_pkt_size );
+        return;
+    }
+
+    for( int i = 0; i < i_pkt; i++ )
+    {
+        uint8_t *pkt = pp_pkt[i];
+
+        /* set transport scrambling control */
+        pkt[3] |= c->use_odd ? 0xc0 : 0x80;
+
+        if( !csa_PrepareLane( &lanes[i_lanes], pkt, i_pkt_size ) )
+        {
+            pkt[3] &= 0x3f;
+            csa_Encrypt( c, pkt, i_pkt_size );
+            continue;
+        }
+
+        if( ++i_lanes == CSA_BATCH_MAX )
+        {
+            csa_EncryptLanes( c, lanes, i_lanes );
+            i_lanes = 0;
+        }
+    }
+
+    if( i_lanes > 0 )
+        csa_EncryptLanes( c, lanes, i_lanes );
+}
+
 /*****************************************************************************
  * Divers
  *****************************************************************************/
@@ -574,6 +795,42 @@ static void csa_BlockDecypher( uint8_t kk[57], uint8_t ib[8], uint8_t bd[8] )
     }
 }
 
+/* Same as csa_BlockDecypher() in place on n consecutive blocks */
+static void csa_BlockDecypherBlocks( const uint8_t kk[57], uint8_t *p_blocks,
+                                     int n )
+{
+    uint8_t R[9][(188 - 4) / 8];
+
+    assert( n <= (188 - 4) / 8 );
+    for( int b = 0; b < n; b++ )
+        for( int i = 0; i < 8; i++ )
+            R[i+1][b] = p_blocks[8*b+i];
+
+    // loop over kk[56]..kk[1]
+    for( int i = 56; i > 0; i-- )
+    {
+        for( int b = 0; b < n; b++ )
+        {
+            const int sbox_out = block_sbox[ kk[i]^R[7][b] ];
+            const int perm_out = block_perm[sbox_out];
+            const int next_R8 = R[7][b];
+
+            R[7][b] = R[6][b] ^ perm_out;
+            R[6][b] = R[5][b];
+            R[5][b] = R[4][b] ^ R[8][b] ^ sbox_out;
+            R[4][b] = R[3][b] ^ R[8][b] ^ sbox_out;
+            R[3][b] = R[2][b] ^ R[8][b] ^ sbox_out;
+            R[2][b] = R[1][b];
+            R[1][b] = R[8][b] ^ sbox_out;
+            R[8][b] = next_R8;
+        }
+    }
+
+    for( int b = 0; b < n; b++ )
+        for( int i = 0; i < 8; i++ )
+            p_blocks[8*b+i] = R[i+1][b];
+}
+
 static void csa_BlockCypher( uint8_t kk[57], uint8_t bd[8], uint8_t ib[8] )
 {
     int i;
@@ -610,3 +867,91 @@ static void csa_BlockCypher( uint8_t kk[57], uint8_t bd[8], uint8_t ib[8] )
     }
 }
 
+
+/*****************************************************************************
+ * Bitsliced stream cypher engines
+ *****************************************************************************/
+#define BS_WORD     uint64_t
+#define BS_ZERO     ((uint64_t)0)
+#define BS_ONES     (~(uint64_t)0)
+#define BS_FUNC(n)  n##_64
+#define BS_ATTR
+#include "csa_bitslice.h"
+#undef BS_ATTR
+#undef BS_FUNC
+#undef BS_ONES
+#undef BS_ZERO
+#undef BS_WORD
+
+#if defined(__GNUC__) && (defined(__i386__) || defined(__x86_64__))
+typedef uint64_t csa_v128_t __attribute__((vector_size(16)));
+# define BS_WORD     csa_v128_t
+# define BS_ZERO     ((csa_v128_t){ 0, 0 })
+# define BS_ONES     (~BS_ZERO)
+# define BS_FUNC(n)  n##_sse2
+# define BS_ATTR     __attribute__((__target__("sse2")))
+# include "csa_bitslice.h"
+# undef BS_ATTR
+# undef BS_FUNC
+# undef BS_ONES
+# undef BS_ZERO
+# undef BS_WORD
+# define CSA_HAVE_SSE2 1
+
+# if defined(__clang__) || VLC_GCC_VERSION(4, 9)
+typedef uint64_t csa_v256_t __attribute__((vector_size(32)));
+#  define BS_WORD     csa_v256_t
+#  define BS_ZERO     ((csa_v256_t){ 0, 0, 0, 0 })
+#  define BS_ONES     (~BS_ZERO)
+#  define BS_FUNC(n)  n##_avx2
+#  define BS_ATTR     __attribute__((__target__("avx2")))
+#  include "csa_bitslice.h"
+#  undef BS_ATTR
+#  undef BS_FUNC
+#  undef BS_ONES
+#  undef BS_ZERO
+#  undef BS_WORD
+#  define CSA_HAVE_AVX2 1
+# endif
+#endif
+
+static void csa_StreamCypherLanes( csa_t *c, const uint8_t ck[8],
+                                   const csa_lane_t *lanes, int i_lanes,
+                                   int i_stream )
+{
+    for( int i = 0; i < i_lanes; )
+    {
+        const uint8_t *pp_iv[CSA_BATCH_MAX];
+        uint8_t *p_out = &c->p_stream[i * i_stream];
+        int i_count = i_lanes - i;
+
+        /* use the narrowest engine fitting the remaining packets */
+#ifdef CSA_HAVE_AVX2
+        if( i_count > 128 && vlc_CPU_AVX2() )
+        {
+            i_count = __MIN( i_count, 256 );
+            for( int l = 0; l < i_count; l++ )
+                pp_iv[l] = lanes[i+l].pkt + lanes[i+l].i_hdr;
+            csa_StreamCypherBatch_avx2( ck, pp_iv, i_count, p_out, i_stream );
+        }
+        else
+#endif
+#ifdef CSA_HAVE_SSE2
+        if( i_count > 64 && vlc_CPU_SSE2() )
+        {
+            i_count = __MIN( i_count, 128 );
+            for( int l = 0; l < i_count; l++ )
+                pp_iv[l] = lanes[i+l].pkt + lanes[i+l].i_hdr;
+            csa_StreamCypherBatch_sse2( ck, pp_iv, i_count, p_out, i_stream );
+        }
+        else
+#endif
+        {
+            i_count = __MIN( i_count, 64 );
+            for( int l = 0; l < i_count; l++ )
+                pp_iv[l] = lanes[i+l].pkt + lanes[i+l].i_hdr;
+            csa_StreamCypherBatch_64( ck, pp_iv, i_count, p_out, i_stream );
+        }
+        i += i_count;
+    }
+}
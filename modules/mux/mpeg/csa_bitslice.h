@@ -0,0 +1,496 @@
+/*****************************************************************************
+ * csa_bitslice.h: bitsliced CSA stream cypher template
+ *****************************************************************************
+ * Copyright (C) 2015 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+/* This file is included several times by csa.c, once per word type.
+ * The includer must define:
+ *  BS_WORD     the word type, one bit per packet (lane)
+ *  BS_ZERO     a BS_WORD with all bits cleared
+ *  BS_ONES     a BS_WORD with all bits set
+ *  BS_FUNC(n)  the name of function n for this word type
+ *  BS_ATTR     function attributes (i.e. target instruction set)
+ *
+ * Every cypher register bit is stored as a BS_WORD, so that the stream
+ * cypher runs for sizeof(BS_WORD)*8 packets at once using only logical
+ * operations. The s-boxes are expressed as multiplexer trees over their
+ * five input bits. */
+
+#define BS_LANES ((int)sizeof(BS_WORD) * 8)
+#define BS_QWORDS ((int)sizeof(BS_WORD) / 8)
+
+typedef struct
+{
+    BS_WORD A[11][4];
+    BS_WORD B[11][4];
+    BS_WORD X[4], Y[4], Z[4];
+    BS_WORD D[4], E[4], F[4];
+    BS_WORD p, q, r;
+} BS_FUNC(csa_bs_state_t);
+
+BS_ATTR static inline void BS_FUNC(csa_Sbox1)( BS_WORD x4, BS_WORD x3,
+        BS_WORD x2, BS_WORD x1, BS_WORD x0, BS_WORD *o1, BS_WORD *o0 )
+{
+    const BS_WORD t0 = ~x0;
+    const BS_WORD t1 = t0 & x1;
+    const BS_WORD t2 = t0 ^ t1;
+    const BS_WORD t3 = x0 & x1;
+    const BS_WORD t4 = ~t3;
+    const BS_WORD t5 = x0 ^ x1;
+    const BS_WORD t6 = ~t1;
+    const BS_WORD t7 = t5 & x2;
+    const BS_WORD t8 = t2 ^ t7;
+    const BS_WORD t9 = t4 ^ x2;
+    const BS_WORD t10 = t0 & x2;
+    const BS_WORD t11 = t5 ^ t10;
+    const BS_WORD t12 = t6 ^ x2;
+    const BS_WORD t13 = t8 ^ t9;
+    const BS_WORD t14 = t13 & x3;
+    const BS_WORD t15 = t8 ^ t14;
+    const BS_WORD t16 = t11 ^ t12;
+    const BS_WORD t17 = t16 & x3;
+    const BS_WORD t18 = t11 ^ t17;
+    const BS_WORD t19 = t15 ^ t18;
+    const BS_WORD t20 = t19 & x4;
+    const BS_WORD t21 = t15 ^ t20;
+    const BS_WORD t22 = x0 & x2;
+    const BS_WORD t23 = x1 ^ t22;
+    const BS_WORD t24 = t2 ^ t22;
+    const BS_WORD t25 = t5 ^ t22;
+    const BS_WORD t26 = ~t9;
+    const BS_WORD t27 = t23 ^ t24;
+    const BS_WORD t28 = t27 & x3;
+    const BS_WORD t29 = t23 ^ t28;
+    const BS_WORD t30 = t25 ^ t26;
+    const BS_WORD t31 = t30 & x3;
+    const BS_WORD t32 = t25 ^ t31;
+    const BS_WORD t33 = t29 ^ t32;
+    const BS_WORD t34 = t33 & x4;
+    const BS_WORD t35 = t29 ^ t34;
+    *o1 = t21;
+    *o0 = t35;
+}
+
+BS_ATTR static inline void BS_FUNC(csa_Sbox2)( BS_WORD x4, BS_WORD x3,
+        BS_WORD x2, BS_WORD x1, BS_WORD x0, BS_WORD *o1, BS_WORD *o0 )
+{
+    const BS_WORD t0 = ~x0;
+    const BS_WORD t1 = t0 ^ x1;
+    const BS_WORD t2 = x0 & x1;
+    const BS_WORD t3 = ~t2;
+    const BS_WORD t4 = t0 & x1;
+    const BS_WORD t5 = ~t4;
+    const BS_WORD t6 = t1 ^ t3;
+    const BS_WORD t7 = t6 & x2;
+    const BS_WORD t8 = t1 ^ t7;
+    const BS_WORD t9 = t1 ^ t5;
+    const BS_WORD t10 = t9 & x2;
+    const BS_WORD t11 = t1 ^ t10;
+    const BS_WORD t12 = ~t9;
+    const BS_WORD t13 = t12 & x2;
+    const BS_WORD t14 = t2 ^ t13;
+    const BS_WORD t15 = t8 ^ x3;
+    const BS_WORD t16 = t11 ^ t14;
+    const BS_WORD t17 = t16 & x3;
+    const BS_WORD t18 = t11 ^ t17;
+    const BS_WORD t19 = t15 ^ t18;
+    const BS_WORD t20 = t19 & x4;
+    const BS_WORD t21 = t15 ^ t20;
+    const BS_WORD t22 = ~x1;
+    const BS_WORD t23 = t0 & x2;
+    const BS_WORD t24 = t22 ^ t23;
+    const BS_WORD t25 = t5 ^ x2;
+    const BS_WORD t26 = x0 & x2;
+    const BS_WORD t27 = t5 ^ t26;
+    const BS_WORD t28 = t24 ^ t25;
+    const BS_WORD t29 = t28 & x3;
+    const BS_WORD t30 = t24 ^ t29;
+    const BS_WORD t31 = t27 ^ x3;
+    const BS_WORD t32 = t30 ^ t31;
+    const BS_WORD t33 = t32 & x4;
+    const BS_WORD t34 = t30 ^ t33;
+    *o1 = t21;
+    *o0 = t34;
+}
+
+BS_ATTR static inline void BS_FUNC(csa_Sbox3)( BS_WORD x4, BS_WORD x3,
+        BS_WORD x2, BS_WORD x1, BS_WORD x0, BS_WORD *o1, BS_WORD *o0 )
+{
+    const BS_WORD t0 = ~x0;
+    const BS_WORD t1 = t0 ^ x1;
+    const BS_WORD t2 = x0 & x1;
+    const BS_WORD t3 = ~t2;
+    const BS_WORD t4 = x0 ^ t2;
+    const BS_WORD t5 = ~t4;
+    const BS_WORD t6 = t1 ^ t3;
+    const BS_WORD t7 = t6 & x2;
+    const BS_WORD t8 = t1 ^ t7;
+    const BS_WORD t9 = t5 & x2;
+    const BS_WORD t10 = t2 ^ t9;
+    const BS_WORD t11 = t4 ^ x2;
+    const BS_WORD t12 = t1 ^ x2;
+    const BS_WORD t13 = t8 ^ t10;
+    const BS_WORD t14 = t13 & x3;
+    const BS_WORD t15 = t8 ^ t14;
+    const BS_WORD t16 = t11 ^ t12;
+    const BS_WORD t17 = t16 & x3;
+    const BS_WORD t18 = t11 ^ t17;
+    const BS_WORD t19 = t15 ^ t18;
+    const BS_WORD t20 = t19 & x4;
+    const BS_WORD t21 = t15 ^ t20;
+    const BS_WORD t22 = ~t16;
+    const BS_WORD t23 = x0 & x2;
+    const BS_WORD t24 = t22 ^ t23;
+    const BS_WORD t25 = t24 ^ x3;
+    const BS_WORD t26 = t25 ^ x4;
+    *o1 = t21;
+    *o0 = t26;
+}
+
+BS_ATTR static inline void BS_FUNC(csa_Sbox4)( BS_WORD x4, BS_WORD x3,
+        BS_WORD x2, BS_WORD x1, BS_WORD x0, BS_WORD *o1, BS_WORD *o0 )
+{
+    const BS_WORD t0 = ~x0;
+    const BS_WORD t1 = x0 & x1;
+    const BS_WORD t2 = t0 ^ t1;
+    const BS_WORD t3 = ~t2;
+    const BS_WORD t4 = t0 ^ x1;
+    const BS_WORD t5 = t0 & x1;
+    const BS_WORD t6 = ~t5;
+    const BS_WORD t7 = ~t4;
+    const BS_WORD t8 = ~t1;
+    const BS_WORD t9 = t8 & x2;
+    const BS_WORD t10 = t2 ^ t9;
+    const BS_WORD t11 = t6 & x2;
+    const BS_WORD t12 = t3 ^ t11;
+    const BS_WORD t13 = t5 ^ x2;
+    const BS_WORD t14 = t10 ^ t12;
+    const BS_WORD t15 = t14 & x3;
+    const BS_WORD t16 = t10 ^ t15;
+    const BS_WORD t17 = t13 ^ t7;
+    const BS_WORD t18 = t17 & x3;
+    const BS_WORD t19 = t13 ^ t18;
+    const BS_WORD t20 = t16 ^ t19;
+    const BS_WORD t21 = t20 & x4;
+    const BS_WORD t22 = t16 ^ t21;
+    const BS_WORD t23 = ~t19;
+    const BS_WORD t24 = ~t20;
+    const BS_WORD t25 = t24 & x4;
+    const BS_WORD t26 = t23 ^ t25;
+    *o1 = t22;
+    *o0 = t26;
+}
+
+BS_ATTR static inline void BS_FUNC(csa_Sbox5)( BS_WORD x4, BS_WORD x3,
+        BS_WORD x2, BS_WORD x1, BS_WORD x0, BS_WORD *o1, BS_WORD *o0 )
+{
+    const BS_WORD t0 = ~x0;
+    const BS_WORD t1 = t0 & x1;
+    const BS_WORD t2 = t0 ^ t1;
+    const BS_WORD t3 = x0 & x1;
+    const BS_WORD t4 = ~t3;
+    const BS_WORD t5 = x0 ^ t3;
+    const BS_WORD t6 = t0 ^ x1;
+    const BS_WORD t7 = ~t2;
+    const BS_WORD t8 = t7 & x2;
+    const BS_WORD t9 = t2 ^ t8;
+    const BS_WORD t10 = t3 & x2;
+    const BS_WORD t11 = x1 ^ t10;
+    const BS_WORD t12 = t0 & x2;
+    const BS_WORD t13 = t4 ^ t12;
+    const BS_WORD t14 = t9 ^ t11;
+    const BS_WORD t15 = t14 & x3;
+    const BS_WORD t16 = t9 ^ t15;
+    const BS_WORD t17 = ~t1;
+    const BS_WORD t18 = t17 & x3;
+    const BS_WORD t19 = t13 ^ t18;
+    const BS_WORD t20 = t16 ^ t19;
+    const BS_WORD t21 = t20 & x4;
+    const BS_WORD t22 = t16 ^ t21;
+    const BS_WORD t23 = ~t5;
+    const BS_WORD t24 = t23 & x2;
+    const BS_WORD t25 = t3 ^ t24;
+    const BS_WORD t26 = t4 & x2;
+    const BS_WORD t27 = t7 ^ t26;
+    const BS_WORD t28 = x1 & x2;
+    const BS_WORD t29 = t5 ^ t28;
+    const BS_WORD t30 = ~t6;
+    const BS_WORD t31 = t30 & x2;
+    const BS_WORD t32 = t0 ^ t31;
+    const BS_WORD t33 = t25 ^ t27;
+    const BS_WORD t34 = t33 & x3;
+    const BS_WORD t35 = t25 ^ t34;
+    const BS_WORD t36 = t29 ^ t32;
+    const BS_WORD t37 = t36 & x3;
+    const BS_WORD t38 = t29 ^ t37;
+    const BS_WORD t39 = t35 ^ t38;
+    const BS_WORD t40 = t39 & x4;
+    const BS_WORD t41 = t35 ^ t40;
+    *o1 = t22;
+    *o0 = t41;
+}
+
+BS_ATTR static inline void BS_FUNC(csa_Sbox6)( BS_WORD x4, BS_WORD x3,
+        BS_WORD x2, BS_WORD x1, BS_WORD x0, BS_WORD *o1, BS_WORD *o0 )
+{
+    const BS_WORD t0 = ~x0;
+    const BS_WORD t1 = x0 ^ x1;
+    const BS_WORD t2 = t0 & x1;
+    const BS_WORD t3 = ~t2;
+    const BS_WORD t4 = ~t1;
+    const BS_WORD t5 = x0 & x2;
+    const BS_WORD t6 = x1 ^ t5;
+    const BS_WORD t7 = t2 ^ x2;
+    const BS_WORD t8 = t3 ^ t5;
+    const BS_WORD t9 = t4 ^ x2;
+    const BS_WORD t10 = t6 ^ t7;
+    const BS_WORD t11 = t10 & x3;
+    const BS_WORD t12 = t6 ^ t11;
+    const BS_WORD t13 = t8 ^ t9;
+    const BS_WORD t14 = t13 & x3;
+    const BS_WORD t15 = t8 ^ t14;
+    const BS_WORD t16 = t12 ^ t15;
+    const BS_WORD t17 = t16 & x4;
+    const BS_WORD t18 = t12 ^ t17;
+    const BS_WORD t19 = x0 & x1;
+    const BS_WORD t20 = x0 ^ t19;
+    const BS_WORD t21 = t3 & x2;
+    const BS_WORD t22 = x0 ^ t21;
+    const BS_WORD t23 = t19 & x2;
+    const BS_WORD t24 = t1 ^ t23;
+    const BS_WORD t25 = t20 ^ x2;
+    const BS_WORD t26 = t22 ^ t24;
+    const BS_WORD t27 = t26 & x3;
+    const BS_WORD t28 = t22 ^ t27;
+    const BS_WORD t29 = t7 & x3;
+    const BS_WORD t30 = t25 ^ t29;
+    const BS_WORD t31 = t28 ^ t30;
+    const BS_WORD t32 = t31 & x4;
+    const BS_WORD t33 = t28 ^ t32;
+    *o1 = t18;
+    *o0 = t33;
+}
+
+BS_ATTR static inline void BS_FUNC(csa_Sbox7)( BS_WORD x4, BS_WORD x3,
+        BS_WORD x2, BS_WORD x1, BS_WORD x0, BS_WORD *o1, BS_WORD *o0 )
+{
+    const BS_WORD t0 = ~x0;
+    const BS_WORD t1 = t0 & x1;
+    const BS_WORD t2 = x0 ^ t1;
+    const BS_WORD t3 = t0 ^ x1;
+    const BS_WORD t4 = ~t3;
+    const BS_WORD t5 = x0 & x1;
+    const BS_WORD t6 = ~x1;
+    const BS_WORD t7 = ~t1;
+    const BS_WORD t8 = t2 ^ x2;
+    const BS_WORD t9 = t1 & x2;
+    const BS_WORD t10 = x1 ^ t9;
+    const BS_WORD t11 = t5 & x2;
+    const BS_WORD t12 = t6 ^ t11;
+    const BS_WORD t13 = ~t5;
+    const BS_WORD t14 = t13 & x3;
+    const BS_WORD t15 = t8 ^ t14;
+    const BS_WORD t16 = t10 ^ t12;
+    const BS_WORD t17 = t16 & x3;
+    const BS_WORD t18 = t10 ^ t17;
+    const BS_WORD t19 = t15 ^ t18;
+    const BS_WORD t20 = t19 & x4;
+    const BS_WORD t21 = t15 ^ t20;
+    const BS_WORD t22 = x0 ^ t5;
+    const BS_WORD t23 = t7 & x2;
+    const BS_WORD t24 = t22 ^ t23;
+    const BS_WORD t25 = ~t24;
+    const BS_WORD t26 = t4 ^ t9;
+    const BS_WORD t27 = ~x2;
+    const BS_WORD t28 = t27 & x3;
+    const BS_WORD t29 = t24 ^ t28;
+    const BS_WORD t30 = t25 ^ t26;
+    const BS_WORD t31 = t30 & x3;
+    const BS_WORD t32 = t25 ^ t31;
+    const BS_WORD t33 = t29 ^ t32;
+    const BS_WORD t34 = t33 & x4;
+    const BS_WORD t35 = t29 ^ t34;
+    *o1 = t21;
+    *o0 = t35;
+}
+
+/* Transposes byte i of each lane IV into 8 bit-words */
+BS_ATTR static void BS_FUNC(csa_LoadByte)( BS_WORD v[8],
+                                           const uint8_t *const *pp_iv,
+                                           int i_lanes, int i )
+{
+    uint64_t q[8][BS_QWORDS];
+
+    memset( q, 0, sizeof(q) );
+    for( int l = 0; l < i_lanes; l++ )
+    {
+        const unsigned c = pp_iv[l][i];
+        for( int k = 0; k < 8; k++ )
+            q[k][l / 64] |= (uint64_t)((c >> k) & 1) << (l % 64);
+    }
+    for( int k = 0; k < 8; k++ )
+        memcpy( &v[k], q[k], sizeof(BS_WORD) );
+}
+
+/* Transposes 8 bit-words back into byte i of each lane output */
+BS_ATTR static void BS_FUNC(csa_StoreByte)( const BS_WORD v[8],
+                                            uint8_t *p_out, int i_out,
+                                            int i_lanes, int i )
+{
+    uint64_t q[8][BS_QWORDS];
+
+    for( int k = 0; k < 8; k++ )
+        memcpy( q[k], &v[k], sizeof(BS_WORD) );
+    for( int l = 0; l < i_lanes; l++ )
+    {
+        unsigned c = 0;
+        for( int k = 0; k < 8; k++ )
+            c |= ((q[k][l / 64] >> (l % 64)) & 1) << k;
+        p_out[l * i_out + i] = c;
+    }
+}
+
+/* One iteration (2 output bits) of the stream cypher.
+ * in_a and in_b are the nibbles fed to A and B during initialisation,
+ * or NULL when generating. */
+BS_ATTR static inline void BS_FUNC(csa_StreamRound)( BS_FUNC(csa_bs_state_t) *s,
+                                                     const BS_WORD *in_a,
+                                                     const BS_WORD *in_b,
+                                                     BS_WORD *p_hi,
+                                                     BS_WORD *p_lo )
+{
+    BS_WORD (*A)[4] = s->A;
+    BS_WORD (*B)[4] = s->B;
+    BS_WORD s1h, s1l, s2h, s2l, s3h, s3l, s4h, s4l, s5h, s5l, s6h, s6l, s7h, s7l;
+    BS_WORD eb[4], na[4], nb[4], ne[4];
+
+    /* from A[1]..A[10], 35 bits are selected as inputs to 7 s-boxes */
+    BS_FUNC(csa_Sbox1)( A[4][0], A[1][2], A[6][1], A[7][3], A[9][0], &s1h, &s1l );
+    BS_FUNC(csa_Sbox2)( A[2][1], A[3][2], A[6][3], A[7][0], A[9][1], &s2h, &s2l );
+    BS_FUNC(csa_Sbox3)( A[1][3], A[2][0], A[5][1], A[5][3], A[6][2], &s3h, &s3l );
+    BS_FUNC(csa_Sbox4)( A[3][3], A[1][1], A[2][3], A[4][2], A[8][0], &s4h, &s4l );
+    BS_FUNC(csa_Sbox5)( A[5][2], A[4][3], A[6][0], A[8][1], A[9][2], &s5h, &s5l );
+    BS_FUNC(csa_Sbox6)( A[3][1], A[4][1], A[5][0], A[7][2], A[9][3], &s6h, &s6l );
+    BS_FUNC(csa_Sbox7)( A[2][2], A[3][0], A[7][1], A[8][2], A[8][3], &s7h, &s7l );
+
+    /* 4x4 xor producing the extra nibble for T3 */
+    eb[3] = B[3][0] ^ B[6][1] ^ B[7][2] ^ B[9][3];
+    eb[2] = B[6][0] ^ B[8][1] ^ B[3][3] ^ B[4][2];
+    eb[1] = B[5][3] ^ B[8][2] ^ B[4][0] ^ B[5][1];
+    eb[0] = B[9][2] ^ B[6][3] ^ B[3][1] ^ B[8][0];
+
+    for( int b = 0; b < 4; b++ )
+    {
+        /* T1 and T2 */
+        na[b] = A[10][b] ^ s->X[b];
+        nb[b] = B[7][b] ^ B[10][b] ^ s->Y[b];
+        if( in_a != NULL )
+        {
+            na[b] ^= s->D[b] ^ in_a[b];
+            nb[b] ^= in_b[b];
+        }
+    }
+
+    /* if p=1, rotate the B input left */
+    const BS_WORD rot[4] = { nb[3], nb[0], nb[1], nb[2] };
+    for( int b = 0; b < 4; b++ )
+        nb[b] ^= (nb[b] ^ rot[b]) & s->p;
+
+    /* T3 */
+    for( int b = 0; b < 4; b++ )
+        s->D[b] = s->E[b] ^ s->Z[b] ^ eb[b];
+
+    /* T4 = sum, carry of Z + E + r, only when q=1 */
+    BS_WORD carry = s->r;
+    for( int b = 0; b < 4; b++ )
+    {
+        const BS_WORD ze = s->Z[b] ^ s->E[b];
+        const BS_WORD sum = ze ^ carry;
+
+        carry = (s->Z[b] & s->E[b]) | (carry & ze);
+        ne[b] = s->F[b];
+        s->F[b] = s->E[b] ^ ((s->E[b] ^ sum) & s->q);
+        s->E[b] = ne[b];
+    }
+    s->r ^= (s->r ^ carry) & s->q;
+
+    memmove( &A[2], &A[1], 9 * sizeof(A[1]) );
+    memmove( &B[2], &B[1], 9 * sizeof(B[1]) );
+    memcpy( A[1], na, sizeof(na) );
+    memcpy( B[1], nb, sizeof(nb) );
+
+    s->X[3] = s4l; s->X[2] = s3l; s->X[1] = s2h; s->X[0] = s1h;
+    s->Y[3] = s6l; s->Y[2] = s5l; s->Y[1] = s4h; s->Y[0] = s3h;
+    s->Z[3] = s2l; s->Z[2] = s1l; s->Z[1] = s6h; s->Z[0] = s5h;
+    s->p = s7h;
+    s->q = s7l;
+
+    /* 2 output bits are a function of the 4 bits of D */
+    *p_hi = s->D[3] ^ s->D[2];
+    *p_lo = s->D[1] ^ s->D[0];
+}
+
+/**
+ * Runs the stream cypher for up to BS_LANES packets sharing the same
+ * control word.
+ * pp_iv[l] points to the 8 bytes initialising lane l, and i_out bytes
+ * (a multiple of 8) of key stream are written at p_out + l * i_out.
+ */
+BS_ATTR static void BS_FUNC(csa_StreamCypherBatch)( const uint8_t ck[8],
+                                                    const uint8_t *const *pp_iv,
+                                                    int i_lanes,
+                                                    uint8_t *p_out, int i_out )
+{
+    BS_FUNC(csa_bs_state_t) s;
+    BS_WORD v[8], hi, lo;
+
+    assert( i_lanes <= BS_LANES );
+
+    /* load first 32 bits of CK into A[1]..A[8],
+     * last 32 bits into B[1]..B[8], all other registers are 0 */
+    memset( &s, 0, sizeof(s) );
+    for( int i = 0; i < 4; i++ )
+        for( int b = 0; b < 4; b++ )
+        {
+            s.A[1+2*i+0][b] = ((ck[i]   >> (4+b)) & 1) ? BS_ONES : BS_ZERO;
+            s.A[1+2*i+1][b] = ((ck[i]   >> b) & 1)     ? BS_ONES : BS_ZERO;
+            s.B[1+2*i+0][b] = ((ck[4+i] >> (4+b)) & 1) ? BS_ONES : BS_ZERO;
+            s.B[1+2*i+1][b] = ((ck[4+i] >> b) & 1)     ? BS_ONES : BS_ZERO;
+        }
+
+    /* initialisation with the first 8 bytes */
+    for( int i = 0; i < 8; i++ )
+    {
+        BS_FUNC(csa_LoadByte)( v, pp_iv, i_lanes, i );
+        /* v[4..7] is the high nibble (in1), v[0..3] the low one (in2) */
+        for( int j = 0; j < 4; j++ )
+            BS_FUNC(csa_StreamRound)( &s, (j % 2) ? &v[0] : &v[4],
+                                      (j % 2) ? &v[4] : &v[0], &hi, &lo );
+    }
+
+    /* key stream generation, 8 bits per byte over 4 iterations */
+    for( int i = 0; i < i_out; i++ )
+    {
+        for( int j = 0; j < 4; j++ )
+            BS_FUNC(csa_StreamRound)( &s, NULL, NULL, &v[7-2*j], &v[6-2*j] );
+        BS_FUNC(csa_StoreByte)( v, p_out, i_out, i_lanes, i );
+    }
+}
+
+#undef BS_QWORDS
+#undef BS_LANES
@@ -39,6 +39,7 @@
 #include <vlc_sout.h>
 #include <vlc_block.h>
 #include <vlc_rand.h>
+#include <vlc_atomic.h>
 
 #include <vlc_iso_lang.h>
 
@@ -308,6 +309,119 @@ static inline void BufferChainClean( sout_buffer_chain_t *c )
     BufferChainInit( c );
 }
 
+/*
+ * TS packet slabs: output packets are carved out of a single allocation,
+ * and runs of consecutive packets are sent to the access output as one
+ * block (TS_BLOCK_PACKETS packets at most, 7 * 188 fitting an UDP datagram,
+ * and fewer if the MTU of the access output is smaller)
+ */
+#define TS_SLAB_PACKETS  64
+#define TS_BLOCK_PACKETS 7
+
+typedef struct ts_slab_t ts_slab_t;
+
+typedef struct
+{
+    block_t    self;
+    ts_slab_t *p_slab;
+} ts_slab_block_t;
+
+struct ts_slab_t
+{
+    atomic_uint     refs;
+    unsigned        i_used;
+    /* one block per packet, then one per possible run of packets */
+    ts_slab_block_t blocks[2 * TS_SLAB_PACKETS];
+    uint8_t         p_data[TS_SLAB_PACKETS * 188];
+};
+
+static void TSSlabRelease( ts_slab_t *p_slab )
+{
+    if( atomic_fetch_sub( &p_slab->refs, 1 ) == 1 )
+        free( p_slab );
+}
+
+static void TSSlabBlockRelease( block_t *p_block )
+{
+    TSSlabRelease( ((ts_slab_block_t *)p_block)->p_slab );
+}
+
+static block_t *TSSlabBlock( ts_slab_t *p_slab, unsigned i_block,
+                             uint8_t *p_data, size_t i_data )
+{
+    ts_slab_block_t *p_sb = &p_slab->blocks[i_block];
+
+    block_Init( &p_sb->self, p_data, i_data );
+    p_sb->self.pf_release = TSSlabBlockRelease;
+    p_sb->p_slab = p_slab;
+    atomic_fetch_add( &p_slab->refs, 1 );
+    return &p_sb->self;
+}
+
+/* Returns a new 188 bytes packet from the current slab */
+static block_t *TSSlabPacket( ts_slab_t **pp_slab )
+{
+    ts_slab_t *p_slab = *pp_slab;
+
+    if( p_slab == NULL || p_slab->i_used == TS_SLAB_PACKETS )
+    {
+        if( p_slab != NULL )
+            TSSlabRelease( p_slab );
+
+        *pp_slab = p_slab = malloc( sizeof( *p_slab ) );
+        if( unlikely(p_slab == NULL) )
+            return block_Alloc( 188 );
+        atomic_init( &p_slab->refs, 1 ); /* the muxer's reference */
+        p_slab->i_used = 0;
+    }
+
+    unsigned i = p_slab->i_used++;
+    return TSSlabBlock( p_slab, i, &p_slab->p_data[i * 188], 188 );
+}
+
+/* Merges the packets following p_ts in the chain into a single block,
+ * as long as they are contiguous and do not start a new access point */
+static block_t *TSSlabGather( sout_buffer_chain_t *c, block_t *p_ts,
+                              int i_max, int *pi_count )
+{
+    *pi_count = 1;
+    if( p_ts->pf_release != TSSlabBlockRelease )
+        return p_ts;
+
+    ts_slab_t *p_slab = ((ts_slab_block_t *)p_ts)->p_slab;
+    block_t *p_next = BufferChainPeek( c );
+    size_t i_size = p_ts->i_buffer;
+    mtime_t i_length = p_ts->i_length;
+    uint32_t i_flags = p_ts->i_flags;
+
+    while( *pi_count < i_max && p_next != NULL &&
+           p_next->pf_release == TSSlabBlockRelease &&
+           ((ts_slab_block_t *)p_next)->p_slab == p_slab &&
+           p_next->p_buffer == &p_ts->p_buffer[i_size] &&
+           !(p_next->i_flags & (BLOCK_FLAG_HEADER|BLOCK_FLAG_TYPE_I)) )
+    {
+        i_size += p_next->i_buffer;
+        i_length += p_next->i_length;
+        i_flags |= p_next->i_flags & BLOCK_FLAG_CLOCK;
+        (*pi_count)++;
+        p_next = p_next->p_next;
+    }
+    if( *pi_count == 1 )
+        return p_ts;
+
+    unsigned i_first = (p_ts->p_buffer - p_slab->p_data) / 188;
+    block_t *p_run = TSSlabBlock( p_slab, TS_SLAB_PACKETS + i_first,
+                                  p_ts->p_buffer, i_size );
+    p_run->i_dts    = p_ts->i_dts;
+    p_run->i_length = i_length;
+    p_run->i_flags  = i_flags;
+
+    block_Release( p_ts );
+    for( int i = 1; i < *pi_count; i++ )
+        block_Release( BufferChainGet( c ) );
+    return p_run;
+}
+
 typedef struct
 {
     sout_buffer_chain_t chain_pes;
@@ -332,6 +446,9 @@ struct sout_mux_sys_t
 
     vlc_mutex_t     csa_lock;
 
+    ts_slab_t       *p_slab;
+    int             i_slab_run; /* packets per block sent to the access */
+
     dvbpsi_t        *p_dvbpsi;
     bool            b_es_id_pid;
     bool            b_sdt;
@@ -691,6 +808,11 @@ static int Open( vlc_object_t *p_this )
                  "(if you need them report it)" );
     }
 
+    /* UDP and RTP cut the blocks at their MTU, which must not split a
+     * TS packet: the access output exposes it, else the core one applies */
+    p_sys->i_slab_run = var_InheritInteger( p_mux->p_access, "mtu" ) / 188;
+    p_sys->i_slab_run = VLC_CLIP( p_sys->i_slab_run, 1, TS_BLOCK_PACKETS );
+
     var_Get( p_mux, SOUT_CFG_PREFIX "shaping", &val );
     p_sys->i_shaping_delay = val.i_int * 1000;
     if( p_sys->i_shaping_delay <= 0 )
@@ -743,6 +865,9 @@ static void Close( vlc_object_t * p_this )
     if( p_sys->p_dvbpsi )
         dvbpsi_delete( p_sys->p_dvbpsi );
 
+    if( p_sys->p_slab )
+        TSSlabRelease( p_sys->p_slab );
+
     if( p_sys->csa )
     {
         var_DelCallback( p_mux, SOUT_CFG_PREFIX "csa-ck", ChangeKeyCallback, NULL );
@@ -1780,10 +1905,14 @@ static void TSDate( sout_mux_t *p_mux, sout_buffer_chain_t *p_chain_ts,
         i_pcr_length = i_packet_count;
     }
 
+    /* Scrambled packets are collected and scrambled in batches */
+    uint8_t *pp_scrambled[CSA_BATCH_MAX];
+    int i_scrambled = 0;
+
     /* msg_Dbg( p_mux, "real pck=%d", i_packet_count ); */
-    for (int i = 0; i < i_packet_count; i++ )
+    block_t *p_ts = BufferChainPeek( p_chain_ts );
+    for (int i = 0; i < i_packet_count; i++, p_ts = p_ts->p_next )
     {
-        block_t *p_ts = BufferChainGet( p_chain_ts );
         mtime_t i_new_dts = i_pcr_dts + i_pcr_length * i / i_packet_count;
 
         p_ts->i_dts    = i_new_dts;
@@ -1796,10 +1925,32 @@ static void TSDate( sout_mux_t *p_mux, sout_buffer_chain_t *p_chain_ts,
         }
         if( p_ts->i_flags & BLOCK_FLAG_SCRAMBLED )
         {
-            vlc_mutex_lock( &p_sys->csa_lock );
-            csa_Encrypt( p_sys->csa, p_ts->p_buffer, p_sys->i_csa_pkt_size );
-            vlc_mutex_unlock( &p_sys->csa_lock );
+            pp_scrambled[i_scrambled++] = p_ts->p_buffer;
+            if( i_scrambled == CSA_BATCH_MAX )
+            {
+                vlc_mutex_lock( &p_sys->csa_lock );
+                csa_EncryptBatch( p_sys->csa, pp_scrambled, i_scrambled,
+                                  p_sys->i_csa_pkt_size );
+                vlc_mutex_unlock( &p_sys->csa_lock );
+                i_scrambled = 0;
+            }
         }
+    }
+    if( i_scrambled > 0 )
+    {
+        vlc_mutex_lock( &p_sys->csa_lock );
+        csa_EncryptBatch( p_sys->csa, pp_scrambled, i_scrambled,
+                          p_sys->i_csa_pkt_size );
+        vlc_mutex_unlock( &p_sys->csa_lock );
+    }
+
+    for (int i = 0; i < i_packet_count; )
+    {
+        int i_count;
+
+        p_ts = BufferChainGet( p_chain_ts );
+        p_ts = TSSlabGather( p_chain_ts, p_ts, p_sys->i_slab_run, &i_count );
+        i += i_count;
 
         /* latency */
         p_ts->i_dts += p_sys->i_shaping_delay * 3 / 2;
@@ -1811,7 +1962,7 @@ static void TSDate( sout_mux_t *p_mux, sout_buffer_chain_t *p_chain_ts,
 static block_t *TSNew( sout_mux_t *p_mux, sout_input_sys_t *p_stream,
                        bool b_pcr )
 {
-    VLC_UNUSED(p_mux);
+    sout_mux_sys_t *p_sys = p_mux->p_sys;
     block_t *p_pes = p_stream->state.chain_pes.p_first;
 
     bool b_new_pes = false;
@@ -1831,7 +1982,7 @@ static block_t *TSNew( sout_mux_t *p_mux, sout_input_sys_t *p_stream,
         b_adaptation_field = true;
     }
 
-    block_t *p_ts = block_Alloc( 188 );
+    block_t *p_ts = TSSlabPacket( &p_sys->p_slab );
 
     if (b_new_pes && !(p_pes->i_flags & BLOCK_FLAG_NO_KEYFRAME) && p_pes->i_flags & BLOCK_FLAG_TYPE_I)
     {
@@ -43,6 +43,7 @@
 #include "../codec/cc.h"
 #include "../codec/h264_nal.h"
 #include "packetizer_helper.h"
+#include "startcode_helper.h"
 #include "../demux/mpeg/mpeg_parser_helpers.h"
 
 /*****************************************************************************
@@ -203,6 +204,7 @@ static int Open( vlc_object_t *p_this )
 
     packetizer_Init( &p_sys->packetizer,
                      p_h264_startcode, sizeof(p_h264_startcode),
+                     startcode_FindAnnexB,
                      p_h264_startcode, 1, 5,
                      PacketizeReset, PacketizeParse, PacketizeValidate, p_dec );
 
@@ -386,6 +388,7 @@ static void Close( vlc_object_t *p_this )
         if( p_sys->pp_pps[i] )
             block_Release( p_sys->pp_pps[i] );
     }
+    packetizer_Stats( VLC_OBJECT(p_dec), &p_sys->packetizer );
     packetizer_Clean( &p_sys->packetizer );
 
     if( p_dec->pf_get_cc )
@@ -728,11 +731,11 @@ static block_t *OutputPicture( decoder_t *p_dec )
             p_head = p_list;
         block_ChainAppend( &p_head, p_sys->p_frame );
 
-        p_pic = block_ChainGather( p_head );
+        p_pic = packetizer_ChainGather( &p_sys->packetizer, p_head );
     }
     else
     {
-        p_pic = block_ChainGather( p_sys->p_frame );
+        p_pic = packetizer_ChainGather( &p_sys->packetizer, p_sys->p_frame );
     }
     p_pic->i_dts = p_sys->i_frame_dts;
     p_pic->i_pts = p_sys->i_frame_pts;
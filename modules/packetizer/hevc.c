@@ -37,6 +37,7 @@
 #include <vlc_bits.h>
 #include <vlc_block_helper.h>
 #include "packetizer_helper.h"
+#include "startcode_helper.h"
 
 /*****************************************************************************
  * Module descriptor
@@ -124,6 +125,7 @@ static int Open(vlc_object_t *p_this)
 
     packetizer_Init(&p_dec->p_sys->packetizer,
                     p_hevc_startcode, sizeof(p_hevc_startcode),
+                    startcode_FindAnnexB,
                     p_hevc_startcode, 1, 5,
                     PacketizeReset, PacketizeParse, PacketizeValidate, p_dec);
 
@@ -144,6 +146,7 @@ static void Close(vlc_object_t *p_this)
 {
     decoder_t *p_dec = (decoder_t*)p_this;
     decoder_sys_t *p_sys = p_dec->p_sys;
+    packetizer_Stats(VLC_OBJECT(p_dec), &p_sys->packetizer);
     packetizer_Clean(&p_sys->packetizer);
 
     free(p_sys);
@@ -209,7 +212,7 @@ static block_t *PacketizeParse(void *p_private, bool *pb_ts_used, block_t *p_blo
 
         if (first_slice_in_pic && p_sys->p_frame)
         {
-            p_nal = block_ChainGather(p_sys->p_frame);
+            p_nal = packetizer_ChainGather(&p_sys->packetizer, p_sys->p_frame);
             p_sys->p_frame = NULL;
         }
 
@@ -219,7 +222,7 @@ static block_t *PacketizeParse(void *p_private, bool *pb_ts_used, block_t *p_blo
     {
         if (p_sys->b_vcl)
         {
-            p_nal = block_ChainGather(p_sys->p_frame);
+            p_nal = packetizer_ChainGather(&p_sys->packetizer, p_sys->p_frame);
             p_nal->p_next = p_block;
             p_sys->p_frame = NULL;
             p_sys->b_vcl =false;
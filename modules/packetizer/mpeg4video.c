@@ -40,6 +40,7 @@
 #include <vlc_bits.h>
 #include <vlc_block_helper.h>
 #include "packetizer_helper.h"
+#include "startcode_helper.h"
 
 /*****************************************************************************
  * Module descriptor
@@ -142,6 +143,7 @@ static int Open( vlc_object_t *p_this )
     /* Misc init */
     packetizer_Init( &p_sys->packetizer,
                      p_mp4v_startcode, sizeof(p_mp4v_startcode),
+                     startcode_FindAnnexB,
                      NULL, 0, 4,
                      PacketizeReset, PacketizeParse, PacketizeValidate, p_dec );
 
@@ -187,6 +189,7 @@ static void Close( vlc_object_t *p_this )
     decoder_t *p_dec = (decoder_t*)p_this;
     decoder_sys_t *p_sys = p_dec->p_sys;
 
+    packetizer_Stats( VLC_OBJECT(p_dec), &p_sys->packetizer );
     packetizer_Clean( &p_sys->packetizer );
     if( p_sys->p_frame )
         block_ChainRelease( p_sys->p_frame );
@@ -324,7 +327,7 @@ static block_t *ParseMPEGBlock( decoder_t *p_dec, block_t *p_frag )
         ParseVOP( p_dec, p_frag ) == VLC_SUCCESS )
     {
         /* We are dealing with a VOP */
-        p_pic = block_ChainGather( p_sys->p_frame );
+        p_pic = packetizer_ChainGather( &p_sys->packetizer, p_sys->p_frame );
         p_pic->i_flags = p_sys->i_flags;
         p_pic->i_pts = p_sys->i_interpolated_pts;
         p_pic->i_dts = p_sys->i_interpolated_dts;
@@ -53,6 +53,7 @@
 #include <vlc_block_helper.h>
 #include "../codec/cc.h"
 #include "packetizer_helper.h"
+#include "startcode_helper.h"
 
 #define SYNC_INTRAFRAME_TEXT N_("Sync on Intra Frame")
 #define SYNC_INTRAFRAME_LONGTEXT N_("Normally the packetizer would " \
@@ -168,6 +169,7 @@ static int Open( vlc_object_t *p_this )
     /* Misc init */
     packetizer_Init( &p_sys->packetizer,
                      p_mp2v_startcode, sizeof(p_mp2v_startcode),
+                     startcode_FindAnnexB,
                      NULL, 0, 4,
                      PacketizeReset, PacketizeParse, PacketizeValidate, p_dec );
 
@@ -234,6 +236,7 @@ static void Close( vlc_object_t *p_this )
     {
         block_ChainRelease( p_sys->p_frame );
     }
+    packetizer_Stats( VLC_OBJECT(p_dec), &p_sys->packetizer );
     packetizer_Clean( &p_sys->packetizer );
 
     var_Destroy( p_dec, "packetizer-mpegvideo-sync-iframe" );
@@ -385,7 +388,7 @@ static block_t *ParseMPEGBlock( decoder_t *p_dec, block_t *p_frag )
             p_frag = NULL;
         }
 
-        p_pic = block_ChainGather( p_sys->p_frame );
+        p_pic = packetizer_ChainGather( &p_sys->packetizer, p_sys->p_frame );
 
         if( b_eos )
             p_pic->i_flags |= BLOCK_FLAG_END_OF_SEQUENCE;
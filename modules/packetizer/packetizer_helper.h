@@ -25,6 +25,7 @@
 #define _PACKETIZER_H 1
 
 #include <vlc_block.h>
+#include <vlc_atomic.h>
 
 enum
 {
@@ -49,6 +50,7 @@ typedef struct
 
     int i_startcode;
     const uint8_t *p_startcode;
+    block_startcode_helper_t pf_startcode_helper;
 
     int i_au_prepend;
     const uint8_t *p_au_prepend;
@@ -60,10 +62,93 @@ typedef struct
     packetizer_parse_t    pf_parse;
     packetizer_validate_t pf_validate;
 
+    /* Statistics */
+    uint64_t i_bytes;
+    uint64_t i_bytes_copied;
+
 } packetizer_t;
 
+/* Blocks pushed in the bytestream are wrapped into a reference counted
+ * block, so that the units found inside a single block can be handed out as
+ * slices of it instead of copies. Slices must be considered read-only. */
+typedef struct
+{
+    block_t self;
+    block_t *p_source;
+    atomic_uint refs;
+} packetizer_shared_t;
+
+typedef struct
+{
+    block_t self;
+    packetizer_shared_t *p_shared;
+} packetizer_slice_t;
+
+static inline void packetizer_SharedRelease( block_t *p_block )
+{
+    packetizer_shared_t *p_shared = (packetizer_shared_t *)p_block;
+
+    if( atomic_fetch_sub( &p_shared->refs, 1 ) == 1 )
+    {
+        block_Release( p_shared->p_source );
+        free( p_shared );
+    }
+}
+
+static inline block_t *packetizer_SharedNew( block_t *p_source )
+{
+    packetizer_shared_t *p_shared = malloc( sizeof(*p_shared) );
+    if( unlikely(p_shared == NULL) )
+        return p_source;
+
+    block_t *p_block = &p_shared->self;
+    block_Init( p_block, p_source->p_buffer, p_source->i_buffer );
+    p_block->i_flags = p_source->i_flags;
+    p_block->i_nb_samples = p_source->i_nb_samples;
+    p_block->i_pts = p_source->i_pts;
+    p_block->i_dts = p_source->i_dts;
+    p_block->i_length = p_source->i_length;
+    p_block->pf_release = packetizer_SharedRelease;
+
+    p_shared->p_source = p_source;
+    atomic_init( &p_shared->refs, 1 );
+    return p_block;
+}
+
+static inline void packetizer_SliceRelease( block_t *p_block )
+{
+    packetizer_slice_t *p_slice = (packetizer_slice_t *)p_block;
+
+    packetizer_SharedRelease( &p_slice->p_shared->self );
+    free( p_slice );
+}
+
+static inline bool packetizer_IsSlice( const block_t *p_block )
+{
+    return p_block->pf_release == packetizer_SliceRelease;
+}
+
+/* The slice has no head nor tail room, so that block_Realloc() never grows
+ * it over the data of the neighbouring units. */
+static inline block_t *packetizer_SliceNew( packetizer_shared_t *p_shared,
+                                            uint8_t *p_data, size_t i_data )
+{
+    packetizer_slice_t *p_slice = malloc( sizeof(*p_slice) );
+    if( unlikely(p_slice == NULL) )
+        return NULL;
+
+    block_t *p_block = &p_slice->self;
+    block_Init( p_block, p_data, i_data );
+    p_block->pf_release = packetizer_SliceRelease;
+
+    atomic_fetch_add( &p_shared->refs, 1 );
+    p_slice->p_shared = p_shared;
+    return p_block;
+}
+
 static inline void packetizer_Init( packetizer_t *p_pack,
                                     const uint8_t *p_startcode, int i_startcode,
+                                    block_startcode_helper_t pf_startcode_helper,
                                     const uint8_t *p_au_prepend, int i_au_prepend,
                                     unsigned i_au_min_size,
                                     packetizer_reset_t pf_reset,
@@ -82,10 +167,14 @@ static inline void packetizer_Init( packetizer_t *p_pack,
 
     p_pack->i_startcode = i_startcode;
     p_pack->p_startcode = p_startcode;
+    p_pack->pf_startcode_helper = pf_startcode_helper;
     p_pack->pf_reset = pf_reset;
     p_pack->pf_parse = pf_parse;
     p_pack->pf_validate = pf_validate;
     p_pack->p_private = p_private;
+
+    p_pack->i_bytes = 0;
+    p_pack->i_bytes_copied = 0;
 }
 
 static inline void packetizer_Clean( packetizer_t *p_pack )
@@ -93,6 +182,118 @@ static inline void packetizer_Clean( packetizer_t *p_pack )
     block_BytestreamRelease( &p_pack->bytestream );
 }
 
+static inline void packetizer_Stats( vlc_object_t *p_obj, const packetizer_t *p_pack )
+{
+    if( p_pack->i_bytes > 0 )
+        msg_Dbg( p_obj, "%"PRIu64" bytes packetized, %.1f%% copied",
+                 p_pack->i_bytes,
+                 100. * p_pack->i_bytes_copied / p_pack->i_bytes );
+}
+
+/**
+ * Gathers a chain of units, like block_ChainGather().
+ *
+ * Consecutive slices of the same block are merged without copying; the data
+ * is only copied when the units come from different blocks.
+ */
+static inline block_t *packetizer_ChainGather( packetizer_t *p_pack,
+                                               block_t *p_list )
+{
+    if( p_list->p_next == NULL )
+        return p_list;  /* Already gathered */
+
+    size_t  i_total;
+    mtime_t i_length;
+    block_ChainProperties( p_list, NULL, &i_total, &i_length );
+
+    block_t *g = NULL;
+    if( packetizer_IsSlice( p_list ) )
+    {
+        packetizer_shared_t *p_shared = ((packetizer_slice_t *)p_list)->p_shared;
+        const uint8_t *p_end = p_list->p_buffer + p_list->i_buffer;
+        block_t *p_block;
+
+        for( p_block = p_list->p_next; p_block != NULL; p_block = p_block->p_next )
+        {
+            if( !packetizer_IsSlice( p_block ) ||
+                ((packetizer_slice_t *)p_block)->p_shared != p_shared ||
+                p_block->p_buffer != p_end )
+                break;
+            p_end += p_block->i_buffer;
+        }
+        if( p_block == NULL )
+            g = packetizer_SliceNew( p_shared, p_list->p_buffer, i_total );
+    }
+
+    if( g == NULL )
+    {
+        g = block_Alloc( i_total );
+        if( unlikely(g == NULL) )
+        {
+            block_ChainRelease( p_list );
+            return NULL;
+        }
+        block_ChainExtract( p_list, g->p_buffer, g->i_buffer );
+        p_pack->i_bytes_copied += i_total;
+    }
+
+    g->i_flags = p_list->i_flags;
+    g->i_pts   = p_list->i_pts;
+    g->i_dts   = p_list->i_dts;
+    g->i_length = i_length;
+
+    block_ChainRelease( p_list );
+    return g;
+}
+
+/* Extracts the next i_offset bytes of the bytestream, preceded by the AU
+ * prepend. When they lie in a single block (and the prepend is already
+ * there), a slice of that block is returned instead of a copy. */
+static inline block_t *packetizer_GetUnit( packetizer_t *p_pack )
+{
+    block_bytestream_t *p_bs = &p_pack->bytestream;
+    block_t *p_block = p_bs->p_block;
+    const size_t i_prepend = p_pack->i_au_prepend;
+    const size_t i_unit = i_prepend + p_pack->i_offset;
+    block_t *p_pic = NULL;
+
+    p_pack->i_bytes += i_unit;
+
+    /* The prepend may lie in the data already consumed (or popped) */
+    if( p_block->pf_release == packetizer_SharedRelease &&
+        p_block->i_buffer - p_bs->i_offset >= p_pack->i_offset )
+    {
+        packetizer_shared_t *p_shared = (packetizer_shared_t *)p_block;
+        uint8_t *p_unit = &p_block->p_buffer[p_bs->i_offset];
+
+        if( (size_t)(p_unit - p_shared->p_source->p_buffer) >= i_prepend &&
+            !memcmp( p_unit - i_prepend, p_pack->p_au_prepend, i_prepend ) )
+        {
+            p_pic = packetizer_SliceNew( p_shared, p_unit - i_prepend, i_unit );
+            if( p_pic != NULL )
+                block_SkipBytes( p_bs, p_pack->i_offset );
+        }
+    }
+
+    if( p_pic == NULL )
+    {
+        p_pic = block_Alloc( i_unit );
+        if( unlikely(p_pic == NULL) )
+        {
+            block_SkipBytes( p_bs, p_pack->i_offset );
+            return NULL;
+        }
+        block_GetBytes( p_bs, &p_pic->p_buffer[i_prepend], p_pack->i_offset );
+        if( i_prepend > 0 )
+            memcpy( p_pic->p_buffer, p_pack->p_au_prepend, i_prepend );
+        p_pack->i_bytes_copied += i_unit;
+    }
+
+    p_pic->i_pts = p_block->i_pts;
+    p_pic->i_dts = p_block->i_dts;
+    return p_pic;
+}
+
 static inline block_t *packetizer_Packetize( packetizer_t *p_pack, block_t **pp_block )
 {
     if( !pp_block || !*pp_block )
@@ -113,6 +314,9 @@ static inline block_t *packetizer_Packetize( packetizer_t *p_pack, block_t **pp_
         return NULL;
     }
 
+    /* Blocks popped out of the bytestream come back already wrapped */
+    if( (*pp_block)->pf_release != packetizer_SharedRelease )
+        *pp_block = packetizer_SharedNew( *pp_block );
     block_BytestreamPush( &p_pack->bytestream, *pp_block );
 
     for( ;; )
@@ -125,7 +329,8 @@ static inline block_t *packetizer_Packetize( packetizer_t *p_pack, block_t **pp_
         case STATE_NOSYNC:
             /* Find a startcode */
             if( !block_FindStartcodeFromOffset( &p_pack->bytestream, &p_pack->i_offset,
-                                                p_pack->p_startcode, p_pack->i_startcode ) )
+                                                p_pack->p_startcode, p_pack->i_startcode,
+                                                p_pack->pf_startcode_helper ) )
                 p_pack->i_state = STATE_NEXT_SYNC;
 
             if( p_pack->i_offset )
@@ -143,7 +348,8 @@ static inline block_t *packetizer_Packetize( packetizer_t *p_pack, block_t **pp_
         case STATE_NEXT_SYNC:
             /* Find the next startcode */
             if( block_FindStartcodeFromOffset( &p_pack->bytestream, &p_pack->i_offset,
-                                               p_pack->p_startcode, p_pack->i_startcode ) )
+                                               p_pack->p_startcode, p_pack->i_startcode,
+                                               p_pack->pf_startcode_helper ) )
             {
                 if( !p_pack->b_flushing || !p_pack->bytestream.p_chain )
                     return NULL; /* Need more data */
@@ -163,17 +369,16 @@ static inline block_t *packetizer_Packetize( packetizer_t *p_pack, block_t **pp_
             /* Get the new fragment and set the pts/dts */
             block_t *p_block_bytestream = p_pack->bytestream.p_block;
 
-            p_pic = block_Alloc( p_pack->i_offset + p_pack->i_au_prepend );
-            p_pic->i_pts = p_block_bytestream->i_pts;
-            p_pic->i_dts = p_block_bytestream->i_dts;
-
-            block_GetBytes( &p_pack->bytestream, &p_pic->p_buffer[p_pack->i_au_prepend],
-                            p_pic->i_buffer - p_pack->i_au_prepend );
-            if( p_pack->i_au_prepend > 0 )
-                memcpy( p_pic->p_buffer, p_pack->p_au_prepend, p_pack->i_au_prepend );
+            p_pic = packetizer_GetUnit( p_pack );
 
             p_pack->i_offset = 0;
 
+            if( unlikely(p_pic == NULL) )
+            {
+                p_pack->i_state = STATE_NOSYNC;
+                break;
+            }
+
             /* Parse the NAL */
             if( p_pic->i_buffer < p_pack->i_au_min_size )
             {
@@ -202,8 +407,25 @@ static inline block_t *packetizer_Packetize( packetizer_t *p_pack, block_t **pp_
                 break;
             }
 
+            /* Units may have been trimmed by the parser: give up the room
+             * left behind, it belongs to the following units. */
+            for( block_t *p_unit = p_pic; p_unit != NULL; p_unit = p_unit->p_next )
+            {
+                if( packetizer_IsSlice( p_unit ) )
+                {
+                    p_unit->p_start = p_unit->p_buffer;
+                    p_unit->i_size = p_unit->i_buffer;
+                }
+            }
+
             /* So p_block doesn't get re-added several times */
             *pp_block = block_BytestreamPop( &p_pack->bytestream );
+            if( *pp_block != NULL )
+            {
+                /* The head room may be shared with the units handed out */
+                (*pp_block)->p_start = (*pp_block)->p_buffer;
+                (*pp_block)->i_size = (*pp_block)->i_buffer;
+            }
 
             p_pack->i_state = STATE_NOSYNC;
 
@@ -0,0 +1,140 @@
+/*****************************************************************************
+ * startcode_helper.h: Annex B start code search
+ *****************************************************************************
+ * Copyright (C) 2015 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifndef VLC_STARTCODE_HELPER_H_
+#define VLC_STARTCODE_HELPER_H_
+
+#include <vlc_cpu.h>
+
+#if defined(__i386__) || defined(__x86_64__)
+# if defined(__SSE2__) || VLC_GCC_VERSION(4,9)
+#  include <emmintrin.h>
+#  define STARTCODE_SSE2
+#  ifdef __SSE2__
+#   define STARTCODE_SSE2_ATTR
+#  else
+#   define STARTCODE_SSE2_ATTR __attribute__ ((__target__ ("sse2")))
+#  endif
+# endif
+# if defined(__AVX2__) || VLC_GCC_VERSION(4,9)
+#  include <immintrin.h>
+#  define STARTCODE_AVX2
+#  ifdef __AVX2__
+#   define STARTCODE_AVX2_ATTR
+#  else
+#   define STARTCODE_AVX2_ATTR __attribute__ ((__target__ ("avx2")))
+#  endif
+# endif
+#endif
+
+/* Looks for 00 00 01 three bytes at a time: if the third byte is above 1,
+ * no start code can begin at any of those three positions. */
+static inline const uint8_t *startcode_FindAnnexB_C( const uint8_t *p,
+                                                     const uint8_t *end )
+{
+    while( end - p >= 3 )
+    {
+        if( p[2] > 1 )
+            p += 3;
+        else if( p[2] == 0 )
+            p++;
+        else if( p[0] == 0 && p[1] == 0 )
+            return p;
+        else
+            p += 3;
+    }
+    return NULL;
+}
+
+#ifdef STARTCODE_SSE2
+STARTCODE_SSE2_ATTR
+static inline const uint8_t *startcode_FindAnnexB_SSE2( const uint8_t *p,
+                                                        const uint8_t *end )
+{
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i one = _mm_set1_epi8( 1 );
+
+    /* Compare 16 candidate positions at once; the last load reads up to
+     * p + 17, hence the 18 bytes margin. */
+    for( ; end - p >= 18; p += 16 )
+    {
+        __m128i b0 = _mm_loadu_si128( (const __m128i *)p );
+        __m128i b1 = _mm_loadu_si128( (const __m128i *)(p + 1) );
+        __m128i b2 = _mm_loadu_si128( (const __m128i *)(p + 2) );
+        __m128i match = _mm_and_si128( _mm_cmpeq_epi8( b0, zero ),
+                                       _mm_cmpeq_epi8( b1, zero ) );
+        match = _mm_and_si128( match, _mm_cmpeq_epi8( b2, one ) );
+
+        unsigned mask = _mm_movemask_epi8( match );
+        if( mask != 0 )
+            return p + ctz( mask );
+    }
+    return startcode_FindAnnexB_C( p, end );
+}
+#endif
+
+#ifdef STARTCODE_AVX2
+STARTCODE_AVX2_ATTR
+static inline const uint8_t *startcode_FindAnnexB_AVX2( const uint8_t *p,
+                                                        const uint8_t *end )
+{
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i one = _mm256_set1_epi8( 1 );
+
+    for( ; end - p >= 34; p += 32 )
+    {
+        __m256i b0 = _mm256_loadu_si256( (const __m256i *)p );
+        __m256i b1 = _mm256_loadu_si256( (const __m256i *)(p + 1) );
+        __m256i b2 = _mm256_loadu_si256( (const __m256i *)(p + 2) );
+        __m256i match = _mm256_and_si256( _mm256_cmpeq_epi8( b0, zero ),
+                                          _mm256_cmpeq_epi8( b1, zero ) );
+        match = _mm256_and_si256( match, _mm256_cmpeq_epi8( b2, one ) );
+
+        unsigned mask = _mm256_movemask_epi8( match );
+        if( mask != 0 )
+            return p + ctz( mask );
+    }
+    return startcode_FindAnnexB_C( p, end );
+}
+#endif
+
+/**
+ * Finds the first 00 00 01 start code entirely contained in [p, end).
+ *
+ * This can be passed as block_FindStartcodeFromOffset() helper when the
+ * start code is 00 00 01.
+ *
+ * @return a pointer to the first byte of the start code, or NULL
+ */
+static inline const uint8_t *startcode_FindAnnexB( const uint8_t *p,
+                                                   const uint8_t *end )
+{
+#ifdef STARTCODE_AVX2
+    if( vlc_CPU_AVX2() )
+        return startcode_FindAnnexB_AVX2( p, end );
+#endif
+#ifdef STARTCODE_SSE2
+    if( vlc_CPU_SSE2() )
+        return startcode_FindAnnexB_SSE2( p, end );
+#endif
+    return startcode_FindAnnexB_C( p, end );
+}
+
+#endif
@@ -38,6 +38,7 @@
 #include <vlc_bits.h>
 #include <vlc_block_helper.h>
 #include "packetizer_helper.h"
+#include "startcode_helper.h"
 
 /*****************************************************************************
  * Module descriptor
@@ -143,6 +144,7 @@ static int Open( vlc_object_t *p_this )
 
     packetizer_Init( &p_sys->packetizer,
                      p_vc1_startcode, sizeof(p_vc1_startcode),
+                     startcode_FindAnnexB,
                      NULL, 0, 4,
                      PacketizeReset, PacketizeParse, PacketizeValidate, p_dec );
 
@@ -189,6 +191,7 @@ static void Close( vlc_object_t *p_this )
     decoder_t     *p_dec = (decoder_t*)p_this;
     decoder_sys_t *p_sys = p_dec->p_sys;
 
+    packetizer_Stats( VLC_OBJECT(p_dec), &p_sys->packetizer );
     packetizer_Clean( &p_sys->packetizer );
     if( p_sys->p_frame )
         block_Release( p_sys->p_frame );
@@ -362,7 +365,7 @@ static block_t *ParseIDU( decoder_t *p_dec, bool *pb_ts_used, block_t *p_frag )
         }
 
         /* */
-        p_pic = block_ChainGather( p_sys->p_frame );
+        p_pic = packetizer_ChainGather( &p_sys->packetizer, p_sys->p_frame );
         p_pic->i_dts = p_sys->i_frame_dts;
         p_pic->i_pts = p_sys->i_frame_pts;
 
@@ -451,10 +454,17 @@ static block_t *ParseIDU( decoder_t *p_dec, bool *pb_ts_used, block_t *p_frag )
                     p_es->video.i_width  = i_potential_width;
                     p_es->video.i_height = i_potential_height;
 
-                    /* Remove it */
-                    p_frag->p_buffer += 4;
-                    p_frag->i_buffer -= 4;
-                    memcpy( p_frag->p_buffer, startcode, sizeof(startcode) );
+                    /* Remove it, from a copy as the fragment may be a
+                     * read-only slice of the packetizer input */
+                    block_t *p_copy = block_Duplicate( p_frag );
+                    if( p_copy != NULL )
+                    {
+                        block_Release( p_frag );
+                        p_release = p_frag = p_copy;
+                        p_frag->p_buffer += 4;
+                        p_frag->i_buffer -= 4;
+                        memcpy( p_frag->p_buffer, startcode, sizeof(startcode) );
+                    }
                 }
             }
         }
@@ -49,11 +49,18 @@
 static int  Open (vlc_object_t *);
 static void Close(vlc_object_t *);
 
+#define THREADS_TEXT N_("Parallel segment downloads")
+#define THREADS_LONGTEXT N_( \
+    "Number of segments downloaded at the same time. Segments are still " \
+    "played back in order.")
+
 vlc_module_begin()
     set_category(CAT_INPUT)
     set_subcategory(SUBCAT_INPUT_STREAM_FILTER)
     set_description(N_("Http Live Streaming stream filter"))
     set_capability("stream_filter", 20)
+    add_integer_with_range("hls-segment-threads", 3, 1, 8,
+                           THREADS_TEXT, THREADS_LONGTEXT, true)
     set_callbacks(Open, Close)
 vlc_module_end()
 
@@ -61,6 +68,7 @@ vlc_module_end()
  *
  *****************************************************************************/
 #define AES_BLOCK_SIZE 16 /* Only support AES-128 */
+#define HLS_READ_CHUNK 65536 /* download and decryption granularity */
 typedef struct segment_s
 {
     int         sequence;   /* unique sequence number */
@@ -102,20 +110,25 @@ struct stream_sys_t
 {
     char         *m3u8;         /* M3U8 url */
     vlc_thread_t  reload;       /* HLS m3u8 reload thread */
-    vlc_thread_t  thread;       /* HLS segment download thread */
+    vlc_thread_t *threads;      /* HLS segment download threads */
+    int           i_threads;
 
     block_t      *peeked;
 
     /* */
     vlc_array_t  *hls_stream;   /* bandwidth adaptation */
-    uint64_t      bandwidth;    /* measured bandwidth (bits per second) */
+    uint64_t      bandwidth;    /* measured bandwidth (bits per second),
+                                   protected by download.lock_wait */
 
     /* Download */
     struct hls_download_s
     {
         int         stream;     /* current hls_stream  */
-        int         segment;    /* current segment for downloading */
+        int         segment;    /* first segment not downloaded yet */
+        int         next;       /* next segment to claim for downloading */
+        uint32_t    done;       /* segments downloaded after "segment" */
         int         seek;       /* segment requested by seek (default -1) */
+        int         active;     /* segments being downloaded */
         vlc_mutex_t lock_wait;  /* protect segment download counter */
         vlc_cond_t  wait;       /* some condition to wait on */
     } download;
@@ -166,7 +179,8 @@ static ssize_t read_M3U8_from_stream(stream_t *s, uint8_t **buffer);
 static ssize_t read_M3U8_from_url(stream_t *s, const char *psz_url, uint8_t **buffer);
 static char *ReadLine(uint8_t *buffer, uint8_t **pos, size_t len);
 
-static int hls_Download(stream_t *s, segment_t *segment);
+static int hls_Download(stream_t *s, hls_stream_t *hls, segment_t *segment,
+                        block_t **pp_data, mtime_t *pi_duration);
 
 static void* hls_Thread(void *);
 static void* hls_Reload(void *);
@@ -1241,20 +1255,35 @@ static int hls_ManageSegmentKeys(stream_t *s, hls_stream_t *hls)
     return VLC_SUCCESS;
 }
 
-static int hls_DecodeSegmentData(stream_t *s, hls_stream_t *hls, segment_t *segment)
+static int hls_OpenSegmentCipher(stream_t *s, hls_stream_t *hls, segment_t *segment,
+                                 gcry_cipher_hd_t *p_aes_ctx)
 {
-    /* Did the segment need to be decoded ? */
-    if (segment->psz_key_path == NULL)
-        return VLC_SUCCESS;
-
     /* Do we have loaded the key ? */
+    vlc_mutex_lock(&hls->lock);
     if (!segment->b_key_loaded)
     {
         /* No ? try to download it now */
         if (hls_ManageSegmentKeys(s, hls) != VLC_SUCCESS)
+        {
+            vlc_mutex_unlock(&hls->lock);
             return VLC_EGENERIC;
+        }
     }
 
+    /* Segments may be downloaded concurrently, do not store the IV */
+    uint8_t iv[AES_BLOCK_SIZE];
+    if (hls->b_iv_loaded == false)
+    {
+        memset(iv, 0, AES_BLOCK_SIZE);
+        iv[15] = segment->sequence & 0xff;
+        iv[14] = (segment->sequence >> 8)& 0xff;
+        iv[13] = (segment->sequence >> 16)& 0xff;
+        iv[12] = (segment->sequence >> 24)& 0xff;
+    }
+    else
+        memcpy(iv, hls->psz_AES_IV, AES_BLOCK_SIZE);
+    vlc_mutex_unlock(&hls->lock);
+
     /* For now, we only decode AES-128 data */
     gcry_error_t i_gcrypt_err;
     gcry_cipher_hd_t aes_ctx;
@@ -1278,18 +1307,7 @@ static int hls_DecodeSegmentData(stream_t *s, hls_stream_t *hls, segment_t *segm
         return VLC_EGENERIC;
     }
 
-    if (hls->b_iv_loaded == false)
-    {
-        memset(hls->psz_AES_IV, 0, AES_BLOCK_SIZE);
-        hls->psz_AES_IV[15] = segment->sequence & 0xff;
-        hls->psz_AES_IV[14] = (segment->sequence >> 8)& 0xff;
-        hls->psz_AES_IV[13] = (segment->sequence >> 16)& 0xff;
-        hls->psz_AES_IV[12] = (segment->sequence >> 24)& 0xff;
-    }
-
-    i_gcrypt_err = gcry_cipher_setiv(aes_ctx, hls->psz_AES_IV,
-                                      sizeof(hls->psz_AES_IV));
-
+    i_gcrypt_err = gcry_cipher_setiv(aes_ctx, iv, sizeof(iv));
     if (i_gcrypt_err)
     {
         msg_Err(s, "gcry_cipher_setiv failed: %s", gpg_strerror(i_gcrypt_err));
@@ -1297,20 +1315,44 @@ static int hls_DecodeSegmentData(stream_t *s, hls_stream_t *hls, segment_t *segm
         return VLC_EGENERIC;
     }
 
+    *p_aes_ctx = aes_ctx;
+    return VLC_SUCCESS;
+}
+
+/* Decrypts in place the whole AES blocks of the segment data not yet
+ * decrypted, the cipher context carrying the CBC state over */
+static int hls_DecryptSegmentData(stream_t *s, gcry_cipher_hd_t aes_ctx,
+                                  block_t *data, size_t *pi_decrypted)
+{
+    size_t i_end = data->i_buffer & ~(size_t)(AES_BLOCK_SIZE - 1);
+    if (i_end <= *pi_decrypted)
+        return VLC_SUCCESS;
+
+    gcry_error_t i_gcrypt_err;
     i_gcrypt_err = gcry_cipher_decrypt(aes_ctx,
-                                       segment->data->p_buffer, /* out */
-                                       segment->data->i_buffer,
+                                       &data->p_buffer[*pi_decrypted], /* out */
+                                       i_end - *pi_decrypted,
                                        NULL, /* in */
                                        0);
     if (i_gcrypt_err)
     {
         msg_Err(s, "gcry_cipher_decrypt failed:  %s/%s\n", gcry_strsource(i_gcrypt_err), gcry_strerror(i_gcrypt_err));
-        gcry_cipher_close(aes_ctx);
         return VLC_EGENERIC;
     }
-    gcry_cipher_close(aes_ctx);
+    *pi_decrypted = i_end;
+    return VLC_SUCCESS;
+}
+
+static int hls_StripSegmentPadding(stream_t *s, block_t *data)
+{
+    if (data->i_buffer == 0 || (data->i_buffer % AES_BLOCK_SIZE) != 0)
+    {
+        msg_Err(s, "Bad encrypted segment size (%zu)", data->i_buffer);
+        return VLC_EGENERIC;
+    }
+
     /* remove the PKCS#7 padding from the buffer */
-    int pad = segment->data->p_buffer[segment->data->i_buffer-1];
+    int pad = data->p_buffer[data->i_buffer-1];
     if (pad <= 0 || pad > AES_BLOCK_SIZE)
     {
         msg_Err(s, "Bad padding character (0x%x), perhaps we failed to decrypt the segment with the correct key", pad);
@@ -1319,7 +1361,7 @@ static int hls_DecodeSegmentData(stream_t *s, hls_stream_t *hls, segment_t *segm
     int count = pad;
     while (count--)
     {
-        if (segment->data->p_buffer[segment->data->i_buffer-1-count] != pad)
+        if (data->p_buffer[data->i_buffer-1-count] != pad)
         {
                 msg_Err(s, "Bad ending buffer, perhaps we failed to decrypt the segment with the correct key");
                 return VLC_EGENERIC;
@@ -1327,7 +1369,7 @@ static int hls_DecodeSegmentData(stream_t *s, hls_stream_t *hls, segment_t *segm
     }
 
     /* not all the data is readable because of padding */
-    segment->data->i_buffer -= pad;
+    data->i_buffer -= pad;
 
     return VLC_SUCCESS;
 }
@@ -1519,7 +1561,7 @@ static int hls_ReloadPlaylist(stream_t *s)
     if (stream_appended == true)
     {
         vlc_mutex_lock(&p_sys->download.lock_wait);
-        vlc_cond_signal(&p_sys->download.wait);
+        vlc_cond_broadcast(&p_sys->download.wait);
         vlc_mutex_unlock(&p_sys->download.lock_wait);
     }
 
@@ -1559,6 +1601,8 @@ static int BandwidthAdaptation(stream_t *s, int progid, uint64_t *bandwidth)
     return candidate;
 }
 
+/* The bandwidth figures and *cur_stream are shared by the download threads:
+ * they are only accessed with download.lock_wait held. */
 static int hls_DownloadSegmentData(stream_t *s, hls_stream_t *hls, segment_t *segment, int *cur_stream)
 {
     stream_sys_t *p_sys = s->p_sys;
@@ -1567,18 +1611,24 @@ static int hls_DownloadSegmentData(stream_t *s, hls_stream_t *hls, segment_t *se
     assert(segment);
 
     vlc_mutex_lock(&segment->lock);
-    if (segment->data != NULL)
+    bool b_downloaded = segment->data != NULL;
+    vlc_mutex_unlock(&segment->lock);
+    if (b_downloaded)
     {
         /* Segment already downloaded */
-        vlc_mutex_unlock(&segment->lock);
         return VLC_SUCCESS;
     }
 
     /* sanity check - can we download this segment on time? */
-    if ((p_sys->bandwidth > 0) && (hls->bandwidth > 0))
+    vlc_mutex_lock(&p_sys->download.lock_wait);
+    uint64_t link_bw = p_sys->bandwidth;
+    uint64_t stream_bw = hls->bandwidth;
+    vlc_mutex_unlock(&p_sys->download.lock_wait);
+
+    if ((link_bw > 0) && (stream_bw > 0))
     {
-        uint64_t size = (segment->duration * hls->bandwidth); /* bits */
-        int estimated = (int)(size / p_sys->bandwidth);
+        uint64_t size = (segment->duration * stream_bw); /* bits */
+        int estimated = (int)(size / link_bw);
         if (estimated > segment->duration)
         {
             msg_Warn(s,"downloading segment %d predicted to take %ds, which exceeds its length (%ds)",
@@ -1586,34 +1636,45 @@ static int hls_DownloadSegmentData(stream_t *s, hls_stream_t *hls, segment_t *se
         }
     }
 
-    mtime_t start = mdate();
-    if (hls_Download(s, segment) != VLC_SUCCESS)
+    /* The segment is only published once complete (and decrypted), so
+     * that readers and other downloaders never wait on a transfer */
+    block_t *data;
+    mtime_t duration;
+    if (hls_Download(s, hls, segment, &data, &duration) != VLC_SUCCESS)
     {
+        vlc_mutex_lock(&p_sys->download.lock_wait);
         msg_Err(s, "downloading segment %d from stream %d failed",
                     segment->sequence, *cur_stream);
-        vlc_mutex_unlock(&segment->lock);
+        vlc_mutex_unlock(&p_sys->download.lock_wait);
         return VLC_EGENERIC;
     }
-    mtime_t duration = mdate() - start;
-    if (hls->bandwidth == 0 && segment->duration > 0)
-    {
-        /* Try to estimate the bandwidth for this stream */
-        hls->bandwidth = (uint64_t)(((double)segment->size * 8) / ((double)segment->duration));
-    }
+    uint64_t size = data->i_buffer;
 
-    /* If the segment is encrypted, decode it */
-    if (hls_DecodeSegmentData(s, hls, segment) != VLC_SUCCESS)
+    vlc_mutex_lock(&segment->lock);
+    if (segment->data == NULL)
     {
-        vlc_mutex_unlock(&segment->lock);
-        return VLC_EGENERIC;
+        segment->data = data;
+        segment->size = size;
     }
-
+    else /* Downloaded twice (after a seek) */
+        block_Release(data);
     vlc_mutex_unlock(&segment->lock);
 
+    vlc_mutex_lock(&p_sys->download.lock_wait);
     msg_Dbg(s, "downloaded segment %d from stream %d",
                 segment->sequence, *cur_stream);
 
-    uint64_t bw = segment->size * 8 * 1000000 / __MAX(1, duration); /* bits / s */
+    if (hls->bandwidth == 0 && segment->duration > 0)
+    {
+        /* Try to estimate the bandwidth for this stream */
+        vlc_mutex_lock(&hls->lock);
+        hls->bandwidth = (uint64_t)(((double)size * 8) / ((double)segment->duration));
+        vlc_mutex_unlock(&hls->lock);
+    }
+
+    /* Concurrent downloads share the link */
+    int active = __MAX(p_sys->download.active, 1);
+    uint64_t bw = size * 8 * 1000000 / __MAX(1, duration) * active; /* bits / s */
     p_sys->bandwidth = bw;
     if (p_sys->b_meta && (hls->bandwidth != bw))
     {
@@ -1627,9 +1688,34 @@ static int hls_DownloadSegmentData(stream_t *s, hls_stream_t *hls, segment_t *se
             *cur_stream = newstream;
         }
     }
+    vlc_mutex_unlock(&p_sys->download.lock_wait);
     return VLC_SUCCESS;
 }
 
+/* Maximum distance between the first segment not downloaded yet and the
+ * next one to claim: bits of download.done */
+#define HLS_DOWNLOAD_WINDOW 32
+
+/* Records a finished segment, and moves download.segment past the ones
+ * downloaded in sequence. Must be called with download.lock_wait held. */
+static void hls_SegmentDone(stream_sys_t *p_sys, int i_segment)
+{
+    int i_bit = i_segment - p_sys->download.segment;
+
+    /* Claimed before a seek, out of the current window */
+    if (i_bit < 0 || i_bit >= HLS_DOWNLOAD_WINDOW)
+        return;
+
+    p_sys->download.done |= UINT32_C(1) << i_bit;
+    while (p_sys->download.done & 1)
+    {
+        p_sys->download.done >>= 1;
+        p_sys->download.segment++;
+    }
+}
+
+/* Each download thread picks the next segment to download, so that up to
+ * hls-segment-threads segments are transferred at the same time */
 static void* hls_Thread(void *p_this)
 {
     stream_t *s = (stream_t *)p_this;
@@ -1639,7 +1725,11 @@ static void* hls_Thread(void *p_this)
 
     while (vlc_object_alive(s))
     {
-        hls_stream_t *hls = hls_Get(p_sys->hls_stream, p_sys->download.stream);
+        vlc_mutex_lock(&p_sys->download.lock_wait);
+        int stream = p_sys->download.stream;
+        vlc_mutex_unlock(&p_sys->download.lock_wait);
+
+        hls_stream_t *hls = hls_Get(p_sys->hls_stream, stream);
         assert(hls);
 
         /* Sliding window (~60 seconds worth of movie) */
@@ -1648,13 +1738,15 @@ static void* hls_Thread(void *p_this)
         vlc_mutex_unlock(&hls->lock);
 
         /* Is there a new segment to process? */
+        vlc_mutex_lock(&p_sys->download.lock_wait);
         if ((!p_sys->b_live && (p_sys->playback.segment < (count - 6))) ||
-            (p_sys->download.segment >= count))
+            (p_sys->download.next >= count) ||
+            (p_sys->download.next - p_sys->download.segment >= HLS_DOWNLOAD_WINDOW))
         {
             /* wait */
-            vlc_mutex_lock(&p_sys->download.lock_wait);
-            while (((p_sys->download.segment - p_sys->playback.segment > 6) ||
-                    (p_sys->download.segment >= count)) &&
+            while (((p_sys->download.next - p_sys->playback.segment > 6) ||
+                    (p_sys->download.next >= count) ||
+                    (p_sys->download.next - p_sys->download.segment >= HLS_DOWNLOAD_WINDOW)) &&
                    (p_sys->download.seek == -1))
             {
                 vlc_cond_wait(&p_sys->download.wait, &p_sys->download.lock_wait);
@@ -1663,23 +1755,54 @@ static void* hls_Thread(void *p_this)
                 if (!vlc_object_alive(s))
                     break;
             }
-            /* */
-            if (p_sys->download.seek >= 0)
-            {
-                p_sys->download.segment = p_sys->download.seek;
-                p_sys->download.seek = -1;
-            }
+        }
+        /* */
+        if (p_sys->download.seek >= 0)
+        {
+            p_sys->download.segment = p_sys->download.seek;
+            p_sys->download.next = p_sys->download.seek;
+            p_sys->download.done = 0;
+            p_sys->download.seek = -1;
+        }
+
+        /* claim the segment */
+        int i_segment = p_sys->download.next;
+        if (i_segment >= count ||
+            i_segment - p_sys->download.segment >= HLS_DOWNLOAD_WINDOW)
+        {
             vlc_mutex_unlock(&p_sys->download.lock_wait);
+            continue; /* woken up with nothing to download */
         }
+        p_sys->download.next++;
+        p_sys->download.active++;
+        vlc_mutex_unlock(&p_sys->download.lock_wait);
 
-        if (!vlc_object_alive(s)) break;
+        if (!vlc_object_alive(s))
+        {
+            vlc_mutex_lock(&p_sys->download.lock_wait);
+            p_sys->download.active--;
+            vlc_mutex_unlock(&p_sys->download.lock_wait);
+            break;
+        }
 
         vlc_mutex_lock(&hls->lock);
-        segment_t *segment = segment_GetSegment(hls, p_sys->download.segment);
+        segment_t *segment = segment_GetSegment(hls, i_segment);
         vlc_mutex_unlock(&hls->lock);
 
-        if ((segment != NULL) &&
-            (hls_DownloadSegmentData(s, hls, segment, &p_sys->download.stream) != VLC_SUCCESS))
+        /* adapts the bandwidth, switching download.stream */
+        bool b_failed = (segment != NULL) &&
+            (hls_DownloadSegmentData(s, hls, segment,
+                                     &p_sys->download.stream) != VLC_SUCCESS);
+
+        vlc_mutex_lock(&p_sys->download.lock_wait);
+        p_sys->download.active--;
+        /* live streams skip the segments which failed */
+        if (!b_failed || p_sys->b_live)
+            hls_SegmentDone(p_sys, i_segment);
+        vlc_cond_broadcast(&p_sys->download.wait);
+        vlc_mutex_unlock(&p_sys->download.lock_wait);
+
+        if (b_failed)
         {
             if (!vlc_object_alive(s)) break;
 
@@ -1690,19 +1813,6 @@ static void* hls_Thread(void *p_this)
             }
         }
 
-        /* download succeeded */
-        /* determine next segment to download */
-        vlc_mutex_lock(&p_sys->download.lock_wait);
-        if (p_sys->download.seek >= 0)
-        {
-            p_sys->download.segment = p_sys->download.seek;
-            p_sys->download.seek = -1;
-        }
-        else if (p_sys->download.segment < count)
-            p_sys->download.segment++;
-        vlc_cond_signal(&p_sys->download.wait);
-        vlc_mutex_unlock(&p_sys->download.lock_wait);
-
         // In case of a successful download signal the read thread that data is available
         vlc_mutex_lock(&p_sys->read.lock_wait);
         vlc_cond_signal(&p_sys->read.wait);
@@ -1823,7 +1933,8 @@ static int Prefetch(stream_t *s, int *current)
 /****************************************************************************
  *
  ****************************************************************************/
-static int hls_Download(stream_t *s, segment_t *segment)
+static int hls_Download(stream_t *s, hls_stream_t *hls, segment_t *segment,
+                        block_t **pp_data, mtime_t *pi_duration)
 {
     stream_sys_t *p_sys = s->p_sys;
     assert(segment);
@@ -1833,82 +1944,90 @@ static int hls_Download(stream_t *s, segment_t *segment)
         vlc_cond_wait(&p_sys->wait, &p_sys->lock);
     vlc_mutex_unlock(&p_sys->lock);
 
+    /* Encrypted segments are decrypted while downloading */
+    gcry_cipher_hd_t aes_ctx = NULL;
+    if (segment->psz_key_path != NULL &&
+        hls_OpenSegmentCipher(s, hls, segment, &aes_ctx) != VLC_SUCCESS)
+        return VLC_EGENERIC;
+
     stream_t *p_ts = stream_UrlNew(s, segment->url);
     if (p_ts == NULL)
+    {
+        if (aes_ctx)
+            gcry_cipher_close(aes_ctx);
         return VLC_EGENERIC;
-
-    segment->size = stream_Size(p_ts);
-
-    if (segment->size == 0) {
-        int chunk_size = 65536;
-        segment->data = block_Alloc(chunk_size);
-        if (!segment->data)
-            goto nomem;
-        do {
-            if (segment->data->i_buffer - segment->size < chunk_size) {
-                chunk_size *= 2;
-                block_t *p_block = block_Realloc(segment->data, 0, segment->data->i_buffer + chunk_size);
-                if (!p_block) {
-                    block_Release(segment->data);
-                    segment->data = NULL;
-                    goto nomem;
-                }
-                segment->data = p_block;
-            }
-
-            ssize_t length = stream_Read(p_ts, segment->data->p_buffer + segment->size, chunk_size);
-            if (length <= 0) {
-                segment->data->i_buffer = segment->size;
-                break;
-            }
-            segment->size += length;
-        } while (vlc_object_alive(s));
-
-        stream_Delete(p_ts);
-        return VLC_SUCCESS;
     }
 
-    segment->data = block_Alloc(segment->size);
-    if (segment->data == NULL)
-        goto nomem;
+    /* The connection setup is not accounted in the transfer duration,
+     * it would skew the bandwidth estimation */
+    mtime_t start = mdate();
 
-    assert(segment->data->i_buffer == segment->size);
+    /* NOTE: Beware the size reported for a segment by the HLS server may not
+     * be correct, when downloading the segment data. Therefore check the size
+     * and enlarge the segment data block if necessary.
+     */
+    uint64_t size = stream_Size(p_ts);
+    block_t *data = block_Alloc(size > 0 ? size : HLS_READ_CHUNK);
+    if (data == NULL)
+        goto error;
 
-    ssize_t curlen = 0;
+    size_t curlen = 0, decrypted = 0;
     do
     {
-        /* NOTE: Beware the size reported for a segment by the HLS server may not
-         * be correct, when downloading the segment data. Therefore check the size
-         * and enlarge the segment data block if necessary.
-         */
-        uint64_t size = stream_Size(p_ts);
-        if (size > segment->size)
+        if (curlen == data->i_buffer)
         {
-            msg_Dbg(s, "size changed %"PRIu64, segment->size);
-            block_t *p_block = block_Realloc(segment->data, 0, size);
+            size = stream_Size(p_ts);
+            if (size > 0 && size <= curlen)
+                break; /* complete */
+
+            block_t *p_block = block_Realloc(data, 0,
+                                   __MAX(size, (uint64_t)curlen * 2));
             if (p_block == NULL)
-            {
-                block_Release(segment->data);
-                segment->data = NULL;
-                goto nomem;
-            }
-            segment->data = p_block;
-            segment->size = size;
-            assert(segment->data->i_buffer == segment->size);
-            p_block = NULL;
+                goto error;
+            data = p_block;
         }
-        ssize_t length = stream_Read(p_ts, segment->data->p_buffer + curlen, segment->size - curlen);
+
+        ssize_t length = stream_Read(p_ts, data->p_buffer + curlen,
+                                     __MIN(data->i_buffer - curlen, HLS_READ_CHUNK));
         if (length <= 0)
             break;
         curlen += length;
+
+        if (aes_ctx)
+        {
+            size_t i_buffer = data->i_buffer;
+            data->i_buffer = curlen;
+            int ret = hls_DecryptSegmentData(s, aes_ctx, data, &decrypted);
+            data->i_buffer = i_buffer;
+            if (ret != VLC_SUCCESS)
+                goto error;
+        }
     } while (vlc_object_alive(s));
 
+    *pi_duration = mdate() - start;
     stream_Delete(p_ts);
+    data->i_buffer = curlen;
+
+    if (aes_ctx)
+    {
+        gcry_cipher_close(aes_ctx);
+        if (hls_StripSegmentPadding(s, data) != VLC_SUCCESS)
+        {
+            block_Release(data);
+            return VLC_EGENERIC;
+        }
+    }
+
+    *pp_data = data;
     return VLC_SUCCESS;
 
-nomem:
+error:
+    if (data)
+        block_Release(data);
+    if (aes_ctx)
+        gcry_cipher_close(aes_ctx);
     stream_Delete(p_ts);
-    return VLC_ENOMEM;
+    return VLC_EGENERIC;
 }
 
 /* Read M3U8 file */
@@ -2071,6 +2190,12 @@ static int Open(vlc_object_t *p_this)
     vlc_cond_init(&p_sys->wait);
     vlc_mutex_init(&p_sys->lock);
 
+    vlc_mutex_init(&p_sys->download.lock_wait);
+    vlc_cond_init(&p_sys->download.wait);
+
+    vlc_mutex_init(&p_sys->read.lock_wait);
+    vlc_cond_init(&p_sys->read.wait);
+
     /* Parse HLS m3u8 content. */
     uint8_t *buffer = NULL;
     ssize_t len = read_M3U8_from_stream(s->p_source, &buffer);
@@ -2101,15 +2226,11 @@ static int Open(vlc_object_t *p_this)
     }
 
     p_sys->download.stream = current;
+    p_sys->download.next = p_sys->download.segment;
+    p_sys->download.done = 0;
     p_sys->playback.stream = current;
     p_sys->download.seek = -1;
 
-    vlc_mutex_init(&p_sys->download.lock_wait);
-    vlc_cond_init(&p_sys->download.wait);
-
-    vlc_mutex_init(&p_sys->read.lock_wait);
-    vlc_cond_init(&p_sys->read.wait);
-
     /* Initialize HLS live stream */
     if (p_sys->b_live)
     {
@@ -2120,27 +2241,37 @@ static int Open(vlc_object_t *p_this)
 
         if (vlc_clone(&p_sys->reload, hls_Reload, s, VLC_THREAD_PRIORITY_LOW))
         {
-            goto fail_thread;
+            goto fail;
         }
     }
 
-    if (vlc_clone(&p_sys->thread, hls_Thread, s, VLC_THREAD_PRIORITY_INPUT))
+    int i_threads = var_InheritInteger(s, "hls-segment-threads");
+    p_sys->threads = malloc(i_threads * sizeof(*p_sys->threads));
+    if (p_sys->threads == NULL)
+        goto fail_thread;
+    for (p_sys->i_threads = 0; p_sys->i_threads < i_threads; p_sys->i_threads++)
+        if (vlc_clone(&p_sys->threads[p_sys->i_threads], hls_Thread, s,
+                      VLC_THREAD_PRIORITY_INPUT))
+            break;
+    if (p_sys->i_threads == 0)
     {
-        if (p_sys->b_live)
-            vlc_join(p_sys->reload, NULL);
+        free(p_sys->threads);
         goto fail_thread;
     }
 
     return VLC_SUCCESS;
 
 fail_thread:
+    if (p_sys->b_live)
+        vlc_join(p_sys->reload, NULL);
+
+fail:
     vlc_mutex_destroy(&p_sys->download.lock_wait);
     vlc_cond_destroy(&p_sys->download.wait);
 
     vlc_mutex_destroy(&p_sys->read.lock_wait);
     vlc_cond_destroy(&p_sys->read.wait);
 
-fail:
     /* Free hls streams */
     for (int i = 0; i < vlc_array_count(p_sys->hls_stream); i++)
     {
@@ -2170,21 +2301,24 @@ static void Close(vlc_object_t *p_this)
 
     vlc_mutex_lock(&p_sys->lock);
     p_sys->paused = false;
-    vlc_cond_signal(&p_sys->wait);
+    vlc_cond_broadcast(&p_sys->wait);
     vlc_mutex_unlock(&p_sys->lock);
 
     /* */
     vlc_mutex_lock(&p_sys->download.lock_wait);
     /* negate the condition variable's predicate */
     p_sys->download.segment = p_sys->playback.segment = 0;
+    p_sys->download.next = 0;
     p_sys->download.seek = 0; /* better safe than sorry */
-    vlc_cond_signal(&p_sys->download.wait);
+    vlc_cond_broadcast(&p_sys->download.wait);
     vlc_mutex_unlock(&p_sys->download.lock_wait);
 
     /* */
     if (p_sys->b_live)
         vlc_join(p_sys->reload, NULL);
-    vlc_join(p_sys->thread, NULL);
+    for (int i = 0; i < p_sys->i_threads; i++)
+        vlc_join(p_sys->threads[i], NULL);
+    free(p_sys->threads);
     vlc_mutex_destroy(&p_sys->download.lock_wait);
     vlc_cond_destroy(&p_sys->download.wait);
 
@@ -2345,7 +2479,7 @@ static ssize_t hls_Read(stream_t *s, uint8_t *p_read, unsigned int i_read)
             /* signal download thread */
             vlc_mutex_lock(&p_sys->download.lock_wait);
             p_sys->playback.segment++;
-            vlc_cond_signal(&p_sys->download.wait);
+            vlc_cond_broadcast(&p_sys->download.wait);
             vlc_mutex_unlock(&p_sys->download.lock_wait);
             continue;
         }
@@ -2656,7 +2790,7 @@ static int segment_Seek(stream_t *s, const uint64_t pos)
         /* Wake up download thread */
         vlc_mutex_lock(&p_sys->download.lock_wait);
         p_sys->download.seek = p_sys->playback.segment;
-        vlc_cond_signal(&p_sys->download.wait);
+        vlc_cond_broadcast(&p_sys->download.wait);
 
         /* Wait for download to be finished */
         msg_Dbg(s, "seek to segment %d", p_sys->playback.segment);
@@ -2701,7 +2835,7 @@ static int Control(stream_t *s, int i_query, va_list args)
 
             vlc_mutex_lock(&p_sys->lock);
             p_sys->paused = paused;
-            vlc_cond_signal(&p_sys->wait);
+            vlc_cond_broadcast(&p_sys->wait);
             vlc_mutex_unlock(&p_sys->lock);
             break;
         }
@@ -1801,6 +1801,13 @@ static sout_access_out_t *GrabberCreate( sout_stream_t *p_stream )
     p_grab->p_sys       = (sout_access_out_sys_t *)p_stream;
     p_grab->pf_seek     = NULL;
     p_grab->pf_write    = AccessOutGrabberWrite;
+
+    /* Maximum payload size, for the muxer to size its writes */
+    int i_mtu = var_InheritInteger( p_stream, "mtu" );
+    if( i_mtu <= 12 + 16 )
+        i_mtu = 576 - 20 - 8; /* pessimistic */
+    var_Create( p_grab, "mtu", VLC_VAR_INTEGER );
+    var_SetInteger( p_grab, "mtu", i_mtu - 12 );
     return p_grab;
 }
 
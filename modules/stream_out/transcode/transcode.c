@@ -76,6 +76,17 @@
 #define MAXHEIGHT_TEXT N_("Maximum video height")
 #define MAXHEIGHT_LONGTEXT N_( \
     "Maximum output video height." )
+#define LADDER_TEXT N_("Video renditions")
+#define LADDER_LONGTEXT N_( \
+    "Comma-separated list of video renditions, each given as WIDTHxHEIGHT " \
+    "optionally followed by :BITRATE in kb/s (e.g. " \
+    "\"1280x720:3000,640x360:800\"). A zero width or height keeps the " \
+    "aspect ratio. The video is decoded and filtered once, then scaled and " \
+    "encoded for each rendition in its own thread. Rendition N is output " \
+    "in program N, along with a copy of the other elementary streams, so " \
+    "that it can be selected by the duplicate module. The first rendition " \
+    "overrides the width, height and bitrate; video filters and overlays " \
+    "only apply to it." )
 #define VFILTER_TEXT N_("Video filter")
 #define VFILTER_LONGTEXT N_( \
     "Video filters will be applied to the video streams (after overlays " \
@@ -177,6 +188,8 @@ vlc_module_begin ()
                  MAXWIDTH_LONGTEXT, true )
     add_integer( SOUT_CFG_PREFIX "maxheight", 0, MAXHEIGHT_TEXT,
                  MAXHEIGHT_LONGTEXT, true )
+    add_string( SOUT_CFG_PREFIX "ladder", NULL, LADDER_TEXT,
+                LADDER_LONGTEXT, true )
     add_module_list( SOUT_CFG_PREFIX "vfilter", "video filter2",
                      NULL, VFILTER_TEXT, VFILTER_LONGTEXT, false )
 
@@ -227,7 +240,7 @@ static const char *const ppsz_sout_options[] = {
     "deinterlace-module", "threads", "aenc", "acodec", "ab", "alang",
     "afilter", "samplerate", "channels", "senc", "scodec", "soverlay",
     "sfilter", "osd", "high-priority", "maxwidth", "maxheight",
-    NULL
+    "ladder", NULL
 };
 
 /*****************************************************************************
@@ -351,6 +364,47 @@ static int Open( vlc_object_t *p_this )
 
     p_sys->i_maxheight = var_GetInteger( p_stream, SOUT_CFG_PREFIX "maxheight" );
 
+    psz_string = var_GetString( p_stream, SOUT_CFG_PREFIX "ladder" );
+    p_sys->i_ladder = 0;
+    if( psz_string && *psz_string )
+    {
+        char *psz_save;
+
+        for( char *psz_rung = strtok_r( psz_string, ",", &psz_save );
+             psz_rung != NULL && p_sys->i_ladder < TRANSCODE_LADDER_MAX;
+             psz_rung = strtok_r( NULL, ",", &psz_save ) )
+        {
+            unsigned i_width, i_height;
+            int i_bitrate = 0;
+
+            if( sscanf( psz_rung, "%ux%u:%d", &i_width, &i_height,
+                        &i_bitrate ) < 2 )
+            {
+                msg_Warn( p_stream, "invalid video rendition `%s'", psz_rung );
+                continue;
+            }
+            p_sys->ladder[p_sys->i_ladder].i_width = i_width;
+            p_sys->ladder[p_sys->i_ladder].i_height = i_height;
+            p_sys->ladder[p_sys->i_ladder].i_bitrate =
+                i_bitrate > 0 ? i_bitrate * 1000 : p_sys->i_vbitrate;
+            p_sys->i_ladder++;
+        }
+    }
+    free( psz_string );
+
+    if( p_sys->i_ladder > 0 && !p_sys->i_vcodec )
+    {
+        msg_Warn( p_stream, "video renditions ignored without video codec" );
+        p_sys->i_ladder = 0;
+    }
+    else if( p_sys->i_ladder > 0 )
+    {
+        /* The first rendition is the one of the main video encoder */
+        p_sys->i_width = p_sys->ladder[0].i_width;
+        p_sys->i_height = p_sys->ladder[0].i_height;
+        p_sys->i_vbitrate = p_sys->ladder[0].i_bitrate;
+    }
+
     psz_string = var_GetString( p_stream, SOUT_CFG_PREFIX "vfilter" );
     if( psz_string && *psz_string )
         p_sys->psz_vf2 = strdup(psz_string );
@@ -504,11 +558,65 @@ static void Close( vlc_object_t * p_this )
     free( p_sys );
 }
 
+/* Copies an output elementary stream in the program of each additional
+ * video rendition, so that every rendition gets its own audio and
+ * subtitles. Audio is thus only encoded once for all the renditions. */
+static void LadderAdd( sout_stream_t *p_stream, sout_stream_id_sys_t *id,
+                       const es_format_t *p_fmt )
+{
+    sout_stream_sys_t *p_sys = p_stream->p_sys;
+
+    for( unsigned i = 1; i < p_sys->i_ladder; i++ )
+    {
+        es_format_t fmt = *p_fmt;
+
+        fmt.i_group = i + 1;
+        id->ladder_id[i - 1] = sout_StreamIdAdd( p_stream->p_next, &fmt );
+    }
+}
+
+static void LadderDel( sout_stream_t *p_stream, sout_stream_id_sys_t *id )
+{
+    for( unsigned i = 0; i < TRANSCODE_LADDER_MAX - 1; i++ )
+        if( id->ladder_id[i] )
+            sout_StreamIdDel( p_stream->p_next, id->ladder_id[i] );
+}
+
+static void LadderSend( sout_stream_t *p_stream, sout_stream_id_sys_t *id,
+                        block_t *p_chain )
+{
+    for( unsigned i = 0; i < TRANSCODE_LADDER_MAX - 1; i++ )
+    {
+        block_t *p_dup = NULL;
+
+        if( !id->ladder_id[i] )
+            continue;
+
+        for( block_t *p_block = p_chain; p_block; p_block = p_block->p_next )
+        {
+            block_t *p_copy = block_Duplicate( p_block );
+            if( p_copy )
+                block_ChainAppend( &p_dup, p_copy );
+        }
+        if( p_dup )
+            sout_StreamIdSend( p_stream->p_next, id->ladder_id[i], p_dup );
+    }
+}
+
 static sout_stream_id_sys_t *Add( sout_stream_t *p_stream,
                                   const es_format_t *p_fmt )
 {
     sout_stream_sys_t *p_sys = p_stream->p_sys;
     sout_stream_id_sys_t *id;
+    es_format_t fmt;
+
+    if( p_sys->i_ladder > 0 )
+    {
+        /* The main rendition is output in the first program */
+        fmt = *p_fmt;
+        fmt.i_group = 1;
+        p_fmt = &fmt;
+    }
 
     id = calloc( 1, sizeof( sout_stream_id_sys_t ) );
     if( !id )
@@ -566,6 +674,10 @@ static sout_stream_id_sys_t *Add( sout_stream_t *p_stream,
     if(!success)
         goto error;
 
+    if( id->id && ( !id->b_transcode || p_fmt->i_cat == AUDIO_ES ) )
+        LadderAdd( p_stream, id,
+                   id->b_transcode ? &id->p_encoder->fmt_out : p_fmt );
+
     return id;
 
 error:
@@ -615,6 +727,7 @@ static void Del( sout_stream_t *p_stream, sout_stream_id_sys_t *id )
     }
 
     if( id->id ) sout_StreamIdDel( p_stream->p_next, id->id );
+    LadderDel( p_stream, id );
 
     if( id->p_decoder )
     {
@@ -640,7 +753,10 @@ static int Send( sout_stream_t *p_stream, sout_stream_id_sys_t *id,
     if( !id->b_transcode )
     {
         if( id->id )
+        {
+            LadderSend( p_stream, id, p_buffer );
             return sout_StreamIdSend( p_stream->p_next, id->id, p_buffer );
+        }
 
         block_Release( p_buffer );
         return VLC_EGENERIC;
@@ -688,6 +804,9 @@ static int Send( sout_stream_t *p_stream, sout_stream_id_sys_t *id,
     }
 
     if( p_out )
+    {
+        LadderSend( p_stream, id, p_out );
         return sout_StreamIdSend( p_stream->p_next, id->id, p_out );
+    }
     return VLC_SUCCESS;
 }
@@ -14,6 +14,9 @@
 /*100ms is around the limit where people are noticing lipsync issues*/
 #define MASTER_SYNC_MAX_DRIFT 100000
 
+/* Maximum number of video renditions */
+#define TRANSCODE_LADDER_MAX 8
+
 struct sout_stream_sys_t
 {
     sout_stream_id_sys_t *id_video;
@@ -53,6 +56,15 @@ struct sout_stream_sys_t
 
     char            *psz_vf2;
 
+    /* Video renditions, the first one being the main video encoder */
+    struct
+    {
+        unsigned int    i_width;
+        unsigned int    i_height;
+        int             i_bitrate;
+    } ladder[TRANSCODE_LADDER_MAX];
+    unsigned int    i_ladder;
+
     /* SPU */
     vlc_fourcc_t    i_scodec;   /* codec spu (0 if not transcode) */
     char            *psz_senc;
@@ -75,12 +87,34 @@ struct sout_stream_sys_t
 
 struct aout_filters;
 
+/* Additional video rendition: the pictures decoded and filtered once for the
+ * main video encoder are scaled and encoded again in a separate thread. */
+typedef struct
+{
+    sout_stream_t   *p_stream;
+    encoder_t       *p_encoder;
+    filter_chain_t  *p_conv_chain; /**< Scaling and chroma conversion */
+    video_format_t  fmt_input_video;
+
+    /* id of the out stream */
+    void            *id;
+
+    vlc_thread_t    thread;
+    vlc_mutex_t     lock;
+    vlc_cond_t      cond;
+    bool            b_abort;
+    picture_fifo_t  *pp_pics;
+    block_t         *p_buffers;
+} transcode_rung_t;
+
 struct sout_stream_id_sys_t
 {
     bool            b_transcode;
 
     /* id of the out stream */
     void *id;
+    /* ids of the copies of the out stream for the other video renditions */
+    void *ladder_id[TRANSCODE_LADDER_MAX - 1];
 
     /* Decoder */
     decoder_t       *p_decoder;
@@ -92,6 +126,8 @@ struct sout_stream_id_sys_t
              filter_chain_t  *p_f_chain; /**< Video filters */
              filter_chain_t  *p_uf_chain; /**< User-specified video filters */
              video_format_t  fmt_input_video;
+             transcode_rung_t *p_rungs; /**< Additional video renditions */
+             unsigned int    i_rungs;
          };
          struct
          {
@@ -312,6 +312,13 @@ static void transcode_video_filter_init( sout_stream_t *p_stream,
         id->p_encoder->fmt_out.video.i_sar_den =
             id->p_encoder->fmt_in.video.i_sar_den;
     }
+    else if( p_stream->p_sys->i_ladder > 1 )
+    {
+        /* Keep the scaling of the main rendition out of the filter chain
+         * shared with the other renditions */
+        id->p_uf_chain = filter_chain_NewVideo( p_stream, false, &owner );
+        filter_chain_Reset( id->p_uf_chain, p_fmt_out, p_fmt_out );
+    }
 
 }
 
@@ -336,19 +343,14 @@ static void conversion_video_filter_append( sout_stream_id_sys_t *id )
     }
 }
 
-static void transcode_video_encoder_init( sout_stream_t *p_stream,
-                                          sout_stream_id_sys_t *id )
+/* Sets up the encoder formats from the source format p_fmt_out */
+static void transcode_video_encoder_setup( sout_stream_t *p_stream,
+                                           sout_stream_id_sys_t *id,
+                                           const es_format_t *p_fmt_out,
+                                           encoder_t *p_enc )
 {
     sout_stream_sys_t *p_sys = p_stream->p_sys;
 
-    const es_format_t *p_fmt_out = &id->p_decoder->fmt_out;
-    if( id->p_f_chain ) {
-        p_fmt_out = filter_chain_GetFmtOut( id->p_f_chain );
-    }
-    if( id->p_uf_chain ) {
-        p_fmt_out = filter_chain_GetFmtOut( id->p_uf_chain );
-    }
-
     /* Calculate scaling
      * width/height of source */
     int i_src_visible_width = p_fmt_out->video.i_visible_width;
@@ -377,8 +379,8 @@ static void transcode_video_encoder_init( sout_stream_t *p_stream,
     msg_Dbg( p_stream, "source pixel aspect is %f:1", (double) f_aspect );
 
     /* Calculate scaling factor for specified parameters */
-    if( id->p_encoder->fmt_out.video.i_visible_width <= 0 &&
-        id->p_encoder->fmt_out.video.i_visible_height <= 0 && p_sys->f_scale )
+    if( p_enc->fmt_out.video.i_visible_width <= 0 &&
+        p_enc->fmt_out.video.i_visible_height <= 0 && p_sys->f_scale )
     {
         /* Global scaling. Make sure width will remain a factor of 16 */
         float f_real_scale;
@@ -397,26 +399,26 @@ static void transcode_video_encoder_init( sout_stream_t *p_stream,
         f_scale_width = f_real_scale;
         f_scale_height = (float) i_new_height / (float) i_src_visible_height;
     }
-    else if( id->p_encoder->fmt_out.video.i_visible_width > 0 &&
-             id->p_encoder->fmt_out.video.i_visible_height <= 0 )
+    else if( p_enc->fmt_out.video.i_visible_width > 0 &&
+             p_enc->fmt_out.video.i_visible_height <= 0 )
     {
         /* Only width specified */
-        f_scale_width = (float)id->p_encoder->fmt_out.video.i_visible_width/i_src_visible_width;
+        f_scale_width = (float)p_enc->fmt_out.video.i_visible_width/i_src_visible_width;
         f_scale_height = f_scale_width;
     }
-    else if( id->p_encoder->fmt_out.video.i_visible_width <= 0 &&
-             id->p_encoder->fmt_out.video.i_visible_height > 0 )
+    else if( p_enc->fmt_out.video.i_visible_width <= 0 &&
+             p_enc->fmt_out.video.i_visible_height > 0 )
     {
          /* Only height specified */
-         f_scale_height = (float)id->p_encoder->fmt_out.video.i_visible_height/i_src_visible_height;
+         f_scale_height = (float)p_enc->fmt_out.video.i_visible_height/i_src_visible_height;
          f_scale_width = f_scale_height;
      }
-     else if( id->p_encoder->fmt_out.video.i_visible_width > 0 &&
-              id->p_encoder->fmt_out.video.i_visible_height > 0 )
+     else if( p_enc->fmt_out.video.i_visible_width > 0 &&
+              p_enc->fmt_out.video.i_visible_height > 0 )
      {
          /* Width and height specified */
-         f_scale_width = (float)id->p_encoder->fmt_out.video.i_visible_width/i_src_visible_width;
-         f_scale_height = (float)id->p_encoder->fmt_out.video.i_visible_height/i_src_visible_height;
+         f_scale_width = (float)p_enc->fmt_out.video.i_visible_width/i_src_visible_width;
+         f_scale_height = (float)p_enc->fmt_out.video.i_visible_height/i_src_visible_height;
      }
 
      /* check maxwidth and maxheight */
@@ -451,15 +453,15 @@ static void transcode_video_encoder_init( sout_stream_t *p_stream,
      f_aspect = f_aspect * i_dst_visible_width / i_dst_visible_height;
 
      /* Store calculated values */
-     id->p_encoder->fmt_out.video.i_width = i_dst_width;
-     id->p_encoder->fmt_out.video.i_visible_width = i_dst_visible_width;
-     id->p_encoder->fmt_out.video.i_height = i_dst_height;
-     id->p_encoder->fmt_out.video.i_visible_height = i_dst_visible_height;
+     p_enc->fmt_out.video.i_width = i_dst_width;
+     p_enc->fmt_out.video.i_visible_width = i_dst_visible_width;
+     p_enc->fmt_out.video.i_height = i_dst_height;
+     p_enc->fmt_out.video.i_visible_height = i_dst_visible_height;
 
-     id->p_encoder->fmt_in.video.i_width = i_dst_width;
-     id->p_encoder->fmt_in.video.i_visible_width = i_dst_visible_width;
-     id->p_encoder->fmt_in.video.i_height = i_dst_height;
-     id->p_encoder->fmt_in.video.i_visible_height = i_dst_visible_height;
+     p_enc->fmt_in.video.i_width = i_dst_width;
+     p_enc->fmt_in.video.i_visible_width = i_dst_visible_width;
+     p_enc->fmt_in.video.i_height = i_dst_height;
+     p_enc->fmt_in.video.i_visible_height = i_dst_visible_height;
 
      msg_Dbg( p_stream, "source %ix%i, destination %ix%i",
          i_src_visible_width, i_src_visible_height,
@@ -467,115 +469,405 @@ static void transcode_video_encoder_init( sout_stream_t *p_stream,
      );
 
     /* Handle frame rate conversion */
-    if( !id->p_encoder->fmt_out.video.i_frame_rate ||
-        !id->p_encoder->fmt_out.video.i_frame_rate_base )
+    if( !p_enc->fmt_out.video.i_frame_rate ||
+        !p_enc->fmt_out.video.i_frame_rate_base )
     {
         if( p_fmt_out->video.i_frame_rate &&
             p_fmt_out->video.i_frame_rate_base )
         {
-            id->p_encoder->fmt_out.video.i_frame_rate =
+            p_enc->fmt_out.video.i_frame_rate =
                 p_fmt_out->video.i_frame_rate;
-            id->p_encoder->fmt_out.video.i_frame_rate_base =
+            p_enc->fmt_out.video.i_frame_rate_base =
                 p_fmt_out->video.i_frame_rate_base;
         }
         else
         {
             /* Pick a sensible default value */
-            id->p_encoder->fmt_out.video.i_frame_rate = ENC_FRAMERATE;
-            id->p_encoder->fmt_out.video.i_frame_rate_base = ENC_FRAMERATE_BASE;
+            p_enc->fmt_out.video.i_frame_rate = ENC_FRAMERATE;
+            p_enc->fmt_out.video.i_frame_rate_base = ENC_FRAMERATE_BASE;
         }
     }
 
-    id->p_encoder->fmt_in.video.orientation =
-        id->p_encoder->fmt_out.video.orientation =
+    p_enc->fmt_in.video.orientation =
+        p_enc->fmt_out.video.orientation =
         id->p_decoder->fmt_in.video.orientation;
 
-    id->p_encoder->fmt_in.video.i_frame_rate =
-        id->p_encoder->fmt_out.video.i_frame_rate;
-    id->p_encoder->fmt_in.video.i_frame_rate_base =
-        id->p_encoder->fmt_out.video.i_frame_rate_base;
+    p_enc->fmt_in.video.i_frame_rate =
+        p_enc->fmt_out.video.i_frame_rate;
+    p_enc->fmt_in.video.i_frame_rate_base =
+        p_enc->fmt_out.video.i_frame_rate_base;
 
-    vlc_ureduce( &id->p_encoder->fmt_in.video.i_frame_rate,
-        &id->p_encoder->fmt_in.video.i_frame_rate_base,
-        id->p_encoder->fmt_in.video.i_frame_rate,
-        id->p_encoder->fmt_in.video.i_frame_rate_base,
+    vlc_ureduce( &p_enc->fmt_in.video.i_frame_rate,
+        &p_enc->fmt_in.video.i_frame_rate_base,
+        p_enc->fmt_in.video.i_frame_rate,
+        p_enc->fmt_in.video.i_frame_rate_base,
         0 );
      msg_Dbg( p_stream, "source fps %d/%d, destination %d/%d",
         id->p_decoder->fmt_out.video.i_frame_rate,
         id->p_decoder->fmt_out.video.i_frame_rate_base,
-        id->p_encoder->fmt_in.video.i_frame_rate,
-        id->p_encoder->fmt_in.video.i_frame_rate_base );
+        p_enc->fmt_in.video.i_frame_rate,
+        p_enc->fmt_in.video.i_frame_rate_base );
 
 
     /* Check whether a particular aspect ratio was requested */
-    if( id->p_encoder->fmt_out.video.i_sar_num <= 0 ||
-        id->p_encoder->fmt_out.video.i_sar_den <= 0 )
+    if( p_enc->fmt_out.video.i_sar_num <= 0 ||
+        p_enc->fmt_out.video.i_sar_den <= 0 )
     {
-        vlc_ureduce( &id->p_encoder->fmt_out.video.i_sar_num,
-                     &id->p_encoder->fmt_out.video.i_sar_den,
+        vlc_ureduce( &p_enc->fmt_out.video.i_sar_num,
+                     &p_enc->fmt_out.video.i_sar_den,
                      (uint64_t)p_fmt_out->video.i_sar_num * i_src_visible_width  * i_dst_visible_height,
                      (uint64_t)p_fmt_out->video.i_sar_den * i_src_visible_height * i_dst_visible_width,
                      0 );
     }
     else
     {
-        vlc_ureduce( &id->p_encoder->fmt_out.video.i_sar_num,
-                     &id->p_encoder->fmt_out.video.i_sar_den,
-                     id->p_encoder->fmt_out.video.i_sar_num,
-                     id->p_encoder->fmt_out.video.i_sar_den,
+        vlc_ureduce( &p_enc->fmt_out.video.i_sar_num,
+                     &p_enc->fmt_out.video.i_sar_den,
+                     p_enc->fmt_out.video.i_sar_num,
+                     p_enc->fmt_out.video.i_sar_den,
                      0 );
     }
 
-    id->p_encoder->fmt_in.video.i_sar_num =
-        id->p_encoder->fmt_out.video.i_sar_num;
-    id->p_encoder->fmt_in.video.i_sar_den =
-        id->p_encoder->fmt_out.video.i_sar_den;
+    p_enc->fmt_in.video.i_sar_num =
+        p_enc->fmt_out.video.i_sar_num;
+    p_enc->fmt_in.video.i_sar_den =
+        p_enc->fmt_out.video.i_sar_den;
 
     msg_Dbg( p_stream, "encoder aspect is %i:%i",
-             id->p_encoder->fmt_out.video.i_sar_num * id->p_encoder->fmt_out.video.i_width,
-             id->p_encoder->fmt_out.video.i_sar_den * id->p_encoder->fmt_out.video.i_height );
+             p_enc->fmt_out.video.i_sar_num * p_enc->fmt_out.video.i_width,
+             p_enc->fmt_out.video.i_sar_den * p_enc->fmt_out.video.i_height );
 
 }
 
-static int transcode_video_encoder_open( sout_stream_t *p_stream,
-                                         sout_stream_id_sys_t *id )
+static void transcode_video_encoder_init( sout_stream_t *p_stream,
+                                          sout_stream_id_sys_t *id )
 {
-    sout_stream_sys_t *p_sys = p_stream->p_sys;
+    const es_format_t *p_fmt_out = &id->p_decoder->fmt_out;
+    if( id->p_f_chain ) {
+        p_fmt_out = filter_chain_GetFmtOut( id->p_f_chain );
+    }
+    if( id->p_uf_chain ) {
+        p_fmt_out = filter_chain_GetFmtOut( id->p_uf_chain );
+    }
 
+    transcode_video_encoder_setup( p_stream, id, p_fmt_out, id->p_encoder );
+}
+
+/* Opens the encoder and adds its output stream, returning its id */
+static void *transcode_video_encoder_open( sout_stream_t *p_stream,
+                                           encoder_t *p_enc )
+{
+    sout_stream_sys_t *p_sys = p_stream->p_sys;
+    void *id;
 
     msg_Dbg( p_stream, "destination (after video filters) %ix%i",
-             id->p_encoder->fmt_in.video.i_width,
-             id->p_encoder->fmt_in.video.i_height );
+             p_enc->fmt_in.video.i_width,
+             p_enc->fmt_in.video.i_height );
 
-    id->p_encoder->p_module =
-        module_need( id->p_encoder, "encoder", p_sys->psz_venc, true );
-    if( !id->p_encoder->p_module )
+    p_enc->p_module = module_need( p_enc, "encoder", p_sys->psz_venc, true );
+    if( !p_enc->p_module )
     {
         msg_Err( p_stream, "cannot find video encoder (module:%s fourcc:%4.4s)",
                  p_sys->psz_venc ? p_sys->psz_venc : "any",
                  (char *)&p_sys->i_vcodec );
-        return VLC_EGENERIC;
+        return NULL;
     }
 
-    id->p_encoder->fmt_in.video.i_chroma = id->p_encoder->fmt_in.i_codec;
+    p_enc->fmt_in.video.i_chroma = p_enc->fmt_in.i_codec;
 
     /*  */
-    id->p_encoder->fmt_out.i_codec =
-        vlc_fourcc_GetCodec( VIDEO_ES, id->p_encoder->fmt_out.i_codec );
+    p_enc->fmt_out.i_codec =
+        vlc_fourcc_GetCodec( VIDEO_ES, p_enc->fmt_out.i_codec );
 
-    id->id = sout_StreamIdAdd( p_stream->p_next, &id->p_encoder->fmt_out );
-    if( !id->id )
-    {
+    id = sout_StreamIdAdd( p_stream->p_next, &p_enc->fmt_out );
+    if( !id )
         msg_Err( p_stream, "cannot add this stream" );
-        return VLC_EGENERIC;
+
+    return id;
+}
+
+/* (Re)creates the scaling and chroma conversion of a rendition for the
+ * pictures of format p_fmt. This is only run by the rendition thread. */
+static void RungConversion( transcode_rung_t *p_rung,
+                            const video_format_t *p_fmt )
+{
+    filter_owner_t owner = {
+        .sys = p_rung->p_stream->p_sys,
+        .video = {
+            .buffer_new = transcode_video_filter_buffer_new,
+        },
+    };
+    const es_format_t *p_fmt_enc = &p_rung->p_encoder->fmt_in;
+    es_format_t fmt;
+
+    es_format_Init( &fmt, VIDEO_ES, p_fmt->i_chroma );
+    fmt.video = *p_fmt;
+    p_rung->fmt_input_video = *p_fmt;
+
+    if( p_rung->p_conv_chain )
+        filter_chain_Delete( p_rung->p_conv_chain );
+    p_rung->p_conv_chain = filter_chain_NewVideo( p_rung->p_stream, false,
+                                                  &owner );
+    if( !p_rung->p_conv_chain )
+        return;
+    filter_chain_Reset( p_rung->p_conv_chain, &fmt, p_fmt_enc );
+
+    if( ( fmt.video.i_chroma != p_fmt_enc->video.i_chroma ) ||
+        ( fmt.video.i_width != p_fmt_enc->video.i_width ) ||
+        ( fmt.video.i_height != p_fmt_enc->video.i_height ) )
+    {
+        if( !filter_chain_AppendFilter( p_rung->p_conv_chain, NULL, NULL,
+                                        &fmt, p_fmt_enc ) )
+        {
+            msg_Err( p_rung->p_stream, "cannot convert video to %ix%i",
+                     p_fmt_enc->video.i_width, p_fmt_enc->video.i_height );
+            filter_chain_Delete( p_rung->p_conv_chain );
+            p_rung->p_conv_chain = NULL;
+        }
+    }
+}
+
+static block_t *RungEncode( transcode_rung_t *p_rung, picture_t *p_pic )
+{
+    encoder_t *p_enc = p_rung->p_encoder;
+    block_t *p_block;
+
+    if( !video_format_IsSimilar( &p_rung->fmt_input_video, &p_pic->format ) )
+        RungConversion( p_rung, &p_pic->format );
+
+    /* Drop the pictures that cannot be converted */
+    if( !p_rung->p_conv_chain )
+    {
+        picture_Release( p_pic );
+        return NULL;
     }
 
+    p_pic = filter_chain_VideoFilter( p_rung->p_conv_chain, p_pic );
+    if( !p_pic )
+        return NULL;
+
+    p_block = p_enc->pf_encode_video( p_enc, p_pic );
+    picture_Release( p_pic );
+    return p_block;
+}
+
+static void* RungThread( void *obj )
+{
+    transcode_rung_t *p_rung = obj;
+    encoder_t *p_enc = p_rung->p_encoder;
+    picture_t *p_pic;
+    block_t *p_block;
+    int canc = vlc_savecancel ();
+
+    vlc_mutex_lock( &p_rung->lock );
+
+    /* Encode what we have in the fifo even when aborting */
+    for( ;; )
+    {
+        while( (p_pic = picture_fifo_Pop( p_rung->pp_pics )) == NULL &&
+               !p_rung->b_abort )
+            vlc_cond_wait( &p_rung->cond, &p_rung->lock );
+
+        if( !p_pic )
+            break;
+
+        /* release lock while scaling and encoding */
+        vlc_mutex_unlock( &p_rung->lock );
+        p_block = RungEncode( p_rung, p_pic );
+        vlc_mutex_lock( &p_rung->lock );
+
+        block_ChainAppend( &p_rung->p_buffers, p_block );
+    }
+
+    /*Now flush encoder*/
+    do {
+        p_block = p_enc->pf_encode_video( p_enc, NULL );
+        block_ChainAppend( &p_rung->p_buffers, p_block );
+    } while( p_block );
+
+    vlc_mutex_unlock( &p_rung->lock );
+
+    vlc_restorecancel (canc);
+
+    return NULL;
+}
+
+static void transcode_video_rung_clean( transcode_rung_t *p_rung )
+{
+    encoder_t *p_enc = p_rung->p_encoder;
+
+    if( p_rung->p_conv_chain )
+        filter_chain_Delete( p_rung->p_conv_chain );
+    if( p_enc->p_module )
+        module_unneed( p_enc, p_enc->p_module );
+    es_format_Clean( &p_enc->fmt_in );
+    es_format_Clean( &p_enc->fmt_out );
+    vlc_object_release( p_enc );
+}
+
+/* Creates the encoder and the thread of the rendition i_rung, once the
+ * main video encoder is opened. */
+static int transcode_video_rung_open( sout_stream_t *p_stream,
+                                      sout_stream_id_sys_t *id,
+                                      transcode_rung_t *p_rung,
+                                      unsigned i_rung )
+{
+    sout_stream_sys_t *p_sys = p_stream->p_sys;
+    const es_format_t *p_fmt_out = &id->p_decoder->fmt_out;
+    encoder_t *p_enc;
+
+    if( id->p_f_chain )
+        p_fmt_out = filter_chain_GetFmtOut( id->p_f_chain );
+
+    p_enc = sout_EncoderCreate( p_stream );
+    if( !p_enc )
+        return VLC_ENOMEM;
+    p_enc->p_module = NULL;
+
+    memset( p_rung, 0, sizeof(*p_rung) );
+    p_rung->p_stream = p_stream;
+    p_rung->p_encoder = p_enc;
+
+    /* The encoder takes the same chroma as the main one */
+    es_format_Copy( &p_enc->fmt_in, &id->p_encoder->fmt_in );
+
+    es_format_Init( &p_enc->fmt_out, VIDEO_ES, p_sys->i_vcodec );
+    p_enc->fmt_out.i_id    = id->p_encoder->fmt_out.i_id;
+    p_enc->fmt_out.i_group = i_rung + 1;
+    if( id->p_encoder->fmt_out.psz_language )
+        p_enc->fmt_out.psz_language =
+            strdup( id->p_encoder->fmt_out.psz_language );
+    p_enc->fmt_out.video.i_visible_width  = p_sys->ladder[i_rung].i_width & ~1;
+    p_enc->fmt_out.video.i_visible_height = p_sys->ladder[i_rung].i_height & ~1;
+    p_enc->fmt_out.i_bitrate = p_sys->ladder[i_rung].i_bitrate;
+    if( p_sys->fps_num )
+    {
+        p_enc->fmt_out.video.i_frame_rate = p_sys->fps_num;
+        p_enc->fmt_out.video.i_frame_rate_base =
+            p_sys->fps_den ? p_sys->fps_den : 1;
+    }
+
+    p_enc->i_threads = p_sys->i_threads;
+    p_enc->p_cfg = p_sys->p_video_cfg;
+
+    transcode_video_encoder_setup( p_stream, id, p_fmt_out, p_enc );
+
+    p_rung->id = transcode_video_encoder_open( p_stream, p_enc );
+    if( !p_rung->id )
+        goto error;
+
+    p_rung->pp_pics = picture_fifo_New();
+    if( !p_rung->pp_pics )
+        goto error;
+
+    vlc_mutex_init( &p_rung->lock );
+    vlc_cond_init( &p_rung->cond );
+    if( vlc_clone( &p_rung->thread, RungThread, p_rung,
+                   p_sys->b_high_priority ? VLC_THREAD_PRIORITY_OUTPUT
+                                          : VLC_THREAD_PRIORITY_VIDEO ) )
+    {
+        msg_Err( p_stream, "cannot spawn encoder thread" );
+        vlc_mutex_destroy( &p_rung->lock );
+        vlc_cond_destroy( &p_rung->cond );
+        goto error;
+    }
     return VLC_SUCCESS;
+
+error:
+    if( p_rung->pp_pics )
+        picture_fifo_Delete( p_rung->pp_pics );
+    if( p_rung->id )
+        sout_StreamIdDel( p_stream->p_next, p_rung->id );
+    transcode_video_rung_clean( p_rung );
+    return VLC_EGENERIC;
+}
+
+static void transcode_video_ladder_open( sout_stream_t *p_stream,
+                                         sout_stream_id_sys_t *id )
+{
+    sout_stream_sys_t *p_sys = p_stream->p_sys;
+
+    id->p_rungs = calloc( p_sys->i_ladder - 1, sizeof(*id->p_rungs) );
+    if( !id->p_rungs )
+        return;
+
+    for( unsigned i = 1; i < p_sys->i_ladder; i++ )
+    {
+        msg_Dbg( p_stream, "opening video rendition %u", i + 1 );
+        if( transcode_video_rung_open( p_stream, id,
+                                       &id->p_rungs[id->i_rungs], i ) )
+            msg_Err( p_stream, "cannot open video rendition %u", i + 1 );
+        else
+            id->i_rungs++;
+    }
+}
+
+static void transcode_video_rung_push( transcode_rung_t *p_rung,
+                                       picture_t *p_pic )
+{
+    vlc_mutex_lock( &p_rung->lock );
+    picture_fifo_Push( p_rung->pp_pics, picture_Hold( p_pic ) );
+    vlc_cond_signal( &p_rung->cond );
+    vlc_mutex_unlock( &p_rung->lock );
+}
+
+/* Sends what the rendition encoder has output, after waiting for all the
+ * pending pictures to be encoded if b_drain is set. */
+static void transcode_video_rung_send( sout_stream_t *p_stream,
+                                       transcode_rung_t *p_rung, bool b_drain )
+{
+    block_t *p_out;
+
+    vlc_mutex_lock( &p_rung->lock );
+    if( b_drain )
+    {
+        p_rung->b_abort = true;
+        vlc_cond_signal( &p_rung->cond );
+        vlc_mutex_unlock( &p_rung->lock );
+
+        vlc_join( p_rung->thread, NULL );
+        vlc_mutex_lock( &p_rung->lock );
+    }
+    p_out = p_rung->p_buffers;
+    p_rung->p_buffers = NULL;
+    vlc_mutex_unlock( &p_rung->lock );
+
+    if( p_out )
+        sout_StreamIdSend( p_stream->p_next, p_rung->id, p_out );
+}
+
+static void transcode_video_rung_close( sout_stream_t *p_stream,
+                                        transcode_rung_t *p_rung )
+{
+    if( !p_rung->b_abort )
+    {
+        vlc_mutex_lock( &p_rung->lock );
+        p_rung->b_abort = true;
+        vlc_cond_signal( &p_rung->cond );
+        vlc_mutex_unlock( &p_rung->lock );
+
+        vlc_join( p_rung->thread, NULL );
+    }
+
+    picture_fifo_Delete( p_rung->pp_pics );
+    block_ChainRelease( p_rung->p_buffers );
+    vlc_mutex_destroy( &p_rung->lock );
+    vlc_cond_destroy( &p_rung->cond );
+
+    sout_StreamIdDel( p_stream->p_next, p_rung->id );
+    transcode_video_rung_clean( p_rung );
 }
 
 void transcode_video_close( sout_stream_t *p_stream,
                                    sout_stream_id_sys_t *id )
 {
+    /* Close the other renditions */
+    for( unsigned i = 0; i < id->i_rungs; i++ )
+        transcode_video_rung_close( p_stream, &id->p_rungs[i] );
+    free( id->p_rungs );
+    id->p_rungs = NULL;
+    id->i_rungs = 0;
+
     if( p_stream->p_sys->i_threads >= 1 && !p_stream->p_sys->b_abort )
     {
         vlc_mutex_lock( &p_stream->p_sys->lock_out );
@@ -638,7 +930,8 @@ static void OutputFrame( sout_stream_t *p_stream, picture_t *p_pic, sout_stream_
         /* Overlay subpicture */
         if( p_subpic )
         {
-            if( picture_IsReferenced( p_pic ) && !filter_chain_GetLength( id->p_f_chain ) )
+            if( picture_IsReferenced( p_pic ) &&
+                ( !filter_chain_GetLength( id->p_f_chain ) || id->i_rungs > 0 ) )
             {
                 /* We can't modify the picture, we need to duplicate it,
                  * in this point the picture is already p_encoder->fmt.in format*/
@@ -713,6 +1006,9 @@ int transcode_video_process( sout_stream_t *p_stream, sout_stream_id_sys_t *id,
 
             msg_Dbg( p_stream, "Flushing done");
         }
+
+        for( unsigned i = 0; i < id->i_rungs; i++ )
+            transcode_video_rung_send( p_stream, &id->p_rungs[i], true );
         return VLC_SUCCESS;
     }
 
@@ -763,13 +1059,17 @@ int transcode_video_process( sout_stream_t *p_stream, sout_stream_id_sys_t *id,
             conversion_video_filter_append( id );
             memcpy( &id->fmt_input_video, &id->p_decoder->fmt_out.video, sizeof(video_format_t));
 
-            if( transcode_video_encoder_open( p_stream, id ) != VLC_SUCCESS )
+            id->id = transcode_video_encoder_open( p_stream, id->p_encoder );
+            if( !id->id )
             {
                 picture_Release( p_pic );
                 transcode_video_close( p_stream, id );
                 id->b_transcode = false;
                 return VLC_EGENERIC;
             }
+
+            if( p_sys->i_ladder > 1 )
+                transcode_video_ladder_open( p_stream, id );
         }
 
         /* Run the filter and output chains; first with the picture,
@@ -785,6 +1085,10 @@ int transcode_video_process( sout_stream_t *p_stream, sout_stream_id_sys_t *id,
             if( !p_filtered_pic )
                 break;
 
+            /* Hand the picture over to the other renditions */
+            for( unsigned i = 0; i < id->i_rungs; i++ )
+                transcode_video_rung_push( &id->p_rungs[i], p_filtered_pic );
+
             for ( ;; ) {
                 picture_t *p_user_filtered_pic = p_filtered_pic;
 
@@ -812,6 +1116,9 @@ int transcode_video_process( sout_stream_t *p_stream, sout_stream_id_sys_t *id,
         vlc_mutex_unlock( &p_sys->lock_out );
     }
 
+    for( unsigned i = 0; i < id->i_rungs; i++ )
+        transcode_video_rung_send( p_stream, &id->p_rungs[i], false );
+
     return VLC_SUCCESS;
 }
 
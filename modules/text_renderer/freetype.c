@@ -263,6 +263,74 @@ struct line_desc_t
     line_character_t *p_character;
 };
 
+/* Faces are loaded once per (font name, bold/italic) and kept until the
+ * filter is destroyed, a NULL face meaning the default one is used */
+typedef struct face_cache_entry_t face_cache_entry_t;
+struct face_cache_entry_t
+{
+    face_cache_entry_t *p_next;
+
+    char               *psz_fontname;
+    int                 i_style_flags;
+    FT_Face             p_face;
+};
+
+/* Rasterized glyphs are kept in a LRU cache keyed by everything GetGlyph()
+ * depends on. They are rendered at the fractional part of the pen only and
+ * moved by the whole pixels when handed out. */
+#define GLYPH_CACHE_SIZE    (512)
+#define GLYPH_CACHE_BUCKETS (256)
+
+typedef struct
+{
+    FT_Face   p_face;
+    FT_UInt   i_glyph_index;
+    FT_UShort i_x_ppem;
+    FT_UShort i_y_ppem;
+    int       i_style_flags;
+    FT_Fixed  i_stroker_radius;
+    FT_Vector pen;
+    FT_Vector pen_shadow;
+} glyph_cache_key_t;
+
+typedef struct glyph_cache_entry_t glyph_cache_entry_t;
+struct glyph_cache_entry_t
+{
+    glyph_cache_key_t   key;
+    glyph_cache_entry_t *p_hash_next;
+    glyph_cache_entry_t *p_prev;        /* LRU order, most recent first */
+    glyph_cache_entry_t *p_next;
+
+    FT_Glyph            p_glyph;
+    FT_Glyph            p_outline;
+    FT_Glyph            p_shadow;
+    FT_Vector           advance;
+};
+
+/* The last laid out texts are kept with their lines, so that rendering the
+ * same subtitle again (karaoke, re-rendering on each picture) does not go
+ * through the layout and the glyphs again */
+#define LINE_CACHE_SIZE (8)
+
+typedef struct
+{
+    /* Key */
+    uni_char_t    *psz_text;
+    text_style_t **pp_styles;
+    uint8_t       *pi_k_bar;
+    int           i_len;
+    unsigned      i_visible_width;
+    unsigned      i_visible_height;
+    int           i_outline_thickness;
+
+    /* Layout */
+    line_desc_t   *p_lines;
+    FT_BBox       bbox;
+    int           i_max_face_height;
+
+    uint64_t      i_last_use;
+} line_cache_entry_t;
+
 /*****************************************************************************
  * filter_sys_t: freetype local data
  *****************************************************************************
@@ -292,6 +360,15 @@ struct filter_sys_t
                                bool bold, bool italic, int size,
                                int *index);
 
+    /* Caches */
+    FT_Fixed             i_stroker_radius;
+    face_cache_entry_t  *p_face_cache;
+    glyph_cache_entry_t *pp_glyph_hash[GLYPH_CACHE_BUCKETS];
+    glyph_cache_entry_t *p_glyph_first;
+    glyph_cache_entry_t *p_glyph_last;
+    int                  i_glyph_count;
+    line_cache_entry_t   line_cache[LINE_CACHE_SIZE];
+    uint64_t             i_line_cache_use;
 };
 
 /* */
@@ -1044,38 +1121,178 @@ static FT_Face LoadFace( filter_t *p_filter,
     return p_face;
 }
 
-static int GetGlyph( filter_t *p_filter,
-                     FT_Glyph *pp_glyph,   FT_BBox *p_glyph_bbox,
-                     FT_Glyph *pp_outline, FT_BBox *p_outline_bbox,
-                     FT_Glyph *pp_shadow,  FT_BBox *p_shadow_bbox,
+static FT_Face GetFace( filter_t *p_filter, const text_style_t *p_style )
+{
+    filter_sys_t *p_sys = p_filter->p_sys;
+    const int i_style_flags = p_style->i_style_flags & (STYLE_BOLD | STYLE_ITALIC);
 
-                     FT_Face  p_face,
-                     int i_glyph_index,
-                     int i_style_flags,
-                     FT_Vector *p_pen,
-                     FT_Vector *p_pen_shadow )
+    for( face_cache_entry_t *p_entry = p_sys->p_face_cache; p_entry; p_entry = p_entry->p_next )
+    {
+        if( p_entry->i_style_flags == i_style_flags &&
+            !strcmp( p_entry->psz_fontname, p_style->psz_fontname ) )
+            return p_entry->p_face;
+    }
+
+    FT_Face p_face = LoadFace( p_filter, p_style );
+
+    face_cache_entry_t *p_entry = malloc( sizeof(*p_entry) );
+    if( p_entry )
+        p_entry->psz_fontname = strdup( p_style->psz_fontname );
+    if( !p_entry || !p_entry->psz_fontname )
+    {
+        /* The glyph cache relies on faces outliving it */
+        free( p_entry );
+        if( p_face )
+            FT_Done_Face( p_face );
+        return NULL;
+    }
+    p_entry->i_style_flags = i_style_flags;
+    p_entry->p_face = p_face;
+    p_entry->p_next = p_sys->p_face_cache;
+    p_sys->p_face_cache = p_entry;
+
+    return p_face;
+}
+
+static void FaceCacheClear( filter_sys_t *p_sys )
 {
+    for( face_cache_entry_t *p_entry = p_sys->p_face_cache; p_entry; )
+    {
+        face_cache_entry_t *p_next = p_entry->p_next;
+        if( p_entry->p_face )
+            FT_Done_Face( p_entry->p_face );
+        free( p_entry->psz_fontname );
+        free( p_entry );
+        p_entry = p_next;
+    }
+    p_sys->p_face_cache = NULL;
+}
+
+static unsigned GlyphCacheHash( const glyph_cache_key_t *p_key )
+{
+    /* FNV-1a */
+    const uint8_t *p = (const uint8_t *)p_key;
+    uint32_t i_hash = 2166136261u;
+    for( size_t i = 0; i < sizeof(*p_key); i++ )
+        i_hash = (i_hash ^ p[i]) * 16777619u;
+    return i_hash % GLYPH_CACHE_BUCKETS;
+}
+
+static void GlyphCacheEntryDelete( glyph_cache_entry_t *p_entry )
+{
+    FT_Done_Glyph( p_entry->p_glyph );
+    if( p_entry->p_outline )
+        FT_Done_Glyph( p_entry->p_outline );
+    if( p_entry->p_shadow )
+        FT_Done_Glyph( p_entry->p_shadow );
+    free( p_entry );
+}
+
+static void GlyphCacheUnlink( filter_sys_t *p_sys, glyph_cache_entry_t *p_entry )
+{
+    if( p_entry->p_prev )
+        p_entry->p_prev->p_next = p_entry->p_next;
+    else
+        p_sys->p_glyph_first = p_entry->p_next;
+    if( p_entry->p_next )
+        p_entry->p_next->p_prev = p_entry->p_prev;
+    else
+        p_sys->p_glyph_last = p_entry->p_prev;
+}
+
+static void GlyphCachePushFront( filter_sys_t *p_sys, glyph_cache_entry_t *p_entry )
+{
+    p_entry->p_prev = NULL;
+    p_entry->p_next = p_sys->p_glyph_first;
+    if( p_sys->p_glyph_first )
+        p_sys->p_glyph_first->p_prev = p_entry;
+    else
+        p_sys->p_glyph_last = p_entry;
+    p_sys->p_glyph_first = p_entry;
+}
+
+static glyph_cache_entry_t *GlyphCacheFind( filter_sys_t *p_sys,
+                                            const glyph_cache_key_t *p_key )
+{
+    glyph_cache_entry_t *p_entry = p_sys->pp_glyph_hash[GlyphCacheHash( p_key )];
+    for( ; p_entry; p_entry = p_entry->p_hash_next )
+    {
+        if( !memcmp( &p_entry->key, p_key, sizeof(*p_key) ) )
+        {
+            GlyphCacheUnlink( p_sys, p_entry );
+            GlyphCachePushFront( p_sys, p_entry );
+            return p_entry;
+        }
+    }
+    return NULL;
+}
+
+static void GlyphCacheInsert( filter_sys_t *p_sys, glyph_cache_entry_t *p_entry )
+{
+    if( p_sys->i_glyph_count >= GLYPH_CACHE_SIZE )
+    {
+        glyph_cache_entry_t *p_old = p_sys->p_glyph_last;
+        glyph_cache_entry_t **pp = &p_sys->pp_glyph_hash[GlyphCacheHash( &p_old->key )];
+        while( *pp != p_old )
+            pp = &(*pp)->p_hash_next;
+        *pp = p_old->p_hash_next;
+
+        GlyphCacheUnlink( p_sys, p_old );
+        GlyphCacheEntryDelete( p_old );
+        p_sys->i_glyph_count--;
+    }
+
+    const unsigned i_hash = GlyphCacheHash( &p_entry->key );
+    p_entry->p_hash_next = p_sys->pp_glyph_hash[i_hash];
+    p_sys->pp_glyph_hash[i_hash] = p_entry;
+    GlyphCachePushFront( p_sys, p_entry );
+    p_sys->i_glyph_count++;
+}
+
+static void GlyphCacheClear( filter_sys_t *p_sys )
+{
+    for( glyph_cache_entry_t *p_entry = p_sys->p_glyph_first; p_entry; )
+    {
+        glyph_cache_entry_t *p_next = p_entry->p_next;
+        GlyphCacheEntryDelete( p_entry );
+        p_entry = p_next;
+    }
+    for( int i = 0; i < GLYPH_CACHE_BUCKETS; i++ )
+        p_sys->pp_glyph_hash[i] = NULL;
+    p_sys->p_glyph_first = p_sys->p_glyph_last = NULL;
+    p_sys->i_glyph_count = 0;
+}
+
+static glyph_cache_entry_t *RenderGlyph( filter_t *p_filter,
+                                         const glyph_cache_key_t *p_key,
+                                         bool b_shadow )
+{
+    FT_Face p_face = p_key->p_face;
+    int i_glyph_index = p_key->i_glyph_index;
+    FT_Vector pen = p_key->pen;
+    FT_Vector pen_shadow = p_key->pen_shadow;
+
     if( FT_Load_Glyph( p_face, i_glyph_index, FT_LOAD_NO_BITMAP | FT_LOAD_DEFAULT ) &&
         FT_Load_Glyph( p_face, i_glyph_index, FT_LOAD_DEFAULT ) )
     {
         msg_Err( p_filter, "unable to render text FT_Load_Glyph failed" );
-        return VLC_EGENERIC;
+        return NULL;
     }
 
     /* Do synthetic styling now that Freetype supports it;
      * ie. if the font we have loaded is NOT already in the
      * style that the tags want, then switch it on; if they
      * are then don't. */
-    if ((i_style_flags & STYLE_BOLD) && !(p_face->style_flags & FT_STYLE_FLAG_BOLD))
+    if ((p_key->i_style_flags & STYLE_BOLD) && !(p_face->style_flags & FT_STYLE_FLAG_BOLD))
         FT_GlyphSlot_Embolden( p_face->glyph );
-    if ((i_style_flags & STYLE_ITALIC) && !(p_face->style_flags & FT_STYLE_FLAG_ITALIC))
+    if ((p_key->i_style_flags & STYLE_ITALIC) && !(p_face->style_flags & FT_STYLE_FLAG_ITALIC))
         FT_GlyphSlot_Oblique( p_face->glyph );
 
     FT_Glyph glyph;
     if( FT_Get_Glyph( p_face->glyph, &glyph ) )
     {
         msg_Err( p_filter, "unable to render text FT_Get_Glyph failed" );
-        return VLC_EGENERIC;
+        return NULL;
     }
 
     FT_Glyph outline = NULL;
@@ -1087,55 +1304,125 @@ static int GetGlyph( filter_t *p_filter,
     }
 
     FT_Glyph shadow = NULL;
-    if( p_filter->p_sys->style.i_shadow_alpha > 0 )
+    if( b_shadow )
     {
         shadow = outline ? outline : glyph;
-        if( FT_Glyph_To_Bitmap( &shadow, FT_RENDER_MODE_NORMAL, p_pen_shadow, 0  ) )
-        {
+        if( FT_Glyph_To_Bitmap( &shadow, FT_RENDER_MODE_NORMAL, &pen_shadow, 0  ) )
             shadow = NULL;
-        }
-        else
-        {
-            FT_Glyph_Get_CBox( shadow, ft_glyph_bbox_pixels, p_shadow_bbox );
-        }
     }
-    *pp_shadow = shadow;
 
-    if( FT_Glyph_To_Bitmap( &glyph, FT_RENDER_MODE_NORMAL, p_pen, 1) )
+    glyph_cache_entry_t *p_entry = malloc( sizeof(*p_entry) );
+    if( !p_entry ||
+        FT_Glyph_To_Bitmap( &glyph, FT_RENDER_MODE_NORMAL, &pen, 1) )
     {
+        free( p_entry );
         FT_Done_Glyph( glyph );
         if( outline )
             FT_Done_Glyph( outline );
         if( shadow )
             FT_Done_Glyph( shadow );
-        return VLC_EGENERIC;
+        return NULL;
     }
-    FT_Glyph_Get_CBox( glyph, ft_glyph_bbox_pixels, p_glyph_bbox );
-    *pp_glyph = glyph;
 
-    if( outline )
+    if( outline && FT_Glyph_To_Bitmap( &outline, FT_RENDER_MODE_NORMAL, &pen, 1 ) )
     {
-        FT_Glyph_To_Bitmap( &outline, FT_RENDER_MODE_NORMAL, p_pen, 1 );
-        FT_Glyph_Get_CBox( outline, ft_glyph_bbox_pixels, p_outline_bbox );
+        FT_Done_Glyph( outline );
+        outline = NULL;
     }
-    *pp_outline = outline;
 
+    memcpy( &p_entry->key, p_key, sizeof(*p_key) );
+    p_entry->p_glyph = glyph;
+    p_entry->p_outline = outline;
+    p_entry->p_shadow = shadow;
+    p_entry->advance = p_face->glyph->advance;
+    return p_entry;
+}
+
+static FT_Glyph CopyGlyph( FT_Glyph src, const FT_Vector *p_pen, FT_BBox *p_bbox )
+{
+    FT_Glyph glyph;
+    if( FT_Glyph_Copy( src, &glyph ) )
+        return NULL;
+
+    FT_BitmapGlyph glyph_bmp = (FT_BitmapGlyph)glyph;
+    glyph_bmp->left += FT_FLOOR(p_pen->x);
+    glyph_bmp->top  += FT_FLOOR(p_pen->y);
+    FT_Glyph_Get_CBox( glyph, ft_glyph_bbox_pixels, p_bbox );
+    return glyph;
+}
+
+static int GetGlyph( filter_t *p_filter,
+                     FT_Glyph *pp_glyph,   FT_BBox *p_glyph_bbox,
+                     FT_Glyph *pp_outline, FT_BBox *p_outline_bbox,
+                     FT_Glyph *pp_shadow,  FT_BBox *p_shadow_bbox,
+                     FT_Vector *p_advance,
+
+                     FT_Face  p_face,
+                     int i_glyph_index,
+                     int i_style_flags,
+                     FT_Vector *p_pen,
+                     FT_Vector *p_pen_shadow )
+{
+    filter_sys_t *p_sys = p_filter->p_sys;
+    const bool b_shadow = p_sys->style.i_shadow_alpha > 0;
+
+    glyph_cache_key_t key;
+    memset( &key, 0, sizeof(key) );
+    key.p_face = p_face;
+    key.i_glyph_index = i_glyph_index;
+    key.i_x_ppem = p_face->size->metrics.x_ppem;
+    key.i_y_ppem = p_face->size->metrics.y_ppem;
+    key.i_style_flags = i_style_flags & (STYLE_BOLD | STYLE_ITALIC);
+    if( p_sys->p_stroker )
+        key.i_stroker_radius = p_sys->i_stroker_radius;
+    key.pen.x = p_pen->x & 63;
+    key.pen.y = p_pen->y & 63;
+    if( b_shadow )
+    {
+        key.pen_shadow.x = p_pen_shadow->x & 63;
+        key.pen_shadow.y = p_pen_shadow->y & 63;
+    }
+
+    glyph_cache_entry_t *p_entry = GlyphCacheFind( p_sys, &key );
+    if( !p_entry )
+    {
+        p_entry = RenderGlyph( p_filter, &key, b_shadow );
+        if( !p_entry )
+            return VLC_EGENERIC;
+        GlyphCacheInsert( p_sys, p_entry );
+    }
+
+    FT_Glyph glyph = CopyGlyph( p_entry->p_glyph, p_pen, p_glyph_bbox );
+    if( !glyph )
+        return VLC_EGENERIC;
+    *pp_glyph = glyph;
+
+    *pp_outline = NULL;
+    if( p_entry->p_outline )
+        *pp_outline = CopyGlyph( p_entry->p_outline, p_pen, p_outline_bbox );
+
+    *pp_shadow = NULL;
+    if( p_entry->p_shadow )
+        *pp_shadow = CopyGlyph( p_entry->p_shadow, p_pen_shadow, p_shadow_bbox );
+
+    *p_advance = p_entry->advance;
     return VLC_SUCCESS;
 }
 
-static void FixGlyph( FT_Glyph glyph, FT_BBox *p_bbox, FT_Face face, const FT_Vector *p_pen )
+static void FixGlyph( FT_Glyph glyph, FT_BBox *p_bbox, const FT_Vector *p_advance,
+                      const FT_Vector *p_pen )
 {
     FT_BitmapGlyph glyph_bmp = (FT_BitmapGlyph)glyph;
     if( p_bbox->xMin >= p_bbox->xMax )
     {
         p_bbox->xMin = FT_CEIL(p_pen->x);
-        p_bbox->xMax = FT_CEIL(p_pen->x + face->glyph->advance.x);
+        p_bbox->xMax = FT_CEIL(p_pen->x + p_advance->x);
         glyph_bmp->left = p_bbox->xMin;
     }
     if( p_bbox->yMin >= p_bbox->yMax )
     {
         p_bbox->yMax = FT_CEIL(p_pen->y);
-        p_bbox->yMin = FT_CEIL(p_pen->y + face->glyph->advance.y);
+        p_bbox->yMin = FT_CEIL(p_pen->y + p_advance->y);
         glyph_bmp->top  = p_bbox->yMax;
     }
 }
@@ -1155,7 +1442,7 @@ static int ProcessLines( filter_t *p_filter,
 
                          uni_char_t *psz_text,
                          text_style_t **pp_styles,
-                         uint32_t *pi_k_dates,
+                         const uint8_t *pi_k_bar,
                          int i_len )
 {
     filter_sys_t   *p_sys = p_filter->p_sys;
@@ -1230,18 +1517,17 @@ static int ProcessLines( filter_t *p_filter,
         psz_text = p_fribidi_string;
     }
 #endif
-    /* Work out the karaoke */
+    /* Reorder the karaoke bar along with the text */
     uint8_t *pi_karaoke_bar = NULL;
-    if( pi_k_dates )
+    if( pi_k_bar )
     {
         pi_karaoke_bar = malloc( i_len * sizeof(*pi_karaoke_bar));
         if( pi_karaoke_bar )
         {
-            int64_t i_elapsed  = var_GetTime( p_filter, "spu-elapsed" ) / 1000;
             for( int i = 0; i < i_len; i++ )
             {
                 unsigned i_bar = p_new_positions ? p_new_positions[i] : i;
-                pi_karaoke_bar[i_bar] = pi_k_dates[i] >= i_elapsed;
+                pi_karaoke_bar[i_bar] = pi_k_bar[i];
             }
         }
     }
@@ -1324,11 +1610,9 @@ static int ProcessLines( filter_t *p_filter,
             /* (Re)load/reconfigure the face if needed */
             if( !FaceStyleEquals( p_current_style, p_previous_style ) )
             {
-                if( p_face )
-                    FT_Done_Face( p_face );
                 p_previous_style = NULL;
 
-                p_face = LoadFace( p_filter, p_current_style );
+                p_face = GetFace( p_filter, p_current_style );
             }
             FT_Face p_current_face = p_face ? p_face : p_sys->p_face;
             if( !p_previous_style || p_previous_style->i_font_size != p_current_style->i_font_size ||
@@ -1351,6 +1635,7 @@ static int ProcessLines( filter_t *p_filter,
                                     i_radius,
                                     FT_STROKER_LINECAP_ROUND,
                                     FT_STROKER_LINEJOIN_ROUND, 0 );
+                    p_sys->i_stroker_radius = i_radius;
                 }
             }
             p_previous_style = p_current_style;
@@ -1418,20 +1703,22 @@ static int ProcessLines( filter_t *p_filter,
                 FT_BBox  outline_bbox;
                 FT_Glyph shadow;
                 FT_BBox  shadow_bbox;
+                FT_Vector glyph_advance;
 
                 if( GetGlyph( p_filter,
                               &glyph, &glyph_bbox,
                               &outline, &outline_bbox,
                               &shadow, &shadow_bbox,
+                              &glyph_advance,
                               p_current_face, i_glyph_index, p_glyph_style->i_style_flags,
                               &pen_new, &pen_shadow_new ) )
                     goto next;
 
-                FixGlyph( glyph, &glyph_bbox, p_current_face, &pen_new );
+                FixGlyph( glyph, &glyph_bbox, &glyph_advance, &pen_new );
                 if( outline )
-                    FixGlyph( outline, &outline_bbox, p_current_face, &pen_new );
+                    FixGlyph( outline, &outline_bbox, &glyph_advance, &pen_new );
                 if( shadow )
-                    FixGlyph( shadow, &shadow_bbox, p_current_face, &pen_shadow_new );
+                    FixGlyph( shadow, &shadow_bbox, &glyph_advance, &pen_shadow_new );
 
                 /* FIXME and what about outline */
 
@@ -1534,8 +1821,7 @@ static int ProcessLines( filter_t *p_filter,
                 /* since multiple diacritics may follow a single base glyph. */
                 if( !DIACRITIC( character ) )
                 {
-                    advance.x = p_current_face->glyph->advance.x;
-                    advance.y = p_current_face->glyph->advance.y;
+                    advance = glyph_advance;
                 }
 
                 pen.x = pen_new.x + advance.x;
@@ -1604,9 +1890,6 @@ static int ProcessLines( filter_t *p_filter,
             break;
         }
     }
-    if( p_face )
-        FT_Done_Face( p_face );
-
     free( pp_fribidi_styles );
     free( p_fribidi_string );
     free( pi_karaoke_bar );
@@ -1627,6 +1910,144 @@ static xml_reader_t *GetXMLReader( filter_t *p_filter, stream_t *p_sub )
     return p_xml_reader;
 }
 
+static bool LineStyleEquals( const text_style_t *p_style1,
+                             const text_style_t *p_style2 )
+{
+    if( p_style1 == p_style2 )
+        return true;
+    if( !p_style1 || !p_style2 )
+        return false;
+
+    return !strcmp( p_style1->psz_fontname, p_style2->psz_fontname ) &&
+           p_style1->i_font_size == p_style2->i_font_size &&
+           p_style1->i_font_color == p_style2->i_font_color &&
+           p_style1->i_font_alpha == p_style2->i_font_alpha &&
+           p_style1->i_style_flags == p_style2->i_style_flags &&
+           p_style1->i_karaoke_background_color == p_style2->i_karaoke_background_color &&
+           p_style1->i_karaoke_background_alpha == p_style2->i_karaoke_background_alpha &&
+           p_style1->i_spacing == p_style2->i_spacing;
+}
+
+static void LineCacheEntryClean( line_cache_entry_t *p_entry )
+{
+    for( int i = 0; i < p_entry->i_len; i++ )
+    {
+        if( p_entry->pp_styles[i] &&
+            ( i + 1 == p_entry->i_len || p_entry->pp_styles[i] != p_entry->pp_styles[i + 1] ) )
+            text_style_Delete( p_entry->pp_styles[i] );
+    }
+    free( p_entry->pp_styles );
+    free( p_entry->psz_text );
+    free( p_entry->pi_k_bar );
+    FreeLines( p_entry->p_lines );
+
+    memset( p_entry, 0, sizeof(*p_entry) );
+}
+
+static line_cache_entry_t *LineCacheFind( filter_t *p_filter,
+                                          const uni_char_t *psz_text,
+                                          text_style_t **pp_styles,
+                                          const uint8_t *pi_k_bar,
+                                          int i_len,
+                                          int i_outline_thickness )
+{
+    filter_sys_t *p_sys = p_filter->p_sys;
+
+    for( int i = 0; i < LINE_CACHE_SIZE; i++ )
+    {
+        line_cache_entry_t *p_entry = &p_sys->line_cache[i];
+
+        if( !p_entry->psz_text || p_entry->i_len != i_len ||
+            p_entry->i_visible_width != p_filter->fmt_out.video.i_visible_width ||
+            p_entry->i_visible_height != p_filter->fmt_out.video.i_visible_height ||
+            p_entry->i_outline_thickness != i_outline_thickness ||
+            memcmp( p_entry->psz_text, psz_text, i_len * sizeof(*psz_text) ) )
+            continue;
+
+        if( !p_entry->pi_k_bar != !pi_k_bar ||
+            ( pi_k_bar && memcmp( p_entry->pi_k_bar, pi_k_bar, i_len ) ) )
+            continue;
+
+        int j;
+        for( j = 0; j < i_len; j++ )
+        {
+            if( j > 0 && pp_styles[j] == pp_styles[j - 1] &&
+                p_entry->pp_styles[j] == p_entry->pp_styles[j - 1] )
+                continue;
+            if( !LineStyleEquals( p_entry->pp_styles[j], pp_styles[j] ) )
+                break;
+        }
+        if( j < i_len )
+            continue;
+
+        p_entry->i_last_use = ++p_sys->i_line_cache_use;
+        return p_entry;
+    }
+    return NULL;
+}
+
+static line_cache_entry_t *LineCacheInsert( filter_t *p_filter,
+                                            const uni_char_t *psz_text,
+                                            text_style_t **pp_styles,
+                                            const uint8_t *pi_k_bar,
+                                            int i_len,
+                                            int i_outline_thickness,
+                                            line_desc_t *p_lines,
+                                            const FT_BBox *p_bbox,
+                                            int i_max_face_height )
+{
+    filter_sys_t *p_sys = p_filter->p_sys;
+
+    /* Replace the least recently used entry */
+    line_cache_entry_t *p_entry = &p_sys->line_cache[0];
+    for( int i = 1; i < LINE_CACHE_SIZE; i++ )
+    {
+        if( p_sys->line_cache[i].i_last_use < p_entry->i_last_use )
+            p_entry = &p_sys->line_cache[i];
+    }
+    LineCacheEntryClean( p_entry );
+
+    p_entry->psz_text = malloc( i_len * sizeof(*psz_text) );
+    p_entry->pp_styles = calloc( i_len, sizeof(*pp_styles) );
+    if( pi_k_bar )
+        p_entry->pi_k_bar = malloc( i_len );
+    if( !p_entry->psz_text || !p_entry->pp_styles ||
+        ( pi_k_bar && !p_entry->pi_k_bar ) )
+        goto error;
+
+    p_entry->i_len = i_len;
+    for( int i = 0; i < i_len; i++ )
+    {
+        if( i > 0 && pp_styles[i] == pp_styles[i - 1] )
+            p_entry->pp_styles[i] = p_entry->pp_styles[i - 1];
+        else if( pp_styles[i] &&
+                 !(p_entry->pp_styles[i] = text_style_Duplicate( pp_styles[i] )) )
+            goto error;
+    }
+    memcpy( p_entry->psz_text, psz_text, i_len * sizeof(*psz_text) );
+    if( pi_k_bar )
+        memcpy( p_entry->pi_k_bar, pi_k_bar, i_len );
+    p_entry->i_visible_width = p_filter->fmt_out.video.i_visible_width;
+    p_entry->i_visible_height = p_filter->fmt_out.video.i_visible_height;
+    p_entry->i_outline_thickness = i_outline_thickness;
+
+    p_entry->p_lines = p_lines;
+    p_entry->bbox = *p_bbox;
+    p_entry->i_max_face_height = i_max_face_height;
+    p_entry->i_last_use = ++p_sys->i_line_cache_use;
+    return p_entry;
+
+error:
+    LineCacheEntryClean( p_entry );
+    return NULL;
+}
+
+static void LineCacheClear( filter_sys_t *p_sys )
+{
+    for( int i = 0; i < LINE_CACHE_SIZE; i++ )
+        LineCacheEntryClean( &p_sys->line_cache[i] );
+}
+
 /**
  * This function renders a text subpicture region into another one.
  * It also calculates the size needed for this string, and renders the
@@ -1667,6 +2088,7 @@ static int RenderCommon( filter_t *p_filter, subpicture_region_t *p_region_out,
     FT_BBox bbox;
     int i_max_face_height;
     line_desc_t *p_lines = NULL;
+    bool b_lines_cached = false;
 
     uint32_t *pi_k_durations   = NULL;
 
@@ -1766,9 +2188,40 @@ static int RenderCommon( filter_t *p_filter, subpicture_region_t *p_region_out,
 
     if( !rv && i_text_length > 0 )
     {
-        rv = ProcessLines( p_filter,
-                           &p_lines, &bbox, &i_max_face_height,
-                           psz_text, pp_styles, pi_k_durations, i_text_length );
+        /* Work out the karaoke */
+        uint8_t *pi_k_bar = NULL;
+        if( pi_k_durations )
+        {
+            pi_k_bar = malloc( i_text_length * sizeof(*pi_k_bar) );
+            if( pi_k_bar )
+            {
+                int64_t i_elapsed  = var_GetTime( p_filter, "spu-elapsed" ) / 1000;
+                for( int i = 0; i < i_text_length; i++ )
+                    pi_k_bar[i] = pi_k_durations[i] >= i_elapsed;
+            }
+        }
+        const int i_outline_thickness = var_InheritInteger( p_filter, "freetype-outline-thickness" );
+
+        line_cache_entry_t *p_cache = LineCacheFind( p_filter, psz_text, pp_styles, pi_k_bar,
+                                                     i_text_length, i_outline_thickness );
+        if( p_cache )
+        {
+            p_lines = p_cache->p_lines;
+            bbox = p_cache->bbox;
+            i_max_face_height = p_cache->i_max_face_height;
+        }
+        else
+        {
+            rv = ProcessLines( p_filter,
+                               &p_lines, &bbox, &i_max_face_height,
+                               psz_text, pp_styles, pi_k_bar, i_text_length );
+            if( !rv )
+                p_cache = LineCacheInsert( p_filter, psz_text, pp_styles, pi_k_bar,
+                                           i_text_length, i_outline_thickness,
+                                           p_lines, &bbox, i_max_face_height );
+        }
+        b_lines_cached = p_cache != NULL;
+        free( pi_k_bar );
     }
 
     p_region_out->i_x = p_region_in->i_x;
@@ -1822,7 +2275,8 @@ static int RenderCommon( filter_t *p_filter, subpicture_region_t *p_region_out,
             var_SetBool( p_filter, "text-rerender", true );
     }
 
-    FreeLines( p_lines );
+    if( !b_lines_cached )
+        FreeLines( p_lines );
 
     free( psz_text );
     for( int i = 0; i < i_text_length; i++ )
@@ -1935,6 +2389,14 @@ static int Create( vlc_object_t *p_this )
     p_sys->p_library        = 0;
     p_sys->style.i_font_size      = 0;
     p_sys->style.i_style_flags = 0;
+    p_sys->i_stroker_radius = 0;
+    p_sys->p_face_cache = NULL;
+    for( int i = 0; i < GLYPH_CACHE_BUCKETS; i++ )
+        p_sys->pp_glyph_hash[i] = NULL;
+    p_sys->p_glyph_first = p_sys->p_glyph_last = NULL;
+    p_sys->i_glyph_count = 0;
+    memset( p_sys->line_cache, 0, sizeof(p_sys->line_cache) );
+    p_sys->i_line_cache_use = 0;
 
     /*
      * The following variables should not be cached, as they might be changed on-the-fly:
@@ -2069,6 +2531,11 @@ static void Destroy( vlc_object_t *p_this )
     filter_t *p_filter = (filter_t *)p_this;
     filter_sys_t *p_sys = p_filter->p_sys;
 
+    /* Faces may be loaded from the attachments */
+    LineCacheClear( p_sys );
+    GlyphCacheClear( p_sys );
+    FaceCacheClear( p_sys );
+
     if( p_sys->pp_font_attachments )
     {
         for( int k = 0; k < p_sys->i_font_attachments; k++ )
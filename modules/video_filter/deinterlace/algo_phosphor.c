@@ -38,6 +38,7 @@
 #include <vlc_filter.h>
 
 #include "deinterlace.h" /* filter_sys_t */
+#include "common.h"      /* DEINTERLACE_SSE2 */
 #include "helpers.h"     /* ComposeFrame() */
 
 #include "algo_phosphor.h"
@@ -257,7 +258,7 @@ static void DarkenFieldMMX( picture_t *p_dst,
                 }
 
                 /* C version - handle the width remainder */
-                uint8_t *po = p_out;
+                uint8_t *po = p_out + x;
                 for( ; x < w; ++x, ++po )
                     (*po) = 128 + ( ((*po) - 128) / (1 << i_strength) );
             } /* for p_out... */
@@ -268,6 +269,98 @@ static void DarkenFieldMMX( picture_t *p_dst,
 }
 #endif
 
+#ifdef DEINTERLACE_SSE2
+DEINTERLACE_SSE2_ATTR
+static void DarkenFieldSSE2( picture_t *p_dst,
+                             const int i_field, const int i_strength,
+                             bool process_chroma )
+{
+    assert( p_dst != NULL );
+    assert( i_field == 0 || i_field == 1 );
+    assert( i_strength >= 1 && i_strength <= 3 );
+
+    const uint8_t remove_high_u8 = 0xFF >> i_strength;
+    const __m128i shift = _mm_cvtsi32_si128( i_strength );
+    const __m128i remove_high = _mm_set1_epi8( remove_high_u8 );
+    const __m128i b128 = _mm_set1_epi8( -128 );
+
+    /* Same as the MMX version, 16 pixels at a time */
+    int i_plane = Y_PLANE;
+    uint8_t *p_out, *p_out_end;
+    int w = p_dst->p[i_plane].i_visible_pitch;
+    p_out = p_dst->p[i_plane].p_pixels;
+    p_out_end = p_out + p_dst->p[i_plane].i_pitch
+                      * p_dst->p[i_plane].i_visible_lines;
+
+    /* skip first line for bottom field */
+    if( i_field == 1 )
+        p_out += p_dst->p[i_plane].i_pitch;
+
+    int w16 = w & ~15; /* part of width that is divisible by 16 */
+    for( ; p_out < p_out_end ; p_out += 2*p_dst->p[i_plane].i_pitch )
+    {
+        int x = 0;
+
+        for( ; x < w16; x += 16 )
+        {
+            __m128i v = _mm_loadu_si128( (__m128i *)&p_out[x] );
+            v = _mm_and_si128( _mm_srl_epi16( v, shift ), remove_high );
+            _mm_storeu_si128( (__m128i *)&p_out[x], v );
+        }
+
+        /* handle the width remainder */
+        for( ; x < w; ++x )
+            p_out[x] = ( (p_out[x] >> i_strength) & remove_high_u8 );
+    }
+
+    if( process_chroma )
+    {
+        for( i_plane++ /* luma already handled */;
+             i_plane < p_dst->i_planes;
+             i_plane++ )
+        {
+            int w = p_dst->p[i_plane].i_visible_pitch;
+            int w16 = w & ~15;
+
+            p_out = p_dst->p[i_plane].p_pixels;
+            p_out_end = p_out + p_dst->p[i_plane].i_pitch
+                              * p_dst->p[i_plane].i_visible_lines;
+
+            /* skip first line for bottom field */
+            if( i_field == 1 )
+                p_out += p_dst->p[i_plane].i_pitch;
+
+            for( ; p_out < p_out_end ; p_out += 2*p_dst->p[i_plane].i_pitch )
+            {
+                int x = 0;
+
+                for( ; x < w16; x += 16 )
+                {
+                    __m128i v = _mm_loadu_si128( (__m128i *)&p_out[x] );
+
+                    /* positive and negative parts around 128 */
+                    __m128i pos = _mm_subs_epu8( v, b128 );
+                    __m128i neg = _mm_subs_epu8( b128, v );
+
+                    /* >> i_strength */
+                    pos = _mm_and_si128( _mm_srl_epi16( pos, shift ),
+                                         remove_high );
+                    neg = _mm_and_si128( _mm_srl_epi16( neg, shift ),
+                                         remove_high );
+
+                    v = _mm_add_epi8( _mm_sub_epi8( pos, neg ), b128 );
+                    _mm_storeu_si128( (__m128i *)&p_out[x], v );
+                }
+
+                /* C version - handle the width remainder */
+                for( ; x < w; ++x )
+                    p_out[x] = 128 + ( (p_out[x] - 128) / (1 << i_strength) );
+            } /* for p_out... */
+        } /* for i_plane... */
+    } /* if process_chroma */
+}
+#endif
+
 /*****************************************************************************
  * Public functions
  *****************************************************************************/
@@ -353,6 +446,13 @@ int RenderPhosphor( filter_t *p_filter,
     */
     if( p_sys->phosphor.i_dimmer_strength > 0 )
     {
+#ifdef DEINTERLACE_SSE2
+        if( vlc_CPU_SSE2() )
+            DarkenFieldSSE2( p_dst, !i_field, p_sys->phosphor.i_dimmer_strength,
+                p_sys->chroma->p[1].h.num == p_sys->chroma->p[1].h.den &&
+                p_sys->chroma->p[2].h.num == p_sys->chroma->p[2].h.den );
+        else
+#endif
 #ifdef CAN_COMPILE_MMXEXT
         if( vlc_CPU_MMXEXT() )
             DarkenFieldMMX( p_dst, !i_field, p_sys->phosphor.i_dimmer_strength,
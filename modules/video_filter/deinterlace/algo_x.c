@@ -36,6 +36,7 @@
 #include <vlc_picture.h>
 
 #include "deinterlace.h" /* filter_sys_t */
+#include "common.h"      /* DEINTERLACE_SSE2 */
 
 #include "algo_x.h"
 
@@ -533,6 +534,221 @@ static inline void XDeintBand8x8MMXEXT( uint8_t *dst, int i_dst,
 }
 #endif
 
+#ifdef DEINTERLACE_SSE2
+/* The SSE2 versions give the same results as the C ones: unlike the MMXEXT
+ * versions, they check 8x10 pixels only in XDeint8x8Detect, and truncate
+ * the averages instead of rounding them. */
+DEINTERLACE_SSE2_ATTR
+static inline int XDeint8x8DetectSSE2( uint8_t *src, int i_src )
+{
+    const __m128i zero = _mm_setzero_si128();
+    __m128i l[10];
+    int y;
+
+    for( y = 0; y < 10; y++ )
+        l[y] = _mm_unpacklo_epi8(
+                   _mm_loadl_epi64( (const __m128i *)&src[y*i_src] ), zero );
+
+    /* Detect interlacing */
+    for( y = 0; y < 7; y += 2 )
+    {
+        __m128i d01 = _mm_sub_epi16( l[y+0], l[y+1] );
+        __m128i d12 = _mm_sub_epi16( l[y+1], l[y+2] );
+        __m128i d02 = _mm_sub_epi16( l[y+0], l[y+2] );
+        __m128i d13 = _mm_sub_epi16( l[y+1], l[y+3] );
+
+        __m128i fr = _mm_add_epi32( _mm_madd_epi16( d01, d01 ),
+                                    _mm_madd_epi16( d12, d12 ) );
+        __m128i ff = _mm_add_epi32( _mm_madd_epi16( d02, d02 ),
+                                    _mm_madd_epi16( d13, d13 ) );
+
+        /* fr and ff horizontal sums in the two lowest dwords */
+        __m128i sum = _mm_add_epi32( _mm_unpacklo_epi32( fr, ff ),
+                                     _mm_unpackhi_epi32( fr, ff ) );
+        sum = _mm_add_epi32( sum, _mm_unpackhi_epi64( sum, sum ) );
+
+        const int32_t i_fr = _mm_cvtsi128_si32( sum );
+        const int32_t i_ff = _mm_cvtsi128_si32( _mm_srli_si128( sum, 4 ) );
+        if( i_ff < 6*i_fr/8 && i_fr > 32 )
+            return true;
+    }
+
+    return false;
+}
+
+DEINTERLACE_SSE2_ATTR
+static inline void XDeint8x8MergeSSE2( uint8_t *dst,  int i_dst,
+                                       uint8_t *src1, int i_src1,
+                                       uint8_t *src2, int i_src2 )
+{
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i w4 = _mm_set1_epi16( 4 );
+    const __m128i w6 = _mm_set1_epi16( 6 );
+    int y;
+
+    /* Progressive */
+    for( y = 0; y < 8; y += 2 )
+    {
+        __m128i a = _mm_loadl_epi64( (const __m128i *)src1 );
+        _mm_storel_epi64( (__m128i *)dst, a );
+        dst += i_dst;
+
+        __m128i b = _mm_loadl_epi64( (const __m128i *)src2 );
+        __m128i c = _mm_loadl_epi64( (const __m128i *)&src1[i_src1] );
+        a = _mm_add_epi16( _mm_unpacklo_epi8( a, zero ),
+                           _mm_unpacklo_epi8( c, zero ) );
+        b = _mm_mullo_epi16( _mm_unpacklo_epi8( b, zero ), w6 );
+        a = _mm_srli_epi16( _mm_add_epi16( _mm_add_epi16( a, b ), w4 ), 3 );
+        _mm_storel_epi64( (__m128i *)dst, _mm_packus_epi16( a, a ) );
+        dst += i_dst;
+
+        src1 += i_src1;
+        src2 += i_src2;
+    }
+}
+
+/* (a + b) >> 1 on bytes: pavgb rounds up, which is fixed by the low bit
+ * of a ^ b */
+DEINTERLACE_SSE2_ATTR
+static inline __m128i XDeintAvgSSE2( __m128i a, __m128i b )
+{
+    return _mm_sub_epi8( _mm_avg_epu8( a, b ),
+                         _mm_and_si128( _mm_xor_si128( a, b ),
+                                        _mm_set1_epi8( 1 ) ) );
+}
+
+DEINTERLACE_SSE2_ATTR
+static inline void XDeint8x8FieldESSE2( uint8_t *dst, int i_dst,
+                                        uint8_t *src, int i_src )
+{
+    int y;
+
+    /* Interlaced */
+    for( y = 0; y < 8; y += 2 )
+    {
+        __m128i a = _mm_loadl_epi64( (const __m128i *)src );
+        __m128i b = _mm_loadl_epi64( (const __m128i *)&src[2*i_src] );
+
+        _mm_storel_epi64( (__m128i *)dst, a );
+        dst += i_dst;
+
+        _mm_storel_epi64( (__m128i *)dst, XDeintAvgSSE2( a, b ) );
+        dst += 1*i_dst;
+        src += 2*i_src;
+    }
+}
+
+/* Sums of 8 consecutive values: returns s[x] = v[x] + ... + v[x+7] as words
+ * for x = 0..7, v being the bytes of the argument (v[15] is not used). */
+DEINTERLACE_SSE2_ATTR
+static inline __m128i XDeintSum8SSE2( __m128i v )
+{
+    const __m128i zero = _mm_setzero_si128();
+    __m128i lo = _mm_unpacklo_epi8( v, zero );
+    __m128i hi = _mm_unpackhi_epi8( v, zero );
+
+    lo = _mm_add_epi16( lo, _mm_or_si128( _mm_srli_si128( lo, 2 ),
+                                          _mm_slli_si128( hi, 14 ) ) );
+    hi = _mm_add_epi16( hi, _mm_srli_si128( hi, 2 ) );
+    lo = _mm_add_epi16( lo, _mm_or_si128( _mm_srli_si128( lo, 4 ),
+                                          _mm_slli_si128( hi, 12 ) ) );
+    hi = _mm_add_epi16( hi, _mm_srli_si128( hi, 4 ) );
+    return _mm_add_epi16( lo, _mm_or_si128( _mm_srli_si128( lo, 8 ),
+                                            _mm_slli_si128( hi, 8 ) ) );
+}
+
+DEINTERLACE_SSE2_ATTR
+static inline __m128i XDeintAbsDiffSSE2( const uint8_t *a, const uint8_t *b )
+{
+    __m128i va = _mm_loadu_si128( (const __m128i *)a );
+    __m128i vb = _mm_loadu_si128( (const __m128i *)b );
+    return _mm_or_si128( _mm_subs_epu8( va, vb ), _mm_subs_epu8( vb, va ) );
+}
+
+/* Computes the 8 pixels of a line at once. The loads read up to +13 pixels
+ * H, but this is only used for blocks with a right neighbour. */
+DEINTERLACE_SSE2_ATTR
+static inline void XDeint8x8FieldSSE2( uint8_t *dst, int i_dst,
+                                       uint8_t *src, int i_src )
+{
+    int y;
+
+    /* Interlaced */
+    for( y = 0; y < 8; y += 2 )
+    {
+        uint8_t *src2 = &src[2*i_src];
+
+        _mm_storel_epi64( (__m128i *)dst,
+                          _mm_loadl_epi64( (const __m128i *)src ) );
+        dst += i_dst;
+
+        const __m128i c0 = XDeintSum8SSE2( XDeintAbsDiffSSE2( &src[-4],
+                                                              &src2[-2] ) );
+        const __m128i c1 = XDeintSum8SSE2( XDeintAbsDiffSSE2( &src[-3],
+                                                              &src2[-3] ) );
+        const __m128i c2 = XDeintSum8SSE2( XDeintAbsDiffSSE2( &src[-2],
+                                                              &src2[-4] ) );
+
+        /* c0 < c1 && c1 <= c2, and c2 < c1 && c1 <= c0 */
+        __m128i m0 = _mm_andnot_si128( _mm_cmpgt_epi16( c1, c2 ),
+                                       _mm_cmpgt_epi16( c1, c0 ) );
+        __m128i m2 = _mm_andnot_si128( _mm_cmpgt_epi16( c1, c0 ),
+                                       _mm_cmpgt_epi16( c1, c2 ) );
+        m0 = _mm_packs_epi16( m0, m0 );
+        m2 = _mm_packs_epi16( m2, m2 );
+
+        __m128i v0 = XDeintAvgSSE2(
+            _mm_loadl_epi64( (const __m128i *)&src[-1] ),
+            _mm_loadl_epi64( (const __m128i *)&src2[1] ) );
+        __m128i v1 = XDeintAvgSSE2(
+            _mm_loadl_epi64( (const __m128i *)&src[0] ),
+            _mm_loadl_epi64( (const __m128i *)&src2[0] ) );
+        __m128i v2 = XDeintAvgSSE2(
+            _mm_loadl_epi64( (const __m128i *)&src[1] ),
+            _mm_loadl_epi64( (const __m128i *)&src2[-1] ) );
+
+        __m128i v = _mm_or_si128( _mm_and_si128( m0, v0 ),
+                                  _mm_andnot_si128( m0, v1 ) );
+        v = _mm_or_si128( _mm_and_si128( m2, v2 ), _mm_andnot_si128( m2, v ) );
+        _mm_storel_epi64( (__m128i *)dst, v );
+
+        dst += 1*i_dst;
+        src += 2*i_src;
+    }
+}
+
+DEINTERLACE_SSE2_ATTR
+static inline void XDeintBand8x8SSE2( uint8_t *dst, int i_dst,
+                                      uint8_t *src, int i_src,
+                                      const int i_mbx, int i_modx )
+{
+    int x;
+
+    for( x = 0; x < i_mbx; x++ )
+    {
+        if( XDeint8x8DetectSSE2( src, i_src ) )
+        {
+            if( x == 0 || x == i_mbx - 1 )
+                XDeint8x8FieldESSE2( dst, i_dst, src, i_src );
+            else
+                XDeint8x8FieldSSE2( dst, i_dst, src, i_src );
+        }
+        else
+        {
+            XDeint8x8MergeSSE2( dst, i_dst,
+                                &src[0*i_src], 2*i_src,
+                                &src[1*i_src], 2*i_src );
+        }
+
+        dst += 8;
+        src += 8;
+    }
+
+    if( i_modx )
+        XDeintNxN( dst, i_dst, src, i_src, i_modx, 8 );
+}
+#endif
+
 /*****************************************************************************
  * Public functions
  *****************************************************************************/
@@ -540,6 +756,9 @@ static inline void XDeintBand8x8MMXEXT( uint8_t *dst, int i_dst,
 void RenderX( picture_t *p_outpic, picture_t *p_pic )
 {
     int i_plane;
+#ifdef DEINTERLACE_SSE2
+    const bool sse2 = vlc_CPU_SSE2();
+#endif
 #if defined (CAN_COMPILE_MMXEXT)
     const bool mmxext = vlc_CPU_MMXEXT();
 #endif
@@ -563,6 +782,11 @@ void RenderX( picture_t *p_outpic, picture_t *p_pic )
             uint8_t *dst = &p_outpic->p[i_plane].p_pixels[8*y*i_dst];
             uint8_t *src = &p_pic->p[i_plane].p_pixels[8*y*i_src];
 
+#ifdef DEINTERLACE_SSE2
+            if( sse2 )
+                XDeintBand8x8SSE2( dst, i_dst, src, i_src, i_mbx, i_modx );
+            else
+#endif
 #ifdef CAN_COMPILE_MMXEXT
             if( mmxext )
                 XDeintBand8x8MMXEXT( dst, i_dst, src, i_src, i_mbx, i_modx );
@@ -35,4 +35,28 @@
 #define FFMIN(a,b)      __MIN(a,b)
 #define FFMIN3(a,b,c)   FFMIN(FFMIN(a,b),c)
 
+/* SSE2 and AVX2 kernels are written with intrinsics, and compiled for their
+   instruction set even if the rest of the module is not. They must only be
+   called after checking vlc_CPU_SSE2() or vlc_CPU_AVX2(). */
+#if defined(__i386__) || defined(__x86_64__)
+# if defined(__SSE2__) || VLC_GCC_VERSION(4,9)
+#  include <emmintrin.h>
+#  define DEINTERLACE_SSE2
+#  ifdef __SSE2__
+#   define DEINTERLACE_SSE2_ATTR
+#  else
+#   define DEINTERLACE_SSE2_ATTR __attribute__ ((__target__ ("sse2")))
+#  endif
+# endif
+# if defined(__AVX2__) || VLC_GCC_VERSION(4,9)
+#  include <immintrin.h>
+#  define DEINTERLACE_AVX2
+#  ifdef __AVX2__
+#   define DEINTERLACE_AVX2_ATTR
+#  else
+#   define DEINTERLACE_AVX2_ATTR __attribute__ ((__target__ ("avx2")))
+#  endif
+# endif
+#endif
+
 #endif
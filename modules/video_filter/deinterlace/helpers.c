@@ -245,6 +245,48 @@ static int TestForMotionInBlockMMX( uint8_t *p_pix_p, uint8_t *p_pix_c,
     return (i_motion >= 8);
 }
 #endif
+
+#ifdef DEINTERLACE_SSE2
+DEINTERLACE_SSE2_ATTR
+static int TestForMotionInBlockSSE2( uint8_t *p_pix_p, uint8_t *p_pix_c,
+                                     int i_pitch_prev, int i_pitch_curr,
+                                     int* pi_top, int* pi_bot )
+{
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i one  = _mm_set1_epi8( 1 );
+    const __m128i bT   = _mm_set1_epi8( T );
+    __m128i score = zero; /* top field score in the low quadword,
+                             bottom field score in the high one */
+
+    /* Each line pair is processed at once, the top field line in the low
+       half of the registers and the bottom field line in the high half. */
+    for( int y = 0; y < 8; y += 2 )
+    {
+        __m128i c = _mm_unpacklo_epi64(
+            _mm_loadl_epi64( (const __m128i *)p_pix_c ),
+            _mm_loadl_epi64( (const __m128i *)(p_pix_c + i_pitch_curr) ) );
+        __m128i p = _mm_unpacklo_epi64(
+            _mm_loadl_epi64( (const __m128i *)p_pix_p ),
+            _mm_loadl_epi64( (const __m128i *)(p_pix_p + i_pitch_prev) ) );
+
+        /* |c - p|, then 1 if above the threshold, 0 otherwise */
+        __m128i diff = _mm_or_si128( _mm_subs_epu8( c, p ),
+                                     _mm_subs_epu8( p, c ) );
+        diff = _mm_min_epu8( _mm_subs_epu8( diff, bT ), one );
+        score = _mm_add_epi64( score, _mm_sad_epu8( diff, zero ) );
+
+        p_pix_c += 2*i_pitch_curr;
+        p_pix_p += 2*i_pitch_prev;
+    }
+
+    int i_top_motion = _mm_cvtsi128_si32( score );
+    int i_bot_motion = _mm_cvtsi128_si32( _mm_unpackhi_epi64( score, score ) );
+
+    (*pi_top) = ( i_top_motion >= 8 );
+    (*pi_bot) = ( i_bot_motion >= 8 );
+    return (i_top_motion + i_bot_motion >= 8);
+}
+#endif
 #undef T
 
 /*****************************************************************************
@@ -394,11 +436,15 @@ int EstimateNumBlocksWithMotion( const picture_t* p_prev,
 
     int (*motion_in_block)(uint8_t *, uint8_t *, int , int, int *, int *) =
         TestForMotionInBlock;
-    /* We must tell our inline helper whether to use MMX acceleration. */
+    /* We must tell our inline helper whether to use SIMD acceleration. */
 #ifdef CAN_COMPILE_MMXEXT
     if (vlc_CPU_MMXEXT())
         motion_in_block = TestForMotionInBlockMMX;
 #endif
+#ifdef DEINTERLACE_SSE2
+    if (vlc_CPU_SSE2())
+        motion_in_block = TestForMotionInBlockSSE2;
+#endif
 
     int i_score = 0;
     for( int i_plane = 0 ; i_plane < p_prev->i_planes ; i_plane++ )
@@ -582,31 +628,151 @@ static int CalculateInterlaceScoreMMX( const picture_t* p_pic_top,
 }
 #endif
 
-/* See header for function doc. */
-int CalculateInterlaceScore( const picture_t* p_pic_top,
-                             const picture_t* p_pic_bot )
+/**
+ * Internal helper function for CalculateInterlaceScore(): counts the combed
+ * pixels of one line, given the neighbouring lines from the other field.
+ *
+ * @param p_c Current line
+ * @param p_p Previous line (other field)
+ * @param p_n Next line (other field)
+ * @param w Number of pixels to check
+ * @return Number of combed pixels
+ */
+static int CombLine( const uint8_t *p_c, const uint8_t *p_p,
+                     const uint8_t *p_n, int w )
 {
-    /*
-        We use the comb metric from the IVTC filter of Transcode 1.1.5.
-        This was found to work better for the particular purpose of IVTC
-        than RenderX()'s comb metric.
+    int i_score = 0;
 
-        Note that we *must not* subsample at all in order to catch interlacing
-        in telecined frames with localized motion (e.g. anime with characters
-        talking, where only mouths move and everything else stays still.)
-    */
+    for( int x = 0; x < w; ++x )
+    {
+        /* Worst case: need 17 bits for "comb". */
+        int_fast32_t C = *p_c;
+        int_fast32_t P = *p_p;
+        int_fast32_t N = *p_n;
+
+        /* Comments in Transcode's filter_ivtc.c attribute this
+           combing metric to Gunnar Thalin.
+
+            The idea is that if the picture is interlaced, both
+            expressions will have the same sign, and this comes
+            up positive. The value T = 100 has been chosen such
+            that a pixel difference of 10 (on average) will
+            trigger the detector.
+        */
+        int_fast32_t comb = (P - C) * (N - C);
+        if( comb > T )
+            ++i_score;
 
-    assert( p_pic_top != NULL );
-    assert( p_pic_bot != NULL );
+        ++p_c;
+        ++p_p;
+        ++p_n;
+    }
 
-    if( p_pic_top->i_planes != p_pic_bot->i_planes )
-        return -1;
+    return i_score;
+}
 
-#ifdef CAN_COMPILE_MMXEXT
-    if (vlc_CPU_MMXEXT())
-        return CalculateInterlaceScoreMMX( p_pic_top, p_pic_bot );
+/* The SIMD versions work on pixel differences saturated to 8 signed bits,
+   like the MMX version. This is exact: the sign of the product is kept,
+   and as soon as one difference saturates, the magnitude of the product
+   is either zero or above the threshold, both before and after
+   saturation. */
+#ifdef DEINTERLACE_SSE2
+DEINTERLACE_SSE2_ATTR
+static int CombLineSSE2( const uint8_t *p_c, const uint8_t *p_p,
+                         const uint8_t *p_n, int w )
+{
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i one  = _mm_set1_epi8( 1 );
+    const __m128i b128 = _mm_set1_epi8( -128 );
+    const __m128i wT   = _mm_set1_epi16( T );
+    __m128i score = zero;
+    int x = 0;
+
+    for( ; x + 16 <= w; x += 16 )
+    {
+        __m128i c = _mm_xor_si128( _mm_loadu_si128( (const __m128i *)&p_c[x] ),
+                                   b128 );
+        __m128i p = _mm_xor_si128( _mm_loadu_si128( (const __m128i *)&p_p[x] ),
+                                   b128 );
+        __m128i n = _mm_xor_si128( _mm_loadu_si128( (const __m128i *)&p_n[x] ),
+                                   b128 );
+        __m128i dp = _mm_subs_epi8( p, c );
+        __m128i dn = _mm_subs_epi8( n, c );
+
+        /* With the differences in the high bytes of the words, the high
+           word of the 32-bit product is the product of the differences. */
+        __m128i lo = _mm_mulhi_epi16( _mm_unpacklo_epi8( zero, dp ),
+                                      _mm_unpacklo_epi8( zero, dn ) );
+        __m128i hi = _mm_mulhi_epi16( _mm_unpackhi_epi8( zero, dp ),
+                                      _mm_unpackhi_epi8( zero, dn ) );
+        __m128i comb = _mm_packs_epi16( _mm_cmpgt_epi16( lo, wT ),
+                                        _mm_cmpgt_epi16( hi, wT ) );
+        score = _mm_add_epi64( score,
+                               _mm_sad_epu8( _mm_and_si128( comb, one ), zero ) );
+    }
+
+    score = _mm_add_epi64( score, _mm_unpackhi_epi64( score, score ) );
+    return _mm_cvtsi128_si32( score )
+         + CombLine( &p_c[x], &p_p[x], &p_n[x], w - x );
+}
 #endif
 
+#ifdef DEINTERLACE_AVX2
+DEINTERLACE_AVX2_ATTR
+static int CombLineAVX2( const uint8_t *p_c, const uint8_t *p_p,
+                         const uint8_t *p_n, int w )
+{
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i one  = _mm256_set1_epi8( 1 );
+    const __m256i b128 = _mm256_set1_epi8( -128 );
+    const __m256i wT   = _mm256_set1_epi16( T );
+    __m256i score = zero;
+    int x = 0;
+
+    for( ; x + 32 <= w; x += 32 )
+    {
+        __m256i c = _mm256_xor_si256(
+            _mm256_loadu_si256( (const __m256i *)&p_c[x] ), b128 );
+        __m256i p = _mm256_xor_si256(
+            _mm256_loadu_si256( (const __m256i *)&p_p[x] ), b128 );
+        __m256i n = _mm256_xor_si256(
+            _mm256_loadu_si256( (const __m256i *)&p_n[x] ), b128 );
+        __m256i dp = _mm256_subs_epi8( p, c );
+        __m256i dn = _mm256_subs_epi8( n, c );
+
+        /* Unpacking works within 128-bit lanes, which does not matter
+           for counting. */
+        __m256i lo = _mm256_mulhi_epi16( _mm256_unpacklo_epi8( zero, dp ),
+                                         _mm256_unpacklo_epi8( zero, dn ) );
+        __m256i hi = _mm256_mulhi_epi16( _mm256_unpackhi_epi8( zero, dp ),
+                                         _mm256_unpackhi_epi8( zero, dn ) );
+        __m256i comb = _mm256_packs_epi16( _mm256_cmpgt_epi16( lo, wT ),
+                                           _mm256_cmpgt_epi16( hi, wT ) );
+        score = _mm256_add_epi64( score,
+                    _mm256_sad_epu8( _mm256_and_si256( comb, one ), zero ) );
+    }
+
+    __m128i sum = _mm_add_epi64( _mm256_castsi256_si128( score ),
+                                 _mm256_extracti128_si256( score, 1 ) );
+    sum = _mm_add_epi64( sum, _mm_unpackhi_epi64( sum, sum ) );
+    return _mm_cvtsi128_si32( sum )
+         + CombLine( &p_c[x], &p_p[x], &p_n[x], w - x );
+}
+#endif
+
+/**
+ * Internal helper function for CalculateInterlaceScore(): runs the given
+ * line function over all the lines of the pictures.
+ *
+ * @see CalculateInterlaceScore()
+ */
+static int CalculateInterlaceScoreLines( const picture_t* p_pic_top,
+                                         const picture_t* p_pic_bot,
+                                         int (*comb_line)( const uint8_t *,
+                                                           const uint8_t *,
+                                                           const uint8_t *,
+                                                           int ) )
+{
     int32_t i_score = 0;
 
     for( int i_plane = 0 ; i_plane < p_pic_top->i_planes ; ++i_plane )
@@ -636,30 +802,7 @@ int CalculateInterlaceScore( const picture_t* p_pic_top,
             uint8_t *p_p = &ngh->p[i_plane].p_pixels[(y-1)*wn]; /* prev line */
             uint8_t *p_n = &ngh->p[i_plane].p_pixels[(y+1)*wn]; /* next line */
 
-            for( int x = 0; x < w; ++x )
-            {
-                /* Worst case: need 17 bits for "comb". */
-                int_fast32_t C = *p_c;
-                int_fast32_t P = *p_p;
-                int_fast32_t N = *p_n;
-
-                /* Comments in Transcode's filter_ivtc.c attribute this
-                   combing metric to Gunnar Thalin.
-
-                    The idea is that if the picture is interlaced, both
-                    expressions will have the same sign, and this comes
-                    up positive. The value T = 100 has been chosen such
-                    that a pixel difference of 10 (on average) will
-                    trigger the detector.
-                */
-                int_fast32_t comb = (P - C) * (N - C);
-                if( comb > T )
-                    ++i_score;
-
-                ++p_c;
-                ++p_p;
-                ++p_n;
-            }
+            i_score += comb_line( p_c, p_p, p_n, w );
 
             /* Now the other field - swap current and neighbour pictures */
             const picture_t *tmp = cur;
@@ -673,4 +816,42 @@ int CalculateInterlaceScore( const picture_t* p_pic_top,
 
     return i_score;
 }
+
+/* See header for function doc. */
+int CalculateInterlaceScore( const picture_t* p_pic_top,
+                             const picture_t* p_pic_bot )
+{
+    /*
+        We use the comb metric from the IVTC filter of Transcode 1.1.5.
+        This was found to work better for the particular purpose of IVTC
+        than RenderX()'s comb metric.
+
+        Note that we *must not* subsample at all in order to catch interlacing
+        in telecined frames with localized motion (e.g. anime with characters
+        talking, where only mouths move and everything else stays still.)
+    */
+
+    assert( p_pic_top != NULL );
+    assert( p_pic_bot != NULL );
+
+    if( p_pic_top->i_planes != p_pic_bot->i_planes )
+        return -1;
+
+#ifdef DEINTERLACE_AVX2
+    if (vlc_CPU_AVX2())
+        return CalculateInterlaceScoreLines( p_pic_top, p_pic_bot,
+                                             CombLineAVX2 );
+#endif
+#ifdef DEINTERLACE_SSE2
+    if (vlc_CPU_SSE2())
+        return CalculateInterlaceScoreLines( p_pic_top, p_pic_bot,
+                                             CombLineSSE2 );
+#endif
+#ifdef CAN_COMPILE_MMXEXT
+    if (vlc_CPU_MMXEXT())
+        return CalculateInterlaceScoreMMX( p_pic_top, p_pic_bot );
+#endif
+
+    return CalculateInterlaceScoreLines( p_pic_top, p_pic_bot, CombLine );
+}
 #undef T
@@ -25,6 +25,9 @@
  * values by ULL, lest they be truncated by the compiler)
  */
 
+#ifndef VLC_DEINTERLACE_MMX_H
+#define VLC_DEINTERLACE_MMX_H 1
+
 #include <stdint.h>
 
 typedef    union {
@@ -260,3 +263,5 @@ typedef    union {
 #define    pshufw_r2r(regs,regd,imm)    mmx_r2ri(pshufw, regs, regd, imm)
 
 #define    sfence() __asm__ __volatile__ ("sfence\n\t")
+
+#endif
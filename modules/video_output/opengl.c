@@ -93,6 +93,9 @@
 #   define PRECISION ""
 #   define SUPPORTS_SHADERS
 #   define SUPPORTS_FIXED_PIPELINE
+#   ifndef __APPLE__
+#       define SUPPORTS_PBO
+#   endif
 #endif
 
 static const vlc_fourcc_t gl_subpicture_chromas[] = {
@@ -118,6 +121,19 @@ typedef struct {
     float    tex_height;
 } gl_region_t;
 
+#ifdef SUPPORTS_PBO
+/* Persistently mapped pixel buffers that pictures are copied to, so that
+ * textures are updated asynchronously. They belong to the display: pictures
+ * never point to GL memory. */
+#define VLCGL_PBO_COUNT 3
+
+typedef struct {
+    GLuint   buffer[PICTURE_PLANE_MAX];
+    plane_t  plane[PICTURE_PLANE_MAX];
+    GLsync   fence; /* pending upload from the buffers */
+} gl_pbo_t;
+#endif
+
 struct vout_display_opengl_t {
 
     vlc_gl_t   *gl;
@@ -153,6 +169,20 @@ struct vout_display_opengl_t {
     GLuint *subpicture_buffer_object;
     int    subpicture_buffer_object_count;
 
+#ifdef SUPPORTS_PBO
+    /* Persistently mapped pixel buffer objects */
+    bool persistent_pbo;
+    PFNGLBUFFERSTORAGEPROC  BufferStorage;
+    PFNGLMAPBUFFERRANGEPROC MapBufferRange;
+    PFNGLFENCESYNCPROC      FenceSync;
+    PFNGLCLIENTWAITSYNCPROC ClientWaitSync;
+    PFNGLDELETESYNCPROC     DeleteSync;
+
+    gl_pbo_t pbo[VLCGL_PBO_COUNT];
+    unsigned pbo_count;
+    unsigned pbo_index;
+#endif
+
     /* Shader variables commands*/
 #ifdef SUPPORTS_SHADERS
     PFNGLGETUNIFORMLOCATIONPROC      GetUniformLocation;
@@ -505,6 +535,26 @@ vout_display_opengl_t *vout_display_opengl_New(video_format_t *fmt,
         supports_shaders = false;
 #endif
 
+#ifdef SUPPORTS_PBO
+    /* Pictures can be copied to pixel buffers if they can stay mapped while
+     * the GPU reads from them (GL 4.4), and fences tell when it is done */
+    vgl->persistent_pbo = supports_shaders &&
+        (strverscmp((const char *)ogl_version, "4.4") >= 0 ||
+         (HasExtension(extensions, "GL_ARB_buffer_storage") &&
+          HasExtension(extensions, "GL_ARB_map_buffer_range") &&
+          HasExtension(extensions, "GL_ARB_sync")));
+    if (vgl->persistent_pbo) {
+        vgl->BufferStorage  = (PFNGLBUFFERSTORAGEPROC)vlc_gl_GetProcAddress(vgl->gl, "glBufferStorage");
+        vgl->MapBufferRange = (PFNGLMAPBUFFERRANGEPROC)vlc_gl_GetProcAddress(vgl->gl, "glMapBufferRange");
+        vgl->FenceSync      = (PFNGLFENCESYNCPROC)vlc_gl_GetProcAddress(vgl->gl, "glFenceSync");
+        vgl->ClientWaitSync = (PFNGLCLIENTWAITSYNCPROC)vlc_gl_GetProcAddress(vgl->gl, "glClientWaitSync");
+        vgl->DeleteSync     = (PFNGLDELETESYNCPROC)vlc_gl_GetProcAddress(vgl->gl, "glDeleteSync");
+        if (!vgl->BufferStorage || !vgl->MapBufferRange || !vgl->FenceSync ||
+            !vgl->ClientWaitSync || !vgl->DeleteSync)
+            vgl->persistent_pbo = false;
+    }
+#endif
+
 #if defined(_WIN32)
     vgl->ActiveTexture = (PFNGLACTIVETEXTUREPROC)vlc_gl_GetProcAddress(vgl->gl, "glActiveTexture");
     vgl->ClientActiveTexture = (PFNGLCLIENTACTIVETEXTUREPROC)vlc_gl_GetProcAddress(vgl->gl, "glClientActiveTexture");
@@ -720,6 +770,75 @@ vout_display_opengl_t *vout_display_opengl_New(video_format_t *fmt,
     return vgl;
 }
 
+#ifdef SUPPORTS_PBO
+/* Must be called with the context current */
+static void PBODeleteAll(vout_display_opengl_t *vgl)
+{
+    for (unsigned i = 0; i < vgl->pbo_count; i++) {
+        gl_pbo_t *pbo = &vgl->pbo[i];
+
+        if (pbo->fence)
+            vgl->DeleteSync(pbo->fence);
+        /* Deleting the buffers also unmaps them */
+        vgl->DeleteBuffers(vgl->chroma->plane_count, pbo->buffer);
+    }
+    vgl->pbo_count = 0;
+}
+
+/* Must be called with the context current */
+static int PBONewAll(vout_display_opengl_t *vgl)
+{
+    picture_t geometry;
+    if (picture_Setup(&geometry, &vgl->fmt))
+        return VLC_EGENERIC;
+
+    const GLbitfield access = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT |
+                              GL_MAP_COHERENT_BIT;
+    for (vgl->pbo_count = 0; vgl->pbo_count < VLCGL_PBO_COUNT; vgl->pbo_count++) {
+        gl_pbo_t *pbo = &vgl->pbo[vgl->pbo_count];
+
+        pbo->fence = NULL;
+        vgl->GenBuffers(vgl->chroma->plane_count, pbo->buffer);
+        for (unsigned j = 0; j < vgl->chroma->plane_count; j++) {
+            const size_t size = geometry.p[j].i_pitch * geometry.p[j].i_lines;
+
+            pbo->plane[j] = geometry.p[j];
+            vgl->BindBuffer(GL_PIXEL_UNPACK_BUFFER, pbo->buffer[j]);
+            vgl->BufferStorage(GL_PIXEL_UNPACK_BUFFER, size, NULL, access);
+            pbo->plane[j].p_pixels = vgl->MapBufferRange(GL_PIXEL_UNPACK_BUFFER,
+                                                         0, size, access);
+            if (!pbo->plane[j].p_pixels) {
+                vgl->BindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+                vgl->pbo_count++;
+                PBODeleteAll(vgl);
+                return VLC_EGENERIC;
+            }
+        }
+    }
+    vgl->BindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+    vgl->pbo_index = 0;
+    return VLC_SUCCESS;
+}
+
+/* Copies the picture to the next buffers, once the GPU is done with them */
+static gl_pbo_t *PBOCopy(vout_display_opengl_t *vgl, const picture_t *picture)
+{
+    gl_pbo_t *pbo = &vgl->pbo[vgl->pbo_index];
+
+    if (pbo->fence) {
+        vgl->ClientWaitSync(pbo->fence, GL_SYNC_FLUSH_COMMANDS_BIT,
+                            UINT64_C(1000000000));
+        vgl->DeleteSync(pbo->fence);
+        pbo->fence = NULL;
+    }
+    for (unsigned j = 0; j < vgl->chroma->plane_count; j++)
+        plane_CopyPixels(&pbo->plane[j], &picture->p[j]);
+
+    vgl->pbo_index = (vgl->pbo_index + 1) % vgl->pbo_count;
+    return pbo;
+}
+#endif
+
 void vout_display_opengl_Delete(vout_display_opengl_t *vgl)
 {
     /* */
@@ -743,6 +862,9 @@ void vout_display_opengl_Delete(vout_display_opengl_t *vgl)
         }
         vgl->DeleteBuffers(1, &vgl->vertex_buffer_object);
         vgl->DeleteBuffers(vgl->chroma->plane_count, vgl->texture_buffer_object);
+#ifdef SUPPORTS_PBO
+        PBODeleteAll(vgl);
+#endif
         if (vgl->subpicture_buffer_object_count > 0)
             vgl->DeleteBuffers(vgl->subpicture_buffer_object_count, vgl->subpicture_buffer_object);
         free(vgl->subpicture_buffer_object);
@@ -809,6 +931,11 @@ picture_pool_t *vout_display_opengl_GetPool(vout_display_opengl_t *vgl, unsigned
         }
     }
 
+#ifdef SUPPORTS_PBO
+    if (vgl->persistent_pbo && PBONewAll(vgl))
+        vgl->persistent_pbo = false;
+#endif
+
     vlc_gl_Unlock(vgl->gl);
 
     return vgl->pool;
@@ -890,6 +1017,10 @@ int vout_display_opengl_Prepare(vout_display_opengl_t *vgl,
     if (vlc_gl_Lock(vgl->gl))
         return VLC_EGENERIC;
 
+#ifdef SUPPORTS_PBO
+    gl_pbo_t *pbo = vgl->pbo_count > 0 ? PBOCopy(vgl, picture) : NULL;
+#endif
+
     /* Update the texture */
     for (unsigned j = 0; j < vgl->chroma->plane_count; j++) {
         if (vgl->use_multitexture) {
@@ -898,11 +1029,27 @@ int vout_display_opengl_Prepare(vout_display_opengl_t *vgl,
         }
         glBindTexture(vgl->tex_target, vgl->texture[0][j]);
 
+        const uint8_t *pixels = picture->p[j].p_pixels;
+        int pitch = picture->p[j].i_pitch;
+#ifdef SUPPORTS_PBO
+        /* Upload from the pixel buffer, asynchronously */
+        if (pbo) {
+            vgl->BindBuffer(GL_PIXEL_UNPACK_BUFFER, pbo->buffer[j]);
+            pixels = NULL;
+            pitch = pbo->plane[j].i_pitch;
+        }
+#endif
         Upload(vgl, picture->format.i_visible_width, vgl->fmt.i_visible_height,
                vgl->fmt.i_width, vgl->fmt.i_height,
                vgl->chroma->p[j].w.num, vgl->chroma->p[j].w.den, vgl->chroma->p[j].h.num, vgl->chroma->p[j].h.den,
-               picture->p[j].i_pitch, picture->p[j].i_pixel_pitch, 0, picture->p[j].p_pixels, vgl->tex_target, vgl->tex_format, vgl->tex_type);
+               pitch, picture->p[j].i_pixel_pitch, 0, pixels, vgl->tex_target, vgl->tex_format, vgl->tex_type);
     }
+#ifdef SUPPORTS_PBO
+    if (pbo) {
+        vgl->BindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+        pbo->fence = vgl->FenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    }
+#endif
 
     int         last_count = vgl->region_count;
     gl_region_t *last = vgl->region;
@@ -82,19 +82,24 @@ vlc_module_end()
  * Local prototypes
  *****************************************************************************/
 struct picture_sys_t {
+    /* must be first, see libvlc_video_frame_release() */
+    void (*release)(void *);
     vout_display_sys_t *sys;
     void *id;
+    atomic_uint refs; /* picture + frames held by the application */
 };
 
 /* NOTE: the callback prototypes must match those of LibVLC */
 struct vout_display_sys_t {
     picture_pool_t *pool;
     unsigned        count;
+    atomic_uint     refs;
 
     void *opaque;
     void *(*lock)(void *sys, void **plane);
     void (*unlock)(void *sys, void *id, void *const *plane);
     void (*display)(void *sys, void *id);
+    void (*frame)(void *sys, void *id, void *frame);
     void (*cleanup)(void *sys);
 
     unsigned pitches[PICTURE_PLANE_MAX];
@@ -137,6 +142,43 @@ static void Unlock(void *data, picture_t *pic)
 
 }
 
+static void Release(vout_display_sys_t *sys)
+{
+    if (atomic_fetch_sub(&sys->refs, 1) != 1)
+        return;
+
+    if (sys->cleanup)
+        sys->cleanup(sys->opaque);
+    free(sys);
+}
+
+/* In frame mode, the application may keep frames after the display is
+ * closed: the buffers are only cleaned up once the last one is released. */
+static void ReleaseFrame(void *data)
+{
+    picture_sys_t *picsys = data;
+    vout_display_sys_t *sys = picsys->sys;
+
+    if (atomic_fetch_sub(&picsys->refs, 1) != 1)
+        return;
+
+    free(picsys);
+    Release(sys);
+}
+
+static void Destroy(picture_t *pic)
+{
+    ReleaseFrame(pic->p_sys);
+    free(pic);
+}
+
+/* Buffers still held by the application are not handed out to decoders,
+ * nor by the pools reserved from the display pool (see picture_pool_Reserve) */
+static int PoolLock(picture_t *pic)
+{
+    return atomic_load(&pic->p_sys->refs) > 1 ? VLC_EGENERIC : VLC_SUCCESS;
+}
+
 /*****************************************************************************
  * Open: allocates video thread
  *****************************************************************************
@@ -160,9 +202,11 @@ static int Open(vlc_object_t *object)
     }
     sys->unlock = var_InheritAddress(vd, "vmem-unlock");
     sys->display = var_InheritAddress(vd, "vmem-display");
+    sys->frame = var_InheritAddress(vd, "vmem-frame");
     sys->cleanup = var_InheritAddress(vd, "vmem-cleanup");
     sys->opaque = var_InheritAddress(vd, "vmem-data");
     sys->pool = NULL;
+    atomic_init(&sys->refs, 1);
 
     /* Define the video format */
     video_format_t fmt;
@@ -264,12 +308,12 @@ static void Close(vlc_object_t *object)
     vout_display_t *vd = (vout_display_t *)object;
     vout_display_sys_t *sys = vd->sys;
 
-    if (sys->cleanup)
-        sys->cleanup(sys->opaque);
-
-    picture_pool_Enum(sys->pool, Unlock, sys);
-    picture_pool_Release(sys->pool);
-    free(sys);
+    if (sys->pool != NULL) {
+        if (sys->frame == NULL)
+            picture_pool_Enum(sys->pool, Unlock, sys);
+        picture_pool_Release(sys->pool);
+    }
+    Release(sys);
 }
 
 static picture_pool_t *Pool(vout_display_t *vd, unsigned count)
@@ -291,10 +335,15 @@ static picture_pool_t *Pool(vout_display_t *vd, unsigned count)
             count = i;
             break;
         }
+        picsys->release = ReleaseFrame;
         picsys->sys = sys;
         picsys->id = NULL;
+        atomic_init(&picsys->refs, 1);
 
-        picture_resource_t rsc = { .p_sys = picsys };
+        picture_resource_t rsc = {
+            .p_sys = picsys,
+            .pf_destroy = Destroy,
+        };
 
         for (unsigned i = 0; i < PICTURE_PLANE_MAX; i++) {
             /* vmem-lock is responsible for the allocation */
@@ -309,22 +358,32 @@ static picture_pool_t *Pool(vout_display_t *vd, unsigned count)
             count = i;
             break;
         }
+        atomic_fetch_add(&sys->refs, 1);
     }
 
     /* */
-    sys->pool = picture_pool_New(count, pictures);
+    picture_pool_configuration_t cfg = {
+        .picture_count = count,
+        .picture = pictures,
+        .lock = sys->frame != NULL ? PoolLock : NULL,
+    };
+
+    sys->pool = picture_pool_NewExtended(&cfg);
     if (!sys->pool) {
         for (unsigned i = 0; i < count; i++)
             picture_Release(pictures[i]);
+        return NULL;
     }
 
+    /* The buffers are locked once and for all in frame mode */
     picture_pool_Enum(sys->pool, Lock, sys);
     return sys->pool;
 }
 
 static void Prepare(vout_display_t *vd, picture_t *pic, subpicture_t *subpic)
 {
-    Unlock(vd->sys, pic);
+    if (vd->sys->frame == NULL)
+        Unlock(vd->sys, pic);
     VLC_UNUSED(subpic);
 }
 
@@ -333,6 +392,16 @@ static void Display(vout_display_t *vd, picture_t *pic, subpicture_t *subpic)
 {
     vout_display_sys_t *sys = vd->sys;
 
+    if (sys->frame != NULL) {
+        picture_sys_t *picsys = pic->p_sys;
+
+        atomic_fetch_add(&picsys->refs, 1);
+        sys->frame(sys->opaque, picsys->id, picsys);
+        picture_Release(pic);
+        VLC_UNUSED(subpic);
+        return;
+    }
+
     if (sys->display != NULL)
         sys->display(sys->opaque, pic->p_sys->id);
 
@@ -99,6 +99,7 @@ error:
     owner->sync.end = VLC_TS_INVALID;
     owner->sync.resamp_type = AOUT_RESAMPLING_NONE;
     owner->sync.discontinuity = true;
+    memset (&owner->sync.drift, 0, sizeof (owner->sync.drift));
     aout_OutputUnlock (p_aout);
 
     atomic_init (&owner->buffers_lost, 0);
@@ -254,6 +255,7 @@ static void aout_DecSynchronize (audio_output_t *aout, mtime_t dec_pts,
         else
             msg_Dbg (aout, "playback too late (%"PRId64"): "
                      "flushing buffers", drift);
+        input_histogram_Add (&owner->sync.drift, drift);
         aout_OutputFlush (aout, false);
 
         aout_StopResampling (aout);
@@ -274,6 +276,7 @@ static void aout_DecSynchronize (audio_output_t *aout, mtime_t dec_pts,
         if (!owner->sync.discontinuity)
             msg_Warn (aout, "playback way too early (%"PRId64"): "
                       "playing silence", drift);
+        input_histogram_Add (&owner->sync.drift, -drift);
         aout_DecSilence (aout, -drift, dec_pts);
 
         aout_StopResampling (aout);
@@ -289,6 +292,7 @@ static void aout_DecSynchronize (audio_output_t *aout, mtime_t dec_pts,
                   drift);
         owner->sync.resamp_type = AOUT_RESAMPLING_UP;
         owner->sync.resamp_start_drift = +drift;
+        input_histogram_Add (&owner->sync.drift, +drift);
     }
     if (drift < -AOUT_MAX_PTS_ADVANCE
      && owner->sync.resamp_type != AOUT_RESAMPLING_DOWN)
@@ -297,6 +301,7 @@ static void aout_DecSynchronize (audio_output_t *aout, mtime_t dec_pts,
                   drift);
         owner->sync.resamp_type = AOUT_RESAMPLING_DOWN;
         owner->sync.resamp_start_drift = -drift;
+        input_histogram_Add (&owner->sync.drift, -drift);
     }
 
     if (owner->sync.resamp_type == AOUT_RESAMPLING_NONE)
@@ -394,6 +399,20 @@ int aout_DecGetResetLost (audio_output_t *aout)
     return atomic_exchange(&owner->buffers_lost, 0);
 }
 
+/**
+ * Merges the drift of the synchronization corrections applied since the
+ * previous call into the given histogram.
+ */
+void aout_DecGetResetDrift (audio_output_t *aout, input_histogram_t *drift)
+{
+    aout_owner_t *owner = aout_owner (aout);
+
+    aout_OutputLock (aout);
+    input_histogram_Merge (drift, &owner->sync.drift);
+    memset (&owner->sync.drift, 0, sizeof (owner->sync.drift));
+    aout_OutputUnlock (aout);
+}
+
 void aout_DecChangePause (audio_output_t *aout, bool paused, mtime_t date)
 {
     aout_owner_t *owner = aout_owner (aout);
@@ -55,7 +55,7 @@
 
 static decoder_t *CreateDecoder( vlc_object_t *, input_thread_t *,
                                  const es_format_t *, bool, input_resource_t *,
-                                 sout_instance_t *p_sout );
+                                 sout_instance_t *p_sout, bool b_scrub );
 static void       DeleteDecoder( decoder_t * );
 
 static void      *DecoderThread( void * );
@@ -132,6 +132,10 @@ struct decoder_owner_sys_t
     /* Flushing */
     bool b_flushing;
 
+    /* Scrubbing */
+    bool b_scrub;
+    bool b_scrub_shown;
+
     /* CC */
     struct
     {
@@ -142,6 +146,11 @@ struct decoder_owner_sys_t
 
     /* Delay */
     mtime_t i_ts_delay;
+
+    /* Statistics: accumulated by the decoder thread, then merged into the
+     * input ones under the counters lock */
+    input_es_stats_t  stats;
+    input_es_stats_t *p_stats;
 };
 
 /* Pictures which are DECODER_BOGUS_VIDEO_DELAY or more in advance probably have
@@ -225,7 +234,7 @@ int decoder_GetDisplayRate( decoder_t *p_dec )
 static decoder_t *decoder_New( vlc_object_t *p_parent, input_thread_t *p_input,
                                const es_format_t *fmt, input_clock_t *p_clock,
                                input_resource_t *p_resource,
-                               sout_instance_t *p_sout  )
+                               sout_instance_t *p_sout, bool b_scrub )
 {
     decoder_t *p_dec = NULL;
     const char *psz_type = p_sout ? N_("packetizer") : N_("decoder");
@@ -233,7 +242,7 @@ static decoder_t *decoder_New( vlc_object_t *p_parent, input_thread_t *p_input,
 
     /* Create the decoder configuration structure */
     p_dec = CreateDecoder( p_parent, p_input, fmt,
-                           p_sout != NULL, p_resource, p_sout );
+                           p_sout != NULL, p_resource, p_sout, b_scrub );
     if( p_dec == NULL )
     {
         msg_Err( p_parent, "could not create %s", psz_type );
@@ -277,14 +286,15 @@ static decoder_t *decoder_New( vlc_object_t *p_parent, input_thread_t *p_input,
  *
  * \param p_input the input thread
  * \param p_es the es descriptor
+ * \param b_scrub whether the decoder is created for scrubbing
  * \return the spawned decoder object
  */
 decoder_t *input_DecoderNew( input_thread_t *p_input,
                              es_format_t *fmt, input_clock_t *p_clock,
-                             sout_instance_t *p_sout  )
+                             sout_instance_t *p_sout, bool b_scrub )
 {
     return decoder_New( VLC_OBJECT(p_input), p_input, fmt, p_clock,
-                        p_input->p->p_resource, p_sout );
+                        p_input->p->p_resource, p_sout, b_scrub );
 }
 
 /**
@@ -293,7 +303,7 @@ decoder_t *input_DecoderNew( input_thread_t *p_input,
 decoder_t *input_DecoderCreate( vlc_object_t *p_parent, const es_format_t *fmt,
                                 input_resource_t *p_resource )
 {
-    return decoder_New( p_parent, NULL, fmt, NULL, p_resource, NULL );
+    return decoder_New( p_parent, NULL, fmt, NULL, p_resource, NULL, false );
 }
 
 
@@ -423,7 +433,7 @@ int input_DecoderSetCcState( decoder_t *p_dec, bool b_decode, int i_channel )
 
         es_format_Init( &fmt, SPU_ES, fcc[i_channel] );
         p_cc = input_DecoderNew( p_owner->p_input, &fmt,
-                              p_dec->p_owner->p_clock, p_owner->p_sout );
+                              p_dec->p_owner->p_clock, p_owner->p_sout, false );
         if( !p_cc )
         {
             msg_Err( p_dec, "could not create decoder" );
@@ -703,7 +713,7 @@ static decoder_t * CreateDecoder( vlc_object_t *p_parent,
                                   input_thread_t *p_input,
                                   const es_format_t *fmt, bool b_packetizer,
                                   input_resource_t *p_resource,
-                                  sout_instance_t *p_sout )
+                                  sout_instance_t *p_sout, bool b_scrub )
 {
     decoder_t *p_dec;
     decoder_owner_sys_t *p_owner;
@@ -750,6 +760,16 @@ static decoder_t * CreateDecoder( vlc_object_t *p_parent,
     p_owner->b_packetizer = b_packetizer;
     es_format_Init( &p_owner->fmt, UNKNOWN_ES, 0 );
 
+    memset( &p_owner->stats, 0, sizeof( p_owner->stats ) );
+    p_owner->p_stats = NULL;
+    if( p_input != NULL && !b_packetizer && libvlc_stats( p_input )
+     && (fmt->i_cat == VIDEO_ES || fmt->i_cat == AUDIO_ES) )
+    {
+        vlc_mutex_lock( &p_input->p->counters.counters_lock );
+        p_owner->p_stats = stats_GetEsStats( p_input, fmt );
+        vlc_mutex_unlock( &p_input->p->counters.counters_lock );
+    }
+
     /* decoder fifo */
     p_owner->p_fifo = block_FifoNew();
     if( unlikely(p_owner->p_fifo == NULL) )
@@ -769,6 +789,9 @@ static decoder_t * CreateDecoder( vlc_object_t *p_parent,
     p_dec->pf_get_display_date = DecoderGetDisplayDate;
     p_dec->pf_get_display_rate = DecoderGetDisplayRate;
 
+    /* While scrubbing, only the key frames are shown */
+    p_dec->b_key_frames_only = b_scrub && !b_packetizer;
+
     /* Find a suitable decoder/packetizer module */
     if( !b_packetizer )
         p_dec->p_module = module_need( p_dec, "decoder", "$codec", false );
@@ -840,6 +863,9 @@ static decoder_t * CreateDecoder( vlc_object_t *p_parent,
 
     p_owner->b_flushing = false;
 
+    p_owner->b_scrub = b_scrub && !b_packetizer;
+    p_owner->b_scrub_shown = false;
+
     /* */
     p_owner->cc.b_supported = false;
     if( !b_packetizer )
@@ -874,6 +900,10 @@ static void *DecoderThread( void *p_data )
     {
         block_t *p_block = block_FifoGet( p_owner->p_fifo );
 
+        if( p_owner->p_stats != NULL )
+            input_histogram_Add( &p_owner->stats.fifo_depth,
+                                 block_FifoCount( p_owner->p_fifo ) );
+
         /* Make sure there is no cancellation point other than this one^^.
          * If you need one, be sure to push cleanup of p_block. */
         bool end_wait = !p_block || p_block->i_flags & BLOCK_FLAG_CORE_EOS;
@@ -1095,6 +1125,24 @@ static void DecoderWaitDate( decoder_t *p_dec,
                                i_deadline ) == 0 );
 }
 
+/**
+ * Merges the statistics accumulated by the decoder thread into the input
+ * ones. It must be called with the input counters lock held.
+ */
+static void DecoderUpdateStatsLocked( decoder_owner_sys_t *p_owner )
+{
+    input_es_stats_t *p_stats = p_owner->p_stats;
+
+    if( p_stats == NULL )
+        return;
+
+    input_histogram_Merge( &p_stats->decode_time, &p_owner->stats.decode_time );
+    input_histogram_Merge( &p_stats->fifo_depth, &p_owner->stats.fifo_depth );
+    input_histogram_Merge( &p_stats->picture_age, &p_owner->stats.picture_age );
+    input_histogram_Merge( &p_stats->audio_drift, &p_owner->stats.audio_drift );
+    memset( &p_owner->stats, 0, sizeof( p_owner->stats ) );
+}
+
 static void DecoderPlayAudio( decoder_t *p_dec, block_t *p_audio,
                               int *pi_played_sum, int *pi_lost_sum )
 {
@@ -1155,6 +1203,8 @@ static void DecoderPlayAudio( decoder_t *p_dec, block_t *p_audio,
             if( !aout_DecPlay( p_aout, p_audio, i_rate ) )
                 *pi_played_sum += 1;
             *pi_lost_sum += aout_DecGetResetLost( p_aout );
+            if( p_owner->p_stats != NULL )
+                aout_DecGetResetDrift( p_aout, &p_owner->stats.audio_drift );
         }
         else
         {
@@ -1175,13 +1225,20 @@ static void DecoderDecodeAudio( decoder_t *p_dec, block_t *p_block )
     int i_decoded = 0;
     int i_lost = 0;
     int i_played = 0;
+    mtime_t i_decode_time = 0;
 
     if (!p_block) {
         /* Play a NULL block to output buffered frames */
         DecoderPlayAudio( p_dec, NULL, &i_played, &i_lost );
     }
-    else while( (p_aout_buf = p_dec->pf_decode_audio( p_dec, &p_block )) )
+    else for( ;; )
     {
+        mtime_t i_start = mdate();
+        p_aout_buf = p_dec->pf_decode_audio( p_dec, &p_block );
+        i_decode_time += mdate() - i_start;
+        if( p_aout_buf == NULL )
+            break;
+
         if( DecoderIsExitRequested( p_dec ) )
         {
             /* It prevent freezing VLC in case of broken decoder */
@@ -1214,12 +1271,16 @@ static void DecoderDecodeAudio( decoder_t *p_dec, block_t *p_block )
     /* Update ugly stat */
     input_thread_t  *p_input = p_owner->p_input;
 
+    if( p_owner->p_stats != NULL && i_decode_time > 0 )
+        input_histogram_Add( &p_owner->stats.decode_time, i_decode_time );
+
     if( p_input != NULL && (i_decoded > 0 || i_lost > 0 || i_played > 0) )
     {
         vlc_mutex_lock( &p_input->p->counters.counters_lock);
         stats_Update( p_input->p->counters.p_lost_abuffers, i_lost, NULL );
         stats_Update( p_input->p->counters.p_played_abuffers, i_played, NULL );
         stats_Update( p_input->p->counters.p_decoded_audio, i_decoded, NULL );
+        DecoderUpdateStatsLocked( p_owner );
         vlc_mutex_unlock( &p_input->p->counters.counters_lock);
     }
 }
@@ -1306,8 +1367,22 @@ static void DecoderPlayVideo( decoder_t *p_dec, picture_t *p_picture,
     DecoderFixTs( p_dec, &p_picture->date, NULL, NULL,
                   &i_rate, DECODER_BOGUS_VIDEO_DELAY );
 
+    /* While scrubbing, only the picture at the seek target is shown */
+    bool b_scrubbed = p_owner->b_scrub && p_owner->b_scrub_shown;
+    if( p_owner->b_scrub && !b_reject )
+    {
+        p_owner->b_scrub_shown = true;
+        p_picture->b_force = true;
+    }
+
     vlc_mutex_unlock( &p_owner->lock );
 
+    if( b_scrubbed )
+    {
+        picture_Release( p_picture );
+        return;
+    }
+
     /* */
     if( !p_picture->b_force && p_picture->date <= VLC_TS_INVALID ) // FIXME --VLC_TS_INVALID verify video_output/*
         b_reject = true;
@@ -1334,7 +1409,9 @@ static void DecoderPlayVideo( decoder_t *p_dec, picture_t *p_picture,
     }
     int i_tmp_display;
     int i_tmp_lost;
-    vout_GetResetStatistic( p_vout, &i_tmp_display, &i_tmp_lost );
+    vout_GetResetStatistic( p_vout, &i_tmp_display, &i_tmp_lost,
+                            p_owner->p_stats != NULL
+                                ? &p_owner->stats.picture_age : NULL );
 
     *pi_played_sum += i_tmp_display;
     *pi_lost_sum += i_tmp_lost;
@@ -1347,9 +1424,16 @@ static void DecoderDecodeVideo( decoder_t *p_dec, block_t *p_block )
     int i_lost = 0;
     int i_decoded = 0;
     int i_displayed = 0;
+    mtime_t i_decode_time = 0;
 
-    while( (p_pic = p_dec->pf_decode_video( p_dec, &p_block )) )
+    for( ;; )
     {
+        mtime_t i_start = mdate();
+        p_pic = p_dec->pf_decode_video( p_dec, &p_block );
+        i_decode_time += mdate() - i_start;
+        if( p_pic == NULL )
+            break;
+
         vout_thread_t  *p_vout = p_owner->p_vout;
         if( DecoderIsExitRequested( p_dec ) )
         {
@@ -1387,6 +1471,9 @@ static void DecoderDecodeVideo( decoder_t *p_dec, block_t *p_block )
     /* Update ugly stat */
     input_thread_t *p_input = p_owner->p_input;
 
+    if( p_owner->p_stats != NULL && i_decode_time > 0 )
+        input_histogram_Add( &p_owner->stats.decode_time, i_decode_time );
+
     if( p_input != NULL && (i_decoded > 0 || i_lost > 0 || i_displayed > 0) )
     {
         vlc_mutex_lock( &p_input->p->counters.counters_lock );
@@ -1394,6 +1481,7 @@ static void DecoderDecodeVideo( decoder_t *p_dec, block_t *p_block )
         stats_Update( p_input->p->counters.p_lost_pictures, i_lost , NULL);
         stats_Update( p_input->p->counters.p_displayed_pictures,
                       i_displayed, NULL);
+        DecoderUpdateStatsLocked( p_owner );
         vlc_mutex_unlock( &p_input->p->counters.counters_lock );
     }
 }
@@ -1716,6 +1804,7 @@ static void DecoderProcessOnFlush( decoder_t *p_dec )
         p_owner->b_flushing = false;
         vlc_cond_signal( &p_owner->wait_acknowledge );
     }
+    p_owner->b_scrub_shown = false;
     vlc_mutex_unlock( &p_owner->lock );
 }
 
@@ -1811,6 +1900,13 @@ static void DeleteDecoder( decoder_t * p_dec )
     block_FifoEmpty( p_owner->p_fifo );
     block_FifoRelease( p_owner->p_fifo );
 
+    if( p_owner->p_stats != NULL )
+    {
+        vlc_mutex_lock( &p_owner->p_input->p->counters.counters_lock );
+        DecoderUpdateStatsLocked( p_owner );
+        vlc_mutex_unlock( &p_owner->p_input->p->counters.counters_lock );
+    }
+
     /* Cleanup */
     if( p_owner->p_aout )
     {
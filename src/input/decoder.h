@@ -31,8 +31,13 @@
 #define BLOCK_FLAG_CORE_FLUSH (1 <<BLOCK_FLAG_CORE_PRIVATE_SHIFT)
 #define BLOCK_FLAG_CORE_EOS   (1 <<(BLOCK_FLAG_CORE_PRIVATE_SHIFT + 1))
 
+/**
+ * This function creates a decoder. When scrubbing, the decoder is asked to
+ * only decode the key frames, and only the first picture after each flush is
+ * displayed, so that only the last seek target is rendered.
+ */
 decoder_t *input_DecoderNew( input_thread_t *, es_format_t *, input_clock_t *,
-                             sout_instance_t * ) VLC_USED;
+                             sout_instance_t *, bool b_scrub ) VLC_USED;
 
 /**
  * This function changes the pause state.
@@ -179,9 +179,28 @@ demux_t *demux_New( vlc_object_t *p_obj, input_thread_t *p_parent_input,
           ;
         SkipAPETag( p_demux );
 
+        /* Try the demux that accepted the same media before, if any, then
+         * fall back to the usual probing */
+        demux_cache_t *p_cache = libvlc_priv( p_obj->p_libvlc )->demux_cache;
+        char psz_cached[DEMUX_CACHE_NAME_MAX];
+        uint64_t i_sig = 0;
+        bool b_cached = false;
+
+        if( p_cache != NULL && !strcmp( psz_module, "any" ) )
+        {
+            i_sig = demux_cache_Signature( p_demux );
+            b_cached = !demux_cache_Lookup( p_cache, i_sig, psz_cached );
+            if( b_cached && !b_quick )
+                msg_Dbg( p_obj, "trying cached demux '%s'", psz_cached );
+        }
+
         p_demux->p_module =
-            module_need( p_demux, "demux", psz_module,
-                         !strcmp( psz_module, p_demux->psz_demux ) );
+            module_need( p_demux, "demux", b_cached ? psz_cached : psz_module,
+                         !b_cached && !strcmp( psz_module, p_demux->psz_demux ) );
+
+        if( i_sig != 0 && p_demux->p_module != NULL )
+            demux_cache_Store( p_cache, i_sig,
+                               module_get_object( p_demux->p_module ) );
     }
     else
     {
@@ -36,6 +36,18 @@ demux_t *demux_New( vlc_object_t *p_obj, input_thread_t *p_parent_input, const c
 
 void demux_Delete( demux_t * );
 
+/* Demux probing results cache, NULL if disabled */
+typedef struct demux_cache_t demux_cache_t;
+
+#define DEMUX_CACHE_NAME_MAX 32
+
+demux_cache_t *demux_cache_New( vlc_object_t * );
+void demux_cache_Delete( demux_cache_t * );
+uint64_t demux_cache_Signature( demux_t * );
+int demux_cache_Lookup( demux_cache_t *, uint64_t,
+                        char psz_module[DEMUX_CACHE_NAME_MAX] );
+void demux_cache_Store( demux_cache_t *, uint64_t, const char * );
+
 static inline int demux_Demux( demux_t *p_demux )
 {
     if( !p_demux->pf_demux )
@@ -0,0 +1,260 @@
+/*****************************************************************************
+ * demux_cache.c: persistent cache of the demux probing results
+ *****************************************************************************
+ * Copyright (C) 2015 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <errno.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <vlc_common.h>
+#include <vlc_fs.h>
+#include "demux.h"
+#include "../playlist/art.h"
+
+/*
+ * The cache maps a signature of the media (URI, size, modification date
+ * and hash of the first bytes) to the name of the demux that accepted it.
+ * It is a direct mapped table: colliding entries replace each other.
+ * It is loaded when LibVLC starts, and saved when it exits, merged with
+ * the entries saved by other processes in the mean time.
+ */
+#define DEMUX_CACHE_MAGIC   "VLCDMX01"
+#define DEMUX_CACHE_ENTRIES 4096
+#define DEMUX_CACHE_PEEK    2048
+
+typedef struct
+{
+    uint64_t i_sig;   /* 0 if unused */
+    char     psz_module[DEMUX_CACHE_NAME_MAX];
+} demux_cache_entry_t;
+
+struct demux_cache_t
+{
+    vlc_object_t *obj;
+    char         *psz_file;
+    vlc_mutex_t   lock;
+    bool          b_dirty;
+    demux_cache_entry_t entries[DEMUX_CACHE_ENTRIES];
+};
+
+/* FNV-1a */
+static uint64_t HashBytes( uint64_t i_hash, const void *p_data, size_t i_size )
+{
+    const uint8_t *p = p_data;
+
+    for( size_t i = 0; i < i_size; i++ )
+    {
+        i_hash ^= p[i];
+        i_hash *= UINT64_C(1099511628211);
+    }
+    return i_hash;
+}
+
+/* Fills the free entries of the table from the cache file */
+static void Load( demux_cache_t *p_cache )
+{
+    FILE *f = vlc_fopen( p_cache->psz_file, "rb" );
+    if( f == NULL )
+        return;
+
+    char magic[sizeof(DEMUX_CACHE_MAGIC) - 1];
+    demux_cache_entry_t entry;
+
+    if( fread( magic, sizeof(magic), 1, f ) != 1
+     || memcmp( magic, DEMUX_CACHE_MAGIC, sizeof(magic) ) )
+    {
+        msg_Warn( p_cache->obj, "ignoring invalid demux cache %s",
+                  p_cache->psz_file );
+        fclose( f );
+        return;
+    }
+
+    while( fread( &entry, sizeof(entry), 1, f ) == 1 )
+    {
+        demux_cache_entry_t *p_entry =
+            &p_cache->entries[entry.i_sig % DEMUX_CACHE_ENTRIES];
+
+        entry.psz_module[DEMUX_CACHE_NAME_MAX - 1] = '\0';
+        if( entry.i_sig != 0 && p_entry->i_sig == 0 )
+            *p_entry = entry;
+    }
+    fclose( f );
+}
+
+static int Save( demux_cache_t *p_cache )
+{
+    char *psz_tmp;
+    if( asprintf( &psz_tmp, "%s.XXXXXX", p_cache->psz_file ) == -1 )
+        return -1;
+
+    int fd = vlc_mkstemp( psz_tmp );
+    if( fd == -1 )
+    {
+        free( psz_tmp );
+        return -1;
+    }
+
+    FILE *f = fdopen( fd, "wb" );
+    if( f == NULL )
+    {
+        close( fd );
+        goto error;
+    }
+
+    bool b_ok = fwrite( DEMUX_CACHE_MAGIC, sizeof(DEMUX_CACHE_MAGIC) - 1,
+                        1, f ) == 1;
+    for( unsigned i = 0; i < DEMUX_CACHE_ENTRIES && b_ok; i++ )
+        if( p_cache->entries[i].i_sig != 0 )
+            b_ok = fwrite( &p_cache->entries[i],
+                           sizeof(p_cache->entries[i]), 1, f ) == 1;
+    if( fclose( f ) )
+        b_ok = false;
+    if( !b_ok || vlc_rename( psz_tmp, p_cache->psz_file ) )
+        goto error;
+
+    free( psz_tmp );
+    return 0;
+
+error:
+    {
+        int i_errno = errno;
+        vlc_unlink( psz_tmp );
+        errno = i_errno;
+    }
+    free( psz_tmp );
+    return -1;
+}
+
+demux_cache_t *demux_cache_New( vlc_object_t *obj )
+{
+    if( !var_InheritBool( obj, "demux-cache" ) )
+        return NULL;
+
+    char *psz_dir = playlist_GetCacheDir( obj );
+    if( psz_dir == NULL )
+        return NULL;
+
+    demux_cache_t *p_cache = calloc( 1, sizeof(*p_cache) );
+    if( unlikely(p_cache == NULL) )
+    {
+        free( psz_dir );
+        return NULL;
+    }
+
+    vlc_mkdir( psz_dir, 0700 );
+    if( asprintf( &p_cache->psz_file, "%s" DIR_SEP "demux.dat",
+                  psz_dir ) == -1 )
+    {
+        free( psz_dir );
+        free( p_cache );
+        return NULL;
+    }
+    free( psz_dir );
+
+    p_cache->obj = obj;
+    vlc_mutex_init( &p_cache->lock );
+    Load( p_cache );
+    msg_Dbg( obj, "using demux cache %s", p_cache->psz_file );
+    return p_cache;
+}
+
+void demux_cache_Delete( demux_cache_t *p_cache )
+{
+    if( p_cache->b_dirty )
+    {
+        /* Keep what other processes found in the mean time */
+        Load( p_cache );
+        if( Save( p_cache ) )
+            msg_Warn( p_cache->obj, "cannot save demux cache %s: %s",
+                      p_cache->psz_file, vlc_strerror_c(errno) );
+    }
+    vlc_mutex_destroy( &p_cache->lock );
+    free( p_cache->psz_file );
+    free( p_cache );
+}
+
+uint64_t demux_cache_Signature( demux_t *p_demux )
+{
+    uint64_t i_sig = UINT64_C(14695981039346656037);
+
+    i_sig = HashBytes( i_sig, p_demux->psz_access,
+                       strlen( p_demux->psz_access ) + 1 );
+    i_sig = HashBytes( i_sig, p_demux->psz_location,
+                       strlen( p_demux->psz_location ) + 1 );
+
+    uint64_t i_size = stream_Size( p_demux->s );
+    i_sig = HashBytes( i_sig, &i_size, sizeof(i_size) );
+
+    /* The size and the first bytes may not change when a file is edited */
+    struct stat st;
+    if( p_demux->psz_file != NULL && !vlc_stat( p_demux->psz_file, &st ) )
+    {
+        int64_t i_mtime = st.st_mtime;
+        i_sig = HashBytes( i_sig, &i_mtime, sizeof(i_mtime) );
+    }
+
+    /* Demuxers peek at least as much while probing, so this is cheap */
+    const uint8_t *p_peek;
+    int i_peek = stream_Peek( p_demux->s, &p_peek, DEMUX_CACHE_PEEK );
+    if( i_peek > 0 )
+        i_sig = HashBytes( i_sig, p_peek, i_peek );
+
+    return i_sig ? i_sig : 1;
+}
+
+int demux_cache_Lookup( demux_cache_t *p_cache, uint64_t i_sig,
+                        char psz_module[DEMUX_CACHE_NAME_MAX] )
+{
+    const demux_cache_entry_t *p_entry =
+        &p_cache->entries[i_sig % DEMUX_CACHE_ENTRIES];
+    int i_ret = VLC_EGENERIC;
+
+    vlc_mutex_lock( &p_cache->lock );
+    if( p_entry->i_sig == i_sig )
+    {
+        strcpy( psz_module, p_entry->psz_module );
+        i_ret = VLC_SUCCESS;
+    }
+    vlc_mutex_unlock( &p_cache->lock );
+    return i_ret;
+}
+
+void demux_cache_Store( demux_cache_t *p_cache, uint64_t i_sig,
+                        const char *psz_module )
+{
+    demux_cache_entry_t *p_entry =
+        &p_cache->entries[i_sig % DEMUX_CACHE_ENTRIES];
+
+    if( strlen( psz_module ) >= DEMUX_CACHE_NAME_MAX )
+        return;
+
+    vlc_mutex_lock( &p_cache->lock );
+    if( p_entry->i_sig != i_sig || strcmp( p_entry->psz_module, psz_module ) )
+    {
+        p_entry->i_sig = i_sig;
+        memset( p_entry->psz_module, 0, DEMUX_CACHE_NAME_MAX );
+        strcpy( p_entry->psz_module, psz_module );
+        p_cache->b_dirty = true;
+    }
+    vlc_mutex_unlock( &p_cache->lock );
+}
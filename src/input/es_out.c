@@ -168,6 +168,9 @@ struct es_out_sys_t
 
     /* Record */
     sout_instance_t *p_sout_record;
+
+    /* Scrubbing */
+    bool        b_scrub;
 };
 
 static es_out_id_t *EsOutAdd    ( es_out_t *, const es_format_t * );
@@ -294,6 +297,7 @@ es_out_t *input_EsOutNew( input_thread_t *p_input, int i_rate )
 
     p_sys->b_buffering = true;
     p_sys->i_preroll_end = -1;
+    p_sys->b_scrub = false;
 
     return out;
 }
@@ -489,7 +493,7 @@ static int EsOutSetRecord(  es_out_t *out, bool b_record )
             if( !p_es->p_dec || p_es->p_master )
                 continue;
 
-            p_es->p_dec_record = input_DecoderNew( p_input, &p_es->fmt, p_es->p_pgrm->p_clock, p_sys->p_sout_record );
+            p_es->p_dec_record = input_DecoderNew( p_input, &p_es->fmt, p_es->p_pgrm->p_clock, p_sys->p_sout_record, false );
             if( p_es->p_dec_record && p_sys->b_buffering )
                 input_DecoderStartWait( p_es->p_dec_record );
         }
@@ -1540,7 +1544,8 @@ static void EsCreateDecoder( es_out_t *out, es_out_id_t *p_es )
     es_out_sys_t   *p_sys = out->p_sys;
     input_thread_t *p_input = p_sys->p_input;
 
-    p_es->p_dec = input_DecoderNew( p_input, &p_es->fmt, p_es->p_pgrm->p_clock, p_input->p->p_sout );
+    p_es->p_dec = input_DecoderNew( p_input, &p_es->fmt, p_es->p_pgrm->p_clock, p_input->p->p_sout,
+                                    p_sys->b_scrub && p_es->fmt.i_cat == VIDEO_ES );
     if( p_es->p_dec )
     {
         if( p_sys->b_buffering )
@@ -1548,7 +1553,7 @@ static void EsCreateDecoder( es_out_t *out, es_out_id_t *p_es )
 
         if( !p_es->p_master && p_sys->p_sout_record )
         {
-            p_es->p_dec_record = input_DecoderNew( p_input, &p_es->fmt, p_es->p_pgrm->p_clock, p_sys->p_sout_record );
+            p_es->p_dec_record = input_DecoderNew( p_input, &p_es->fmt, p_es->p_pgrm->p_clock, p_sys->p_sout_record, false );
             if( p_es->p_dec_record && p_sys->b_buffering )
                 input_DecoderStartWait( p_es->p_dec_record );
         }
@@ -1572,6 +1577,26 @@ static void EsDestroyDecoder( es_out_t *out, es_out_id_t *p_es )
         p_es->p_dec_record = NULL;
     }
 }
+/* While scrubbing, video decoders are asked to only decode key frames, at
+ * reduced quality. */
+static void EsOutSetScrub( es_out_t *out, bool b_scrub )
+{
+    es_out_sys_t   *p_sys = out->p_sys;
+
+    p_sys->b_scrub = b_scrub;
+
+    /* The decoders only read the hint when they are opened */
+    for( int i = 0; i < p_sys->i_es; i++ )
+    {
+        es_out_id_t *es = p_sys->es[i];
+
+        if( es->fmt.i_cat == VIDEO_ES && es->p_dec != NULL )
+        {
+            EsDestroyDecoder( out, es );
+            EsCreateDecoder( out, es );
+        }
+    }
+}
 
 static void EsSelect( es_out_t *out, es_out_id_t *es )
 {
@@ -2476,6 +2501,15 @@ static int EsOutControlLocked( es_out_t *out, int i_query, va_list args )
         return VLC_SUCCESS;
     }
 
+    case ES_OUT_SET_SCRUB:
+    {
+        const bool b_scrub = (bool)va_arg( args, int );
+
+        if( p_sys->b_scrub != b_scrub )
+            EsOutSetScrub( out, b_scrub );
+        return VLC_SUCCESS;
+    }
+
     case ES_OUT_SET_ES_BY_ID:
     case ES_OUT_RESTART_ES_BY_ID:
     case ES_OUT_SET_ES_DEFAULT_BY_ID:
@@ -82,6 +82,9 @@ enum es_out_query_private_e
 
     /* Set End Of Stream */
     ES_OUT_SET_EOS,                                 /* res=cannot fail */
+
+    /* Set scrubbing mode (key frames only, at reduced quality) */
+    ES_OUT_SET_SCRUB,                               /* arg1=bool                res=cannot fail */
 };
 
 static inline void es_out_SetMode( es_out_t *p_out, int i_mode )
@@ -138,6 +141,11 @@ static inline int es_out_SetFrameNext( es_out_t *p_out )
 {
     return es_out_Control( p_out, ES_OUT_SET_FRAME_NEXT );
 }
+static inline void es_out_SetScrub( es_out_t *p_out, bool b_scrub )
+{
+    int i_ret = es_out_Control( p_out, ES_OUT_SET_SCRUB, b_scrub );
+    assert( !i_ret );
+}
 static inline void es_out_SetTimes( es_out_t *p_out, double f_position, mtime_t i_time, mtime_t i_length )
 {
     int i_ret = es_out_Control( p_out, ES_OUT_SET_TIMES, f_position, i_time, i_length );
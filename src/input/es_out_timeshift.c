@@ -696,6 +696,11 @@ static int ControlLocked( es_out_t *p_out, int i_query, va_list args )
         int *pi_group = va_arg( args, int * );
         return es_out_Control( p_sys->p_out, ES_OUT_GET_GROUP_FORCED, pi_group );
     }
+    case ES_OUT_SET_SCRUB:
+    {
+        const bool b_scrub = (bool)va_arg( args, int );
+        return es_out_Control( p_sys->p_out, ES_OUT_SET_SCRUB, b_scrub );
+    }
 
 
     default:
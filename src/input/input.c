@@ -108,6 +108,15 @@ enum {
 
 static void input_SubtitleAdd( input_thread_t *, const char *, unsigned );
 static void input_SubtitleFileAdd( input_thread_t *, char *, unsigned );
+static char *SubtitleFilePath( const char * );
+static char **GetSlaves( input_thread_t * );
+static void PrefetchStart( input_thread_t *, char ** );
+static int  PrefetchTake( input_thread_t *, const char *, const char *,
+                          stream_t **, char ** );
+static void PrefetchClean( input_thread_t * );
+static stream_t *InputStreamNew( input_thread_t *, bool, const char *,
+                                 const char *, const char *, const char *,
+                                 bool, char ** );
 static void input_ChangeState( input_thread_t *p_input, int i_state ); /* TODO fix name */
 
 #undef input_Create
@@ -175,23 +184,55 @@ int input_Read( vlc_object_t *p_parent, input_item_t *p_item )
     return VLC_SUCCESS;
 }
 
+struct preparse_timeout
+{
+    input_thread_t *p_input;
+    bool            b_expired; /* read after the timer is destroyed */
+};
+
+static void PreparseTimeout( void *data )
+{
+    struct preparse_timeout *p_timeout = data;
+    input_thread_t *p_input = p_timeout->p_input;
+
+    msg_Warn( p_input, "preparsing timed out" );
+    p_timeout->b_expired = true;
+    ObjectKillChildrens( VLC_OBJECT(p_input) );
+}
+
 /**
  * Initialize an input and initialize it to preparse the item
  * This function is blocking. It will only accept parsing regular files.
  *
  * \param p_parent a vlc_object_t
  * \param p_item an input item
- * \return VLC_SUCCESS or an error
+ * \param i_timeout maximum preparsing duration, or 0 for no limit
+ * \return VLC_SUCCESS, VLC_ETIMEOUT if the preparsing was interrupted, or
+ * another error
  */
-int input_Preparse( vlc_object_t *p_parent, input_item_t *p_item )
+int input_Preparse( vlc_object_t *p_parent, input_item_t *p_item,
+                    mtime_t i_timeout )
 {
     input_thread_t *p_input;
+    vlc_timer_t timer;
+    bool b_timer = false;
 
     /* Allocate descriptor */
     p_input = Create( p_parent, p_item, NULL, true, NULL );
     if( !p_input )
         return VLC_EGENERIC;
 
+    /* Kill the input (and its access and demux) once the deadline expires,
+     * so that a stalled network share cannot block the preparser forever. */
+    struct preparse_timeout timeout = { .p_input = p_input,
+                                        .b_expired = false };
+    if( i_timeout > 0 && !vlc_timer_create( &timer, PreparseTimeout, &timeout ) )
+    {
+        vlc_timer_schedule( timer, false, i_timeout, 0 );
+        b_timer = true;
+    }
+
+    int i_ret = VLC_EGENERIC;
     if( !Init( p_input ) ) {
         /* if the demux is a playlist, call Mainloop that will call
          * demux_Demux in order to fetch sub items */
@@ -204,11 +245,18 @@ int input_Preparse( vlc_object_t *p_parent, input_item_t *p_item )
         if( b_is_playlist )
             MainLoop( p_input, false );
         End( p_input );
+        i_ret = VLC_SUCCESS;
     }
 
+    if( b_timer )
+    {
+        vlc_timer_destroy( timer );
+        if( timeout.b_expired )
+            i_ret = VLC_ETIMEOUT;
+    }
     vlc_object_release( p_input );
 
-    return VLC_SUCCESS;
+    return i_ret;
 }
 
 /**
@@ -339,6 +387,7 @@ static input_thread_t *Create( vlc_object_t *p_parent, input_item_t *p_item,
     p_input->p->i_state = INIT_S;
     p_input->p->i_rate = INPUT_RATE_DEFAULT;
     p_input->p->b_recording = false;
+    p_input->p->b_scrub = false;
     memset( &p_input->p->bookmark, 0, sizeof(p_input->p->bookmark) );
     TAB_INIT( p_input->p->i_bookmark, p_input->p->pp_bookmark );
     TAB_INIT( p_input->p->i_attachment, p_input->p->attachment );
@@ -493,6 +542,7 @@ static void Destructor( input_thread_t * p_input )
 
     vlc_gc_decref( p_input->p->p_item );
 
+    stats_CleanEsStats( p_input );
     vlc_mutex_destroy( &p_input->p->counters.counters_lock );
 
     for( int i = 0; i < p_input->p->i_control; i++ )
@@ -738,7 +788,8 @@ static void MainLoop( input_thread_t *p_input, bool b_interactive )
             /* Postpone seeking until ES buffering is complete or at most
              * 125 ms. */
             bool b_postpone = es_out_GetBuffering( p_input->p->p_es_out )
-                            && !p_input->p->input.b_eof;
+                            && !p_input->p->input.b_eof
+                            && !p_input->p->b_scrub;
             if( b_postpone )
             {
                 mtime_t now = mdate();
@@ -919,7 +970,20 @@ static void StartTitle( input_thread_t * p_input )
     p_input->p->b_fast_seek = var_GetBool( p_input, "input-fast-seek" );
 }
 
-static void LoadSubtitles( input_thread_t *p_input )
+/* Returns the NULL-terminated list of the autodetected subtitle files */
+static char **DetectSubtitles( input_thread_t *p_input )
+{
+    if( !var_GetBool( p_input, "sub-autodetect-file" ) )
+        return NULL;
+
+    char *psz_autopath = var_GetNonEmptyString( p_input, "sub-autodetect-path" );
+    char **ppsz_subs = subtitles_Detect( p_input, psz_autopath,
+                                         p_input->p->p_item->psz_uri );
+    free( psz_autopath );
+    return ppsz_subs;
+}
+
+static void LoadSubtitles( input_thread_t *p_input, char **ppsz_subs )
 {
     /* Load subtitles */
     /* Get fps and set it if not already set */
@@ -953,26 +1017,18 @@ static void LoadSubtitles( input_thread_t *p_input )
         i_flags = SUB_NOFLAG;
     }
 
-    if( var_GetBool( p_input, "sub-autodetect-file" ) )
+    for( int i = 0; ppsz_subs && ppsz_subs[i]; i++ )
     {
-        char *psz_autopath = var_GetNonEmptyString( p_input, "sub-autodetect-path" );
-        char **ppsz_subs = subtitles_Detect( p_input, psz_autopath,
-                                             p_input->p->p_item->psz_uri );
-        free( psz_autopath );
-
-        for( int i = 0; ppsz_subs && ppsz_subs[i]; i++ )
+        if( !psz_subtitle || strcmp( psz_subtitle, ppsz_subs[i] ) )
         {
-            if( !psz_subtitle || strcmp( psz_subtitle, ppsz_subs[i] ) )
-            {
-                i_flags |= SUB_CANFAIL;
-                input_SubtitleFileAdd( p_input, ppsz_subs[i], i_flags );
-                i_flags = SUB_NOFLAG;
-            }
-
-            free( ppsz_subs[i] );
+            i_flags |= SUB_CANFAIL;
+            input_SubtitleFileAdd( p_input, ppsz_subs[i], i_flags );
+            i_flags = SUB_NOFLAG;
         }
-        free( ppsz_subs );
+
+        free( ppsz_subs[i] );
     }
+    free( ppsz_subs );
     free( psz_subtitle );
 
     /* Load subtitles from attachments */
@@ -1015,12 +1071,15 @@ static void LoadSubtitles( input_thread_t *p_input )
         var_Destroy( p_input, "sub-description" );
 }
 
-static void LoadSlaves( input_thread_t *p_input )
+/* Returns the NULL-terminated list of the "input-slave" URIs */
+static char **GetSlaves( input_thread_t *p_input )
 {
     char *psz = var_GetNonEmptyString( p_input, "input-slave" );
     if( !psz )
-        return;
+        return NULL;
 
+    int i_slaves = 0;
+    char **ppsz_slaves = NULL;
     char *psz_org = psz;
     while( psz && *psz )
     {
@@ -1039,6 +1098,22 @@ static void LoadSlaves( input_thread_t *p_input )
         psz = psz_delim;
         if( uri == NULL )
             continue;
+        TAB_APPEND( i_slaves, ppsz_slaves, uri );
+    }
+    free( psz_org );
+
+    if( i_slaves > 0 )
+        TAB_APPEND( i_slaves, ppsz_slaves, NULL );
+    return ppsz_slaves;
+}
+
+static void LoadSlaves( input_thread_t *p_input )
+{
+    char **ppsz_slaves = GetSlaves( p_input );
+
+    for( int i = 0; ppsz_slaves && ppsz_slaves[i]; i++ )
+    {
+        const char *uri = ppsz_slaves[i];
         msg_Dbg( p_input, "adding slave input '%s'", uri );
 
         input_source_t *p_slave = InputSourceNew( p_input );
@@ -1046,9 +1121,9 @@ static void LoadSlaves( input_thread_t *p_input )
             TAB_APPEND( p_input->p->i_slave, p_input->p->slave, p_slave );
         else
             free( p_slave );
-        free( uri );
+        free( ppsz_slaves[i] );
     }
-    free( psz_org );
+    free( ppsz_slaves );
 }
 
 static void UpdatePtsDelay( input_thread_t *p_input )
@@ -1139,6 +1214,8 @@ static void InitPrograms( input_thread_t * p_input )
 
 static int Init( input_thread_t * p_input )
 {
+    char **ppsz_subs = NULL;
+
     for( int i = 0; i < p_input->p->p_item->i_options; i++ )
     {
         if( !strncmp( p_input->p->p_item->ppsz_options[i], "meta-file", 9 ) )
@@ -1166,6 +1243,13 @@ static int Init( input_thread_t * p_input )
     input_ChangeState( p_input, OPENING_S );
     input_SendEventCache( p_input, 0.0 );
 
+    /* Open the slave sources while the master source opens */
+    if( !p_input->b_preparsing )
+    {
+        ppsz_subs = DetectSubtitles( p_input );
+        PrefetchStart( p_input, ppsz_subs );
+    }
+
     /* */
     if( InputSourceInit( p_input, &p_input->p->input,
                          p_input->p->p_item->psz_uri, NULL, false ) )
@@ -1190,8 +1274,10 @@ static int Init( input_thread_t * p_input )
     if( !p_input->b_preparsing )
     {
         StartTitle( p_input );
-        LoadSubtitles( p_input );
+        LoadSubtitles( p_input, ppsz_subs );
+        ppsz_subs = NULL;
         LoadSlaves( p_input );
+        PrefetchClean( p_input );
         InitPrograms( p_input );
 
         double f_rate = var_InheritFloat( p_input, "rate" );
@@ -1243,6 +1329,11 @@ static int Init( input_thread_t * p_input )
     return VLC_SUCCESS;
 
 error:
+    PrefetchClean( p_input );
+    for( int i = 0; ppsz_subs && ppsz_subs[i]; i++ )
+        free( ppsz_subs[i] );
+    free( ppsz_subs );
+
     input_ChangeState( p_input, ERROR_S );
 
     if( p_input->p->p_es_out )
@@ -1419,6 +1510,12 @@ void input_ControlPush( input_thread_t *p_input,
     vlc_mutex_unlock( &p_input->p->lock_control );
 }
 
+static bool ControlIsScrubSeek( input_thread_t *p_input, int i_type )
+{
+    return p_input->p->b_scrub && ( i_type == INPUT_CONTROL_SET_POSITION ||
+                                    i_type == INPUT_CONTROL_SET_TIME );
+}
+
 static int ControlGetReducedIndexLocked( input_thread_t *p_input )
 {
     const int i_lt = p_input->p->control[0].i_type;
@@ -1427,6 +1524,11 @@ static int ControlGetReducedIndexLocked( input_thread_t *p_input )
     {
         const int i_ct = p_input->p->control[i].i_type;
 
+        /* While scrubbing, any seek supersedes the previous ones */
+        if( ControlIsScrubSeek( p_input, i_lt ) &&
+            ControlIsScrubSeek( p_input, i_ct ) )
+            continue;
+
         if( i_lt == i_ct &&
             ( i_ct == INPUT_CONTROL_SET_STATE ||
               i_ct == INPUT_CONTROL_SET_RATE ||
@@ -1635,7 +1737,8 @@ static bool Control( input_thread_t *p_input,
             /* Reset the decoders states and clock sync (before calling the demuxer */
             es_out_SetTime( p_input->p->p_es_out, -1 );
             if( demux_Control( p_input->p->input.p_demux, DEMUX_SET_POSITION,
-                               (double) f_pos, !p_input->p->b_fast_seek ) )
+                               (double) f_pos, !p_input->p->b_fast_seek
+                                            && !p_input->p->b_scrub ) )
             {
                 msg_Err( p_input, "INPUT_CONTROL_SET_POSITION(_OFFSET) "
                          "%2.1f%% failed", (double)(f_pos * 100.f) );
@@ -1671,7 +1774,8 @@ static bool Control( input_thread_t *p_input,
 
             i_ret = demux_Control( p_input->p->input.p_demux,
                                    DEMUX_SET_TIME, i_time,
-                                   !p_input->p->b_fast_seek );
+                                   !p_input->p->b_fast_seek
+                                && !p_input->p->b_scrub );
             if( i_ret )
             {
                 int64_t i_length;
@@ -1683,7 +1787,8 @@ static bool Control( input_thread_t *p_input,
                     double f_pos = (double)i_time / (double)i_length;
                     i_ret = demux_Control( p_input->p->input.p_demux,
                                             DEMUX_SET_POSITION, f_pos,
-                                            !p_input->p->b_fast_seek );
+                                            !p_input->p->b_fast_seek
+                                         && !p_input->p->b_scrub );
                 }
             }
             if( i_ret )
@@ -1996,6 +2101,16 @@ static bool Control( input_thread_t *p_input,
             b_force_update = true;
             break;
 
+        case INPUT_CONTROL_SET_SCRUB:
+            if( p_input->p->b_scrub != val.b_bool )
+            {
+                msg_Dbg( p_input, "scrubbing %s",
+                         val.b_bool ? "started" : "stopped" );
+                p_input->p->b_scrub = val.b_bool;
+                es_out_SetScrub( p_input->p->p_es_out, val.b_bool );
+            }
+            break;
+
         case INPUT_CONTROL_SET_BOOKMARK:
         {
             mtime_t time_offset = -1;
@@ -2139,6 +2254,311 @@ static void UpdateTitleListfromDemux( input_thread_t *p_input )
 }
 
 
+/*****************************************************************************
+ * InputStreamNew: opens the access and the stream filters of a source
+ *****************************************************************************
+ * It may run on a prefetch thread, so it must not use the input source.
+ * The demux suggested by the access is returned in *ppsz_access_demux.
+ */
+static stream_t *InputStreamNew( input_thread_t *p_input, bool b_master,
+                                 const char *psz_mrl, const char *psz_access,
+                                 const char *psz_demux, const char *psz_path,
+                                 bool b_in_can_fail, char **ppsz_access_demux )
+{
+    access_t *p_access = access_New( p_input, p_input,
+                                     psz_access, psz_demux, psz_path );
+    if( p_access == NULL )
+    {
+        if( vlc_object_alive( p_input ) )
+        {
+            msg_Err( p_input, "open of `%s' failed", psz_mrl );
+            if( !b_in_can_fail )
+                dialog_Fatal( p_input, _("Your input can't be opened"),
+                               _("VLC is unable to open the MRL '%s'."
+                                 " Check the log for details."), psz_mrl );
+        }
+        return NULL;
+    }
+
+    *ppsz_access_demux = strdup( p_access->psz_demux );
+    if( unlikely(*ppsz_access_demux == NULL) )
+    {
+        access_Delete( p_access );
+        return NULL;
+    }
+
+    /* */
+    int  i_input_list;
+    char **ppsz_input_list;
+
+    TAB_INIT( i_input_list, ppsz_input_list );
+
+    /* On master stream only, use input-list */
+    if( b_master )
+    {
+        char *psz_list;
+        char *psz_parser;
+
+        psz_list =
+        psz_parser = var_CreateGetNonEmptyString( p_input, "input-list" );
+
+        while( psz_parser && *psz_parser )
+        {
+            char *p = strchr( psz_parser, ',' );
+            if( p )
+                *p++ = '\0';
+
+            if( *psz_parser )
+            {
+                char *psz_name = strdup( psz_parser );
+                if( psz_name )
+                    TAB_APPEND( i_input_list, ppsz_input_list, psz_name );
+            }
+
+            psz_parser = p;
+        }
+        free( psz_list );
+    }
+    /* Autodetect extra files if none specified */
+    if( i_input_list <= 0 )
+    {
+        InputGetExtraFiles( p_input, &i_input_list, &ppsz_input_list,
+                            psz_access, psz_path );
+    }
+    if( i_input_list > 0 )
+        TAB_APPEND( i_input_list, ppsz_input_list, NULL );
+
+    /* Create the stream_t */
+    stream_t *p_stream = stream_AccessNew( p_access, ppsz_input_list );
+    if( ppsz_input_list )
+    {
+        for( int i = 0; ppsz_input_list[i] != NULL; i++ )
+            free( ppsz_input_list[i] );
+        TAB_CLEAN( i_input_list, ppsz_input_list );
+    }
+
+    if( p_stream == NULL )
+    {
+        msg_Warn( p_input, "cannot create a stream_t from access" );
+        free( *ppsz_access_demux );
+        *ppsz_access_demux = NULL;
+        return NULL;
+    }
+
+    /* Add stream filters */
+    char *psz_stream_filter = var_GetNonEmptyString( p_input,
+                                                     "stream-filter" );
+    p_stream = stream_FilterChainNew( p_stream, psz_stream_filter,
+                           var_GetBool( p_input, "input-record-native" ) );
+    free( psz_stream_filter );
+
+    return p_stream;
+}
+
+/*****************************************************************************
+ * Prefetch: opens the slave sources while the master source opens
+ *****************************************************************************
+ * Only the access and stream filters are opened by the prefetch threads,
+ * and the first bytes of the stream are read. The demuxers are still opened
+ * by the input thread, in order, as they create elementary streams.
+ */
+#define INPUT_PREFETCH_MAX  8
+#define INPUT_PREFETCH_PEEK 2048
+
+typedef struct input_prefetch_t input_prefetch_t;
+
+struct input_prefetch_t
+{
+    input_thread_t *p_input;
+    vlc_thread_t    thread;
+
+    char       *psz_mrl;
+    char       *psz_forced_demux;
+    bool        b_can_fail;
+
+    char       *psz_dup;
+    const char *psz_access;
+    const char *psz_demux;
+    const char *psz_path;
+    char       *psz_var_demux;
+
+    stream_t   *p_stream;    /* NULL if the open failed */
+    char       *psz_access_demux;
+};
+
+/* Whether an access_demux module may handle an access. Such sources are not
+ * prefetched, as the access could hold the device that the access_demux
+ * needs. Disc image readers also accept files, but sharing them is fine. */
+static bool HasAccessDemux( const char *psz_access )
+{
+    if( !strcasecmp( psz_access, "file" ) )
+        return false;
+    if( !psz_access[0] || !strcasecmp( psz_access, "any" )
+     || strchr( psz_access, ',' ) != NULL )
+        return true;
+
+    return module_cap_has_shortcut( "access_demux", psz_access );
+}
+
+static void *PrefetchThread( void *data )
+{
+    input_prefetch_t *p = data;
+
+    p->p_stream = InputStreamNew( p->p_input, false, p->psz_mrl,
+                                  p->psz_access, p->psz_demux, p->psz_path,
+                                  p->b_can_fail, &p->psz_access_demux );
+
+    /* Fill the stream buffer, so that probing the demuxers does not wait */
+    if( p->p_stream != NULL )
+    {
+        const uint8_t *p_peek;
+        stream_Peek( p->p_stream, &p_peek, INPUT_PREFETCH_PEEK );
+    }
+    return NULL;
+}
+
+static void PrefetchDelete( input_prefetch_t *p )
+{
+    if( p->p_stream != NULL )
+        stream_Delete( p->p_stream );
+    free( p->psz_access_demux );
+    free( p->psz_var_demux );
+    free( p->psz_dup );
+    free( p->psz_forced_demux );
+    free( p->psz_mrl );
+    free( p );
+}
+
+static void PrefetchAdd( input_thread_t *p_input, const char *psz_mrl,
+                         const char *psz_forced_demux, bool b_can_fail )
+{
+    input_thread_private_t *priv = p_input->p;
+
+    if( priv->i_prefetch >= INPUT_PREFETCH_MAX )
+        return;
+
+    input_prefetch_t *p = calloc( 1, sizeof(*p) );
+    if( unlikely(p == NULL) )
+        return;
+
+    p->p_input = p_input;
+    p->psz_mrl = strdup( psz_mrl );
+    p->psz_forced_demux = psz_forced_demux ? strdup( psz_forced_demux ) : NULL;
+    p->psz_dup = strdup( psz_mrl );
+    p->b_can_fail = b_can_fail;
+    if( unlikely(p->psz_mrl == NULL || p->psz_dup == NULL
+              || (psz_forced_demux && p->psz_forced_demux == NULL)) )
+        goto error;
+
+    const char *psz_anchor;
+    input_SplitMRL( &p->psz_access, &p->psz_demux, &p->psz_path, &psz_anchor,
+                    p->psz_dup );
+    if( HasAccessDemux( p->psz_access ) )
+        goto error;
+
+    /* Same demux as InputSourceInit() would ask the access for */
+    if( psz_forced_demux && *psz_forced_demux )
+        p->psz_demux = psz_forced_demux;
+    else if( *p->psz_demux == '\0' )
+        p->psz_demux = p->psz_var_demux =
+            var_GetNonEmptyString( p_input, "demux" );
+    if( p->psz_demux == NULL )
+        goto error;
+
+    if( vlc_clone( &p->thread, PrefetchThread, p, VLC_THREAD_PRIORITY_INPUT ) )
+        goto error;
+
+    msg_Dbg( p_input, "opening `%s' ahead", psz_mrl );
+    TAB_APPEND( priv->i_prefetch, priv->prefetch, p );
+    return;
+
+error:
+    PrefetchDelete( p );
+}
+
+static void PrefetchStart( input_thread_t *p_input, char **ppsz_subs )
+{
+    char *psz_subtitle = var_GetNonEmptyString( p_input, "sub-file" );
+    if( psz_subtitle != NULL )
+    {
+        char *psz_path = SubtitleFilePath( psz_subtitle );
+        char *url = psz_path ? vlc_path2uri( psz_path, NULL ) : NULL;
+        if( url != NULL )
+        {
+            PrefetchAdd( p_input, url, "subtitle", false );
+            free( url );
+        }
+        free( psz_path );
+    }
+
+    /* Same paths as input_SubtitleFileAdd() will open */
+    for( int i = 0; ppsz_subs && ppsz_subs[i]; i++ )
+    {
+        if( psz_subtitle && !strcmp( psz_subtitle, ppsz_subs[i] ) )
+            continue;
+
+        char *psz_path = SubtitleFilePath( ppsz_subs[i] );
+        char *url = psz_path ? vlc_path2uri( psz_path, NULL ) : NULL;
+        if( url != NULL )
+        {
+            PrefetchAdd( p_input, url, "subtitle", true );
+            free( url );
+        }
+        free( psz_path );
+    }
+    free( psz_subtitle );
+
+    char **ppsz_slaves = GetSlaves( p_input );
+    for( int i = 0; ppsz_slaves && ppsz_slaves[i]; i++ )
+    {
+        PrefetchAdd( p_input, ppsz_slaves[i], NULL, false );
+        free( ppsz_slaves[i] );
+    }
+    free( ppsz_slaves );
+}
+
+/* Hands over the stream opened ahead for a source, if any */
+static int PrefetchTake( input_thread_t *p_input, const char *psz_mrl,
+                         const char *psz_forced_demux, stream_t **pp_stream,
+                         char **ppsz_access_demux )
+{
+    input_thread_private_t *priv = p_input->p;
+
+    for( int i = 0; i < priv->i_prefetch; i++ )
+    {
+        input_prefetch_t *p = priv->prefetch[i];
+
+        if( strcmp( p->psz_mrl, psz_mrl )
+         || strcmp( p->psz_forced_demux ? p->psz_forced_demux : "",
+                    psz_forced_demux ? psz_forced_demux : "" ) )
+            continue;
+
+        vlc_join( p->thread, NULL );
+        TAB_REMOVE( priv->i_prefetch, priv->prefetch, p );
+
+        *pp_stream = p->p_stream;
+        *ppsz_access_demux = p->psz_access_demux;
+        p->p_stream = NULL;
+        p->psz_access_demux = NULL;
+        PrefetchDelete( p );
+        return VLC_SUCCESS;
+    }
+    return VLC_EGENERIC;
+}
+
+/* Waits for and releases the sources opened ahead but not used */
+static void PrefetchClean( input_thread_t *p_input )
+{
+    input_thread_private_t *priv = p_input->p;
+
+    for( int i = 0; i < priv->i_prefetch; i++ )
+    {
+        vlc_join( priv->prefetch[i]->thread, NULL );
+        PrefetchDelete( priv->prefetch[i] );
+    }
+    TAB_CLEAN( priv->i_prefetch, priv->prefetch );
+}
+
 /*****************************************************************************
  * InputSourceNew:
  *****************************************************************************/
@@ -2158,6 +2578,7 @@ static int InputSourceInit( input_thread_t *p_input,
 {
     const char *psz_access, *psz_demux, *psz_path, *psz_anchor = NULL;
     char *psz_var_demux = NULL;
+    char *psz_access_demux = NULL;
     double f_fps;
 
     assert( psz_mrl );
@@ -2245,88 +2666,22 @@ static int InputSourceInit( input_thread_t *p_input,
         var_SetBool( p_input, "can-seek", b_can_seek );
     }
     else
-    {   /* Now try a real access */
-        access_t *p_access = access_New( p_input, p_input,
-                                         psz_access, psz_demux, psz_path );
-        if( p_access == NULL )
-        {
-            if( vlc_object_alive( p_input ) )
-            {
-                msg_Err( p_input, "open of `%s' failed", psz_mrl );
-                if( !b_in_can_fail )
-                    dialog_Fatal( p_input, _("Your input can't be opened"),
-                                   _("VLC is unable to open the MRL '%s'."
-                                     " Check the log for details."), psz_mrl );
-            }
+    {   /* Now try a real access, unless a prefetch thread opened it */
+        stream_t *p_stream;
+
+        if( &p_input->p->input == in
+         || PrefetchTake( p_input, psz_mrl, psz_forced_demux,
+                          &p_stream, &psz_access_demux ) )
+            p_stream = InputStreamNew( p_input, &p_input->p->input == in,
+                                       psz_mrl, psz_access, psz_demux,
+                                       psz_path, b_in_can_fail,
+                                       &psz_access_demux );
+        if( p_stream == NULL )
             goto error;
-        }
 
         /* Access-forced demuxer (PARENTAL ADVISORY: EXPLICIT HACK) */
         if( !psz_demux[0] || !strcasecmp( psz_demux, "any" ) )
-            psz_demux = p_access->psz_demux;
-
-        /* */
-        int  i_input_list;
-        char **ppsz_input_list;
-
-        TAB_INIT( i_input_list, ppsz_input_list );
-
-        /* On master stream only, use input-list */
-        if( &p_input->p->input == in )
-        {
-            char *psz_list;
-            char *psz_parser;
-
-            psz_list =
-            psz_parser = var_CreateGetNonEmptyString( p_input, "input-list" );
-
-            while( psz_parser && *psz_parser )
-            {
-                char *p = strchr( psz_parser, ',' );
-                if( p )
-                    *p++ = '\0';
-
-                if( *psz_parser )
-                {
-                    char *psz_name = strdup( psz_parser );
-                    if( psz_name )
-                        TAB_APPEND( i_input_list, ppsz_input_list, psz_name );
-                }
-
-                psz_parser = p;
-            }
-            free( psz_list );
-        }
-        /* Autodetect extra files if none specified */
-        if( i_input_list <= 0 )
-        {
-            InputGetExtraFiles( p_input, &i_input_list, &ppsz_input_list,
-                                psz_access, psz_path );
-        }
-        if( i_input_list > 0 )
-            TAB_APPEND( i_input_list, ppsz_input_list, NULL );
-
-        /* Create the stream_t */
-        stream_t *p_stream = stream_AccessNew( p_access, ppsz_input_list );
-        if( ppsz_input_list )
-        {
-            for( int i = 0; ppsz_input_list[i] != NULL; i++ )
-                free( ppsz_input_list[i] );
-            TAB_CLEAN( i_input_list, ppsz_input_list );
-        }
-
-        if( p_stream == NULL )
-        {
-            msg_Warn( p_input, "cannot create a stream_t from access" );
-            goto error;
-        }
-
-        /* Add stream filters */
-        char *psz_stream_filter = var_GetNonEmptyString( p_input,
-                                                         "stream-filter" );
-        p_stream = stream_FilterChainNew( p_stream, psz_stream_filter,
-                               var_GetBool( p_input, "input-record-native" ) );
-        free( psz_stream_filter );
+            psz_demux = psz_access_demux;
 
         if( !p_input->b_preparsing )
         {
@@ -2392,6 +2747,7 @@ static int InputSourceInit( input_thread_t *p_input,
         }
     }
 
+    free( psz_access_demux );
     free( psz_var_demux );
     free( psz_dup );
 
@@ -2449,6 +2805,7 @@ error:
     if( in->p_demux )
         demux_Delete( in->p_demux );
 
+    free( psz_access_demux );
     free( psz_var_demux );
     free( psz_dup );
 
@@ -2986,27 +3343,38 @@ static void input_SubtitleAdd( input_thread_t *p_input,
     var_FreeList( &list, NULL );
 }
 
+/* If we are provided a subtitle.sub file, see if we don't have a
+ * subtitle.idx and use it instead */
+static char *SubtitleFilePath( const char *psz_subtitle )
+{
+    char *psz_path = strdup( psz_subtitle );
+    if( unlikely(psz_path == NULL) )
+        return NULL;
+
+    char *psz_extension = strrchr( psz_path, '.');
+    if( psz_extension && strcmp( psz_extension, ".sub" ) == 0 )
+    {
+        struct stat st;
+
+        strcpy( psz_extension, ".idx" );
+
+        if( vlc_stat( psz_path, &st ) || !S_ISREG( st.st_mode ) )
+            strcpy( psz_extension, ".sub" );
+    }
+    return psz_path;
+}
+
 static void input_SubtitleFileAdd( input_thread_t *p_input, char *psz_subtitle,
                                    unsigned i_flags )
 {
-    /* if we are provided a subtitle.sub file,
-     * see if we don't have a subtitle.idx and use it instead */
-    char *psz_path = strdup( psz_subtitle );
+    char *psz_path = SubtitleFilePath( psz_subtitle );
     if( likely(psz_path != NULL) )
     {
-        char *psz_extension = strrchr( psz_path, '.');
-        if( psz_extension && strcmp( psz_extension, ".sub" ) == 0 )
+        if( strcmp( psz_path, psz_subtitle ) )
         {
-            struct stat st;
-
-            strcpy( psz_extension, ".idx" );
-
-            if( !vlc_stat( psz_path, &st ) && S_ISREG( st.st_mode ) )
-            {
-                msg_Dbg( p_input, "using %s as subtitle file instead of %s",
-                         psz_path, psz_subtitle );
-                strcpy( psz_subtitle, psz_path ); /* <- FIXME! constify */
-            }
+            msg_Dbg( p_input, "using %s as subtitle file instead of %s",
+                     psz_path, psz_subtitle );
+            strcpy( psz_subtitle, psz_path ); /* <- FIXME! constify */
         }
         free( psz_path );
     }
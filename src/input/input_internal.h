@@ -94,6 +94,7 @@ struct input_thread_private_t
     int64_t     i_run;      /* :run-time, 0 if none */
     int64_t     i_time;     /* Current time */
     bool        b_fast_seek;/* :input-fast-seek */
+    bool        b_scrub;    /* superseded seeks are dropped, key frames only */
 
     /* Output */
     bool            b_out_pace_control; /* XXX Move it ot es_sout ? */
@@ -128,6 +129,9 @@ struct input_thread_private_t
     /* Slave sources (subs, and others) */
     int            i_slave;
     input_source_t **slave;
+    /* Slave sources being opened ahead, while the master source opens */
+    int            i_prefetch;
+    struct input_prefetch_t **prefetch;
 
     /* Resources */
     input_resource_t *p_resource;
@@ -152,6 +156,9 @@ struct input_thread_private_t
         counter_t *p_lost_abuffers;
         counter_t *p_displayed_pictures;
         counter_t *p_lost_pictures;
+        /* Per ES statistics, kept until the input is destroyed */
+        int i_es;
+        input_es_stats_t **pp_es;
         vlc_mutex_t counters_lock;
     } counters;
 
@@ -211,6 +218,8 @@ enum input_control_e
     INPUT_CONTROL_SET_RECORD_STATE,
 
     INPUT_CONTROL_SET_FRAME_NEXT,
+
+    INPUT_CONTROL_SET_SCRUB,
 };
 
 /* Internal helpers */
@@ -250,6 +259,10 @@ int subtitles_Filter( const char *);
 void input_SplitMRL( const char **, const char **, const char **,
                      const char **, char * );
 
+/* stats.c */
+input_es_stats_t *stats_GetEsStats( input_thread_t *, const es_format_t * );
+void stats_CleanEsStats( input_thread_t * );
+
 /* meta.c */
 void vlc_audio_replay_gain_MergeFromMeta( audio_replay_gain_t *p_dst,
                                           const vlc_meta_t *p_meta );
@@ -216,7 +216,7 @@ void input_ExtractAttachmentAndCacheArt( input_thread_t *p_input,
     {   /* XXX Weird, we should not end up with attachment:// art URL
          * unless there is a race condition */
         msg_Warn( p_input, "art already fetched" );
-        playlist_FindArtInCache( p_item );
+        playlist_FindArtInCache( VLC_OBJECT(p_input), p_item );
         return;
     }
 
@@ -115,10 +115,57 @@ void stats_ComputeInputStats(input_thread_t *input, input_stats_t *st)
     st->i_displayed_pictures = stats_GetTotal(input->p->counters.p_displayed_pictures);
     st->i_lost_pictures = stats_GetTotal(input->p->counters.p_lost_pictures);
 
+    /* Elementary streams */
+    if (input->p->counters.i_es != st->i_es)
+    {
+        free(st->p_es);
+        st->p_es = NULL;
+        st->i_es = 0;
+        if (input->p->counters.i_es > 0)
+        {
+            st->p_es = malloc(input->p->counters.i_es * sizeof (*st->p_es));
+            if (st->p_es != NULL)
+                st->i_es = input->p->counters.i_es;
+        }
+    }
+    for (int i = 0; i < st->i_es; i++)
+        st->p_es[i] = *input->p->counters.pp_es[i];
+
     vlc_mutex_unlock(&st->lock);
     vlc_mutex_unlock(&input->p->counters.counters_lock);
 }
 
+/**
+ * Returns the statistics of an elementary stream, creating them if needed.
+ * Statistics outlive the decoder so that restarting an ES accumulates into
+ * the same entry. Must be called with the counters lock held.
+ */
+input_es_stats_t *stats_GetEsStats( input_thread_t *p_input,
+                                    const es_format_t *p_fmt )
+{
+    for( int i = 0; i < p_input->p->counters.i_es; i++ )
+    {
+        input_es_stats_t *p_es = p_input->p->counters.pp_es[i];
+        if( p_es->i_id == p_fmt->i_id && p_es->i_cat == p_fmt->i_cat )
+            return p_es;
+    }
+
+    input_es_stats_t *p_es = calloc( 1, sizeof( *p_es ) );
+    if( unlikely(p_es == NULL) )
+        return NULL;
+    p_es->i_id = p_fmt->i_id;
+    p_es->i_cat = p_fmt->i_cat;
+    TAB_APPEND( p_input->p->counters.i_es, p_input->p->counters.pp_es, p_es );
+    return p_es;
+}
+
+void stats_CleanEsStats( input_thread_t *p_input )
+{
+    for( int i = 0; i < p_input->p->counters.i_es; i++ )
+        free( p_input->p->counters.pp_es[i] );
+    TAB_CLEAN( p_input->p->counters.i_es, p_input->p->counters.pp_es );
+}
+
 void stats_ReinitInputStats( input_stats_t *p_stats )
 {
     vlc_mutex_lock( &p_stats->lock );
@@ -132,6 +179,9 @@ void stats_ReinitInputStats( input_stats_t *p_stats )
     p_stats->i_decoded_video = p_stats->i_decoded_audio =
     p_stats->i_sent_bytes = p_stats->i_sent_packets = p_stats->f_send_bitrate
      = 0;
+    free( p_stats->p_es );
+    p_stats->p_es = NULL;
+    p_stats->i_es = 0;
     vlc_mutex_unlock( &p_stats->lock );
 }
 
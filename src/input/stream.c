@@ -642,6 +642,31 @@ static int AStreamControl( stream_t *s, int i_query, va_list args )
             AStreamControlUpdate( s );
             return VLC_SUCCESS;
 
+        case STREAM_GET_BUFFERED_SIZE:
+        {
+            /* Data that can be read or peeked without blocking */
+            uint64_t *pi_64 = va_arg( args, uint64_t * );
+            switch( p_sys->method )
+            {
+            case STREAM_METHOD_BLOCK:
+                *pi_64 = p_sys->block.i_size
+                       - (p_sys->i_pos - p_sys->block.i_start);
+                break;
+            case STREAM_METHOD_STREAM:
+            {
+                const stream_track_t *tk =
+                    &p_sys->stream.tk[p_sys->stream.i_tk];
+                uint64_t i_cur = tk->i_start + p_sys->stream.i_offset;
+                *pi_64 = tk->i_end > i_cur ? tk->i_end - i_cur : 0;
+                break;
+            }
+            default:
+                *pi_64 = 0;
+                break;
+            }
+            break;
+        }
+
         case STREAM_SET_TITLE:
         case STREAM_SET_SEEKPOINT:
         {
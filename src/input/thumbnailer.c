@@ -0,0 +1,425 @@
+/*****************************************************************************
+ * thumbnailer.c: fast keyframe thumbnail extraction
+ *****************************************************************************
+ * Copyright (C) 2015 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+/*
+ * The thumbnailer does not use an input thread: it opens the stream and the
+ * demuxer directly with its own es_out, so that no clock, audio output or
+ * video output is involved. The first video ES is decoded synchronously in
+ * the caller thread, with the decoder asked to skip everything but
+ * keyframes, until one picture comes out. Every call uses its own objects,
+ * so any number of thumbnails can be extracted concurrently.
+ */
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <assert.h>
+
+#include <vlc_common.h>
+#include <vlc_input.h>
+#include <vlc_es_out.h>
+#include <vlc_codec.h>
+#include <vlc_block.h>
+#include <vlc_picture.h>
+#include <vlc_modules.h>
+#include <vlc_meta.h>
+
+#include "input_internal.h"
+#include "demux.h"
+#include "../libvlc.h"
+
+/* Maximum number of demux calls without getting a picture */
+#define THUMBNAILER_MAX_DEMUX 10000
+
+struct es_out_id_t
+{
+    decoder_t *p_dec;
+    decoder_t *p_packetizer;
+};
+
+struct es_out_sys_t
+{
+    vlc_object_t *p_obj;
+    bool          b_has_video;
+    picture_t    *p_picture;
+
+    int           i_es;
+    es_out_id_t **pp_es;
+};
+
+/*****************************************************************************
+ * Decoder
+ *****************************************************************************/
+static int VideoUpdateFormat( decoder_t *p_dec )
+{
+    p_dec->fmt_out.video.i_chroma = p_dec->fmt_out.i_codec;
+    return 0;
+}
+
+static picture_t *VideoNewBuffer( decoder_t *p_dec )
+{
+    return picture_NewFromFormat( &p_dec->fmt_out.video );
+}
+
+static void DeleteDecoder( decoder_t *p_dec )
+{
+    if( p_dec->p_module != NULL )
+        module_unneed( p_dec, p_dec->p_module );
+
+    es_format_Clean( &p_dec->fmt_in );
+    es_format_Clean( &p_dec->fmt_out );
+    if( p_dec->p_description != NULL )
+        vlc_meta_Delete( p_dec->p_description );
+
+    vlc_object_release( p_dec );
+}
+
+static decoder_t *CreateDecoder( vlc_object_t *p_obj, const es_format_t *p_fmt,
+                                 bool b_packetizer )
+{
+    decoder_t *p_dec = vlc_custom_create( p_obj, sizeof( *p_dec ),
+                                          b_packetizer ? "packetizer"
+                                                       : "decoder" );
+    if( p_dec == NULL )
+        return NULL;
+
+    p_dec->p_module = NULL;
+    p_dec->p_description = NULL;
+    es_format_Copy( &p_dec->fmt_in, p_fmt );
+    es_format_Init( &p_dec->fmt_out, UNKNOWN_ES, 0 );
+    p_dec->b_pace_control = true;
+    /* Only keyframes are needed, and in system memory */
+    p_dec->b_key_frames_only = !b_packetizer;
+    p_dec->b_software_only = !b_packetizer;
+
+    p_dec->pf_vout_format_update = VideoUpdateFormat;
+    p_dec->pf_vout_buffer_new = VideoNewBuffer;
+
+    if( b_packetizer )
+        p_dec->p_module = module_need( p_dec, "packetizer", "$packetizer",
+                                       false );
+    else
+        p_dec->p_module = module_need( p_dec, "decoder", "$codec", false );
+
+    if( p_dec->p_module == NULL )
+    {
+        msg_Err( p_obj, "no suitable %s module for fourcc `%4.4s'",
+                 b_packetizer ? "packetizer" : "decoder",
+                 (const char *)&p_fmt->i_codec );
+        DeleteDecoder( p_dec );
+        return NULL;
+    }
+    return p_dec;
+}
+
+static void Decode( es_out_sys_t *p_sys, decoder_t *p_dec, block_t *p_block )
+{
+    picture_t *p_pic;
+
+    while( (p_pic = p_dec->pf_decode_video( p_dec, &p_block )) != NULL )
+    {
+        if( p_sys->p_picture == NULL )
+            p_sys->p_picture = p_pic;
+        else
+            picture_Release( p_pic );
+    }
+}
+
+/*****************************************************************************
+ * es_out
+ *****************************************************************************/
+static es_out_id_t *EsOutAdd( es_out_t *out, const es_format_t *p_fmt )
+{
+    es_out_sys_t *p_sys = out->p_sys;
+    es_out_id_t *id = malloc( sizeof( *id ) );
+
+    if( unlikely(id == NULL) )
+        return NULL;
+    id->p_dec = NULL;
+    id->p_packetizer = NULL;
+    TAB_APPEND( p_sys->i_es, p_sys->pp_es, id );
+
+    /* Only the first video ES is decoded */
+    if( p_fmt->i_cat != VIDEO_ES || p_sys->b_has_video )
+        return id;
+
+    id->p_dec = CreateDecoder( p_sys->p_obj, p_fmt, false );
+    if( id->p_dec == NULL )
+        return id;
+
+    if( id->p_dec->b_need_packetized && !p_fmt->b_packetized )
+    {
+        id->p_packetizer = CreateDecoder( p_sys->p_obj, p_fmt, true );
+        if( id->p_packetizer == NULL )
+        {
+            DeleteDecoder( id->p_dec );
+            id->p_dec = NULL;
+            return id;
+        }
+    }
+    p_sys->b_has_video = true;
+    return id;
+}
+
+static int EsOutSend( es_out_t *out, es_out_id_t *id, block_t *p_block )
+{
+    es_out_sys_t *p_sys = out->p_sys;
+
+    if( id->p_dec == NULL || p_sys->p_picture != NULL )
+    {
+        block_Release( p_block );
+        return VLC_SUCCESS;
+    }
+
+    if( id->p_packetizer == NULL )
+    {
+        Decode( p_sys, id->p_dec, p_block );
+        return VLC_SUCCESS;
+    }
+
+    decoder_t *p_packetizer = id->p_packetizer;
+    block_t *p_packetized;
+    while( (p_packetized = p_packetizer->pf_packetize( p_packetizer,
+                                                       &p_block )) )
+    {
+        /* Same format propagation as the input decoders */
+        if( p_packetizer->fmt_out.i_extra && !id->p_dec->fmt_in.i_extra )
+        {
+            es_format_Clean( &id->p_dec->fmt_in );
+            es_format_Copy( &id->p_dec->fmt_in, &p_packetizer->fmt_out );
+        }
+        if( p_packetizer->fmt_out.video.i_sar_num > 0
+         && p_packetizer->fmt_out.video.i_sar_den > 0 )
+        {
+            id->p_dec->fmt_in.video.i_sar_num =
+                p_packetizer->fmt_out.video.i_sar_num;
+            id->p_dec->fmt_in.video.i_sar_den =
+                p_packetizer->fmt_out.video.i_sar_den;
+        }
+
+        while( p_packetized != NULL )
+        {
+            block_t *p_next = p_packetized->p_next;
+
+            p_packetized->p_next = NULL;
+            Decode( p_sys, id->p_dec, p_packetized );
+            p_packetized = p_next;
+        }
+    }
+    return VLC_SUCCESS;
+}
+
+static void EsOutDel( es_out_t *out, es_out_id_t *id )
+{
+    es_out_sys_t *p_sys = out->p_sys;
+
+    TAB_REMOVE( p_sys->i_es, p_sys->pp_es, id );
+    if( id->p_packetizer != NULL )
+        DeleteDecoder( id->p_packetizer );
+    if( id->p_dec != NULL )
+        DeleteDecoder( id->p_dec );
+    free( id );
+}
+
+static int EsOutControl( es_out_t *out, int i_query, va_list args )
+{
+    VLC_UNUSED(out);
+
+    switch( i_query )
+    {
+        case ES_OUT_GET_ES_STATE:
+        {
+            es_out_id_t *id = va_arg( args, es_out_id_t * );
+            bool *pb = va_arg( args, bool * );
+            /* Let the demuxer skip the streams we do not decode */
+            *pb = id->p_dec != NULL;
+            return VLC_SUCCESS;
+        }
+        default:
+            return VLC_EGENERIC;
+    }
+}
+
+static void EsOutDestroy( es_out_t *out )
+{
+    es_out_sys_t *p_sys = out->p_sys;
+
+    /* Some demuxers do not delete their ES when closed */
+    while( p_sys->i_es > 0 )
+        EsOutDel( out, p_sys->pp_es[0] );
+    TAB_CLEAN( p_sys->i_es, p_sys->pp_es );
+}
+
+/*****************************************************************************
+ * Thumbnailer
+ *****************************************************************************/
+static void ThumbnailTimeout( void *data )
+{
+    vlc_object_t *p_obj = data;
+
+    msg_Warn( p_obj, "thumbnailing timed out" );
+    ObjectKillChildrens( p_obj );
+}
+
+static picture_t *ThumbnailPicture( vlc_object_t *p_obj, const char *psz_mrl,
+                                    mtime_t i_time, double f_pos,
+                                    mtime_t i_deadline )
+{
+    es_out_sys_t sys = {
+        .p_obj = p_obj,
+        .b_has_video = false,
+        .p_picture = NULL,
+        .i_es = 0,
+        .pp_es = NULL,
+    };
+    es_out_t out = {
+        .pf_add = EsOutAdd,
+        .pf_send = EsOutSend,
+        .pf_del = EsOutDel,
+        .pf_control = EsOutControl,
+        .pf_destroy = EsOutDestroy,
+        .p_sys = &sys,
+    };
+    const char *psz_access, *psz_demux, *psz_path, *psz_anchor;
+
+    char *psz_dup = strdup( psz_mrl );
+    if( unlikely(psz_dup == NULL) )
+        return NULL;
+    input_SplitMRL( &psz_access, &psz_demux, &psz_path, &psz_anchor, psz_dup );
+
+    /* Try access_demux first, as the input does */
+    demux_t *p_demux = demux_New( p_obj, NULL, psz_access, psz_demux,
+                                  psz_path, NULL, &out, false );
+    stream_t *p_stream = NULL;
+    if( p_demux == NULL )
+    {
+        p_stream = stream_UrlNew( p_obj, psz_mrl );
+        if( p_stream != NULL )
+        {
+            p_demux = demux_New( p_obj, NULL, psz_access, psz_demux,
+                                 p_stream->psz_path ? p_stream->psz_path
+                                                    : psz_path,
+                                 p_stream, &out, false );
+            if( p_demux != NULL )
+                p_stream = NULL; /* deleted with the demuxer */
+            else
+                msg_Err( p_obj, "no suitable demux module for `%s'", psz_mrl );
+        }
+    }
+    free( psz_dup );
+    if( p_demux == NULL )
+        goto out;
+
+    /* Seek to the keyframe before the requested time. Nothing is lost if
+     * the demuxer cannot seek: the first picture is used instead. */
+    int i_ret = VLC_EGENERIC;
+    if( i_time >= 0 )
+        i_ret = demux_Control( p_demux, DEMUX_SET_TIME, i_time, false );
+    else if( f_pos > 0. )
+        i_ret = demux_Control( p_demux, DEMUX_SET_POSITION, f_pos, false );
+    if( i_ret != VLC_SUCCESS && (i_time > 0 || f_pos > 0.) )
+        msg_Warn( p_obj, "cannot seek, using the first picture" );
+
+    for( int i = 0; i < THUMBNAILER_MAX_DEMUX && sys.p_picture == NULL; i++ )
+    {
+        if( (i_deadline > 0 && mdate() > i_deadline)
+         || demux_Demux( p_demux ) <= 0 )
+            break;
+    }
+    demux_Delete( p_demux );
+
+out:
+    if( p_stream != NULL )
+        stream_Delete( p_stream );
+    EsOutDestroy( &out );
+    return sys.p_picture;
+}
+
+#undef input_Thumbnail
+/**
+ * Extracts and encodes a video thumbnail from an input item.
+ *
+ * This function is blocking but can be called concurrently from several
+ * threads.
+ *
+ * \param p_parent a vlc_object_t
+ * \param p_item an input item
+ * \param i_time time of the thumbnail, or a negative value to use f_pos
+ * \param f_pos position of the thumbnail in [0;1], used if i_time < 0
+ * \param i_format image format (e.g. VLC_CODEC_PNG)
+ * \param i_width, i_height thumbnail dimensions, as in picture_Export()
+ * \param i_timeout maximum duration, or 0 for no limit
+ * \return the encoded image or NULL on error
+ */
+block_t *input_Thumbnail( vlc_object_t *p_parent, input_item_t *p_item,
+                          mtime_t i_time, double f_pos, vlc_fourcc_t i_format,
+                          int i_width, int i_height, mtime_t i_timeout )
+{
+    vlc_object_t *p_obj = vlc_custom_create( p_parent, sizeof( *p_obj ),
+                                             "thumbnailer" );
+    if( unlikely(p_obj == NULL) )
+        return NULL;
+
+    /* Keep the input item options, as the input would */
+    vlc_mutex_lock( &p_item->lock );
+    char *psz_mrl = strdup( p_item->psz_uri );
+    for( int i = 0; i < p_item->i_options; i++ )
+        var_OptionParse( p_obj, p_item->ppsz_options[i],
+                         !!(p_item->optflagv[i] & VLC_INPUT_OPTION_TRUSTED) );
+    vlc_mutex_unlock( &p_item->lock );
+
+    block_t *p_image = NULL;
+    if( unlikely(psz_mrl == NULL) )
+        goto out;
+
+    /* Kill the access and demux once the deadline expires, so that a
+     * stalled read cannot block the caller forever */
+    vlc_timer_t timer;
+    bool b_timer = false;
+    if( i_timeout > 0 && !vlc_timer_create( &timer, ThumbnailTimeout, p_obj ) )
+    {
+        vlc_timer_schedule( timer, false, i_timeout, 0 );
+        b_timer = true;
+    }
+
+    picture_t *p_picture =
+        ThumbnailPicture( p_obj, psz_mrl, i_time, f_pos,
+                          i_timeout > 0 ? mdate() + i_timeout : 0 );
+
+    if( b_timer )
+        vlc_timer_destroy( timer );
+    free( psz_mrl );
+
+    if( p_picture == NULL )
+    {
+        msg_Dbg( p_obj, "no picture decoded" );
+        goto out;
+    }
+
+    msg_Dbg( p_obj, "thumbnail picture at %"PRId64" us", p_picture->date );
+    if( picture_Export( p_obj, &p_image, NULL, p_picture, i_format,
+                        i_width, i_height ) )
+        p_image = NULL;
+    picture_Release( p_picture );
+out:
+    vlc_object_release( p_obj );
+    return p_image;
+}
@@ -69,6 +69,9 @@ static int RecordCallback( vlc_object_t *p_this, char const *psz_cmd,
 static int FrameNextCallback( vlc_object_t *p_this, char const *psz_cmd,
                               vlc_value_t oldval, vlc_value_t newval,
                               void *p_data );
+static int ScrubCallback( vlc_object_t *p_this, char const *psz_cmd,
+                          vlc_value_t oldval, vlc_value_t newval,
+                          void *p_data );
 
 typedef struct
 {
@@ -103,6 +106,7 @@ static const vlc_input_callback_t p_input_callbacks[] =
     CALLBACK( "spu-es", ESCallback ),
     CALLBACK( "record", RecordCallback ),
     CALLBACK( "frame-next", FrameNextCallback ),
+    CALLBACK( "scrub", ScrubCallback ),
 
     CALLBACK( NULL, NULL )
 };
@@ -140,6 +144,9 @@ void input_ControlVarInit ( input_thread_t *p_input )
 
     var_Create( p_input, "frame-next", VLC_VAR_VOID );
 
+    /* Scrubbing */
+    var_Create( p_input, "scrub", VLC_VAR_BOOL );
+
     /* Position */
     var_Create( p_input, "position",  VLC_VAR_FLOAT );
     var_Create( p_input, "position-offset",  VLC_VAR_FLOAT );
@@ -835,3 +842,15 @@ static int FrameNextCallback( vlc_object_t *p_this, char const *psz_cmd,
     return VLC_SUCCESS;
 }
 
+static int ScrubCallback( vlc_object_t *p_this, char const *psz_cmd,
+                          vlc_value_t oldval, vlc_value_t newval,
+                          void *p_data )
+{
+    input_thread_t *p_input = (input_thread_t*)p_this;
+    VLC_UNUSED(psz_cmd); VLC_UNUSED(oldval); VLC_UNUSED(p_data);
+
+    input_ControlPush( p_input, INPUT_CONTROL_SET_SCRUB, &newval );
+
+    return VLC_SUCCESS;
+}
+
@@ -993,6 +993,13 @@ static const char *const ppsz_prefres[] = {
     "the correct demuxer is not automatically detected. You should not "\
     "set this as a global option unless you really know what you are doing." )
 
+#define DEMUX_CACHE_TEXT N_("Cache demux probing")
+#define DEMUX_CACHE_LONGTEXT N_( \
+    "Remember which demultiplexer accepted each media, identified by its " \
+    "location, size, modification date and first bytes, so that it is " \
+    "tried first when the media is opened again. The cache is kept in the " \
+    "media cache directory." )
+
 #define VOD_SERVER_TEXT N_("VoD server module")
 #define VOD_SERVER_LONGTEXT N_( \
     "You can select which VoD server module you want to use. Set this " \
@@ -1093,6 +1100,31 @@ static const char *const ppsz_prefres[] = {
 
 #define METADATA_NETWORK_TEXT N_( "Allow metadata network access" )
 
+#define PREPARSE_THREADS_TEXT N_( "Preparsing threads" )
+#define PREPARSE_THREADS_LONGTEXT N_( \
+    "Maximum number of threads used to preparse items concurrently." )
+
+#define PREPARSE_CACHE_TEXT N_( "Cache preparsing results" )
+#define PREPARSE_CACHE_LONGTEXT N_( \
+    "Keep the meta data, duration and tracks of preparsed local files in " \
+    "the media cache directory, so that they are not preparsed again, by " \
+    "this or another process, until they are modified." )
+
+#define MEDIA_CACHE_DIR_TEXT N_( "Media cache directory" )
+#define MEDIA_CACHE_DIR_LONGTEXT N_( \
+    "Directory of the album art and preparsing caches. Several processes " \
+    "can share it. By default, the user cache directory is used." )
+
+#define PREPARSE_TIMEOUT_TEXT N_( "Preparsing timeout" )
+#define PREPARSE_TIMEOUT_LONGTEXT N_( \
+    "Maximum time allowed to preparse a single item, in milliseconds. " \
+    "Use -1 (or 0) to disable the timeout." )
+
+#define FETCH_ART_THREADS_TEXT N_( "Art fetcher threads" )
+#define FETCH_ART_THREADS_LONGTEXT N_( \
+    "Maximum number of threads used to fetch meta data and art " \
+    "concurrently." )
+
 #define SD_TEXT N_( "Services discovery modules")
 #define SD_LONGTEXT N_( \
      "Specifies the services discovery modules to preload, separated by " \
@@ -1851,6 +1883,8 @@ vlc_module_begin ()
 
     set_subcategory( SUBCAT_INPUT_DEMUX )
     add_module( "demux", "demux", "any", DEMUX_TEXT, DEMUX_LONGTEXT, true )
+    add_bool( "demux-cache", false, DEMUX_CACHE_TEXT, DEMUX_CACHE_LONGTEXT,
+              true )
     set_subcategory( SUBCAT_INPUT_ACODEC )
     set_subcategory( SUBCAT_INPUT_SCODEC )
     add_obsolete_bool( "prefer-system-codecs" )
@@ -2009,6 +2043,18 @@ vlc_module_begin ()
     add_obsolete_integer( "album-art" )
     add_bool( "metadata-network-access", false, METADATA_NETWORK_TEXT,
                  METADATA_NETWORK_TEXT, false )
+    add_integer_with_range( "preparse-threads", 1, 1, 32,
+                            PREPARSE_THREADS_TEXT,
+                            PREPARSE_THREADS_LONGTEXT, true )
+    add_integer( "preparse-timeout", -1, PREPARSE_TIMEOUT_TEXT,
+                 PREPARSE_TIMEOUT_LONGTEXT, true )
+    add_bool( "preparse-cache", false, PREPARSE_CACHE_TEXT,
+              PREPARSE_CACHE_LONGTEXT, true )
+    add_directory( "media-cache-dir", NULL, MEDIA_CACHE_DIR_TEXT,
+                   MEDIA_CACHE_DIR_LONGTEXT, true )
+    add_integer_with_range( "fetch-art-threads", 1, 1, 32,
+                            FETCH_ART_THREADS_TEXT,
+                            FETCH_ART_THREADS_LONGTEXT, true )
 
     set_subcategory( SUBCAT_PLAYLIST_SD )
     add_string( "services-discovery", "", SD_TEXT, SD_LONGTEXT, true )
@@ -43,6 +43,7 @@
 #include "modules/modules.h"
 #include "config/configuration.h"
 #include "playlist/preparser.h"
+#include "input/demux.h"
 
 #include <stdio.h>                                              /* sprintf() */
 #include <string.h>
@@ -362,6 +363,7 @@ dbus_out:
      * Meta data handling
      */
     priv->parser = playlist_preparser_New(VLC_OBJECT(p_libvlc));
+    priv->demux_cache = demux_cache_New(VLC_OBJECT(p_libvlc));
 
     /* Create a variable for showing the fullscreen interface */
     var_Create( p_libvlc, "intf-toggle-fscontrol", VLC_VAR_BOOL );
@@ -525,6 +527,8 @@ void libvlc_InternalCleanup( libvlc_int_t *p_libvlc )
 
     if (priv->parser != NULL)
         playlist_preparser_Delete(priv->parser);
+    if (priv->demux_cache != NULL)
+        demux_cache_Delete(priv->demux_cache);
 
     vlc_DeinitActions( p_libvlc, priv->actions );
 
@@ -133,6 +133,7 @@ void vlc_object_set_destructor (vlc_object_t *, vlc_destructor_t);
  * To be cleaned-up module stuff:
  */
 module_t *module_find_by_shortcut (const char *psz_shortcut);
+bool module_cap_has_shortcut (const char *psz_cap, const char *psz_shortcut);
 
 #define ZOOM_SECTION N_("Zoom")
 #define ZOOM_QUARTER_KEY_TEXT N_("1:4 Quarter")
@@ -156,6 +157,7 @@ typedef struct libvlc_priv_t
     vlc_object_t      *p_dialog_provider; ///< dialog provider
     struct playlist_t *playlist; ///< Playlist for interfaces
     struct playlist_preparser_t *parser; ///< Input item meta data handler
+    struct demux_cache_t *demux_cache; ///< Demux probing results (or NULL)
     struct vlc_actions *actions; ///< Hotkeys handler
 
     /* Objects tree */
@@ -30,6 +30,7 @@
 # include "config.h"
 #endif
 #include <assert.h>
+#include <limits.h>
 
 #include <vlc_common.h>
 #include <vlc_picture_pool.h>
@@ -37,35 +38,42 @@
 /*****************************************************************************
  *
  *****************************************************************************/
+#define POOL_WORD_BITS (CHAR_BIT * sizeof (unsigned))
+
 struct picture_gc_sys_t {
     picture_pool_t *pool;
     picture_t *picture;
-    bool in_use;
+    unsigned index;
     uint64_t tick;
 };
 
 struct picture_pool_t {
-    uint64_t       tick;
+    atomic_ullong  tick;
     /* */
     unsigned       picture_count;
     picture_t      **picture;
 
     int       (*pic_lock)(picture_t *);
     void      (*pic_unlock)(picture_t *);
-    unsigned    refs;
-    vlc_mutex_t lock;
+    atomic_uint refs;
+    /* One bit per picture, set while the picture is free */
+    unsigned    word_count;
+    atomic_uint available[];
 };
 
-void picture_pool_Release(picture_pool_t *pool)
+static bool picture_pool_IsFree(picture_pool_t *pool, unsigned index)
 {
-    bool destroy;
+    unsigned word = atomic_load(&pool->available[index / POOL_WORD_BITS]);
 
-    vlc_mutex_lock(&pool->lock);
-    assert(pool->refs > 0);
-    destroy = --pool->refs == 0;
-    vlc_mutex_unlock(&pool->lock);
+    return (word >> (index % POOL_WORD_BITS)) & 1;
+}
 
-    if (likely(!destroy))
+void picture_pool_Release(picture_pool_t *pool)
+{
+    unsigned refs = atomic_fetch_sub(&pool->refs, 1);
+
+    assert(refs > 0);
+    if (likely(refs != 1))
         return;
 
     for (unsigned i = 0; i < pool->picture_count; i++) {
@@ -77,7 +85,6 @@ void picture_pool_Release(picture_pool_t *pool)
         free(picture);
     }
 
-    vlc_mutex_destroy(&pool->lock);
     free(pool->picture);
     free(pool);
 }
@@ -86,20 +93,22 @@ static void picture_pool_ReleasePicture(picture_t *picture)
 {
     picture_gc_sys_t *sys = picture->gc.p_sys;
     picture_pool_t *pool = sys->pool;
+    unsigned mask = 1u << (sys->index % POOL_WORD_BITS);
 
     if (pool->pic_unlock != NULL)
         pool->pic_unlock(picture);
 
-    vlc_mutex_lock(&pool->lock);
-    assert(sys->in_use);
-    sys->in_use = false;
-    vlc_mutex_unlock(&pool->lock);
+    unsigned word = atomic_fetch_or(&pool->available[sys->index / POOL_WORD_BITS],
+                                    mask);
+    assert(!(word & mask));
+    (void) word;
 
     picture_pool_Release(pool);
 }
 
 static picture_t *picture_pool_ClonePicture(picture_pool_t *pool,
-                                            picture_t *picture)
+                                            picture_t *picture,
+                                            unsigned index)
 {
     picture_gc_sys_t *sys = malloc(sizeof(*sys));
     if (unlikely(sys == NULL))
@@ -107,7 +116,7 @@ static picture_t *picture_pool_ClonePicture(picture_pool_t *pool,
 
     sys->pool = pool;
     sys->picture = picture;
-    sys->in_use = false;
+    sys->index = index;
     sys->tick = 0;
 
     picture_resource_t res = {
@@ -130,22 +139,33 @@ static picture_t *picture_pool_ClonePicture(picture_pool_t *pool,
     return clone;
 }
 
-static picture_pool_t *Create(int picture_count)
+static picture_pool_t *Create(unsigned picture_count)
 {
-    picture_pool_t *pool = calloc(1, sizeof(*pool));
+    unsigned word_count = (picture_count + POOL_WORD_BITS - 1) / POOL_WORD_BITS;
+    picture_pool_t *pool = malloc(sizeof(*pool)
+                                  + word_count * sizeof(pool->available[0]));
     if (!pool)
         return NULL;
 
-    pool->tick = 1;
     pool->picture_count = picture_count;
-    pool->picture = calloc(pool->picture_count, sizeof(*pool->picture));
+    pool->picture = calloc(pool->picture_count ? pool->picture_count : 1,
+                           sizeof(*pool->picture));
     if (!pool->picture) {
-        free(pool->picture);
         free(pool);
         return NULL;
     }
-    pool->refs = 1;
-    vlc_mutex_init(&pool->lock);
+    pool->pic_lock = NULL;
+    pool->pic_unlock = NULL;
+    atomic_init(&pool->tick, 1);
+    atomic_init(&pool->refs, 1);
+    pool->word_count = word_count;
+    /* All pictures start free */
+    for (unsigned i = 0; i < word_count; i++) {
+        unsigned bits = picture_count - i * POOL_WORD_BITS;
+
+        atomic_init(&pool->available[i],
+                    bits >= POOL_WORD_BITS ? ~0u : (1u << bits) - 1);
+    }
     return pool;
 }
 
@@ -159,7 +179,8 @@ picture_pool_t *picture_pool_NewExtended(const picture_pool_configuration_t *cfg
     pool->pic_unlock = cfg->unlock;
 
     for (unsigned i = 0; i < cfg->picture_count; i++) {
-        picture_t *picture = picture_pool_ClonePicture(pool, cfg->picture[i]);
+        picture_t *picture = picture_pool_ClonePicture(pool, cfg->picture[i],
+                                                       i);
         if (unlikely(picture == NULL))
             abort();
 
@@ -217,7 +238,15 @@ picture_pool_t *picture_pool_Reserve(picture_pool_t *master, unsigned count)
             goto error;
     }
 
-    picture_pool_t *pool = picture_pool_New(count, picture);
+    /* A lock without unlock cannot acquire anything, so it can be checked
+     * again whenever a reserved picture is reused */
+    picture_pool_configuration_t cfg = {
+        .picture_count = count,
+        .picture = picture,
+        .lock = master->pic_unlock == NULL ? master->pic_lock : NULL,
+    };
+
+    picture_pool_t *pool = picture_pool_NewExtended(&cfg);
     if (!pool)
         goto error;
 
@@ -231,60 +260,60 @@ error:
 
 picture_t *picture_pool_Get(picture_pool_t *pool)
 {
-    vlc_mutex_lock(&pool->lock);
-    assert(pool->refs > 0);
+    assert(atomic_load(&pool->refs) > 0);
 
-    for (unsigned i = 0; i < pool->picture_count; i++) {
-        picture_t *picture = pool->picture[i];
-        picture_gc_sys_t *sys = picture->gc.p_sys;
-        uint64_t tick;
+    for (unsigned w = 0; w < pool->word_count; w++) {
+        atomic_uint *word = &pool->available[w];
+        unsigned free_mask = atomic_load(word);
+        unsigned tried = 0;
 
-        if (sys->in_use)
-            continue;
+        while ((free_mask & ~tried) != 0) {
+            unsigned bit = ctz(free_mask & ~tried);
+            unsigned mask = 1u << bit;
 
-        pool->refs++;
-        tick = ++pool->tick;
-        sys->in_use = true;
-        vlc_mutex_unlock(&pool->lock);
+            /* Claim the lowest free picture; on contention, the mask is
+             * reloaded and the scan starts over from the new value. */
+            if (!atomic_compare_exchange_weak(word, &free_mask,
+                                              free_mask & ~mask))
+                continue;
 
-        if (pool->pic_lock != NULL && pool->pic_lock(picture) != 0) {
-            vlc_mutex_lock(&pool->lock);
-            sys->in_use = false;
-            pool->refs--;
-            continue;
-        }
+            picture_t *picture = pool->picture[w * POOL_WORD_BITS + bit];
+
+            atomic_fetch_add(&pool->refs, 1);
 
-        sys->tick = tick;
+            if (pool->pic_lock != NULL && pool->pic_lock(picture) != 0) {
+                free_mask = atomic_fetch_or(word, mask) | mask;
+                atomic_fetch_sub(&pool->refs, 1);
+                tried |= mask;
+                continue;
+            }
 
-        assert(atomic_load(&picture->gc.refcount) == 0);
-        atomic_init(&picture->gc.refcount, 1);
-        picture->p_next = NULL;
-        return picture;
+            picture->gc.p_sys->tick = atomic_fetch_add(&pool->tick, 1) + 1;
+
+            assert(atomic_load(&picture->gc.refcount) == 0);
+            atomic_init(&picture->gc.refcount, 1);
+            picture->p_next = NULL;
+            return picture;
+        }
     }
 
-    vlc_mutex_unlock(&pool->lock);
     return NULL;
 }
 
 unsigned picture_pool_Reset(picture_pool_t *pool)
 {
     unsigned ret = 0;
-retry:
-    vlc_mutex_lock(&pool->lock);
-    assert(pool->refs > 0);
+
+    assert(atomic_load(&pool->refs) > 0);
 
     for (unsigned i = 0; i < pool->picture_count; i++) {
         picture_t *picture = pool->picture[i];
-        picture_gc_sys_t *sys = picture->gc.p_sys;
 
-        if (sys->in_use) {
-            vlc_mutex_unlock(&pool->lock);
+        while (!picture_pool_IsFree(pool, i)) {
             picture_Release(picture);
             ret++;
-            goto retry;
         }
     }
-    vlc_mutex_unlock(&pool->lock);
 
     return ret;
 }
@@ -294,17 +323,13 @@ void picture_pool_NonEmpty(picture_pool_t *pool)
     picture_t *oldest = NULL;
     uint64_t tick = 0;
 
-    vlc_mutex_lock(&pool->lock);
-    assert(pool->refs > 0);
+    assert(atomic_load(&pool->refs) > 0);
 
     for (unsigned i = 0; i < pool->picture_count; i++) {
         picture_t *picture = pool->picture[i];
-        picture_gc_sys_t *sys = picture->gc.p_sys;
 
-        if (!sys->in_use) {
-            vlc_mutex_unlock(&pool->lock);
+        if (picture_pool_IsFree(pool, i))
             return; /* Nothing to do */
-        }
 
         if (picture->gc.p_sys->tick < tick) {
             oldest = picture;
@@ -313,14 +338,20 @@ void picture_pool_NonEmpty(picture_pool_t *pool)
     }
 
     if (oldest != NULL) {
-        while (oldest->gc.p_sys->in_use) {
-            vlc_mutex_unlock(&pool->lock);
+        unsigned index = oldest->gc.p_sys->index;
+
+        while (!picture_pool_IsFree(pool, index))
             picture_Release(oldest);
-            vlc_mutex_lock(&pool->lock);
-        }
     }
+}
+
+unsigned picture_pool_GetInFlight(picture_pool_t *pool)
+{
+    unsigned count = pool->picture_count;
 
-    vlc_mutex_unlock(&pool->lock);
+    for (unsigned i = 0; i < pool->word_count; i++)
+        count -= popcount(atomic_load(&pool->available[i]));
+    return count;
 }
 
 unsigned picture_pool_GetSize(const picture_pool_t *pool)
@@ -332,7 +363,7 @@ void picture_pool_Enum(picture_pool_t *pool, void (*cb)(void *, picture_t *),
                        void *opaque)
 {
     /* NOTE: So far, the pictures table cannot change after the pool is created
-     * so there is no need to lock the pool mutex here. */
+     * so there is no need to synchronize with other threads here. */
     for (unsigned i = 0; i < pool->picture_count; i++)
         cb(opaque, pool->picture[i]);
 }
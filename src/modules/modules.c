@@ -442,6 +442,26 @@ module_t *module_find_by_shortcut (const char *psz_shortcut)
     return NULL;
 }
 
+/**
+ * Tell if a module of a given capability handles a shortcut.
+ *
+ * \param psz_cap capability of the modules
+ * \param psz_shortcut shortcut to look for (case insensitive)
+ * \return true if at least one such module exists
+ */
+bool module_cap_has_shortcut (const char *psz_cap, const char *psz_shortcut)
+{
+    module_t **list;
+    ssize_t total = module_list_cap (&list, psz_cap);
+    bool found = false;
+
+    for (ssize_t i = 0; i < total && !found; i++)
+        for (size_t j = 0; j < list[i]->i_shortcuts && !found; j++)
+            found = !strcasecmp (list[i]->pp_shortcuts[j], psz_shortcut);
+    module_list_free (list);
+    return found;
+}
+
 /**
  * Get the configuration of a module
  *
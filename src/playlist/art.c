@@ -28,6 +28,7 @@
 
 #include <sys/stat.h>
 #include <errno.h>
+#include <unistd.h>
 
 #include <vlc_common.h>
 #include <vlc_input_item.h>
@@ -58,11 +59,20 @@ static void ArtCacheCreateDir( const char *psz_dir )
     vlc_mkdir( psz_dir, 0700 );
 }
 
-static char* ArtCacheGetDirPath( const char *psz_arturl, const char *psz_artist,
-                                 const char *psz_album,  const char *psz_title )
+char *playlist_GetCacheDir( vlc_object_t *obj )
+{
+    char *psz_dir = var_InheritString( obj, "media-cache-dir" );
+    if( psz_dir == NULL )
+        psz_dir = config_GetUserDir( VLC_CACHE_DIR );
+    return psz_dir;
+}
+
+static char* ArtCacheGetDirPath( vlc_object_t *obj, const char *psz_arturl,
+                                 const char *psz_artist, const char *psz_album,
+                                 const char *psz_title )
 {
     char *psz_dir;
-    char *psz_cachedir = config_GetUserDir(VLC_CACHE_DIR);
+    char *psz_cachedir = playlist_GetCacheDir( obj );
 
     if( !EMPTY_STR(psz_artist) && !EMPTY_STR(psz_album) )
     {
@@ -103,7 +113,7 @@ static char* ArtCacheGetDirPath( const char *psz_arturl, const char *psz_artist,
     return psz_dir;
 }
 
-static char *ArtCachePath( input_item_t *p_item )
+static char *ArtCachePath( vlc_object_t *obj, input_item_t *p_item )
 {
     char* psz_path = NULL;
     const char *psz_artist;
@@ -129,16 +139,18 @@ static char *ArtCachePath( input_item_t *p_item )
     if( (EMPTY_STR(psz_artist) || EMPTY_STR(psz_album) ) && !psz_arturl )
         goto end;
 
-    psz_path = ArtCacheGetDirPath( psz_arturl, psz_artist, psz_album, psz_title );
+    psz_path = ArtCacheGetDirPath( obj, psz_arturl, psz_artist, psz_album,
+                                   psz_title );
 
 end:
     vlc_mutex_unlock( &p_item->lock );
     return psz_path;
 }
 
-static char *ArtCacheName( input_item_t *p_item, const char *psz_type )
+static char *ArtCacheName( vlc_object_t *obj, input_item_t *p_item,
+                           const char *psz_type )
 {
-    char *psz_path = ArtCachePath( p_item );
+    char *psz_path = ArtCachePath( obj, p_item );
     if( !psz_path )
         return NULL;
 
@@ -157,9 +169,9 @@ static char *ArtCacheName( input_item_t *p_item, const char *psz_type )
 }
 
 /* */
-int playlist_FindArtInCache( input_item_t *p_item )
+int playlist_FindArtInCache( vlc_object_t *obj, input_item_t *p_item )
 {
-    char *psz_path = ArtCachePath( p_item );
+    char *psz_path = ArtCachePath( obj, p_item );
 
     if( !psz_path )
         return VLC_EGENERIC;
@@ -201,9 +213,9 @@ int playlist_FindArtInCache( input_item_t *p_item )
     return b_found ? VLC_SUCCESS : VLC_EGENERIC;
 }
 
-static char * GetDirByItemUIDs( char *psz_uid )
+static char * GetDirByItemUIDs( vlc_object_t *obj, char *psz_uid )
 {
-    char *psz_cachedir = config_GetUserDir(VLC_CACHE_DIR);
+    char *psz_cachedir = playlist_GetCacheDir( obj );
     char *psz_dir;
     if( asprintf( &psz_dir, "%s" DIR_SEP
                   "by-iiuid" DIR_SEP
@@ -226,7 +238,8 @@ static char * GetFileByItemUID( char *psz_dir, const char *psz_type )
     return psz_file;
 }
 
-int playlist_FindArtInCacheUsingItemUID( input_item_t *p_item )
+int playlist_FindArtInCacheUsingItemUID( vlc_object_t *obj,
+                                         input_item_t *p_item )
 {
     char *uid = input_item_GetInfo( p_item, "uid", "md5" );
     if ( ! *uid )
@@ -237,7 +250,7 @@ int playlist_FindArtInCacheUsingItemUID( input_item_t *p_item )
 
     /* we have an input item uid set */
     bool b_done = false;
-    char *psz_byuiddir = GetDirByItemUIDs( uid );
+    char *psz_byuiddir = GetDirByItemUIDs( obj, uid );
     char *psz_byuidfile = GetFileByItemUID( psz_byuiddir, "arturl" );
     free( psz_byuiddir );
     if( psz_byuidfile )
@@ -262,11 +275,59 @@ int playlist_FindArtInCacheUsingItemUID( input_item_t *p_item )
     return VLC_EGENERIC;
 }
 
+/* Writes a cache file atomically: readers either see the previous file or
+ * the complete new one. Returns 0 on success, -1 on error (see errno).
+ * The temporary file is hidden, so that playlist_FindArtInCache() never
+ * picks it up, even if it is left behind by a crash. */
+static int ArtCacheWrite( const char *psz_filename,
+                          const void *data, size_t length )
+{
+    const char *psz_base = strrchr( psz_filename, DIR_SEP_CHAR );
+    int i_dir = psz_base ? psz_base + 1 - psz_filename : 0;
+    char *psz_tmp;
+
+    if( asprintf( &psz_tmp, "%.*s.tmp-%s.XXXXXX", i_dir, psz_filename,
+                  psz_filename + i_dir ) == -1 )
+        return -1;
+
+    int fd = vlc_mkstemp( psz_tmp );
+    if( fd == -1 )
+    {
+        free( psz_tmp );
+        return -1;
+    }
+
+    FILE *f = fdopen( fd, "wb" );
+    if( f == NULL )
+    {
+        close( fd );
+        goto error;
+    }
+
+    bool b_ok = fwrite( data, 1, length, f ) == length;
+    if( fclose( f ) )
+        b_ok = false;
+    if( !b_ok || vlc_rename( psz_tmp, psz_filename ) )
+        goto error;
+
+    free( psz_tmp );
+    return 0;
+
+error:
+    {
+        int i_errno = errno;
+        vlc_unlink( psz_tmp );
+        errno = i_errno;
+    }
+    free( psz_tmp );
+    return -1;
+}
+
 /* */
 int playlist_SaveArt( vlc_object_t *obj, input_item_t *p_item,
                       const void *data, size_t length, const char *psz_type )
 {
-    char *psz_filename = ArtCacheName( p_item, psz_type );
+    char *psz_filename = ArtCacheName( obj, p_item, psz_type );
 
     if( !psz_filename )
         return VLC_EGENERIC;
@@ -288,20 +349,14 @@ int playlist_SaveArt( vlc_object_t *obj, input_item_t *p_item,
         return VLC_SUCCESS;
     }
 
-    /* Dump it otherwise */
-    FILE *f = vlc_fopen( psz_filename, "wb" );
-    if( f )
+    /* Dump it otherwise, through a temporary file, so that other processes
+     * sharing the cache never see a partially written file */
+    if( ArtCacheWrite( psz_filename, data, length ) )
+        msg_Err( obj, "%s: %s", psz_filename, vlc_strerror_c(errno) );
+    else
     {
-        if( fwrite( data, 1, length, f ) != length )
-        {
-            msg_Err( obj, "%s: %s", psz_filename, vlc_strerror_c(errno) );
-        }
-        else
-        {
-            msg_Dbg( obj, "album art saved to %s", psz_filename );
-            input_item_SetArtURL( p_item, psz_uri );
-        }
-        fclose( f );
+        msg_Dbg( obj, "album art saved to %s", psz_filename );
+        input_item_SetArtURL( p_item, psz_uri );
     }
     free( psz_uri );
 
@@ -313,20 +368,21 @@ int playlist_SaveArt( vlc_object_t *obj, input_item_t *p_item,
         goto end;
     }
 
-    char *psz_byuiddir = GetDirByItemUIDs( uid );
+    char *psz_byuiddir = GetDirByItemUIDs( obj, uid );
     char *psz_byuidfile = GetFileByItemUID( psz_byuiddir, "arturl" );
     ArtCacheCreateDir( psz_byuiddir );
     free( psz_byuiddir );
 
     if ( psz_byuidfile )
     {
-        f = vlc_fopen( psz_byuidfile, "wb" );
-        if ( f )
+        char *psz_arturl;
+        if( asprintf( &psz_arturl, "file://%s", psz_filename ) != -1 )
         {
-            if( fputs( "file://", f ) < 0 || fputs( psz_filename, f ) < 0 )
+            if( ArtCacheWrite( psz_byuidfile, psz_arturl,
+                               strlen( psz_arturl ) ) )
                 msg_Err( obj, "Error writing %s: %s", psz_byuidfile,
                          vlc_strerror_c(errno) );
-            fclose( f );
+            free( psz_arturl );
         }
         free( psz_byuidfile );
     }
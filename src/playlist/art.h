@@ -25,8 +25,15 @@
 #ifndef _PLAYLIST_ART_H
 #define _PLAYLIST_ART_H 1
 
-int playlist_FindArtInCache( input_item_t * );
-int playlist_FindArtInCacheUsingItemUID( input_item_t * );
+/**
+ * Returns the root of the art and preparsing caches: the "media-cache-dir"
+ * directory if set, so that several processes can share them, or the user
+ * cache directory otherwise.
+ */
+char *playlist_GetCacheDir( vlc_object_t * );
+
+int playlist_FindArtInCache( vlc_object_t *, input_item_t * );
+int playlist_FindArtInCacheUsingItemUID( vlc_object_t *, input_item_t * );
 
 int playlist_SaveArt( vlc_object_t *, input_item_t *,
                       const void *, size_t, const char *psz_type );
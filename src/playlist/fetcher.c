@@ -72,14 +72,18 @@ struct fetcher_entry_t
 struct playlist_fetcher_t
 {
     vlc_object_t   *object;
+    playlist_metacache_t *p_metacache;
     vlc_mutex_t     lock;
     vlc_cond_t      wait;
-    bool            b_live;
+    unsigned        i_live;   /* number of worker threads */
+    unsigned        i_active; /* number of workers processing an entry */
+    unsigned        i_waiting;
+    unsigned        i_max_threads;
 
     fetcher_entry_t *p_waiting_head[PASS_COUNT];
     fetcher_entry_t *p_waiting_tail[PASS_COUNT];
 
-    DECL_ARRAY(playlist_album_t) albums;
+    DECL_ARRAY(playlist_album_t) albums; /* protected by lock */
     meta_fetcher_scope_t e_scope;
 };
 
@@ -89,16 +93,23 @@ static void *Thread( void * );
 /*****************************************************************************
  * Public functions
  *****************************************************************************/
-playlist_fetcher_t *playlist_fetcher_New( vlc_object_t *parent )
+playlist_fetcher_t *playlist_fetcher_New( vlc_object_t *parent,
+                                          playlist_metacache_t *p_metacache )
 {
     playlist_fetcher_t *p_fetcher = malloc( sizeof(*p_fetcher) );
     if( !p_fetcher )
         return NULL;
 
     p_fetcher->object = parent;
+    p_fetcher->p_metacache = p_metacache;
     vlc_mutex_init( &p_fetcher->lock );
     vlc_cond_init( &p_fetcher->wait );
-    p_fetcher->b_live = false;
+    p_fetcher->i_live = 0;
+    p_fetcher->i_active = 0;
+    p_fetcher->i_waiting = 0;
+
+    int i_threads = var_InheritInteger( parent, "fetch-art-threads" );
+    p_fetcher->i_max_threads = i_threads > 0 ? i_threads : 1;
 
     bool b_access = var_InheritBool( parent, "metadata-network-access" );
     if ( !b_access )
@@ -125,14 +136,28 @@ void playlist_fetcher_Push( playlist_fetcher_t *p_fetcher, input_item_t *p_item,
     p_entry->p_next = NULL;
     p_entry->i_options = i_options;
     vlc_mutex_lock( &p_fetcher->lock );
-    /* Append last */
-    if ( p_fetcher->p_waiting_head[PASS1_LOCAL] )
-        p_fetcher->p_waiting_tail[PASS1_LOCAL]->p_next = p_entry;
-    else
+    if( i_options & META_REQUEST_OPTION_PRIORITY )
+    {
+        /* Insert first */
+        p_entry->p_next = p_fetcher->p_waiting_head[PASS1_LOCAL];
+        if ( p_entry->p_next == NULL )
+            p_fetcher->p_waiting_tail[PASS1_LOCAL] = p_entry;
         p_fetcher->p_waiting_head[PASS1_LOCAL] = p_entry;
-    p_fetcher->p_waiting_tail[PASS1_LOCAL] = p_entry;
+    }
+    else
+    {
+        /* Append last */
+        if ( p_fetcher->p_waiting_head[PASS1_LOCAL] )
+            p_fetcher->p_waiting_tail[PASS1_LOCAL]->p_next = p_entry;
+        else
+            p_fetcher->p_waiting_head[PASS1_LOCAL] = p_entry;
+        p_fetcher->p_waiting_tail[PASS1_LOCAL] = p_entry;
+    }
+    p_fetcher->i_waiting++;
 
-    if( !p_fetcher->b_live )
+    /* Spawn a new worker if the idle ones cannot absorb the backlog */
+    if( p_fetcher->i_live < p_fetcher->i_max_threads
+     && p_fetcher->i_waiting > p_fetcher->i_live - p_fetcher->i_active )
     {
         assert( p_fetcher->p_waiting_head[PASS1_LOCAL] );
         if( vlc_clone_detach( NULL, Thread, p_fetcher,
@@ -140,7 +165,7 @@ void playlist_fetcher_Push( playlist_fetcher_t *p_fetcher, input_item_t *p_item,
             msg_Err( p_fetcher->object,
                      "cannot spawn secondary preparse thread" );
         else
-            p_fetcher->b_live = true;
+            p_fetcher->i_live++;
     }
     vlc_mutex_unlock( &p_fetcher->lock );
 }
@@ -161,8 +186,9 @@ void playlist_fetcher_Delete( playlist_fetcher_t *p_fetcher )
         }
         p_fetcher->p_waiting_head[i_queue] = NULL;
     }
+    p_fetcher->i_waiting = 0;
 
-    while( p_fetcher->b_live )
+    while( p_fetcher->i_live > 0 )
         vlc_cond_wait( &p_fetcher->wait, &p_fetcher->lock );
     vlc_mutex_unlock( &p_fetcher->lock );
 
@@ -176,6 +202,24 @@ void playlist_fetcher_Delete( playlist_fetcher_t *p_fetcher )
 /*****************************************************************************
  * Privates functions
  *****************************************************************************/
+/**
+ * Looks up an album already searched in this session.
+ * The fetcher lock must be held.
+ */
+static playlist_album_t *FindAlbum( playlist_fetcher_t *p_fetcher,
+                                    const char *psz_artist,
+                                    const char *psz_album )
+{
+    for( int i = 0; i < p_fetcher->albums.i_size; i++ )
+    {
+        playlist_album_t *p_album = &p_fetcher->albums.p_elems[i];
+        if( !strcmp( p_album->psz_artist, psz_artist ) &&
+            !strcmp( p_album->psz_album, psz_album ) )
+            return p_album;
+    }
+    return NULL;
+}
+
 /**
  * This function locates the art associated to an input item.
  * Return codes:
@@ -183,11 +227,11 @@ void playlist_fetcher_Delete( playlist_fetcher_t *p_fetcher )
  *   1 : Art found, need to download
  *  -X : Error/not found
  */
-static int FindArt( playlist_fetcher_t *p_fetcher, input_item_t *p_item )
+static int FindArt( playlist_fetcher_t *p_fetcher, input_item_t *p_item,
+                    meta_fetcher_scope_t e_scope )
 {
     int i_ret;
 
-    playlist_album_t *p_album = NULL;
     char *psz_artist = input_item_GetArtist( p_item );
     char *psz_album = input_item_GetAlbum( p_item );
     char *psz_title = input_item_GetTitle( p_item );
@@ -202,43 +246,52 @@ static int FindArt( playlist_fetcher_t *p_fetcher, input_item_t *p_item )
     /* If we already checked this album in this session, skip */
     if( psz_artist && psz_album )
     {
-        FOREACH_ARRAY( playlist_album_t album, p_fetcher->albums )
-            if( !strcmp( album.psz_artist, psz_artist ) &&
-                !strcmp( album.psz_album, psz_album ) )
+        vlc_mutex_lock( &p_fetcher->lock );
+        playlist_album_t *p_album = FindAlbum( p_fetcher, psz_artist,
+                                               psz_album );
+        if( p_album )
+        {
+            msg_Dbg( p_fetcher->object,
+                     " %s - %s has already been searched",
+                     psz_artist, psz_album );
+            /* TODO-fenrir if we cache art filename too, we can go faster */
+            if( p_album->b_found )
             {
-                msg_Dbg( p_fetcher->object,
-                         " %s - %s has already been searched",
-                         psz_artist, psz_album );
-                /* TODO-fenrir if we cache art filename too, we can go faster */
+                char *psz_arturl = NULL;
+                if( !strncmp( p_album->psz_arturl, "file://", 7 ) )
+                    psz_arturl = strdup( p_album->psz_arturl );
+                vlc_mutex_unlock( &p_fetcher->lock );
                 free( psz_artist );
                 free( psz_album );
-                if( album.b_found )
-                {
-                    if( !strncmp( album.psz_arturl, "file://", 7 ) )
-                        input_item_SetArtURL( p_item, album.psz_arturl );
-                    else /* Actually get URL from cache */
-                        playlist_FindArtInCache( p_item );
-                    return 0;
-                }
-                else if ( album.e_scope >= p_fetcher->e_scope )
+
+                if( psz_arturl )
                 {
-                    return VLC_EGENERIC;
+                    input_item_SetArtURL( p_item, psz_arturl );
+                    free( psz_arturl );
                 }
-                msg_Dbg( p_fetcher->object,
-                         " will search at higher scope, if possible" );
-                p_album = &p_fetcher->albums.p_elems[fe_idx];
-
-                psz_artist = psz_album = NULL;
-                break;
+                else /* Actually get URL from cache */
+                    playlist_FindArtInCache( p_fetcher->object, p_item );
+                return 0;
             }
-        FOREACH_END();
+            else if ( p_album->e_scope >= e_scope )
+            {
+                vlc_mutex_unlock( &p_fetcher->lock );
+                free( psz_artist );
+                free( psz_album );
+                return VLC_EGENERIC;
+            }
+            msg_Dbg( p_fetcher->object,
+                     " will search at higher scope, if possible" );
+        }
+        vlc_mutex_unlock( &p_fetcher->lock );
     }
 
     free( psz_artist );
     free( psz_album );
 
-    if ( playlist_FindArtInCacheUsingItemUID( p_item ) != VLC_SUCCESS )
-        playlist_FindArtInCache( p_item );
+    if ( playlist_FindArtInCacheUsingItemUID( p_fetcher->object,
+                                              p_item ) != VLC_SUCCESS )
+        playlist_FindArtInCache( p_fetcher->object, p_item );
     else
         msg_Dbg( p_fetcher->object, "successfully retrieved arturl by uid" );
 
@@ -287,14 +340,14 @@ static int FindArt( playlist_fetcher_t *p_fetcher, input_item_t *p_item )
         module_t *p_module;
 
         p_finder->p_item = p_item;
-        p_finder->e_scope = p_fetcher->e_scope;
+        p_finder->e_scope = e_scope;
 
         p_module = module_need( p_finder, "art finder", NULL, false );
         if( p_module )
         {
             module_unneed( p_finder, p_module );
             /* Try immediately if found in cache by download URL */
-            if( !playlist_FindArtInCache( p_item ) )
+            if( !playlist_FindArtInCache( p_fetcher->object, p_item ) )
                 i_ret = 0;
             else
                 i_ret = 1;
@@ -305,9 +358,13 @@ static int FindArt( playlist_fetcher_t *p_fetcher, input_item_t *p_item )
     /* Record this album */
     if( psz_artist && psz_album )
     {
+        /* Another worker may have recorded the album in the meantime */
+        vlc_mutex_lock( &p_fetcher->lock );
+        playlist_album_t *p_album = FindAlbum( p_fetcher, psz_artist,
+                                               psz_album );
         if ( p_album )
         {
-            p_album->e_scope = p_fetcher->e_scope;
+            p_album->e_scope = e_scope;
             free( p_album->psz_arturl );
             p_album->psz_arturl = input_item_GetArtURL( p_item );
             p_album->b_found = (i_ret == VLC_EGENERIC ? false : true );
@@ -321,9 +378,10 @@ static int FindArt( playlist_fetcher_t *p_fetcher, input_item_t *p_item )
             a.psz_album = psz_album;
             a.psz_arturl = input_item_GetArtURL( p_item );
             a.b_found = (i_ret == VLC_EGENERIC ? false : true );
-            a.e_scope = p_fetcher->e_scope;
+            a.e_scope = e_scope;
             ARRAY_APPEND( p_fetcher->albums, a );
         }
+        vlc_mutex_unlock( &p_fetcher->lock );
     }
     else
     {
@@ -407,14 +465,15 @@ error:
  * connections, and gather information upon the playing media.
  * (even artwork).
  */
-static void FetchMeta( playlist_fetcher_t *p_fetcher, input_item_t *p_item )
+static void FetchMeta( playlist_fetcher_t *p_fetcher, input_item_t *p_item,
+                       meta_fetcher_scope_t e_scope )
 {
     meta_fetcher_t *p_finder =
         vlc_custom_create( p_fetcher->object, sizeof( *p_finder ), "art finder" );
     if ( !p_finder )
         return;
 
-    p_finder->e_scope = p_fetcher->e_scope;
+    p_finder->e_scope = e_scope;
     p_finder->p_item = p_item;
 
     module_t *p_module = module_need( p_finder, "meta fetcher", NULL, false );
@@ -450,10 +509,12 @@ static void *Thread( void *p_data )
             if ( p_entry->p_next == NULL )
                 p_fetcher->p_waiting_tail[e_pass] = NULL;
             p_entry->p_next = NULL;
+            p_fetcher->i_waiting--;
+            p_fetcher->i_active++;
         }
         else
         {
-            p_fetcher->b_live = false;
+            p_fetcher->i_live--;
             vlc_cond_signal( &p_fetcher->wait );
         }
         vlc_mutex_unlock( &p_fetcher->lock );
@@ -461,18 +522,18 @@ static void *Thread( void *p_data )
         if( !p_entry )
             break;
 
-        meta_fetcher_scope_t e_prev_scope = p_fetcher->e_scope;
+        meta_fetcher_scope_t e_scope = p_fetcher->e_scope;
 
         /* scope override */
-        switch ( p_entry->i_options ) {
+        switch ( p_entry->i_options & META_REQUEST_OPTION_SCOPE_ANY ) {
         case META_REQUEST_OPTION_SCOPE_ANY:
-            p_fetcher->e_scope = FETCHER_SCOPE_ANY;
+            e_scope = FETCHER_SCOPE_ANY;
             break;
         case META_REQUEST_OPTION_SCOPE_LOCAL:
-            p_fetcher->e_scope = FETCHER_SCOPE_LOCAL;
+            e_scope = FETCHER_SCOPE_LOCAL;
             break;
         case META_REQUEST_OPTION_SCOPE_NETWORK:
-            p_fetcher->e_scope = FETCHER_SCOPE_NETWORK;
+            e_scope = FETCHER_SCOPE_NETWORK;
             break;
         case META_REQUEST_OPTION_NONE:
         default:
@@ -481,26 +542,27 @@ static void *Thread( void *p_data )
         /* Triggers "meta fetcher", eventually fetch meta on the network.
          * They are identical to "meta reader" expect that may actually
          * takes time. That's why they are running here.
-         * The result of this fetch is not cached. */
+         * The result of this fetch is only cached with the preparsing
+         * results, if enabled. */
 
         int i_ret = -1;
 
-        if( e_pass == PASS1_LOCAL && ( p_fetcher->e_scope & FETCHER_SCOPE_LOCAL ) )
+        if( e_pass == PASS1_LOCAL && ( e_scope & FETCHER_SCOPE_LOCAL ) )
         {
             /* only fetch from local */
-            p_fetcher->e_scope = FETCHER_SCOPE_LOCAL;
+            e_scope = FETCHER_SCOPE_LOCAL;
         }
-        else if( e_pass == PASS2_NETWORK && ( p_fetcher->e_scope & FETCHER_SCOPE_NETWORK ) )
+        else if( e_pass == PASS2_NETWORK && ( e_scope & FETCHER_SCOPE_NETWORK ) )
         {
             /* only fetch from network */
-            p_fetcher->e_scope = FETCHER_SCOPE_NETWORK;
+            e_scope = FETCHER_SCOPE_NETWORK;
         }
         else
-            p_fetcher->e_scope = 0;
-        if ( p_fetcher->e_scope & FETCHER_SCOPE_ANY )
+            e_scope = 0;
+        if ( e_scope & FETCHER_SCOPE_ANY )
         {
-            FetchMeta( p_fetcher, p_entry->p_item );
-            i_ret = FindArt( p_fetcher, p_entry->p_item );
+            FetchMeta( p_fetcher, p_entry->p_item, e_scope );
+            i_ret = FindArt( p_fetcher, p_entry->p_item, e_scope );
             switch( i_ret )
             {
             case 1: /* Found, need to dl */
@@ -514,7 +576,6 @@ static void *Thread( void *p_data )
             }
         }
 
-        p_fetcher->e_scope = e_prev_scope;
         /* */
         if ( i_ret != VLC_SUCCESS && (e_pass != PASS2_NETWORK) )
         {
@@ -525,6 +586,8 @@ static void *Thread( void *p_data )
             else
                 p_fetcher->p_waiting_head[e_pass + 1] = p_entry;
             p_fetcher->p_waiting_tail[e_pass + 1] = p_entry;
+            p_fetcher->i_waiting++;
+            p_fetcher->i_active--;
             vlc_mutex_unlock( &p_fetcher->lock );
         }
         else
@@ -536,6 +599,9 @@ static void *Thread( void *p_data )
                 msg_Dbg( obj, "found art for %s in cache", psz_name );
                 input_item_SetArtFetched( p_entry->p_item, true );
                 var_SetAddress( obj, "item-change", p_entry->p_item );
+                if( p_fetcher->p_metacache != NULL )
+                    playlist_metacache_Store( p_fetcher->p_metacache,
+                                              p_entry->p_item );
             }
             else
             {
@@ -545,6 +611,10 @@ static void *Thread( void *p_data )
             free( psz_name );
             vlc_gc_decref( p_entry->p_item );
             free( p_entry );
+
+            vlc_mutex_lock( &p_fetcher->lock );
+            p_fetcher->i_active--;
+            vlc_mutex_unlock( &p_fetcher->lock );
         }
     }
     return NULL;
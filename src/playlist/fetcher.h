@@ -26,6 +26,7 @@
 #define _PLAYLIST_FETCHER_H 1
 
 #include <vlc_input_item.h>
+#include "metacache.h"
 
 /**
  * Fetcher opaque structure.
@@ -37,8 +38,12 @@ typedef struct playlist_fetcher_t playlist_fetcher_t;
 
 /**
  * This function creates the fetcher object and thread.
+ *
+ * The fetched meta data are stored in the preparsing results cache, if not
+ * NULL, which must outlive the fetcher.
  */
-playlist_fetcher_t *playlist_fetcher_New( vlc_object_t * );
+playlist_fetcher_t *playlist_fetcher_New( vlc_object_t *,
+                                          playlist_metacache_t * );
 
 /**
  * This function enqueues the provided item to be art fetched.
@@ -0,0 +1,720 @@
+/*****************************************************************************
+ * metacache.c: shared preparsing results cache
+ *****************************************************************************
+ * Copyright (C) 2015 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <vlc_common.h>
+#include <vlc_input_item.h>
+#include "metacache.h"
+
+#ifdef HAVE_MMAP
+#include <errno.h>
+#include <fcntl.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include <vlc_fs.h>
+#include <vlc_meta.h>
+#include <vlc_url.h>
+#include <vlc_atomic.h>
+#include "art.h"
+#include "input/item.h"
+
+/*
+ * The cache is a file made of a header page followed by fixed size slots,
+ * forming an open addressing hash table keyed by URI. It is mapped in
+ * memory by every process using it.
+ *
+ * Each slot is protected by a sequence counter, odd while the slot is being
+ * written: readers copy the slot out, and retry if the counter changed in
+ * the mean time. Writers are serialized with a lock on the whole file, and
+ * evict the oldest entry of the probe sequence when it is full.
+ */
+#define METACACHE_MAGIC     "VLCMETA1"
+#define METACACHE_SLOT_SIZE 4096
+#define METACACHE_SLOTS     8192 /* 32 MiB, allocated on demand */
+#define METACACHE_PROBES    4
+#define METACACHE_RETRIES   8
+
+typedef struct
+{
+    char     magic[8];
+    uint32_t i_slot_size;
+    uint32_t i_slots;
+} metacache_header_t;
+
+typedef struct
+{
+    atomic_uint i_seq;    /* odd while the slot is being written */
+    uint32_t    i_length; /* size of the record, 0 if the slot is free */
+    uint64_t    i_hash;   /* hash of the URI */
+    int64_t     i_mtime;  /* modification date of the file */
+    uint64_t    i_size;   /* size of the file */
+    int64_t     i_stamp;  /* date of storage, for eviction */
+    uint8_t     data[];
+} metacache_slot_t;
+
+#define METACACHE_RECORD_MAX (METACACHE_SLOT_SIZE - sizeof(metacache_slot_t))
+
+struct playlist_metacache_t
+{
+    vlc_object_t *obj;
+    int           fd;
+    uint8_t      *p_map;
+    size_t        i_map;
+    vlc_mutex_t   lock; /* serializes the writers of this process */
+};
+
+static metacache_slot_t *GetSlot( playlist_metacache_t *p_cache,
+                                  uint64_t i_hash, unsigned i_probe )
+{
+    size_t i_slot = (i_hash + i_probe) % METACACHE_SLOTS;
+    return (metacache_slot_t *)( p_cache->p_map + METACACHE_SLOT_SIZE
+                                 + i_slot * METACACHE_SLOT_SIZE );
+}
+
+/* FNV-1a */
+static uint64_t Hash( const char *psz )
+{
+    uint64_t i_hash = UINT64_C(14695981039346656037);
+    while( *psz )
+    {
+        i_hash ^= (uint8_t)*psz++;
+        i_hash *= UINT64_C(1099511628211);
+    }
+    return i_hash;
+}
+
+static int LockFile( int fd, short i_type )
+{
+    struct flock lock;
+
+    lock.l_type = i_type;
+    lock.l_whence = SEEK_SET;
+    lock.l_start = 0;
+    lock.l_len = 0;
+    while( fcntl( fd, (i_type == F_UNLCK) ? F_SETLK : F_SETLKW, &lock ) )
+        if( errno != EINTR )
+            return -1;
+    return 0;
+}
+
+/* Only local files can be checked for modifications */
+static int StatItem( const char *psz_uri, struct stat *p_st )
+{
+    char *psz_path = make_path( psz_uri );
+    if( psz_path == NULL )
+        return -1;
+
+    int i_ret = vlc_stat( psz_path, p_st );
+    free( psz_path );
+    return i_ret;
+}
+
+/*****************************************************************************
+ * Records serialization
+ *****************************************************************************/
+typedef struct
+{
+    uint8_t *p;
+    size_t   i_offset;
+    size_t   i_max;
+    bool     b_error;
+} metacache_buf_t;
+
+static void PutBytes( metacache_buf_t *b, const void *p, size_t i_size )
+{
+    if( b->b_error || i_size > b->i_max - b->i_offset )
+    {
+        b->b_error = true;
+        return;
+    }
+    memcpy( &b->p[b->i_offset], p, i_size );
+    b->i_offset += i_size;
+}
+
+static void GetBytes( metacache_buf_t *b, void *p, size_t i_size )
+{
+    if( b->b_error || i_size > b->i_max - b->i_offset )
+    {
+        b->b_error = true;
+        memset( p, 0, i_size );
+        return;
+    }
+    memcpy( p, &b->p[b->i_offset], i_size );
+    b->i_offset += i_size;
+}
+
+#define PutValue( b, v ) PutBytes( b, &(v), sizeof(v) )
+#define GetValue( b, v ) GetBytes( b, &(v), sizeof(v) )
+
+/* Strings are stored with their length including the nul, 0 if NULL */
+static void PutString( metacache_buf_t *b, const char *psz )
+{
+    size_t i_len = psz ? strlen( psz ) + 1 : 0;
+    uint16_t i_stored = i_len;
+
+    if( i_len > UINT16_MAX )
+        b->b_error = true;
+    PutValue( b, i_stored );
+    PutBytes( b, psz, i_len );
+}
+
+/* Returns a pointer within the buffer, valid as long as it is */
+static const char *GetString( metacache_buf_t *b )
+{
+    uint16_t i_len;
+
+    GetValue( b, i_len );
+    if( b->b_error || i_len == 0 )
+        return NULL;
+    if( i_len > b->i_max - b->i_offset || b->p[b->i_offset + i_len - 1] )
+    {
+        b->b_error = true;
+        return NULL;
+    }
+    const char *psz = (const char *)&b->p[b->i_offset];
+    b->i_offset += i_len;
+    return psz;
+}
+
+static char *GetStringDup( metacache_buf_t *b )
+{
+    const char *psz = GetString( b );
+    return psz ? strdup( psz ) : NULL;
+}
+
+static void PutES( metacache_buf_t *b, const es_format_t *p_fmt )
+{
+    int32_t i_cat = p_fmt->i_cat;
+
+    PutValue( b, i_cat );
+    PutValue( b, p_fmt->i_codec );
+    PutValue( b, p_fmt->i_original_fourcc );
+    PutValue( b, p_fmt->i_id );
+    PutValue( b, p_fmt->i_profile );
+    PutValue( b, p_fmt->i_level );
+    PutValue( b, p_fmt->i_bitrate );
+    PutString( b, p_fmt->psz_language );
+    PutString( b, p_fmt->psz_description );
+
+    switch( p_fmt->i_cat )
+    {
+    case VIDEO_ES:
+        PutValue( b, p_fmt->video.i_width );
+        PutValue( b, p_fmt->video.i_height );
+        PutValue( b, p_fmt->video.i_visible_width );
+        PutValue( b, p_fmt->video.i_visible_height );
+        PutValue( b, p_fmt->video.i_sar_num );
+        PutValue( b, p_fmt->video.i_sar_den );
+        PutValue( b, p_fmt->video.i_frame_rate );
+        PutValue( b, p_fmt->video.i_frame_rate_base );
+        break;
+    case AUDIO_ES:
+        PutValue( b, p_fmt->audio.i_channels );
+        PutValue( b, p_fmt->audio.i_rate );
+        PutValue( b, p_fmt->audio.i_bitspersample );
+        break;
+    case SPU_ES:
+        PutString( b, p_fmt->subs.psz_encoding );
+        break;
+    default:
+        break;
+    }
+}
+
+static void GetES( metacache_buf_t *b, es_format_t *p_fmt )
+{
+    int32_t i_cat;
+    vlc_fourcc_t i_codec;
+
+    GetValue( b, i_cat );
+    GetValue( b, i_codec );
+    es_format_Init( p_fmt, i_cat, i_codec );
+    GetValue( b, p_fmt->i_original_fourcc );
+    GetValue( b, p_fmt->i_id );
+    GetValue( b, p_fmt->i_profile );
+    GetValue( b, p_fmt->i_level );
+    GetValue( b, p_fmt->i_bitrate );
+    p_fmt->psz_language = GetStringDup( b );
+    p_fmt->psz_description = GetStringDup( b );
+
+    switch( i_cat )
+    {
+    case VIDEO_ES:
+        GetValue( b, p_fmt->video.i_width );
+        GetValue( b, p_fmt->video.i_height );
+        GetValue( b, p_fmt->video.i_visible_width );
+        GetValue( b, p_fmt->video.i_visible_height );
+        GetValue( b, p_fmt->video.i_sar_num );
+        GetValue( b, p_fmt->video.i_sar_den );
+        GetValue( b, p_fmt->video.i_frame_rate );
+        GetValue( b, p_fmt->video.i_frame_rate_base );
+        break;
+    case AUDIO_ES:
+        GetValue( b, p_fmt->audio.i_channels );
+        GetValue( b, p_fmt->audio.i_rate );
+        GetValue( b, p_fmt->audio.i_bitspersample );
+        break;
+    case SPU_ES:
+        p_fmt->subs.psz_encoding = GetStringDup( b );
+        break;
+    default:
+        break;
+    }
+}
+
+/* Serializes the URI, duration, meta data and tracks of an item.
+ * The item lock must be held. */
+static void PutItem( metacache_buf_t *b, input_item_t *p_item )
+{
+    PutString( b, p_item->psz_uri );
+    PutValue( b, p_item->i_duration );
+
+    uint8_t i_meta = 0;
+    char **ppsz_extra = NULL;
+    uint16_t i_extra = 0;
+    if( p_item->p_meta != NULL )
+    {
+        for( int i = 0; i < VLC_META_TYPE_COUNT; i++ )
+            if( vlc_meta_Get( p_item->p_meta, i ) != NULL )
+                i_meta++;
+        ppsz_extra = vlc_meta_CopyExtraNames( p_item->p_meta );
+        while( ppsz_extra != NULL && ppsz_extra[i_extra] != NULL )
+            i_extra++;
+    }
+
+    PutValue( b, i_meta );
+    for( int i = 0; i < VLC_META_TYPE_COUNT && i_meta > 0; i++ )
+    {
+        const char *psz_value = vlc_meta_Get( p_item->p_meta, i );
+        if( psz_value == NULL )
+            continue;
+
+        uint8_t i_type = i;
+        PutValue( b, i_type );
+        PutString( b, psz_value );
+    }
+
+    PutValue( b, i_extra );
+    for( unsigned i = 0; i < i_extra; i++ )
+    {
+        PutString( b, ppsz_extra[i] );
+        PutString( b, vlc_meta_GetExtra( p_item->p_meta, ppsz_extra[i] ) );
+        free( ppsz_extra[i] );
+    }
+    free( ppsz_extra );
+
+    uint16_t i_es = p_item->i_es;
+    PutValue( b, i_es );
+    for( int i = 0; i < p_item->i_es; i++ )
+        PutES( b, p_item->es[i] );
+}
+
+/* Restores an item from a record, only if the record is fully valid */
+static int GetItem( metacache_buf_t *b, input_item_t *p_item )
+{
+    mtime_t i_duration;
+    uint8_t i_meta;
+    uint16_t i_extra, i_es;
+
+    GetValue( b, i_duration );
+
+    vlc_meta_t *p_meta = vlc_meta_New();
+    if( unlikely(p_meta == NULL) )
+        return VLC_ENOMEM;
+
+    GetValue( b, i_meta );
+    for( unsigned i = 0; i < i_meta; i++ )
+    {
+        uint8_t i_type;
+        GetValue( b, i_type );
+        const char *psz_value = GetString( b );
+        if( b->b_error || i_type >= VLC_META_TYPE_COUNT )
+        {
+            b->b_error = true;
+            break;
+        }
+
+        /* The art may have been removed from the art cache since */
+        if( i_type == vlc_meta_ArtworkURL && psz_value != NULL
+         && !strncmp( psz_value, "file://", 7 ) )
+        {
+            struct stat st;
+            if( StatItem( psz_value, &st ) )
+                continue;
+        }
+        vlc_meta_Set( p_meta, i_type, psz_value );
+    }
+
+    GetValue( b, i_extra );
+    for( unsigned i = 0; i < i_extra && !b->b_error; i++ )
+    {
+        const char *psz_name = GetString( b );
+        const char *psz_value = GetString( b );
+        if( psz_name != NULL )
+            vlc_meta_AddExtra( p_meta, psz_name, psz_value );
+    }
+
+    GetValue( b, i_es );
+    es_format_t *p_es = NULL;
+    if( !b->b_error && i_es > 0 )
+    {
+        p_es = malloc( i_es * sizeof(*p_es) );
+        if( unlikely(p_es == NULL) )
+            b->b_error = true;
+    }
+
+    unsigned i_parsed = 0;
+    while( !b->b_error && i_parsed < i_es )
+        GetES( b, &p_es[i_parsed++] );
+
+    if( !b->b_error )
+    {
+        for( int i = 0; i < VLC_META_TYPE_COUNT; i++ )
+        {
+            const char *psz_value = vlc_meta_Get( p_meta, i );
+            if( psz_value != NULL )
+                input_item_SetMeta( p_item, i, psz_value );
+        }
+
+        char **ppsz_extra = vlc_meta_CopyExtraNames( p_meta );
+        if( ppsz_extra != NULL )
+        {
+            vlc_mutex_lock( &p_item->lock );
+            if( p_item->p_meta == NULL )
+                p_item->p_meta = vlc_meta_New();
+            for( int i = 0; ppsz_extra[i] != NULL; i++ )
+            {
+                if( p_item->p_meta != NULL )
+                    vlc_meta_AddExtra( p_item->p_meta, ppsz_extra[i],
+                                vlc_meta_GetExtra( p_meta, ppsz_extra[i] ) );
+                free( ppsz_extra[i] );
+            }
+            vlc_mutex_unlock( &p_item->lock );
+            free( ppsz_extra );
+        }
+
+        input_item_SetDuration( p_item, i_duration );
+        for( unsigned i = 0; i < i_es; i++ )
+            input_item_UpdateTracksInfo( p_item, &p_es[i] );
+    }
+
+    for( unsigned i = 0; i < i_parsed; i++ )
+        es_format_Clean( &p_es[i] );
+    free( p_es );
+    vlc_meta_Delete( p_meta );
+    return b->b_error ? VLC_EGENERIC : VLC_SUCCESS;
+}
+
+/*****************************************************************************
+ * Public functions
+ *****************************************************************************/
+static int InitFile( vlc_object_t *obj, int fd, size_t i_map )
+{
+    metacache_header_t hdr;
+    struct stat st;
+
+    if( fstat( fd, &st ) )
+        return -1;
+
+    if( st.st_size == 0 )
+    {
+        memset( &hdr, 0, sizeof(hdr) );
+        memcpy( hdr.magic, METACACHE_MAGIC, sizeof(hdr.magic) );
+        hdr.i_slot_size = METACACHE_SLOT_SIZE;
+        hdr.i_slots = METACACHE_SLOTS;
+
+        /* The slots are left sparse, until they get used */
+        if( pwrite( fd, &hdr, sizeof(hdr), 0 ) != sizeof(hdr)
+         || ftruncate( fd, i_map ) )
+        {
+            msg_Err( obj, "cannot create preparse cache: %s",
+                     vlc_strerror_c(errno) );
+            return -1;
+        }
+        return 0;
+    }
+
+    if( (uintmax_t)st.st_size != i_map
+     || pread( fd, &hdr, sizeof(hdr), 0 ) != sizeof(hdr)
+     || memcmp( hdr.magic, METACACHE_MAGIC, sizeof(hdr.magic) )
+     || hdr.i_slot_size != METACACHE_SLOT_SIZE
+     || hdr.i_slots != METACACHE_SLOTS )
+    {
+        msg_Warn( obj, "incompatible preparse cache" );
+        return -1;
+    }
+    return 0;
+}
+
+playlist_metacache_t *playlist_metacache_New( vlc_object_t *obj )
+{
+    if( !var_InheritBool( obj, "preparse-cache" ) )
+        return NULL;
+
+    char *psz_dir = playlist_GetCacheDir( obj );
+    if( psz_dir == NULL )
+        return NULL;
+
+    char *psz_file;
+    vlc_mkdir( psz_dir, 0700 );
+    int i_ret = asprintf( &psz_file, "%s" DIR_SEP "preparse.dat", psz_dir );
+    free( psz_dir );
+    if( i_ret == -1 )
+        return NULL;
+
+    playlist_metacache_t *p_cache = malloc( sizeof(*p_cache) );
+    if( unlikely(p_cache == NULL) )
+    {
+        free( psz_file );
+        return NULL;
+    }
+
+    p_cache->obj = obj;
+    p_cache->i_map = (size_t)METACACHE_SLOT_SIZE * (1 + METACACHE_SLOTS);
+    p_cache->fd = vlc_open( psz_file, O_RDWR | O_CREAT, 0666 );
+    if( p_cache->fd == -1 )
+    {
+        msg_Err( obj, "cannot open %s: %s", psz_file, vlc_strerror_c(errno) );
+        goto error;
+    }
+
+    /* Another process may be creating the file at the same time */
+    if( LockFile( p_cache->fd, F_WRLCK ) )
+        goto error;
+    i_ret = InitFile( obj, p_cache->fd, p_cache->i_map );
+    LockFile( p_cache->fd, F_UNLCK );
+    if( i_ret )
+        goto error;
+
+    p_cache->p_map = mmap( NULL, p_cache->i_map, PROT_READ | PROT_WRITE,
+                           MAP_SHARED, p_cache->fd, 0 );
+    if( p_cache->p_map == MAP_FAILED )
+    {
+        msg_Err( obj, "cannot map %s: %s", psz_file, vlc_strerror_c(errno) );
+        goto error;
+    }
+
+    vlc_mutex_init( &p_cache->lock );
+    msg_Dbg( obj, "using preparse cache %s", psz_file );
+    free( psz_file );
+    return p_cache;
+
+error:
+    if( p_cache->fd != -1 )
+        close( p_cache->fd );
+    free( p_cache );
+    free( psz_file );
+    return NULL;
+}
+
+void playlist_metacache_Delete( playlist_metacache_t *p_cache )
+{
+    vlc_mutex_destroy( &p_cache->lock );
+    munmap( p_cache->p_map, p_cache->i_map );
+    close( p_cache->fd );
+    free( p_cache );
+}
+
+int playlist_metacache_Load( playlist_metacache_t *p_cache,
+                             input_item_t *p_item )
+{
+    char *psz_uri = input_item_GetURI( p_item );
+    struct stat st;
+
+    if( psz_uri == NULL || StatItem( psz_uri, &st ) )
+    {
+        free( psz_uri );
+        return VLC_EGENERIC;
+    }
+
+    uint64_t i_hash = Hash( psz_uri );
+    uint8_t record[METACACHE_RECORD_MAX];
+    int i_ret = VLC_EGENERIC;
+
+    for( unsigned i_probe = 0; i_probe < METACACHE_PROBES; i_probe++ )
+    {
+        metacache_slot_t *p_slot = GetSlot( p_cache, i_hash, i_probe );
+        metacache_slot_t slot;
+        bool b_consistent = false;
+
+        for( unsigned i_retry = 0; i_retry < METACACHE_RETRIES; i_retry++ )
+        {
+            unsigned i_seq = atomic_load_explicit( &p_slot->i_seq,
+                                                   memory_order_acquire );
+            if( i_seq & 1 )
+                continue; /* being written */
+
+            slot.i_length = p_slot->i_length;
+            slot.i_hash = p_slot->i_hash;
+            slot.i_mtime = p_slot->i_mtime;
+            slot.i_size = p_slot->i_size;
+            if( slot.i_length > METACACHE_RECORD_MAX )
+                slot.i_length = 0;
+            memcpy( record, p_slot->data, slot.i_length );
+
+            atomic_thread_fence( memory_order_acquire );
+            if( atomic_load_explicit( &p_slot->i_seq,
+                                      memory_order_relaxed ) == i_seq )
+            {
+                b_consistent = true;
+                break;
+            }
+        }
+
+        if( !b_consistent )
+            continue;
+        /* Slots are never freed, so the URI cannot be further */
+        if( slot.i_length == 0 )
+            break;
+        if( slot.i_hash != i_hash
+         || slot.i_mtime != (int64_t)st.st_mtime
+         || slot.i_size != (uint64_t)st.st_size )
+            continue;
+
+        metacache_buf_t b = { record, 0, slot.i_length, false };
+        const char *psz_stored = GetString( &b );
+        if( psz_stored == NULL || strcmp( psz_stored, psz_uri ) )
+            continue;
+
+        i_ret = GetItem( &b, p_item );
+        break;
+    }
+
+    if( i_ret == VLC_SUCCESS )
+        msg_Dbg( p_cache->obj, "preparsing results of %s found in cache",
+                 psz_uri );
+    free( psz_uri );
+    return i_ret;
+}
+
+void playlist_metacache_Store( playlist_metacache_t *p_cache,
+                               input_item_t *p_item )
+{
+    uint8_t record[METACACHE_RECORD_MAX];
+    metacache_buf_t b = { record, 0, sizeof(record), false };
+    struct stat st;
+
+    char *psz_uri = input_item_GetURI( p_item );
+    if( psz_uri == NULL || StatItem( psz_uri, &st ) )
+    {
+        free( psz_uri );
+        return;
+    }
+
+    vlc_mutex_lock( &p_item->lock );
+    bool b_store = p_item->i_type == ITEM_TYPE_FILE && p_item->i_es > 0;
+    if( b_store )
+        PutItem( &b, p_item );
+    vlc_mutex_unlock( &p_item->lock );
+
+    if( !b_store || b.b_error )
+    {
+        if( b.b_error )
+            msg_Dbg( p_cache->obj, "preparsing results of %s too large to be "
+                     "cached", psz_uri );
+        free( psz_uri );
+        return;
+    }
+
+    uint64_t i_hash = Hash( psz_uri );
+    size_t i_uri = strlen( psz_uri ) + 1;
+
+    vlc_mutex_lock( &p_cache->lock );
+    if( LockFile( p_cache->fd, F_WRLCK ) )
+    {
+        vlc_mutex_unlock( &p_cache->lock );
+        free( psz_uri );
+        return;
+    }
+
+    /* Reuse the slot of the URI or a free one, or evict the oldest */
+    metacache_slot_t *p_slot = NULL;
+    for( unsigned i_probe = 0; i_probe < METACACHE_PROBES; i_probe++ )
+    {
+        metacache_slot_t *p_probe = GetSlot( p_cache, i_hash, i_probe );
+        unsigned i_seq = atomic_load_explicit( &p_probe->i_seq,
+                                               memory_order_relaxed );
+
+        /* An odd counter is left by a writer that died: the slot is junk */
+        if( (i_seq & 1) || p_probe->i_length == 0
+         || ( p_probe->i_hash == i_hash
+           && p_probe->i_length >= sizeof(uint16_t) + i_uri
+           && !memcmp( &p_probe->data[sizeof(uint16_t)], psz_uri, i_uri ) ) )
+        {
+            p_slot = p_probe;
+            break;
+        }
+        if( p_slot == NULL || p_probe->i_stamp < p_slot->i_stamp )
+            p_slot = p_probe;
+    }
+
+    unsigned i_seq = atomic_load_explicit( &p_slot->i_seq,
+                                           memory_order_relaxed ) | 1;
+    atomic_store_explicit( &p_slot->i_seq, i_seq, memory_order_relaxed );
+    atomic_thread_fence( memory_order_release );
+
+    p_slot->i_length = b.i_offset;
+    p_slot->i_hash = i_hash;
+    p_slot->i_mtime = st.st_mtime;
+    p_slot->i_size = st.st_size;
+    p_slot->i_stamp = time( NULL );
+    memcpy( p_slot->data, record, b.i_offset );
+
+    atomic_store_explicit( &p_slot->i_seq, i_seq + 1, memory_order_release );
+
+    LockFile( p_cache->fd, F_UNLCK );
+    vlc_mutex_unlock( &p_cache->lock );
+    free( psz_uri );
+}
+
+#else /* !HAVE_MMAP */
+
+playlist_metacache_t *playlist_metacache_New( vlc_object_t *obj )
+{
+    if( var_InheritBool( obj, "preparse-cache" ) )
+        msg_Warn( obj, "preparse cache not supported on this system" );
+    return NULL;
+}
+
+void playlist_metacache_Delete( playlist_metacache_t *p_cache )
+{
+    (void) p_cache;
+    vlc_assert_unreachable();
+}
+
+int playlist_metacache_Load( playlist_metacache_t *p_cache,
+                             input_item_t *p_item )
+{
+    (void) p_cache; (void) p_item;
+    return VLC_EGENERIC;
+}
+
+void playlist_metacache_Store( playlist_metacache_t *p_cache,
+                               input_item_t *p_item )
+{
+    (void) p_cache; (void) p_item;
+}
+#endif
@@ -0,0 +1,59 @@
+/*****************************************************************************
+ * metacache.h: shared preparsing results cache
+ *****************************************************************************
+ * Copyright (C) 2015 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifndef _PLAYLIST_METACACHE_H
+#define _PLAYLIST_METACACHE_H 1
+
+#include <vlc_input_item.h>
+
+/**
+ * Preparsing results cache opaque structure.
+ *
+ * The cache keeps the meta data, duration and tracks of local files, keyed
+ * by URI, and invalidated when the file size or modification time change.
+ * It is stored in a memory mapped file, which several processes can use at
+ * the same time: lookups do not take any lock.
+ */
+typedef struct playlist_metacache_t playlist_metacache_t;
+
+/**
+ * Opens (or creates) the cache, if enabled by the "preparse-cache" option.
+ *
+ * @return the cache, or NULL if disabled or not available
+ */
+playlist_metacache_t *playlist_metacache_New( vlc_object_t * );
+
+void playlist_metacache_Delete( playlist_metacache_t * );
+
+/**
+ * Restores the preparsing results of an item, if they are cached and the
+ * file did not change since.
+ *
+ * @return VLC_SUCCESS if the item was found, an error code otherwise
+ */
+int playlist_metacache_Load( playlist_metacache_t *, input_item_t * );
+
+/**
+ * Stores the preparsing results of an item. Items that are not local files,
+ * or that have no tracks (e.g. playlists), are not stored.
+ */
+void playlist_metacache_Store( playlist_metacache_t *, input_item_t * );
+
+#endif
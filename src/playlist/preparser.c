@@ -34,24 +34,37 @@
 /*****************************************************************************
  * Structures/definitions
  *****************************************************************************/
+typedef enum
+{
+    QUEUE_PRIORITY = 0,
+    QUEUE_NORMAL
+} preparser_queue_t;
+#define QUEUE_COUNT 2
+
 typedef struct preparser_entry_t preparser_entry_t;
 
 struct preparser_entry_t
 {
     input_item_t    *p_item;
     input_item_meta_request_option_t i_options;
+    preparser_entry_t *p_next;
 };
 
 struct playlist_preparser_t
 {
     vlc_object_t        *object;
+    playlist_metacache_t *p_metacache;
     playlist_fetcher_t  *p_fetcher;
+    mtime_t              i_timeout;
+    unsigned             i_max_threads;
 
     vlc_mutex_t     lock;
     vlc_cond_t      wait;
-    bool            b_live;
-    preparser_entry_t  **pp_waiting;
-    int             i_waiting;
+    unsigned        i_live;   /* number of worker threads */
+    unsigned        i_active; /* number of workers processing an item */
+    unsigned        i_waiting;
+    preparser_entry_t *p_waiting_head[QUEUE_COUNT];
+    preparser_entry_t *p_waiting_tail[QUEUE_COUNT];
 };
 
 static void *Thread( void * );
@@ -66,40 +79,112 @@ playlist_preparser_t *playlist_preparser_New( vlc_object_t *parent )
         return NULL;
 
     p_preparser->object = parent;
-    p_preparser->p_fetcher = playlist_fetcher_New( parent );
+    p_preparser->p_metacache = playlist_metacache_New( parent );
+    p_preparser->p_fetcher = playlist_fetcher_New( parent,
+                                                   p_preparser->p_metacache );
     if( unlikely(p_preparser->p_fetcher == NULL) )
         msg_Err( parent, "cannot create fetcher" );
 
+    p_preparser->i_timeout =
+        var_InheritInteger( parent, "preparse-timeout" ) * (mtime_t)1000;
+    int i_threads = var_InheritInteger( parent, "preparse-threads" );
+    p_preparser->i_max_threads = i_threads > 0 ? i_threads : 1;
+
     vlc_mutex_init( &p_preparser->lock );
     vlc_cond_init( &p_preparser->wait );
-    p_preparser->b_live = false;
+    p_preparser->i_live = 0;
+    p_preparser->i_active = 0;
     p_preparser->i_waiting = 0;
-    p_preparser->pp_waiting = NULL;
+    for( int i = 0; i < QUEUE_COUNT; i++ )
+    {
+        p_preparser->p_waiting_head[i] = NULL;
+        p_preparser->p_waiting_tail[i] = NULL;
+    }
 
     return p_preparser;
 }
 
+static void QueueAppend( playlist_preparser_t *p_preparser,
+                         preparser_queue_t i_queue, preparser_entry_t *p_entry )
+{
+    p_entry->p_next = NULL;
+    if( p_preparser->p_waiting_head[i_queue] )
+        p_preparser->p_waiting_tail[i_queue]->p_next = p_entry;
+    else
+        p_preparser->p_waiting_head[i_queue] = p_entry;
+    p_preparser->p_waiting_tail[i_queue] = p_entry;
+}
+
+/**
+ * Removes the entry of an item from the normal queue, so that it can be
+ * requeued with priority. Returns NULL if the item is not queued.
+ */
+static preparser_entry_t *QueueUnlink( playlist_preparser_t *p_preparser,
+                                       input_item_t *p_item )
+{
+    preparser_entry_t **pp = &p_preparser->p_waiting_head[QUEUE_NORMAL];
+    preparser_entry_t *p_prev = NULL;
+
+    for( preparser_entry_t *p_entry = *pp; p_entry != NULL;
+         p_prev = p_entry, p_entry = p_entry->p_next )
+    {
+        if( p_entry->p_item != p_item )
+            continue;
+
+        if( p_prev )
+            p_prev->p_next = p_entry->p_next;
+        else
+            *pp = p_entry->p_next;
+        if( p_preparser->p_waiting_tail[QUEUE_NORMAL] == p_entry )
+            p_preparser->p_waiting_tail[QUEUE_NORMAL] = p_prev;
+        p_entry->p_next = NULL;
+        return p_entry;
+    }
+    return NULL;
+}
+
 void playlist_preparser_Push( playlist_preparser_t *p_preparser, input_item_t *p_item,
                               input_item_meta_request_option_t i_options )
 {
-    preparser_entry_t *p_entry = malloc( sizeof(preparser_entry_t) );
+    preparser_entry_t *p_entry;
+
+    vlc_mutex_lock( &p_preparser->lock );
+    if( i_options & META_REQUEST_OPTION_PRIORITY )
+    {
+        /* Bump an already queued item instead of preparsing it twice */
+        p_entry = QueueUnlink( p_preparser, p_item );
+        if( p_entry )
+        {
+            p_entry->i_options |= i_options;
+            QueueAppend( p_preparser, QUEUE_PRIORITY, p_entry );
+            vlc_mutex_unlock( &p_preparser->lock );
+            return;
+        }
+    }
 
+    p_entry = malloc( sizeof(preparser_entry_t) );
     if ( !p_entry )
+    {
+        vlc_mutex_unlock( &p_preparser->lock );
         return;
+    }
     p_entry->p_item = p_item;
     p_entry->i_options = i_options;
     vlc_gc_incref( p_entry->p_item );
 
-    vlc_mutex_lock( &p_preparser->lock );
-    INSERT_ELEM( p_preparser->pp_waiting, p_preparser->i_waiting,
-                 p_preparser->i_waiting, p_entry );
-    if( !p_preparser->b_live )
+    QueueAppend( p_preparser, (i_options & META_REQUEST_OPTION_PRIORITY)
+                              ? QUEUE_PRIORITY : QUEUE_NORMAL, p_entry );
+    p_preparser->i_waiting++;
+
+    /* Spawn a new worker if the idle ones cannot absorb the backlog */
+    if( p_preparser->i_live < p_preparser->i_max_threads
+     && p_preparser->i_waiting > p_preparser->i_live - p_preparser->i_active )
     {
         if( vlc_clone_detach( NULL, Thread, p_preparser,
                               VLC_THREAD_PRIORITY_LOW ) )
             msg_Warn( p_preparser->object, "cannot spawn pre-parser thread" );
         else
-            p_preparser->b_live = true;
+            p_preparser->i_live++;
     }
     vlc_mutex_unlock( &p_preparser->lock );
 }
@@ -115,15 +200,20 @@ void playlist_preparser_Delete( playlist_preparser_t *p_preparser )
 {
     vlc_mutex_lock( &p_preparser->lock );
     /* Remove pending item to speed up preparser thread exit */
-    while( p_preparser->i_waiting > 0 )
+    for( int i = 0; i < QUEUE_COUNT; i++ )
     {
-        preparser_entry_t *p_entry = p_preparser->pp_waiting[0];
-        vlc_gc_decref( p_entry->p_item );
-        free( p_entry );
-        REMOVE_ELEM( p_preparser->pp_waiting, p_preparser->i_waiting, 0 );
+        while( p_preparser->p_waiting_head[i] )
+        {
+            preparser_entry_t *p_entry = p_preparser->p_waiting_head[i];
+            p_preparser->p_waiting_head[i] = p_entry->p_next;
+            vlc_gc_decref( p_entry->p_item );
+            free( p_entry );
+        }
+        p_preparser->p_waiting_tail[i] = NULL;
     }
+    p_preparser->i_waiting = 0;
 
-    while( p_preparser->b_live )
+    while( p_preparser->i_live > 0 )
         vlc_cond_wait( &p_preparser->wait, &p_preparser->lock );
     vlc_mutex_unlock( &p_preparser->lock );
 
@@ -133,6 +223,8 @@ void playlist_preparser_Delete( playlist_preparser_t *p_preparser )
 
     if( p_preparser->p_fetcher != NULL )
         playlist_fetcher_Delete( p_preparser->p_fetcher );
+    if( p_preparser->p_metacache != NULL )
+        playlist_metacache_Delete( p_preparser->p_metacache );
     free( p_preparser );
 }
 
@@ -142,9 +234,11 @@ void playlist_preparser_Delete( playlist_preparser_t *p_preparser )
 /**
  * This function preparses an item when needed.
  */
-static void Preparse( vlc_object_t *obj, input_item_t *p_item,
+static void Preparse( playlist_preparser_t *p_preparser, input_item_t *p_item,
                       input_item_meta_request_option_t i_options )
 {
+    vlc_object_t *obj = p_preparser->object;
+
     vlc_mutex_lock( &p_item->lock );
     int i_type = p_item->i_type;
     vlc_mutex_unlock( &p_item->lock );
@@ -172,7 +266,17 @@ static void Preparse( vlc_object_t *obj, input_item_t *p_item,
     /* Do not preparse if it is already done (like by playing it) */
     if( !input_item_IsPreparsed( p_item ) )
     {
-        input_Preparse( obj, p_item );
+        playlist_metacache_t *p_metacache = p_preparser->p_metacache;
+
+        /* Reuse the results of a previous run, or of another process */
+        if( p_metacache == NULL
+         || playlist_metacache_Load( p_metacache, p_item ) != VLC_SUCCESS )
+        {
+            /* Only complete results are worth sharing */
+            if( input_Preparse( obj, p_item, p_preparser->i_timeout )
+                    == VLC_SUCCESS && p_metacache != NULL )
+                playlist_metacache_Store( p_metacache, p_item );
+        }
         input_item_SetPreparsed( p_item, true );
 
         var_SetAddress( obj, "item-change", p_item );
@@ -183,7 +287,8 @@ static void Preparse( vlc_object_t *obj, input_item_t *p_item,
 /**
  * This function ask the fetcher object to fetch the art when needed
  */
-static void Art( playlist_preparser_t *p_preparser, input_item_t *p_item )
+static void Art( playlist_preparser_t *p_preparser, input_item_t *p_item,
+                 input_item_meta_request_option_t i_options )
 {
     vlc_object_t *obj = p_preparser->object;
     playlist_fetcher_t *p_fetcher = p_preparser->p_fetcher;
@@ -218,7 +323,8 @@ static void Art( playlist_preparser_t *p_preparser, input_item_t *p_item )
     vlc_mutex_unlock( &p_item->lock );
 
     if( b_fetch && p_fetcher )
-        playlist_fetcher_Push( p_fetcher, p_item, 0 );
+        playlist_fetcher_Push( p_fetcher, p_item,
+                               i_options & META_REQUEST_OPTION_PRIORITY );
 }
 
 /**
@@ -227,27 +333,36 @@ static void Art( playlist_preparser_t *p_preparser, input_item_t *p_item )
 static void *Thread( void *data )
 {
     playlist_preparser_t *p_preparser = data;
-    vlc_object_t *obj = p_preparser->object;
 
     for( ;; )
     {
-        input_item_t *p_current;
+        input_item_t *p_current = NULL;
         input_item_meta_request_option_t i_options;
 
         /* */
         vlc_mutex_lock( &p_preparser->lock );
-        if( p_preparser->i_waiting > 0 )
+        for( int i = 0; i < QUEUE_COUNT; i++ )
         {
-            preparser_entry_t *p_entry = p_preparser->pp_waiting[0];
+            preparser_entry_t *p_entry = p_preparser->p_waiting_head[i];
+            if( p_entry == NULL )
+                continue;
+
+            p_preparser->p_waiting_head[i] = p_entry->p_next;
+            if( p_entry->p_next == NULL )
+                p_preparser->p_waiting_tail[i] = NULL;
+            p_preparser->i_waiting--;
+
             p_current = p_entry->p_item;
             i_options = p_entry->i_options;
             free( p_entry );
-            REMOVE_ELEM( p_preparser->pp_waiting, p_preparser->i_waiting, 0 );
+            break;
         }
+
+        if( p_current )
+            p_preparser->i_active++;
         else
         {
-            p_current = NULL;
-            p_preparser->b_live = false;
+            p_preparser->i_live--;
             vlc_cond_signal( &p_preparser->wait );
         }
         vlc_mutex_unlock( &p_preparser->lock );
@@ -255,11 +370,14 @@ static void *Thread( void *data )
         if( !p_current )
             break;
 
-        Preparse( obj, p_current, i_options );
+        Preparse( p_preparser, p_current, i_options );
 
-        Art( p_preparser, p_current );
+        Art( p_preparser, p_current, i_options );
         vlc_gc_decref(p_current);
+
+        vlc_mutex_lock( &p_preparser->lock );
+        p_preparser->i_active--;
+        vlc_mutex_unlock( &p_preparser->lock );
     }
     return NULL;
 }
-
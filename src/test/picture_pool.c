@@ -32,6 +32,10 @@
 
 #define PICTURES 10
 
+#define BENCH_PICTURES 32
+#define BENCH_THREADS  4
+#define BENCH_ROUNDS   200000
+
 static video_format_t fmt;
 static picture_pool_t *pool, *reserve;
 
@@ -49,6 +53,7 @@ static void test(bool zombie)
 
     for (unsigned i = 0; i < PICTURES; i++)
         assert(picture_pool_Get(pool) == NULL);
+    assert(picture_pool_GetInFlight(pool) == PICTURES);
 
     // Reserve currently assumes that all pictures are free (or reserved).
     //assert(picture_pool_Reserve(pool, 1) == NULL);
@@ -66,9 +71,11 @@ static void test(bool zombie)
 
     for (unsigned i = 0; i < PICTURES; i++)
         picture_Release(pics[i]);
+    assert(picture_pool_GetInFlight(pool) == 0);
 
     reserve = picture_pool_Reserve(pool, PICTURES / 2);
     assert(reserve != NULL);
+    assert(picture_pool_GetInFlight(pool) == PICTURES / 2);
 
     for (unsigned i = 0; i < PICTURES / 2; i++) {
         pics[i] = picture_pool_Get(pool);
@@ -80,6 +87,8 @@ static void test(bool zombie)
         pics[i] = picture_pool_Get(reserve);
         assert(pics[i] != NULL);
     }
+    assert(picture_pool_GetInFlight(pool) == PICTURES);
+    assert(picture_pool_GetInFlight(reserve) == PICTURES - PICTURES / 2);
 
     if (!zombie)
         for (unsigned i = 0; i < PICTURES; i++)
@@ -93,6 +102,115 @@ static void test(bool zombie)
             picture_Release(pics[i]);
 }
 
+struct picture_sys_t
+{
+    bool busy;
+};
+
+static int test_lock(picture_t *pic)
+{
+    return pic->p_sys->busy ? VLC_EGENERIC : VLC_SUCCESS;
+}
+
+static void test_unlock(picture_t *pic)
+{
+    (void) pic;
+}
+
+static void test_reserve_lock(bool with_unlock)
+{
+    picture_sys_t *sys[PICTURES];
+    picture_t *pics[PICTURES];
+
+    for (unsigned i = 0; i < PICTURES; i++) {
+        /* freed along with the picture */
+        sys[i] = malloc(sizeof (*sys[i]));
+        assert(sys[i] != NULL);
+        sys[i]->busy = false;
+
+        picture_resource_t res = { .p_sys = sys[i] };
+        pics[i] = picture_NewFromResource(&fmt, &res);
+        assert(pics[i] != NULL);
+    }
+
+    picture_pool_configuration_t cfg = {
+        .picture_count = PICTURES,
+        .picture = pics,
+        .lock = test_lock,
+        .unlock = with_unlock ? test_unlock : NULL,
+    };
+
+    pool = picture_pool_NewExtended(&cfg);
+    assert(pool != NULL);
+    reserve = picture_pool_Reserve(pool, 1);
+    assert(reserve != NULL);
+
+    picture_t *pic = picture_pool_Get(reserve);
+    assert(pic != NULL);
+    picture_Release(pic);
+
+    /* A lock without unlock also applies to the reserved pictures */
+    for (unsigned i = 0; i < PICTURES; i++)
+        sys[i]->busy = true;
+    pic = picture_pool_Get(reserve);
+    assert((pic != NULL) == with_unlock);
+    if (pic != NULL)
+        picture_Release(pic);
+    assert(picture_pool_Get(pool) == NULL);
+
+    picture_pool_Release(reserve);
+    picture_pool_Release(pool);
+}
+
+static void *bench_thread(void *data)
+{
+    picture_pool_t *p = data;
+    picture_t *pics[BENCH_PICTURES / BENCH_THREADS];
+
+    for (unsigned i = 0; i < BENCH_ROUNDS; i++) {
+        /* Hold a few pictures at a time, like a frame-threaded decoder */
+        unsigned n = 1 + i % (BENCH_PICTURES / BENCH_THREADS);
+
+        for (unsigned j = 0; j < n; j++) {
+            pics[j] = picture_pool_Get(p);
+            assert(pics[j] != NULL);
+        }
+        for (unsigned j = 0; j < n; j++)
+            picture_Release(pics[j]);
+    }
+    return NULL;
+}
+
+static void bench(void)
+{
+    vlc_thread_t threads[BENCH_THREADS];
+
+    pool = picture_pool_NewFromFormat(&fmt, BENCH_PICTURES);
+    assert(pool != NULL);
+
+    mtime_t start = mdate();
+
+    for (unsigned i = 0; i < BENCH_THREADS; i++)
+        if (vlc_clone(&threads[i], bench_thread, pool,
+                      VLC_THREAD_PRIORITY_LOW))
+            abort();
+    for (unsigned i = 0; i < BENCH_THREADS; i++)
+        vlc_join(threads[i], NULL);
+
+    mtime_t elapsed = mdate() - start;
+    unsigned long ops = 0;
+
+    for (unsigned i = 0; i < BENCH_ROUNDS; i++)
+        ops += 1 + i % (BENCH_PICTURES / BENCH_THREADS);
+    ops *= BENCH_THREADS;
+
+    printf("%lu pictures in %"PRId64" us (%"PRId64" ns per get/release)\n",
+           ops, elapsed, elapsed * 1000 / (mtime_t)ops);
+
+    assert(picture_pool_GetInFlight(pool) == 0);
+    picture_pool_Release(pool);
+}
+
 int main(void)
 {
     video_format_Setup(&fmt, VLC_CODEC_I420, 320, 200, 320, 200, 1, 1);
@@ -109,6 +227,11 @@ int main(void)
 
     test(false);
     test(true);
+    test_reserve_lock(false);
+    test_reserve_lock(true);
+
+    if (getenv("VLC_PICTURE_POOL_BENCH") != NULL)
+        bench();
 
     return 0;
 }
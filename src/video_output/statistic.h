@@ -24,6 +24,10 @@
 #ifndef LIBVLC_VOUT_STATISTIC_H
 # define LIBVLC_VOUT_STATISTIC_H
 # include <vlc_atomic.h>
+# include <vlc_input_item.h>
+
+/* Number of queued pictures whose queueing date is remembered */
+#define VOUT_STATISTIC_QUEUE 32
 
 /* NOTE: Both statistics are atomic on their own, so one might be older than
  * the other one. Currently, only one of them is updated at a time, so this
@@ -31,23 +35,45 @@
 typedef struct {
     atomic_uint displayed;
     atomic_uint lost;
+
+    /* Picture age at display, protected by lock */
+    vlc_mutex_t lock;
+    struct {
+        mtime_t date;
+        mtime_t queued;
+    } queue[VOUT_STATISTIC_QUEUE];
+    unsigned queue_index;
+    input_histogram_t age;
 } vout_statistic_t;
 
 static inline void vout_statistic_Init(vout_statistic_t *stat)
 {
     atomic_init(&stat->displayed, 0);
     atomic_init(&stat->lost, 0);
+    vlc_mutex_init(&stat->lock);
+    for (unsigned i = 0; i < VOUT_STATISTIC_QUEUE; i++)
+        stat->queue[i].date = VLC_TS_INVALID;
+    stat->queue_index = 0;
+    memset(&stat->age, 0, sizeof(stat->age));
 }
 
 static inline void vout_statistic_Clean(vout_statistic_t *stat)
 {
-    (void) stat;
+    vlc_mutex_destroy(&stat->lock);
 }
 
-static inline void vout_statistic_GetReset(vout_statistic_t *stat, int *displayed, int *lost)
+static inline void vout_statistic_GetReset(vout_statistic_t *stat, int *displayed, int *lost,
+                                           input_histogram_t *age)
 {
     *displayed = atomic_exchange(&stat->displayed, 0);
     *lost      = atomic_exchange(&stat->lost, 0);
+
+    if (age) {
+        vlc_mutex_lock(&stat->lock);
+        input_histogram_Merge(age, &stat->age);
+        memset(&stat->age, 0, sizeof(stat->age));
+        vlc_mutex_unlock(&stat->lock);
+    }
 }
 
 static inline void vout_statistic_AddDisplayed(vout_statistic_t *stat,
@@ -61,4 +87,31 @@ static inline void vout_statistic_AddLost(vout_statistic_t *stat, int lost)
     atomic_fetch_add(&stat->lost, lost);
 }
 
+/* Remembers when a picture of the given date was handed to the vout */
+static inline void vout_statistic_AddQueued(vout_statistic_t *stat,
+                                            mtime_t date, mtime_t now)
+{
+    vlc_mutex_lock(&stat->lock);
+    stat->queue[stat->queue_index].date   = date;
+    stat->queue[stat->queue_index].queued = now;
+    stat->queue_index = (stat->queue_index + 1) % VOUT_STATISTIC_QUEUE;
+    vlc_mutex_unlock(&stat->lock);
+}
+
+/* Accounts the age of the picture of the given date when displayed. Pictures
+ * created by the filters (e.g. field doubling) have no match and are ignored. */
+static inline void vout_statistic_AddAge(vout_statistic_t *stat,
+                                         mtime_t date, mtime_t now)
+{
+    vlc_mutex_lock(&stat->lock);
+    for (unsigned i = 0; i < VOUT_STATISTIC_QUEUE; i++) {
+        if (stat->queue[i].date == date) {
+            input_histogram_Add(&stat->age, now - stat->queue[i].queued);
+            stat->queue[i].date = VLC_TS_INVALID;
+            break;
+        }
+    }
+    vlc_mutex_unlock(&stat->lock);
+}
+
 #endif
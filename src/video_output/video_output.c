@@ -309,9 +309,10 @@ void vout_ChangePause(vout_thread_t *vout, bool is_paused, mtime_t date)
     vout_control_WaitEmpty(&vout->p->control);
 }
 
-void vout_GetResetStatistic(vout_thread_t *vout, int *displayed, int *lost)
+void vout_GetResetStatistic(vout_thread_t *vout, int *displayed, int *lost,
+                            input_histogram_t *age)
 {
-    vout_statistic_GetReset( &vout->p->statistic, displayed, lost );
+    vout_statistic_GetReset( &vout->p->statistic, displayed, lost, age );
 }
 
 void vout_Flush(vout_thread_t *vout, mtime_t date)
@@ -344,16 +345,15 @@ void vout_FixLeaks( vout_thread_t *vout )
 
     }
 
-    picture = picture_pool_Get(vout->p->decoder_pool);
+    picture_pool_t *pool = vout->p->decoder_pool;
 
-    if (picture != NULL)
-        picture_Release(picture); /* Not all pictures are referenced */
-    else {
-        /* There are no reasons that no pictures are available, force one
-         * from the pool, be careful with it though */
-        msg_Err(vout, "pictures leaked, trying to workaround");
-        picture_pool_NonEmpty(vout->p->decoder_pool);
-    }
+    if (picture_pool_GetInFlight(pool) < picture_pool_GetSize(pool))
+        return; /* Not all pictures are referenced */
+
+    /* There are no reasons that no pictures are available, force one
+     * from the pool, be careful with it though */
+    msg_Err(vout, "pictures leaked, trying to workaround");
+    picture_pool_NonEmpty(pool);
 }
 
 void vout_NextPicture(vout_thread_t *vout, mtime_t *duration)
@@ -428,6 +428,8 @@ picture_t *vout_GetPicture(vout_thread_t *vout)
 void vout_PutPicture(vout_thread_t *vout, picture_t *picture)
 {
     picture->p_next = NULL;
+    if (libvlc_stats(vout))
+        vout_statistic_AddQueued(&vout->p->statistic, picture->date, mdate());
     picture_fifo_Push(vout->p->decoder_fifo, picture);
 
     vout_control_Wake(&vout->p->control);
@@ -1015,6 +1017,9 @@ static int ThreadDisplayRenderPicture(vout_thread_t *vout, bool is_forced)
 
     /* Display the direct buffer returned by vout_RenderPicture */
     vout->p->displayed.date = mdate();
+    if (libvlc_stats(vout))
+        vout_statistic_AddAge(&vout->p->statistic, todisplay->date,
+                              vout->p->displayed.date);
     vout_display_Display(vd,
                          sys->display.filtered ? sys->display.filtered
                                                 : todisplay,
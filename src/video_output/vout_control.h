@@ -25,6 +25,8 @@
 #ifndef LIBVLC_VOUT_CONTROL_H
 #define LIBVLC_VOUT_CONTROL_H 1
 
+#include <vlc_input_item.h>
+
 /**
  * This function will (un)pause the display of pictures.
  * It is thread safe
@@ -38,8 +40,12 @@ void spu_OffsetSubtitleDate( spu_t *p_spu, mtime_t i_duration );
 
 /**
  * This function will return and reset internal statistics.
+ *
+ * If p_age is not NULL, the ages of the displayed pictures (time between
+ * vout_PutPicture and display) are merged into it.
  */
-void vout_GetResetStatistic( vout_thread_t *p_vout, int *pi_displayed, int *pi_lost );
+void vout_GetResetStatistic( vout_thread_t *p_vout, int *pi_displayed, int *pi_lost,
+                             input_histogram_t *p_age );
 
 /**
  * This function will ensure that all ready/displayed pciture have at most
@@ -0,0 +1,184 @@
+/*
+ * event_async.c - libvlc asynchronous event queue test
+ */
+
+/**********************************************************************
+ *  This program is free software; you can redistribute and/or modify *
+ *  it under the terms of the GNU General Public License as published *
+ *  by the Free Software Foundation; version 2 of the license, or (at *
+ *  your option) any later version.                                   *
+ *                                                                    *
+ *  This program is distributed in the hope that it will be useful,   *
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of    *
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.              *
+ *  See the GNU General Public License for more details.              *
+ *                                                                    *
+ *  You should have received a copy of the GNU General Public License *
+ *  along with this program; if not, you can get it from:             *
+ *  http://www.gnu.org/copyleft/gpl.html                              *
+ **********************************************************************/
+
+/* The asynchronous listeners are internal to LibVLC: this test is built
+ * with the event manager sources rather than linked with LibVLC. */
+
+#include "test.h"
+#include "../lib/libvlc_internal.h"
+#include "../lib/event_internal.h"
+
+#include <pthread.h>
+
+/* The event manager only needs these from the rest of LibVLC */
+const char *libvlc_printerr (const char *fmt, ...)
+{
+    return fmt;
+}
+
+void libvlc_retain (libvlc_instance_t *vlc)
+{
+    (void) vlc;
+}
+
+void libvlc_release (libvlc_instance_t *vlc)
+{
+    (void) vlc;
+}
+
+struct coalesce
+{
+    pthread_mutex_t lock;
+    pthread_cond_t wait;
+    bool entered;
+    bool open;
+    unsigned position_calls;
+    float positions[2];
+    unsigned time_calls;
+    libvlc_time_t time;
+    unsigned title_calls;
+};
+
+static void position_changed (const libvlc_event_t *event, void *data)
+{
+    struct coalesce *c = data;
+
+    pthread_mutex_lock (&c->lock);
+    if (c->position_calls < 2)
+        c->positions[c->position_calls] =
+            event->u.media_player_position_changed.new_position;
+    c->position_calls++;
+
+    /* Hold the asynchronous thread while the events pile up */
+    c->entered = true;
+    pthread_cond_broadcast (&c->wait);
+    while (!c->open)
+        pthread_cond_wait (&c->wait, &c->lock);
+    pthread_mutex_unlock (&c->lock);
+}
+
+static void time_changed (const libvlc_event_t *event, void *data)
+{
+    struct coalesce *c = data;
+
+    pthread_mutex_lock (&c->lock);
+    c->time_calls++;
+    c->time = event->u.media_player_time_changed.new_time;
+    pthread_mutex_unlock (&c->lock);
+}
+
+static void title_changed (const libvlc_event_t *event, void *data)
+{
+    struct coalesce *c = data;
+
+    (void) event;
+    pthread_mutex_lock (&c->lock);
+    c->title_calls++;
+    pthread_cond_broadcast (&c->wait);
+    pthread_mutex_unlock (&c->lock);
+}
+
+/* Position and time changes pending for an asynchronous listener are
+ * superseded by the latest one, other events are all delivered */
+static void test_coalescing (void)
+{
+    struct coalesce c = {
+        .lock = PTHREAD_MUTEX_INITIALIZER,
+        .wait = PTHREAD_COND_INITIALIZER,
+    };
+    libvlc_event_manager_t *em;
+    libvlc_event_t event;
+
+    log ("Testing asynchronous event coalescing\n");
+
+    em = libvlc_event_manager_new (&c, NULL);
+    assert (em != NULL);
+    libvlc_event_manager_register_event_type (em,
+                                        libvlc_MediaPlayerPositionChanged);
+    libvlc_event_manager_register_event_type (em,
+                                        libvlc_MediaPlayerTimeChanged);
+    libvlc_event_manager_register_event_type (em,
+                                        libvlc_MediaPlayerTitleChanged);
+
+    libvlc_event_attach_async (em, libvlc_MediaPlayerPositionChanged,
+                               position_changed, &c);
+    libvlc_event_attach_async (em, libvlc_MediaPlayerTimeChanged,
+                               time_changed, &c);
+    libvlc_event_attach_async (em, libvlc_MediaPlayerTitleChanged,
+                               title_changed, &c);
+
+    event.type = libvlc_MediaPlayerPositionChanged;
+    event.u.media_player_position_changed.new_position = 0.f;
+    libvlc_event_send (em, &event);
+
+    pthread_mutex_lock (&c.lock);
+    while (!c.entered)
+        pthread_cond_wait (&c.wait, &c.lock);
+    pthread_mutex_unlock (&c.lock);
+
+    for (unsigned i = 1; i <= 100; i++)
+    {
+        event.type = libvlc_MediaPlayerPositionChanged;
+        event.u.media_player_position_changed.new_position = i;
+        libvlc_event_send (em, &event);
+        event.type = libvlc_MediaPlayerTimeChanged;
+        event.u.media_player_time_changed.new_time = i;
+        libvlc_event_send (em, &event);
+        if (i % 10 == 0)
+        {
+            event.type = libvlc_MediaPlayerTitleChanged;
+            event.u.media_player_title_changed.new_title = i / 10;
+            libvlc_event_send (em, &event);
+        }
+    }
+
+    /* The last title change is queued after the coalesced events */
+    pthread_mutex_lock (&c.lock);
+    c.open = true;
+    pthread_cond_broadcast (&c.wait);
+    while (c.title_calls < 10)
+        pthread_cond_wait (&c.wait, &c.lock);
+    pthread_mutex_unlock (&c.lock);
+
+    assert (c.position_calls == 2);
+    assert (c.positions[0] == 0.f && c.positions[1] == 100.f);
+    assert (c.time_calls == 1);
+    assert (c.time == 100);
+    assert (c.title_calls == 10);
+
+    libvlc_event_detach (em, libvlc_MediaPlayerTitleChanged,
+                         title_changed, &c);
+    libvlc_event_detach (em, libvlc_MediaPlayerTimeChanged,
+                         time_changed, &c);
+    libvlc_event_detach (em, libvlc_MediaPlayerPositionChanged,
+                         position_changed, &c);
+    libvlc_event_manager_release (em);
+}
+
+int main (void)
+{
+    test_init ();
+    libvlc_event_threads_init ();
+
+    test_coalescing ();
+
+    libvlc_event_threads_deinit ();
+    return 0;
+}
@@ -0,0 +1,281 @@
+/*
+ * events.c - libvlc event dispatch test and benchmark
+ */
+
+/**********************************************************************
+ *  This program is free software; you can redistribute and/or modify *
+ *  it under the terms of the GNU General Public License as published *
+ *  by the Free Software Foundation; version 2 of the license, or (at *
+ *  your option) any later version.                                   *
+ *                                                                    *
+ *  This program is distributed in the hope that it will be useful,   *
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of    *
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.              *
+ *  See the GNU General Public License for more details.              *
+ *                                                                    *
+ *  You should have received a copy of the GNU General Public License *
+ *  along with this program; if not, you can get it from:             *
+ *  http://www.gnu.org/copyleft/gpl.html                              *
+ **********************************************************************/
+
+#include "test.h"
+
+#include <inttypes.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdatomic.h>
+#include <time.h>
+
+#define PLAYERS 100
+#define ROUNDS  2000
+
+#define SENDERS      8
+#define SEND_ROUNDS  5000
+#define CHURNERS     4
+
+struct player
+{
+    libvlc_media_player_t *mp;
+    libvlc_media_t *md;
+    pthread_t thread;
+    unsigned changes;
+    unsigned detached_calls;
+};
+
+static void media_changed (const libvlc_event_t *event, void *data)
+{
+    struct player *p = data;
+
+    assert (event->type == libvlc_MediaPlayerMediaChanged);
+    p->changes++;
+}
+
+/* Detaches itself from within the callback: it must not be called again */
+static void detach_self (const libvlc_event_t *event, void *data)
+{
+    struct player *p = data;
+    libvlc_event_manager_t *em = libvlc_media_player_event_manager (p->mp);
+
+    (void) event;
+    p->detached_calls++;
+    libvlc_event_detach (em, libvlc_MediaPlayerMediaChanged, detach_self, p);
+}
+
+static void *run (void *data)
+{
+    struct player *p = data;
+
+    for (unsigned i = 0; i < ROUNDS; i++)
+        libvlc_media_player_set_media (p->mp, p->md);
+    return NULL;
+}
+
+static uint64_t now (void)
+{
+    struct timespec ts;
+
+    clock_gettime (CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * UINT64_C(1000000000) + ts.tv_nsec;
+}
+
+static void test_events (const char **argv, int argc)
+{
+    static struct player players[PLAYERS];
+    libvlc_instance_t *vlc;
+
+    log ("Testing event dispatch with %u players\n", PLAYERS);
+
+    vlc = libvlc_new (argc, argv);
+    assert (vlc != NULL);
+
+    for (unsigned i = 0; i < PLAYERS; i++)
+    {
+        struct player *p = &players[i];
+
+        p->md = libvlc_media_new_path (vlc, test_default_sample);
+        assert (p->md != NULL);
+        p->mp = libvlc_media_player_new (vlc);
+        assert (p->mp != NULL);
+
+        libvlc_event_manager_t *em = libvlc_media_player_event_manager (p->mp);
+        assert (!libvlc_event_attach (em, libvlc_MediaPlayerMediaChanged,
+                                      detach_self, p));
+        assert (!libvlc_event_attach (em, libvlc_MediaPlayerMediaChanged,
+                                      media_changed, p));
+    }
+
+    uint64_t start = now ();
+    for (unsigned i = 0; i < PLAYERS; i++)
+        assert (!pthread_create (&players[i].thread, NULL, run, &players[i]));
+    for (unsigned i = 0; i < PLAYERS; i++)
+        pthread_join (players[i].thread, NULL);
+    uint64_t elapsed = now () - start;
+
+    log ("%u events in %"PRIu64" us (%"PRIu64" ns per event)\n",
+         PLAYERS * ROUNDS, elapsed / 1000,
+         elapsed / (PLAYERS * ROUNDS));
+
+    for (unsigned i = 0; i < PLAYERS; i++)
+    {
+        struct player *p = &players[i];
+        libvlc_event_manager_t *em = libvlc_media_player_event_manager (p->mp);
+
+        assert (p->detached_calls == 1);
+        assert (p->changes == ROUNDS);
+        libvlc_event_detach (em, libvlc_MediaPlayerMediaChanged,
+                             media_changed, p);
+        libvlc_media_player_release (p->mp);
+        libvlc_media_release (p->md);
+    }
+
+    libvlc_release (vlc);
+}
+
+/* Many threads sending on a single event manager, while others attach and
+ * detach listeners, from outside and from within a callback */
+struct shared
+{
+    libvlc_media_player_t *mp;
+    libvlc_media_t *md;
+    libvlc_event_manager_t *em;
+    atomic_uint changes;
+    atomic_bool stop;
+};
+
+struct churn
+{
+    struct shared *s;
+    pthread_t thread;
+    atomic_bool alive;
+    unsigned calls;
+};
+
+static void count_changes (const libvlc_event_t *event, void *data)
+{
+    struct shared *s = data;
+
+    (void) event;
+    atomic_fetch_add (&s->changes, 1);
+}
+
+/* Must not be running once detached */
+static void check_alive (const libvlc_event_t *event, void *data)
+{
+    atomic_bool *alive = data;
+
+    (void) event;
+    assert (atomic_load (alive));
+    sched_yield (); /* let the detaching thread run */
+    assert (atomic_load (alive));
+}
+
+/* Attaches and detaches a listener from within the callback */
+static void nested_churn (const libvlc_event_t *event, void *data)
+{
+    struct shared *s = data;
+    atomic_bool alive;
+
+    (void) event;
+    atomic_init (&alive, true);
+    assert (!libvlc_event_attach (s->em, libvlc_MediaPlayerMediaChanged,
+                                  check_alive, &alive));
+    libvlc_event_detach (s->em, libvlc_MediaPlayerMediaChanged,
+                         check_alive, &alive);
+    atomic_store (&alive, false);
+}
+
+static void *send_changes (void *data)
+{
+    struct shared *s = data;
+
+    for (unsigned i = 0; i < SEND_ROUNDS; i++)
+        libvlc_media_player_set_media (s->mp, s->md);
+    return NULL;
+}
+
+static void *churn (void *data)
+{
+    struct churn *c = data;
+
+    while (!atomic_load (&c->s->stop))
+    {
+        atomic_store (&c->alive, true);
+        assert (!libvlc_event_attach (c->s->em, libvlc_MediaPlayerMediaChanged,
+                                      check_alive, &c->alive));
+        libvlc_event_detach (c->s->em, libvlc_MediaPlayerMediaChanged,
+                             check_alive, &c->alive);
+        atomic_store (&c->alive, false);
+        c->calls++;
+    }
+    return NULL;
+}
+
+static void test_shared (const char **argv, int argc)
+{
+    struct shared s;
+    struct churn churners[CHURNERS];
+    pthread_t senders[SENDERS];
+    libvlc_instance_t *vlc;
+
+    log ("Testing %u senders on a shared event manager\n", SENDERS);
+
+    vlc = libvlc_new (argc, argv);
+    assert (vlc != NULL);
+
+    s.md = libvlc_media_new_path (vlc, test_default_sample);
+    assert (s.md != NULL);
+    s.mp = libvlc_media_player_new (vlc);
+    assert (s.mp != NULL);
+    s.em = libvlc_media_player_event_manager (s.mp);
+    atomic_init (&s.changes, 0);
+    atomic_init (&s.stop, false);
+    assert (!libvlc_event_attach (s.em, libvlc_MediaPlayerMediaChanged,
+                                  count_changes, &s));
+    assert (!libvlc_event_attach (s.em, libvlc_MediaPlayerMediaChanged,
+                                  nested_churn, &s));
+
+    for (unsigned i = 0; i < CHURNERS; i++)
+    {
+        churners[i].s = &s;
+        atomic_init (&churners[i].alive, false);
+        churners[i].calls = 0;
+        assert (!pthread_create (&churners[i].thread, NULL, churn,
+                                 &churners[i]));
+    }
+
+    uint64_t start = now ();
+    for (unsigned i = 0; i < SENDERS; i++)
+        assert (!pthread_create (&senders[i], NULL, send_changes, &s));
+    for (unsigned i = 0; i < SENDERS; i++)
+        pthread_join (senders[i], NULL);
+    uint64_t elapsed = now () - start;
+
+    atomic_store (&s.stop, true);
+    for (unsigned i = 0; i < CHURNERS; i++)
+    {
+        pthread_join (churners[i].thread, NULL);
+        log ("churner %u: %u attach/detach cycles\n", i, churners[i].calls);
+    }
+
+    log ("%u events in %"PRIu64" us\n", SENDERS * SEND_ROUNDS,
+         elapsed / 1000);
+    assert (atomic_load (&s.changes) == SENDERS * SEND_ROUNDS);
+
+    libvlc_event_detach (s.em, libvlc_MediaPlayerMediaChanged,
+                         nested_churn, &s);
+    libvlc_event_detach (s.em, libvlc_MediaPlayerMediaChanged,
+                         count_changes, &s);
+    libvlc_media_player_release (s.mp);
+    libvlc_media_release (s.md);
+    libvlc_release (vlc);
+}
+
+int main (void)
+{
+    test_init ();
+
+    test_events (test_defaults_args, test_defaults_nargs);
+    test_shared (test_defaults_args, test_defaults_nargs);
+
+    return 0;
+}
@@ -0,0 +1,615 @@
+/*****************************************************************************
+ * mp4.c: test and benchmark the MP4 demuxer sample tables
+ *****************************************************************************
+ * Copyright (C) 2015 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#include "../../libvlc/test.h"
+#include "../lib/libvlc_internal.h"
+
+#include <string.h>
+#include <sys/resource.h>
+
+#include <vlc_common.h>
+#include <vlc_demux.h>
+#include <vlc_es_out.h>
+#include <vlc_modules.h>
+#include <vlc_url.h>
+
+#define TEST_SAMPLES  3000
+#define TEST_SEEKS    200
+#define BENCH_SAMPLES 2000000 /* about 500k chunks */
+#define TIMESCALE     30000
+#define SYNC_INTERVAL 30
+
+/*****************************************************************************
+ * Generated file
+ *
+ * Every table is drawn from its own pseudo-random sequence, so that it can
+ * be written out entry by entry and replayed to compute the expected
+ * timestamps. Each sample starts with its big endian index.
+ *****************************************************************************/
+typedef struct
+{
+    uint32_t i_samples;
+    bool     b_sizes; /* varying sample sizes */
+} layout_t;
+
+typedef struct
+{
+    uint32_t i_seed;
+    uint32_t i_left; /* samples left for the current entry */
+    uint32_t i_value;
+} run_t;
+
+enum { RUN_CHUNK, RUN_SIZE, RUN_STTS, RUN_CTTS };
+
+static uint32_t Rand( uint32_t *pi_seed, uint32_t i_max )
+{
+    *pi_seed = *pi_seed * 1103515245 + 12345;
+    return (*pi_seed >> 16) % i_max;
+}
+
+static void RunInit( run_t *p_run, int i_type )
+{
+    p_run->i_seed = 1 + i_type;
+    p_run->i_left = 0;
+}
+
+/* Draws the next entry of a table: its sample count and value */
+static uint32_t RunNext( run_t *p_run, int i_type, uint32_t *pi_value )
+{
+    static const uint32_t deltas[4] = { 1000, 1001, 1002, 2000 };
+    static const uint32_t offsets[4] = { 0, 1000, 2000, 3000 };
+
+    switch( i_type )
+    {
+        case RUN_CHUNK:
+            *pi_value = 1;
+            return 1 + Rand( &p_run->i_seed, 7 );
+        case RUN_SIZE:
+            *pi_value = 4 + Rand( &p_run->i_seed, 60 );
+            return 1;
+        case RUN_STTS:
+            *pi_value = deltas[Rand( &p_run->i_seed, 4 )];
+            return 1 + Rand( &p_run->i_seed, 40 );
+        default:
+            *pi_value = offsets[Rand( &p_run->i_seed, 4 )];
+            return 1 + Rand( &p_run->i_seed, 3 );
+    }
+}
+
+/* Returns the value of the next sample */
+static uint32_t RunSample( run_t *p_run, int i_type )
+{
+    if( p_run->i_left == 0 )
+        p_run->i_left = RunNext( p_run, i_type, &p_run->i_value );
+    p_run->i_left--;
+    return p_run->i_value;
+}
+
+static uint32_t SampleSize( const layout_t *p_layout, run_t *p_run )
+{
+    return p_layout->b_sizes ? RunSample( p_run, RUN_SIZE ) : 4;
+}
+
+static void W8( FILE *f, uint8_t i )
+{
+    putc( i, f );
+}
+
+static void W16( FILE *f, uint16_t i )
+{
+    W8( f, i >> 8 );
+    W8( f, i );
+}
+
+static void W32( FILE *f, uint32_t i )
+{
+    W16( f, i >> 16 );
+    W16( f, i );
+}
+
+static void WZero( FILE *f, unsigned i )
+{
+    while( i-- > 0 )
+        W8( f, 0 );
+}
+
+static void WMatrix( FILE *f )
+{
+    static const uint32_t matrix[9] = {
+        0x10000, 0, 0, 0, 0x10000, 0, 0, 0, 0x40000000
+    };
+    for( unsigned i = 0; i < 9; i++ )
+        W32( f, matrix[i] );
+}
+
+static long BoxStart( FILE *f, const char *psz_type )
+{
+    long i_start = ftell( f );
+    W32( f, 0 );
+    fwrite( psz_type, 1, 4, f );
+    return i_start;
+}
+
+static long FullBoxStart( FILE *f, const char *psz_type, uint32_t i_flags )
+{
+    long i_start = BoxStart( f, psz_type );
+    W32( f, i_flags );
+    return i_start;
+}
+
+/* Patches a 32 bits field written earlier */
+static void Patch( FILE *f, long i_offset, uint32_t i_value )
+{
+    long i_end = ftell( f );
+    fseek( f, i_offset, SEEK_SET );
+    W32( f, i_value );
+    fseek( f, i_end, SEEK_SET );
+}
+
+static void BoxEnd( FILE *f, long i_start )
+{
+    Patch( f, i_start, ftell( f ) - i_start );
+}
+
+/* Writes a run-length table (stts, ctts or stsc) */
+static void WriteRuns( FILE *f, const char *psz_type, int i_type,
+                       uint32_t i_samples )
+{
+    long i_box = FullBoxStart( f, psz_type, 0 );
+    long i_count = ftell( f );
+    uint32_t i_entries = 0;
+    run_t run;
+
+    W32( f, 0 );
+    RunInit( &run, i_type );
+    for( uint32_t i = 0; i < i_samples; i_entries++ )
+    {
+        uint32_t i_value;
+        uint32_t i_run = RunNext( &run, i_type, &i_value );
+        i_run = __MIN( i_run, i_samples - i );
+        if( i_type == RUN_CHUNK )
+        {
+            W32( f, i_entries + 1 ); /* first_chunk */
+            W32( f, i_run );         /* samples_per_chunk */
+            W32( f, 1 );             /* sample_description_index */
+        }
+        else
+        {
+            W32( f, i_run );
+            W32( f, i_value );
+        }
+        i += i_run;
+    }
+    Patch( f, i_count, i_entries );
+    BoxEnd( f, i_box );
+}
+
+static uint64_t Duration( uint32_t i_samples )
+{
+    uint64_t i_duration = 0;
+    run_t run;
+
+    RunInit( &run, RUN_STTS );
+    for( uint32_t i = 0; i < i_samples; i++ )
+        i_duration += RunSample( &run, RUN_STTS );
+    return i_duration;
+}
+
+/* ftyp, then mdat and moov at the end, as recorders write them */
+static bool Generate( const char *psz_path, const layout_t *p_layout )
+{
+    FILE *f = fopen( psz_path, "wb" );
+    if( f == NULL )
+        return false;
+
+    const uint32_t i_samples = p_layout->i_samples;
+    const uint64_t i_duration = Duration( i_samples );
+    run_t run;
+
+    long i_box = BoxStart( f, "ftyp" );
+    fwrite( "isom", 1, 4, f );
+    W32( f, 0 );
+    fwrite( "isom", 1, 4, f );
+    BoxEnd( f, i_box );
+
+    const long i_mdat = BoxStart( f, "mdat" );
+    RunInit( &run, RUN_SIZE );
+    for( uint32_t i = 0; i < i_samples; i++ )
+    {
+        uint32_t i_size = SampleSize( p_layout, &run );
+        W32( f, i );
+        for( uint32_t j = 4; j < i_size; j++ )
+            W8( f, i );
+    }
+    BoxEnd( f, i_mdat );
+
+    long i_moov = BoxStart( f, "moov" );
+
+    i_box = FullBoxStart( f, "mvhd", 0 );
+    W32( f, 0 ); W32( f, 0 ); /* creation and modification times */
+    W32( f, 1000 );
+    W32( f, i_duration * 1000 / TIMESCALE );
+    W32( f, 0x10000 ); W16( f, 0x100 ); /* rate and volume */
+    WZero( f, 10 );
+    WMatrix( f );
+    WZero( f, 24 );
+    W32( f, 2 ); /* next_track_ID */
+    BoxEnd( f, i_box );
+
+    long i_trak = BoxStart( f, "trak" );
+
+    i_box = FullBoxStart( f, "tkhd", 3 );
+    W32( f, 0 ); W32( f, 0 );
+    W32( f, 1 ); /* track_ID */
+    W32( f, 0 );
+    W32( f, i_duration * 1000 / TIMESCALE );
+    WZero( f, 16 );
+    WMatrix( f );
+    W32( f, 320 << 16 ); W32( f, 240 << 16 );
+    BoxEnd( f, i_box );
+
+    long i_mdia = BoxStart( f, "mdia" );
+
+    i_box = FullBoxStart( f, "mdhd", 0 );
+    W32( f, 0 ); W32( f, 0 );
+    W32( f, TIMESCALE );
+    W32( f, i_duration );
+    W16( f, 0x55c4 ); W16( f, 0 ); /* undetermined language */
+    BoxEnd( f, i_box );
+
+    i_box = FullBoxStart( f, "hdlr", 0 );
+    W32( f, 0 );
+    fwrite( "vide", 1, 4, f );
+    WZero( f, 12 );
+    fwrite( "v", 1, 2, f );
+    BoxEnd( f, i_box );
+
+    long i_minf = BoxStart( f, "minf" );
+
+    i_box = FullBoxStart( f, "vmhd", 1 );
+    WZero( f, 8 );
+    BoxEnd( f, i_box );
+
+    long i_dinf = BoxStart( f, "dinf" );
+    i_box = FullBoxStart( f, "dref", 0 );
+    W32( f, 1 );
+    BoxEnd( f, FullBoxStart( f, "url ", 1 ) );
+    BoxEnd( f, i_box );
+    BoxEnd( f, i_dinf );
+
+    long i_stbl = BoxStart( f, "stbl" );
+
+    i_box = FullBoxStart( f, "stsd", 0 );
+    W32( f, 1 );
+    long i_entry = BoxStart( f, "jpeg" );
+    WZero( f, 6 ); W16( f, 1 ); /* data_reference_index */
+    WZero( f, 16 );
+    W16( f, 320 ); W16( f, 240 );
+    W32( f, 0x480000 ); W32( f, 0x480000 ); /* resolution */
+    W32( f, 0 ); W16( f, 1 ); /* frame_count */
+    WZero( f, 32 );
+    W16( f, 24 ); W16( f, 0xffff ); /* depth, color table */
+    BoxEnd( f, i_entry );
+    BoxEnd( f, i_box );
+
+    WriteRuns( f, "stts", RUN_STTS, i_samples );
+    WriteRuns( f, "ctts", RUN_CTTS, i_samples );
+
+    i_box = FullBoxStart( f, "stss", 0 );
+    W32( f, (i_samples + SYNC_INTERVAL - 1) / SYNC_INTERVAL );
+    for( uint32_t i = 0; i < i_samples; i += SYNC_INTERVAL )
+        W32( f, i + 1 );
+    BoxEnd( f, i_box );
+
+    WriteRuns( f, "stsc", RUN_CHUNK, i_samples );
+
+    i_box = FullBoxStart( f, "stsz", 0 );
+    W32( f, 0 );
+    W32( f, i_samples );
+    RunInit( &run, RUN_SIZE );
+    for( uint32_t i = 0; i < i_samples; i++ )
+        W32( f, SampleSize( p_layout, &run ) );
+    BoxEnd( f, i_box );
+
+    /* Chunk offsets, replaying the chunk and size sequences */
+    i_box = FullBoxStart( f, "stco", 0 );
+    long i_count = ftell( f );
+    uint32_t i_chunks = 0;
+    uint32_t i_offset = i_mdat + 8;
+    run_t chunks, sizes;
+
+    W32( f, 0 );
+    RunInit( &chunks, RUN_CHUNK );
+    RunInit( &sizes, RUN_SIZE );
+    for( uint32_t i = 0; i < i_samples; i_chunks++ )
+    {
+        uint32_t i_unused;
+        uint32_t i_run = RunNext( &chunks, RUN_CHUNK, &i_unused );
+        i_run = __MIN( i_run, i_samples - i );
+        W32( f, i_offset );
+        for( uint32_t j = 0; j < i_run; j++ )
+            i_offset += SampleSize( p_layout, &sizes );
+        i += i_run;
+    }
+    Patch( f, i_count, i_chunks );
+    BoxEnd( f, i_box );
+
+    BoxEnd( f, i_stbl );
+    BoxEnd( f, i_minf );
+    BoxEnd( f, i_mdia );
+    BoxEnd( f, i_trak );
+    BoxEnd( f, i_moov );
+
+    bool b_ok = !ferror( f );
+    if( fclose( f ) )
+        b_ok = false;
+    return b_ok;
+}
+
+/*****************************************************************************
+ * Demuxer
+ *****************************************************************************/
+struct es_out_sys_t
+{
+    unsigned i_blocks;
+    uint32_t i_sample;
+    mtime_t  i_dts;
+    mtime_t  i_pts;
+};
+
+static es_out_id_t *EsOutAdd( es_out_t *out, const es_format_t *fmt )
+{
+    assert( fmt->i_cat == VIDEO_ES );
+    return (es_out_id_t *)out->p_sys;
+}
+
+static int EsOutSend( es_out_t *out, es_out_id_t *id, block_t *p_block )
+{
+    es_out_sys_t *p_sys = out->p_sys;
+
+    assert( id == (es_out_id_t *)p_sys );
+    assert( p_block->i_buffer >= 4 );
+    p_sys->i_blocks++;
+    p_sys->i_sample = GetDWBE( p_block->p_buffer );
+    p_sys->i_dts = p_block->i_dts;
+    p_sys->i_pts = p_block->i_pts;
+    block_Release( p_block );
+    return VLC_SUCCESS;
+}
+
+static void EsOutDel( es_out_t *out, es_out_id_t *id )
+{
+    (void) out; (void) id;
+}
+
+static int EsOutControl( es_out_t *out, int i_query, va_list args )
+{
+    (void) out;
+    if( i_query == ES_OUT_GET_ES_STATE )
+    {
+        (void) va_arg( args, es_out_id_t * );
+        *va_arg( args, bool * ) = true;
+    }
+    return VLC_SUCCESS;
+}
+
+static demux_t *DemuxOpen( libvlc_int_t *p_libvlc, const char *psz_path,
+                           es_out_t *out )
+{
+    demux_t *p_demux = vlc_object_create( p_libvlc, sizeof(*p_demux) );
+    assert( p_demux != NULL );
+
+    p_demux->psz_access = strdup( "file" );
+    p_demux->psz_demux = strdup( "mp4" );
+    p_demux->psz_location = strdup( psz_path );
+    p_demux->psz_file = strdup( psz_path );
+    p_demux->out = out;
+
+    char *psz_url = vlc_path2uri( psz_path, NULL );
+    assert( psz_url != NULL );
+    p_demux->s = stream_UrlNew( p_demux, psz_url );
+    free( psz_url );
+    assert( p_demux->s != NULL );
+
+    p_demux->p_module = module_need( p_demux, "demux", "mp4", true );
+    assert( p_demux->p_module != NULL );
+    return p_demux;
+}
+
+static void DemuxClose( demux_t *p_demux )
+{
+    module_unneed( p_demux, p_demux->p_module );
+    stream_Delete( p_demux->s );
+    free( p_demux->psz_access );
+    free( p_demux->psz_demux );
+    free( p_demux->psz_location );
+    free( p_demux->psz_file );
+    vlc_object_release( p_demux );
+}
+
+static int DemuxControl( demux_t *p_demux, int i_query, ... )
+{
+    va_list args;
+    va_start( args, i_query );
+    int i_ret = p_demux->pf_control( p_demux, i_query, args );
+    va_end( args );
+    return i_ret;
+}
+
+/* Demuxes until the next sample comes out; false at the end of the file */
+static bool DemuxSample( demux_t *p_demux, es_out_sys_t *p_out )
+{
+    unsigned i_blocks = p_out->i_blocks;
+
+    while( p_out->i_blocks == i_blocks )
+        if( p_demux->pf_demux( p_demux ) != VLC_DEMUXER_SUCCESS )
+            return false;
+    assert( p_out->i_blocks == i_blocks + 1 );
+    return true;
+}
+
+/*****************************************************************************
+ * Test
+ *****************************************************************************/
+static void Test( libvlc_int_t *p_libvlc, const char *psz_path )
+{
+    const layout_t layout = { TEST_SAMPLES, true };
+    mtime_t *pi_dts = malloc( TEST_SAMPLES * sizeof(*pi_dts) );
+    mtime_t *pi_pts = malloc( TEST_SAMPLES * sizeof(*pi_pts) );
+    uint64_t *pi_ts = malloc( TEST_SAMPLES * sizeof(*pi_ts) );
+    assert( pi_dts != NULL && pi_pts != NULL && pi_ts != NULL );
+
+    assert( Generate( psz_path, &layout ) );
+
+    /* Expected timestamps */
+    run_t stts, ctts;
+    uint64_t i_ts = 0;
+    RunInit( &stts, RUN_STTS );
+    RunInit( &ctts, RUN_CTTS );
+    for( uint32_t i = 0; i < TEST_SAMPLES; i++ )
+    {
+        pi_ts[i] = i_ts;
+        pi_dts[i] = VLC_TS_0 + CLOCK_FREQ * (int64_t)i_ts / TIMESCALE;
+        pi_pts[i] = pi_dts[i] + RunSample( &ctts, RUN_CTTS ) * CLOCK_FREQ
+                                / TIMESCALE;
+        i_ts += RunSample( &stts, RUN_STTS );
+    }
+
+    es_out_sys_t sys = { .i_blocks = 0 };
+    es_out_t out = {
+        .pf_add = EsOutAdd, .pf_send = EsOutSend, .pf_del = EsOutDel,
+        .pf_control = EsOutControl, .p_sys = &sys,
+    };
+    demux_t *p_demux = DemuxOpen( p_libvlc, psz_path, &out );
+
+    int64_t i_length;
+    assert( DemuxControl( p_demux, DEMUX_GET_LENGTH, &i_length ) == 0 );
+    assert( i_length == CLOCK_FREQ * (int64_t)(i_ts * 1000 / TIMESCALE) / 1000 );
+
+    /* Straight read */
+    for( uint32_t i = 0; i < TEST_SAMPLES; i++ )
+    {
+        assert( DemuxSample( p_demux, &sys ) );
+        assert( sys.i_sample == i );
+        assert( sys.i_dts == pi_dts[i] );
+        assert( sys.i_pts == pi_pts[i] );
+    }
+    assert( !DemuxSample( p_demux, &sys ) );
+
+    /* Seeks back and forth, many chunks away from each other, so that the
+     * tables of the chunks around the playhead get expanded and dropped */
+    uint32_t i_seed = 42;
+    for( unsigned i = 0; i < TEST_SEEKS; i++ )
+    {
+        int64_t i_time = Rand( &i_seed, i_length / 1000 ) * INT64_C(1000);
+        uint64_t i_target = i_time * TIMESCALE / CLOCK_FREQ;
+        uint32_t i_sample = 0;
+
+        while( i_sample + 1 < TEST_SAMPLES && pi_ts[i_sample + 1] <= i_target )
+            i_sample++;
+        i_sample -= i_sample % SYNC_INTERVAL;
+
+        assert( DemuxControl( p_demux, DEMUX_SET_TIME, i_time ) == 0 );
+        for( uint32_t j = i_sample; j < __MIN( i_sample + 50, TEST_SAMPLES ); j++ )
+        {
+            assert( DemuxSample( p_demux, &sys ) );
+            if( sys.i_sample != j )
+            {
+                fprintf( stderr, "seek to %"PRId64": sample %u instead of "
+                         "%u\n", i_time, sys.i_sample, j );
+                abort();
+            }
+            assert( sys.i_dts == pi_dts[j] );
+            assert( sys.i_pts == pi_pts[j] );
+        }
+    }
+
+    DemuxClose( p_demux );
+    unlink( psz_path );
+    free( pi_ts );
+    free( pi_pts );
+    free( pi_dts );
+}
+
+/*****************************************************************************
+ * Benchmark: opening a long file and reading its first second
+ *****************************************************************************/
+static long MaxRSS( void )
+{
+    struct rusage usage;
+    getrusage( RUSAGE_SELF, &usage );
+    return usage.ru_maxrss;
+}
+
+static void Bench( libvlc_int_t *p_libvlc, const char *psz_path )
+{
+    const layout_t layout = { BENCH_SAMPLES, false };
+
+    assert( Generate( psz_path, &layout ) );
+
+    es_out_sys_t sys = { .i_blocks = 0 };
+    es_out_t out = {
+        .pf_add = EsOutAdd, .pf_send = EsOutSend, .pf_del = EsOutDel,
+        .pf_control = EsOutControl, .p_sys = &sys,
+    };
+
+    long i_rss = MaxRSS();
+    mtime_t i_time = mdate();
+    demux_t *p_demux = DemuxOpen( p_libvlc, psz_path, &out );
+    mtime_t i_open = mdate() - i_time;
+
+    while( DemuxSample( p_demux, &sys ) && sys.i_dts < VLC_TS_0 + CLOCK_FREQ )
+        ;
+    i_time = mdate() - i_time;
+
+    printf( "%u samples: open %.3f s, open and first second %.3f s, "
+            "peak RSS +%ld KiB\n", BENCH_SAMPLES, i_open / 1000000.,
+            i_time / 1000000., MaxRSS() - i_rss );
+
+    DemuxClose( p_demux );
+    unlink( psz_path );
+}
+
+int main( void )
+{
+    test_init();
+
+    const char *psz_dir = getenv( "TMPDIR" );
+    char *psz_path;
+    if( asprintf( &psz_path, "%s/test-mp4-%d.mp4",
+                  psz_dir ? psz_dir : "/tmp", (int)getpid() ) < 0 )
+        return 1;
+
+    libvlc_instance_t *p_vlc = libvlc_new( test_defaults_nargs,
+                                           test_defaults_args );
+    assert( p_vlc != NULL );
+
+    Test( p_vlc->p_libvlc_int, psz_path );
+
+    if( getenv( "VLC_MP4_BENCH" ) != NULL )
+    {
+        alarm( 0 );
+        Bench( p_vlc->p_libvlc_int, psz_path );
+    }
+
+    libvlc_release( p_vlc );
+    free( psz_path );
+    return 0;
+}
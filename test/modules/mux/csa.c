@@ -0,0 +1,174 @@
+/*****************************************************************************
+ * csa.c: test and benchmark the CSA (de)scrambler
+ *****************************************************************************
+ * Copyright (C) 2015 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <vlc_common.h>
+#include "../modules/mux/mpeg/csa.c"
+
+#define PACKETS 1024
+#define BENCH_ROUNDS 20
+
+static uint8_t ref[PACKETS][188];
+static uint8_t scalar[PACKETS][188];
+static uint8_t batch[PACKETS][188];
+static uint8_t *pp_pkt[PACKETS];
+
+static void SetKeys( csa_t *c )
+{
+    for( int i = 0; i < 8; i++ )
+    {
+        c->o_ck[i] = rand();
+        c->e_ck[i] = rand();
+    }
+    csa_ComputeKey( c->o_kk, c->o_ck );
+    csa_ComputeKey( c->e_kk, c->e_ck );
+}
+
+static void FillPackets( void )
+{
+    for( int i = 0; i < PACKETS; i++ )
+    {
+        ref[i][0] = 0x47;
+        ref[i][1] = 0x01;
+        ref[i][2] = 0x00;
+        ref[i][3] = 0x10 | (i & 0xf);
+        for( int j = 4; j < 188; j++ )
+            ref[i][j] = rand();
+
+        /* some packets carry an adaptation field, up to a full one */
+        if( (i % 5) == 0 )
+        {
+            ref[i][3] |= 0x20;
+            ref[i][4] = rand() % 184;
+        }
+        pp_pkt[i] = batch[i];
+    }
+}
+
+static void Check( const char *psz_what, int i_pkt_size )
+{
+    for( int i = 0; i < PACKETS; i++ )
+        if( memcmp( scalar[i], batch[i], i_pkt_size ) )
+        {
+            fprintf( stderr, "%s mismatch on packet %d (size %d)\n",
+                     psz_what, i, i_pkt_size );
+            exit( 1 );
+        }
+}
+
+static void TestSize( csa_t *c, int i_pkt_size )
+{
+    /* scrambling, with a batch per key */
+    for( int k = 0; k < 2; k++ )
+    {
+        c->use_odd = k;
+        memcpy( scalar, ref, sizeof(ref) );
+        memcpy( batch, ref, sizeof(ref) );
+        for( int i = 0; i < PACKETS; i++ )
+            csa_Encrypt( c, scalar[i], i_pkt_size );
+        csa_EncryptBatch( c, pp_pkt, PACKETS, i_pkt_size );
+        Check( "encrypt", i_pkt_size );
+    }
+
+    /* descrambling, with both keys in one batch and clear packets */
+    memcpy( scalar, ref, sizeof(ref) );
+    for( int i = 0; i < PACKETS; i++ )
+    {
+        c->use_odd = (i / 3) & 1;
+        if( (i % 7) != 0 )
+            csa_Encrypt( c, scalar[i], i_pkt_size );
+    }
+    memcpy( batch, scalar, sizeof(scalar) );
+    for( int i = 0; i < PACKETS; i++ )
+        csa_Decrypt( c, scalar[i], i_pkt_size );
+    csa_DecryptBatch( c, pp_pkt, PACKETS, i_pkt_size );
+    Check( "decrypt", i_pkt_size );
+
+    for( int i = 0; i < PACKETS; i++ )
+        if( memcmp( batch[i], ref[i], 188 ) )
+        {
+            fprintf( stderr, "round trip mismatch on packet %d\n", i );
+            exit( 1 );
+        }
+}
+
+static void Bench( csa_t *c, int i_batch )
+{
+    memcpy( batch, ref, sizeof(ref) );
+    c->use_odd = true;
+    csa_EncryptBatch( c, pp_pkt, PACKETS, 188 );
+    memcpy( scalar, batch, sizeof(batch) );
+
+    mtime_t i_scalar = mdate();
+    for( int r = 0; r < BENCH_ROUNDS; r++ )
+    {
+        memcpy( batch, scalar, sizeof(scalar) );
+        for( int i = 0; i < PACKETS; i++ )
+            csa_Decrypt( c, batch[i], 188 );
+    }
+    i_scalar = mdate() - i_scalar;
+
+    mtime_t i_batched = mdate();
+    for( int r = 0; r < BENCH_ROUNDS; r++ )
+    {
+        memcpy( batch, scalar, sizeof(scalar) );
+        for( int i = 0; i < PACKETS; i += i_batch )
+            csa_DecryptBatch( c, &pp_pkt[i], __MIN(i_batch, PACKETS - i), 188 );
+    }
+    i_batched = mdate() - i_batched;
+
+    const double f_bytes = (double)PACKETS * BENCH_ROUNDS * 188;
+    printf( "descrambling, %3d packets per batch: scalar %6.1f MB/s, "
+            "batched %6.1f MB/s\n", i_batch,
+            f_bytes / __MAX(i_scalar, 1), f_bytes / __MAX(i_batched, 1) );
+}
+
+int main( void )
+{
+    csa_t *c = csa_New();
+    if( c == NULL )
+        return 1;
+
+    srand( 0 );
+    SetKeys( c );
+    FillPackets();
+
+    TestSize( c, 188 );
+    TestSize( c, 184 );
+    TestSize( c, 100 );
+    TestSize( c, 12 );
+
+    if( getenv( "VLC_CSA_BENCH" ) != NULL )
+    {
+        Bench( c, 32 );
+        Bench( c, 64 );
+        Bench( c, 128 );
+        Bench( c, 256 );
+    }
+
+    csa_Delete( c );
+    return 0;
+}
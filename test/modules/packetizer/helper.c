@@ -0,0 +1,188 @@
+/*****************************************************************************
+ * helper.c: test the packetizer helper unit extraction
+ *****************************************************************************
+ * Copyright (C) 2015 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#undef NDEBUG
+#include <assert.h>
+
+#include <vlc_common.h>
+#include <vlc_block.h>
+#include <vlc_block_helper.h>
+#include "../modules/packetizer/startcode_helper.h"
+#include "../modules/packetizer/packetizer_helper.h"
+
+#define UNITS_PER_AU 3
+
+static const uint8_t startcode[3] = { 0x00, 0x00, 0x01 };
+
+typedef struct
+{
+    packetizer_t packetizer;
+    block_t *p_frame;
+    unsigned i_units;
+} test_sys_t;
+
+static void Reset( void *p_private, bool b_broken )
+{
+    (void) p_private; (void) b_broken;
+}
+
+/* Gathers UNITS_PER_AU units in each access unit, like the h264 packetizer */
+static block_t *Parse( void *p_private, bool *pb_ts_used, block_t *p_block )
+{
+    test_sys_t *p_sys = p_private;
+    block_t *p_au = NULL;
+
+    while( p_block->i_buffer > 5 && p_block->p_buffer[p_block->i_buffer-1] == 0 )
+        p_block->i_buffer--;
+
+    if( p_sys->i_units++ % UNITS_PER_AU == 0 && p_sys->p_frame != NULL )
+    {
+        p_au = packetizer_ChainGather( &p_sys->packetizer, p_sys->p_frame );
+        p_sys->p_frame = NULL;
+    }
+    block_ChainAppend( &p_sys->p_frame, p_block );
+
+    *pb_ts_used = false;
+    return p_au;
+}
+
+static int Validate( void *p_private, block_t *p_au )
+{
+    (void) p_private; (void) p_au;
+    return VLC_SUCCESS;
+}
+
+/* Builds units made of a start code (with a leading zero byte if long, or
+ * randomly otherwise) and a payload without start code nor trailing zero.
+ * The expected output of each unit always begins with a 4 bytes start code,
+ * so only units with a long start code can be handed out without copy. */
+static size_t BuildStream( uint8_t *p_data, size_t i_data,
+                           uint8_t *p_expect, size_t *pi_expect,
+                           size_t i_unit_max, bool b_long_startcode )
+{
+    size_t i = 0, j = 0;
+
+    for( ;; )
+    {
+        size_t i_payload = 2 + rand() % i_unit_max;
+        if( i + 4 + i_payload + 8 > i_data )
+            break;
+
+        if( b_long_startcode || (rand() & 1) )
+            p_data[i++] = 0x00;
+        memcpy( &p_data[i], startcode, 3 );
+        i += 3;
+        memcpy( &p_expect[j], "\x00\x00\x00\x01", 4 );
+        j += 4;
+
+        for( size_t k = 0; k < i_payload; k++ )
+        {
+            uint8_t v = rand() % 4;
+            if( k == i_payload - 1 || ( k >= 2 && v <= 1 && !p_data[i-1] && !p_data[i-2] ) )
+                v = 2 + rand() % 2;
+            p_data[i++] = p_expect[j++] = v;
+        }
+    }
+    /* Terminating start code, so that the last unit gets output */
+    memcpy( &p_data[i], "\x00\x00\x01\x02\x02\x02\x02\x02", 8 );
+    *pi_expect = j;
+    return i + 8;
+}
+
+static void Run( const uint8_t *p_data, size_t i_data,
+                 const uint8_t *p_expect, size_t i_expect,
+                 size_t i_block_max, packetizer_t *p_stats )
+{
+    test_sys_t sys = { .p_frame = NULL, .i_units = 0 };
+    static const uint8_t prepend[1] = { 0x00 };
+    size_t i_out = 0;
+    block_t *p_out = NULL;
+
+    packetizer_Init( &sys.packetizer, startcode, sizeof(startcode),
+                     startcode_FindAnnexB, prepend, sizeof(prepend), 5,
+                     Reset, Parse, Validate, &sys );
+
+    for( size_t i = 0; i < i_data; )
+    {
+        size_t i_size = 1 + rand() % i_block_max;
+        if( i_size > i_data - i )
+            i_size = i_data - i;
+
+        block_t *p_block = block_Alloc( i_size );
+        assert( p_block != NULL );
+        memcpy( p_block->p_buffer, &p_data[i], i_size );
+        i += i_size;
+
+        block_t *p_au;
+        while( ( p_au = packetizer_Packetize( &sys.packetizer, &p_block ) ) )
+            /* Keep the output until the end, after its source blocks */
+            block_ChainAppend( &p_out, p_au );
+    }
+    if( sys.p_frame != NULL )
+        block_ChainAppend( &p_out,
+                           packetizer_ChainGather( &sys.packetizer, sys.p_frame ) );
+    packetizer_Clean( &sys.packetizer );
+
+    for( block_t *p_au = p_out; p_au != NULL; p_au = p_au->p_next )
+    {
+        assert( i_out + p_au->i_buffer <= i_expect );
+        assert( !memcmp( p_au->p_buffer, &p_expect[i_out], p_au->i_buffer ) );
+        i_out += p_au->i_buffer;
+    }
+    assert( i_out == i_expect );
+    block_ChainRelease( p_out );
+
+    *p_stats = sys.packetizer;
+}
+
+int main( void )
+{
+    /* The expected output is larger than the stream (4 bytes start codes) */
+    static uint8_t data[1 << 20], expect[(1 << 20) + (1 << 19)];
+    packetizer_t stats;
+    size_t i_expect;
+
+    srand( 0 );
+
+    /* Small blocks: units are often split and need to be copied */
+    for( int round = 0; round < 50; round++ )
+    {
+        size_t i_data = BuildStream( data, 1 + rand() % 8192,
+                                     expect, &i_expect, 1 + rand() % 100,
+                                     false );
+        Run( data, i_data, expect, i_expect, 1 + rand() % 200, &stats );
+    }
+
+    /* Large blocks: most units and access units must not be copied */
+    size_t i_data = BuildStream( data, sizeof(data), expect, &i_expect, 2000,
+                                 true );
+    Run( data, i_data, expect, i_expect, 256 << 10, &stats );
+    printf( "%"PRIu64" bytes packetized, %"PRIu64" copied\n",
+            stats.i_bytes, stats.i_bytes_copied );
+    assert( stats.i_bytes_copied * 4 < stats.i_bytes );
+
+    return 0;
+}
@@ -0,0 +1,352 @@
+/*****************************************************************************
+ * packetize.c: test and benchmark the video packetizers
+ *****************************************************************************
+ * Copyright (C) 2015 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#include "../../libvlc/test.h"
+#include "../lib/libvlc_internal.h"
+
+#include <string.h>
+
+#include <vlc_common.h>
+#include <vlc_block.h>
+#include <vlc_codec.h>
+#include <vlc_modules.h>
+
+#define TEST_FRAMES   16
+#define BENCH_FRAMES  500
+#define FRAME_SIZE    (200 << 10) /* 40 Mbit/s at 25 fps */
+#define INPUT_BLOCK   (64 << 10)
+
+/* Generated elementary stream and the expected size of each access unit */
+typedef struct
+{
+    uint8_t *p_data;
+    size_t   i_data;
+    size_t   i_max;
+    size_t  *pi_au;
+    unsigned i_au;
+    uint32_t i_seed;
+} es_t;
+
+static void Put( es_t *es, const uint8_t *p, size_t i )
+{
+    assert( es->i_data + i <= es->i_max );
+    memcpy( &es->p_data[es->i_data], p, i );
+    es->i_data += i;
+}
+
+/* Slice data never contains two zero bytes in a row, so it does not need
+ * emulation prevention and cannot be mistaken for a start code. */
+static void PutPayload( es_t *es, size_t i )
+{
+    assert( es->i_data + i <= es->i_max );
+    for( size_t j = 0; j < i; j++ )
+    {
+        es->i_seed = es->i_seed * 1103515245 + 12345;
+        es->p_data[es->i_data++] = 1 + (es->i_seed >> 16) % 255;
+    }
+}
+
+typedef struct
+{
+    uint8_t p[16];
+    unsigned i_bits;
+} bw_t;
+
+static void bw_put( bw_t *bw, unsigned i_count, uint32_t i_value )
+{
+    while( i_count-- > 0 )
+    {
+        assert( bw->i_bits < 8 * sizeof(bw->p) );
+        if( (i_value >> i_count) & 1 )
+            bw->p[bw->i_bits / 8] |= 0x80 >> (bw->i_bits % 8);
+        bw->i_bits++;
+    }
+}
+
+static void bw_put_ue( bw_t *bw, uint32_t i_value )
+{
+    unsigned i_len = 0;
+    while( (i_value + 1) >> (i_len + 1) )
+        i_len++;
+    bw_put( bw, i_len, 0 );
+    bw_put( bw, i_len + 1, i_value + 1 );
+}
+
+/* Appends an H.264 NAL unit with a 4 bytes start code and returns its size.
+ * The RBSP is ended with a stop bit, and padded with ones when a payload
+ * follows. */
+static size_t PutNAL( es_t *es, uint8_t i_header, bw_t *bw, size_t i_payload )
+{
+    static const uint8_t startcode[4] = { 0x00, 0x00, 0x00, 0x01 };
+
+    bw_put( bw, 1, 1 );
+    while( bw->i_bits % 8 )
+        bw_put( bw, 1, i_payload > 0 );
+
+    const size_t i_rbsp = bw->i_bits / 8;
+    for( size_t i = 1; i < i_rbsp; i++ )
+        assert( bw->p[i - 1] != 0 || bw->p[i] != 0 );
+
+    Put( es, startcode, 4 );
+    Put( es, &i_header, 1 );
+    Put( es, bw->p, i_rbsp );
+    PutPayload( es, i_payload );
+    return 5 + i_rbsp + i_payload;
+}
+
+/* 1920x1088 baseline profile, 4 slices of P frames after one IDR frame */
+static void GenerateH264( es_t *es, unsigned i_frames )
+{
+    const unsigned i_slices = 4;
+    const unsigned i_mbs = 120 * 68;
+    size_t i_headers = 0;
+
+    /* SPS */
+    bw_t sps = { .i_bits = 0 };
+    bw_put( &sps, 8, 66 );      /* profile_idc */
+    bw_put( &sps, 8, 0 );       /* constraint flags */
+    bw_put( &sps, 8, 40 );      /* level_idc */
+    bw_put_ue( &sps, 0 );       /* seq_parameter_set_id */
+    bw_put_ue( &sps, 0 );       /* log2_max_frame_num_minus4 */
+    bw_put_ue( &sps, 2 );       /* pic_order_cnt_type */
+    bw_put_ue( &sps, 1 );       /* num_ref_frames */
+    bw_put( &sps, 1, 0 );       /* gaps_in_frame_num_value_allowed_flag */
+    bw_put_ue( &sps, 120 - 1 ); /* pic_width_in_mbs_minus1 */
+    bw_put_ue( &sps, 68 - 1 );  /* pic_height_in_map_units_minus1 */
+    bw_put( &sps, 1, 1 );       /* frame_mbs_only_flag */
+    bw_put( &sps, 1, 1 );       /* direct_8x8_inference_flag */
+    bw_put( &sps, 1, 0 );       /* frame_cropping_flag */
+    bw_put( &sps, 1, 0 );       /* vui_parameters_present_flag */
+    i_headers += PutNAL( es, 0x67, &sps, 0 );
+
+    /* PPS */
+    bw_t pps = { .i_bits = 0 };
+    bw_put_ue( &pps, 0 );       /* pic_parameter_set_id */
+    bw_put_ue( &pps, 0 );       /* seq_parameter_set_id */
+    bw_put( &pps, 1, 0 );       /* entropy_coding_mode_flag */
+    bw_put( &pps, 1, 0 );       /* pic_order_present_flag */
+    bw_put_ue( &pps, 0 );       /* num_slice_groups_minus1 */
+    bw_put_ue( &pps, 0 );       /* num_ref_idx_l0_active_minus1 */
+    bw_put_ue( &pps, 0 );       /* num_ref_idx_l1_active_minus1 */
+    bw_put( &pps, 3, 0 );       /* weighted prediction */
+    bw_put_ue( &pps, 0 );       /* pic_init_qp_minus26 */
+    bw_put_ue( &pps, 0 );       /* pic_init_qs_minus26 */
+    bw_put_ue( &pps, 0 );       /* chroma_qp_index_offset */
+    bw_put( &pps, 3, 4 );       /* deblocking_filter_control_present_flag */
+    i_headers += PutNAL( es, 0x68, &pps, 0 );
+
+    for( unsigned i = 0; i < i_frames; i++ )
+    {
+        const bool b_idr = i == 0;
+        size_t i_au = b_idr ? i_headers : 0;
+
+        for( unsigned j = 0; j < i_slices; j++ )
+        {
+            bw_t slice = { .i_bits = 0 };
+            bw_put_ue( &slice, j * i_mbs / i_slices ); /* first_mb_in_slice */
+            bw_put_ue( &slice, b_idr ? 7 : 5 );        /* slice_type */
+            bw_put_ue( &slice, 0 );                    /* pic_parameter_set_id */
+            bw_put( &slice, 4, i % 16 );               /* frame_num */
+            if( b_idr )
+                bw_put_ue( &slice, 0 );                /* idr_pic_id */
+            i_au += PutNAL( es, b_idr ? 0x65 : 0x41, &slice,
+                            FRAME_SIZE / i_slices );
+        }
+        es->pi_au[es->i_au++] = i_au;
+    }
+
+    /* Parameter sets again, so that the last frame gets output */
+    PutNAL( es, 0x67, &sps, 0 );
+    PutNAL( es, 0x68, &pps, 0 );
+}
+
+/* 1920x1080 MPEG-1 video, one slice per macroblock row, P frames after one
+ * I frame */
+static void GenerateMPGV( es_t *es, unsigned i_frames )
+{
+    static const uint8_t seq[12] = {
+        0x00, 0x00, 0x01, 0xb3,
+        0x78, 0x04, 0x38,       /* 1920x1080 */
+        0x33,                   /* 16:9, 25 fps */
+        0x61, 0xa8, 0x23, 0x80, /* 40 Mbit/s, vbv 112, no matrices */
+    };
+    static const uint8_t eos[4] = { 0x00, 0x00, 0x01, 0xb7 };
+    const unsigned i_slices = 68;
+
+    Put( es, seq, sizeof(seq) );
+
+    for( unsigned i = 0; i < i_frames; i++ )
+    {
+        const unsigned i_tr = i % 1024;
+        const uint8_t pic[8] = {
+            0x00, 0x00, 0x01, 0x00,
+            i_tr >> 2, ((i_tr & 3) << 6) | ((i == 0 ? 1 : 2) << 3) | 0x07,
+            0xff, 0xf8, /* vbv_delay 0xffff */
+        };
+        size_t i_au = i == 0 ? sizeof(seq) : 0;
+
+        Put( es, pic, sizeof(pic) );
+        i_au += sizeof(pic);
+        for( unsigned j = 0; j < i_slices; j++ )
+        {
+            const uint8_t slice[4] = { 0x00, 0x00, 0x01, 1 + j };
+
+            Put( es, slice, sizeof(slice) );
+            PutPayload( es, FRAME_SIZE / i_slices );
+            i_au += sizeof(slice) + FRAME_SIZE / i_slices;
+        }
+        es->pi_au[es->i_au++] = i_au;
+    }
+
+    /* The end of sequence is gathered with the last frame, and only output
+     * once the next start code shows up */
+    Put( es, eos, sizeof(eos) );
+    es->pi_au[es->i_au - 1] += sizeof(eos);
+    Put( es, seq, sizeof(seq) );
+}
+
+static const struct
+{
+    const char *psz_module;
+    vlc_fourcc_t i_codec;
+    void (*pf_generate)( es_t *, unsigned );
+} packetizers[] = {
+    { "h264",      VLC_CODEC_H264, GenerateH264 },
+    { "mpegvideo", VLC_CODEC_MPGV, GenerateMPGV },
+};
+
+/* Splits the stream into demuxer sized blocks */
+static block_t **Split( const es_t *es, size_t *pi_blocks )
+{
+    const size_t i_blocks = (es->i_data + INPUT_BLOCK - 1) / INPUT_BLOCK;
+    block_t **pp_blocks = malloc( i_blocks * sizeof(*pp_blocks) );
+    assert( pp_blocks != NULL );
+
+    for( size_t i = 0; i < i_blocks; i++ )
+    {
+        const size_t i_offset = i * INPUT_BLOCK;
+        const size_t i_size = __MIN( INPUT_BLOCK, es->i_data - i_offset );
+
+        pp_blocks[i] = block_Alloc( i_size );
+        assert( pp_blocks[i] != NULL );
+        memcpy( pp_blocks[i]->p_buffer, &es->p_data[i_offset], i_size );
+        pp_blocks[i]->i_dts =
+        pp_blocks[i]->i_pts = i == 0 ? VLC_TS_0 : VLC_TS_INVALID;
+    }
+    *pi_blocks = i_blocks;
+    return pp_blocks;
+}
+
+static void Run( libvlc_int_t *p_libvlc, unsigned i, unsigned i_frames,
+                 bool b_bench )
+{
+    es_t es = {
+        .i_max = (size_t)i_frames * (FRAME_SIZE + 4096) + 4096,
+        .pi_au = malloc( i_frames * sizeof(size_t) ),
+        .i_seed = 1,
+    };
+    es.p_data = malloc( es.i_max );
+    assert( es.p_data != NULL && es.pi_au != NULL );
+    packetizers[i].pf_generate( &es, i_frames );
+    assert( es.i_au == i_frames );
+
+    size_t i_blocks;
+    block_t **pp_blocks = Split( &es, &i_blocks );
+
+    decoder_t *p_dec = vlc_object_create( p_libvlc, sizeof(*p_dec) );
+    assert( p_dec != NULL );
+    es_format_Init( &p_dec->fmt_in, VIDEO_ES, packetizers[i].i_codec );
+    es_format_Init( &p_dec->fmt_out, UNKNOWN_ES, 0 );
+    p_dec->p_module = module_need( p_dec, "packetizer",
+                                   packetizers[i].psz_module, true );
+    assert( p_dec->p_module != NULL );
+
+    unsigned i_au = 0;
+    mtime_t i_time = mdate();
+    for( size_t j = 0; j < i_blocks; j++ )
+    {
+        block_t *p_block = pp_blocks[j];
+        block_t *p_au;
+
+        while( (p_au = p_dec->pf_packetize( p_dec,
+                                            p_block ? &p_block : NULL )) )
+        {
+            if( !b_bench )
+            {
+                size_t i_size;
+
+                assert( i_au < es.i_au );
+                block_ChainProperties( p_au, NULL, &i_size, NULL );
+                if( i_size != es.pi_au[i_au] )
+                {
+                    fprintf( stderr, "%s: frame %u is %zu bytes, not %zu\n",
+                             packetizers[i].psz_module, i_au, i_size,
+                             es.pi_au[i_au] );
+                    abort();
+                }
+                assert( p_au->i_flags & (i_au == 0 ? BLOCK_FLAG_TYPE_I
+                                                   : BLOCK_FLAG_TYPE_P) );
+                assert( !(p_au->i_flags & BLOCK_FLAG_PREROLL) );
+            }
+            block_ChainRelease( p_au );
+            i_au++;
+        }
+    }
+    i_time = mdate() - i_time;
+    assert( i_au == es.i_au );
+
+    if( b_bench )
+        printf( "%-10s: %u frames, %7.1f MB/s, %6.1f fps\n",
+                packetizers[i].psz_module, i_au,
+                (double)es.i_data * CLOCK_FREQ / i_time / (1 << 20),
+                (double)i_au * CLOCK_FREQ / i_time );
+
+    module_unneed( p_dec, p_dec->p_module );
+    es_format_Clean( &p_dec->fmt_in );
+    es_format_Clean( &p_dec->fmt_out );
+    vlc_object_release( p_dec );
+
+    free( pp_blocks );
+    free( es.pi_au );
+    free( es.p_data );
+}
+
+int main( void )
+{
+    test_init();
+
+    libvlc_instance_t *p_vlc = libvlc_new( test_defaults_nargs,
+                                           test_defaults_args );
+    assert( p_vlc != NULL );
+
+    for( unsigned i = 0; i < ARRAY_SIZE(packetizers); i++ )
+        Run( p_vlc->p_libvlc_int, i, TEST_FRAMES, false );
+
+    /* High bitrate streams, fed the way a demuxer would */
+    if( getenv( "VLC_PACKETIZER_BENCH" ) != NULL )
+    {
+        alarm( 0 );
+        for( unsigned i = 0; i < ARRAY_SIZE(packetizers); i++ )
+            Run( p_vlc->p_libvlc_int, i, BENCH_FRAMES, true );
+    }
+
+    libvlc_release( p_vlc );
+    return 0;
+}
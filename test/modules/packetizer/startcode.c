@@ -0,0 +1,236 @@
+/*****************************************************************************
+ * startcode.c: test and benchmark the Annex B start code search
+ *****************************************************************************
+ * Copyright (C) 2015 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#undef NDEBUG
+#include <assert.h>
+
+#include <vlc_common.h>
+#include <vlc_block.h>
+#include <vlc_block_helper.h>
+#include "../modules/packetizer/startcode_helper.h"
+
+#define BENCH_SIZE   (64 << 20)
+#define BENCH_BLOCK  (64 << 10)
+#define BENCH_NAL    (256 << 10) /* large intra coded NAL units */
+
+static const uint8_t startcode[3] = { 0x00, 0x00, 0x01 };
+
+static const struct
+{
+    const char *psz_name;
+    block_startcode_helper_t pf_find;
+} helpers[] = {
+    { "bytewise", NULL },
+    { "C", startcode_FindAnnexB_C },
+#ifdef STARTCODE_SSE2
+    { "SSE2", startcode_FindAnnexB_SSE2 },
+#endif
+#ifdef STARTCODE_AVX2
+    { "AVX2", startcode_FindAnnexB_AVX2 },
+#endif
+};
+
+static bool Usable( block_startcode_helper_t pf_find )
+{
+#ifdef STARTCODE_SSE2
+    if( pf_find == startcode_FindAnnexB_SSE2 )
+        return vlc_CPU_SSE2();
+#endif
+#ifdef STARTCODE_AVX2
+    if( pf_find == startcode_FindAnnexB_AVX2 )
+        return vlc_CPU_AVX2();
+#endif
+    return true;
+}
+
+static const uint8_t *FindRef( const uint8_t *p, const uint8_t *end )
+{
+    for( ; end - p >= 3; p++ )
+        if( p[0] == 0 && p[1] == 0 && p[2] == 1 )
+            return p;
+    return NULL;
+}
+
+/* Buffers made of 0, 1 and 2 values only are full of start codes and near
+ * misses, which exercises every branch of the helpers. */
+static void TestHelpers( void )
+{
+    uint8_t buf[256];
+
+    for( int round = 0; round < 2000; round++ )
+    {
+        for( size_t i = 0; i < sizeof(buf); i++ )
+            buf[i] = (rand() % 8 < 6) ? 0 : rand() % 3;
+
+        for( size_t start = 0; start < 40; start++ )
+            for( size_t end = start; end <= sizeof(buf); end += 1 + rand() % 7 )
+            {
+                const uint8_t *ref = FindRef( &buf[start], &buf[end] );
+
+                for( size_t h = 1; h < ARRAY_SIZE(helpers); h++ )
+                {
+                    if( !Usable( helpers[h].pf_find ) )
+                        continue;
+                    if( helpers[h].pf_find( &buf[start], &buf[end] ) != ref )
+                    {
+                        fprintf( stderr, "%s helper mismatch (%zu-%zu)\n",
+                                 helpers[h].psz_name, start, end );
+                        exit( 1 );
+                    }
+                }
+            }
+    }
+}
+
+/* Splits data into randomly sized blocks, like a demuxer output */
+static void BuildChain( block_bytestream_t *bs, const uint8_t *p_data,
+                        size_t i_data, size_t i_block_max )
+{
+    block_BytestreamInit( bs );
+    for( size_t i = 0; i < i_data; )
+    {
+        size_t i_size = 1 + rand() % i_block_max;
+        if( i_size > i_data - i )
+            i_size = i_data - i;
+
+        block_t *p_block = block_Alloc( i_size );
+        assert( p_block != NULL );
+        memcpy( p_block->p_buffer, &p_data[i], i_size );
+        block_BytestreamPush( bs, p_block );
+        i += i_size;
+    }
+}
+
+/* Scans a bytestream like a packetizer, and returns the offsets of all the
+ * start codes found. */
+static size_t ScanChain( block_bytestream_t *bs,
+                         block_startcode_helper_t pf_find,
+                         size_t *pi_found, size_t i_found_max )
+{
+    size_t i_found = 0, i_base = 0;
+    size_t i_offset = 0;
+
+    while( block_FindStartcodeFromOffset( bs, &i_offset, startcode,
+                                          sizeof(startcode), pf_find ) == 0 )
+    {
+        if( i_found < i_found_max )
+            pi_found[i_found] = i_base + i_offset;
+        i_found++;
+
+        /* Consume the data up to the start code, like the packetizers */
+        block_SkipBytes( bs, i_offset );
+        block_BytestreamFlush( bs );
+        i_base += i_offset;
+        i_offset = 1;
+    }
+    block_BytestreamRelease( bs );
+    return i_found;
+}
+
+static void TestBytestream( void )
+{
+    uint8_t buf[4096];
+    size_t ref[sizeof(buf)], found[sizeof(buf)];
+
+    for( int round = 0; round < 200; round++ )
+    {
+        for( size_t i = 0; i < sizeof(buf); i++ )
+            buf[i] = (rand() % 8 < 6) ? 0 : rand() % 3;
+
+        size_t i_block_max = 1 + rand() % 200;
+        unsigned seed = rand();
+
+        block_bytestream_t bs;
+
+        srand( seed );
+        BuildChain( &bs, buf, sizeof(buf), i_block_max );
+        size_t i_ref = ScanChain( &bs, NULL, ref, ARRAY_SIZE(ref) );
+
+        for( size_t h = 1; h < ARRAY_SIZE(helpers); h++ )
+        {
+            if( !Usable( helpers[h].pf_find ) )
+                continue;
+
+            srand( seed );
+            BuildChain( &bs, buf, sizeof(buf), i_block_max );
+            size_t i_found = ScanChain( &bs, helpers[h].pf_find,
+                                        found, ARRAY_SIZE(found) );
+            if( i_found != i_ref || memcmp( found, ref, i_ref * sizeof(*ref) ) )
+            {
+                fprintf( stderr, "%s bytestream mismatch\n",
+                         helpers[h].psz_name );
+                exit( 1 );
+            }
+        }
+    }
+}
+
+static void Bench( void )
+{
+    uint8_t *p_data = malloc( BENCH_SIZE );
+    assert( p_data != NULL );
+
+    /* Entropy coded payload does not contain start codes (emulation
+     * prevention), only one at the beginning of each NAL unit. */
+    for( size_t i = 0; i < BENCH_SIZE; i++ )
+    {
+        p_data[i] = rand();
+        if( i >= 2 && p_data[i] <= 3 && !p_data[i - 1] && !p_data[i - 2] )
+            p_data[i] = 4;
+    }
+    for( size_t i = 0; i + 4 < BENCH_SIZE; i += BENCH_NAL )
+        memcpy( &p_data[i], "\x00\x00\x01\x65", 4 );
+
+    for( size_t h = 0; h < ARRAY_SIZE(helpers); h++ )
+    {
+        if( !Usable( helpers[h].pf_find ) )
+            continue;
+
+        block_bytestream_t bs;
+        BuildChain( &bs, p_data, BENCH_SIZE, BENCH_BLOCK );
+
+        mtime_t i_time = mdate();
+        size_t i_found = ScanChain( &bs, helpers[h].pf_find, NULL, 0 );
+        i_time = mdate() - i_time;
+
+        printf( "%-8s: %zu start codes, %7.1f MB/s\n", helpers[h].psz_name,
+                i_found, (double)BENCH_SIZE / __MAX(i_time, 1) );
+    }
+    free( p_data );
+}
+
+int main( void )
+{
+    srand( 0 );
+
+    TestHelpers();
+    TestBytestream();
+
+    if( getenv( "VLC_STARTCODE_BENCH" ) != NULL )
+        Bench();
+
+    return 0;
+}
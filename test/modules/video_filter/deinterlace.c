@@ -0,0 +1,391 @@
+/*****************************************************************************
+ * deinterlace.c: test and benchmark the deinterlacer SIMD kernels
+ *****************************************************************************
+ * Copyright (C) 2015 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#undef NDEBUG
+#include <assert.h>
+
+#include <vlc_common.h>
+#include "../modules/video_filter/deinterlace/helpers.c"
+#include "../modules/video_filter/deinterlace/algo_x.c"
+#include "../modules/video_filter/deinterlace/algo_phosphor.c"
+
+#define BENCH_WIDTH  1920
+#define BENCH_HEIGHT 1080
+#define BENCH_FRAMES 100
+
+typedef int (*comb_line_t)( const uint8_t *, const uint8_t *,
+                            const uint8_t *, int );
+typedef int (*motion_t)( uint8_t *, uint8_t *, int, int, int *, int * );
+typedef void (*darken_t)( picture_t *, int, int, bool );
+typedef void (*band_t)( uint8_t *, int, uint8_t *, int, int, int );
+
+enum { ISA_C, ISA_MMXEXT, ISA_SSE2, ISA_AVX2 };
+static const char *const isa_names[] = { "C", "MMXEXT", "SSE2", "AVX2" };
+
+static bool Usable( int isa )
+{
+    switch( isa )
+    {
+        case ISA_MMXEXT:
+            return vlc_CPU_MMXEXT();
+        case ISA_SSE2:
+            return vlc_CPU_SSE2();
+        case ISA_AVX2:
+            return vlc_CPU_AVX2();
+    }
+    return true;
+}
+
+/* The MMXEXT versions of the IVTC motion metric and of X do not match the C
+ * ones (they use more lines or round differently), so they are only
+ * benchmarked. */
+static const struct
+{
+    int isa;
+    comb_line_t pf_comb;
+} combs[] = {
+    { ISA_C, CombLine },
+#ifdef DEINTERLACE_SSE2
+    { ISA_SSE2, CombLineSSE2 },
+#endif
+#ifdef DEINTERLACE_AVX2
+    { ISA_AVX2, CombLineAVX2 },
+#endif
+};
+
+static const struct
+{
+    int isa;
+    motion_t pf_motion;
+} motions[] = {
+    { ISA_C, TestForMotionInBlock },
+#ifdef CAN_COMPILE_MMXEXT
+    { ISA_MMXEXT, TestForMotionInBlockMMX },
+#endif
+#ifdef DEINTERLACE_SSE2
+    { ISA_SSE2, TestForMotionInBlockSSE2 },
+#endif
+};
+
+static const struct
+{
+    int isa;
+    darken_t pf_darken;
+} darkens[] = {
+    { ISA_C, DarkenField },
+#ifdef CAN_COMPILE_MMXEXT
+    { ISA_MMXEXT, DarkenFieldMMX },
+#endif
+#ifdef DEINTERLACE_SSE2
+    { ISA_SSE2, DarkenFieldSSE2 },
+#endif
+};
+
+static const struct
+{
+    int isa;
+    band_t pf_band;
+} bands[] = {
+    { ISA_C, XDeintBand8x8C },
+#ifdef CAN_COMPILE_MMXEXT
+    { ISA_MMXEXT, XDeintBand8x8MMXEXT },
+#endif
+#ifdef DEINTERLACE_SSE2
+    { ISA_SSE2, XDeintBand8x8SSE2 },
+#endif
+};
+
+static picture_t *NewPicture( vlc_fourcc_t i_chroma, int i_width, int i_height )
+{
+    video_format_t fmt;
+
+    video_format_Init( &fmt, 0 );
+    video_format_Setup( &fmt, i_chroma, i_width, i_height,
+                        i_width, i_height, 1, 1 );
+    picture_t *p_pic = picture_NewFromFormat( &fmt );
+    assert( p_pic != NULL );
+    return p_pic;
+}
+
+/* Fills the picture with a mix of flat, progressive, combed and noisy 8x8
+ * areas, so that all the decisions of the algorithms get exercised. */
+static void FillPicture( picture_t *p_pic, unsigned i_seed )
+{
+    uint32_t i_noise = i_seed;
+
+    for( int i = 0; i < p_pic->i_planes; i++ )
+    {
+        plane_t *p = &p_pic->p[i];
+        int i_kind = 0, i_base = 0, i_comb = 0;
+
+        for( int y = 0; y < p->i_lines; y++ )
+            for( int x = 0; x < p->i_pitch; x++ )
+            {
+                if( x % 8 == 0 )
+                {
+                    srand( i_seed + i * 65537 + (y / 8) * 7919 + x / 8 );
+                    i_kind = rand() % 4;
+                    i_base = rand() % 256;
+                    i_comb = rand() % 160 - 80;
+                }
+
+                int v = i_base;
+                if( i_kind == 1 )
+                    v += (x + y) % 16;
+                else if( i_kind == 2 && (y & 1) )
+                    v += i_comb;
+                else if( i_kind == 3 )
+                {
+                    i_noise = i_noise * 1103515245 + 12345;
+                    v += (i_noise >> 16) % 64 - 32;
+                }
+                p->p_pixels[y * p->i_pitch + x] = VLC_CLIP( v, 0, 255 );
+            }
+    }
+}
+
+static void Fail( const char *psz_algo, int isa )
+{
+    fprintf( stderr, "%s %s mismatch\n", psz_algo, isa_names[isa] );
+    exit( 1 );
+}
+
+static bool PicturesEqual( const picture_t *p_a, const picture_t *p_b )
+{
+    for( int i = 0; i < p_a->i_planes; i++ )
+        for( int y = 0; y < p_a->p[i].i_visible_lines; y++ )
+            if( memcmp( &p_a->p[i].p_pixels[y * p_a->p[i].i_pitch],
+                        &p_b->p[i].p_pixels[y * p_b->p[i].i_pitch],
+                        p_a->p[i].i_visible_pitch ) )
+                return false;
+    return true;
+}
+
+static int MotionScore( const picture_t *p_prev, const picture_t *p_curr,
+                        motion_t pf_motion, int *pi_top, int *pi_bot )
+{
+    int i_score = 0;
+
+    *pi_top = *pi_bot = 0;
+    for( int i = 0; i < p_prev->i_planes; i++ )
+    {
+        const plane_t *pp = &p_prev->p[i], *pc = &p_curr->p[i];
+
+        for( int by = 0; by < pp->i_visible_lines / 8; by++ )
+            for( int bx = 0; bx < pp->i_visible_pitch / 8; bx++ )
+            {
+                int i_top, i_bot;
+                i_score += pf_motion( &pp->p_pixels[8*by*pp->i_pitch + 8*bx],
+                                      &pc->p_pixels[8*by*pc->i_pitch + 8*bx],
+                                      pp->i_pitch, pc->i_pitch,
+                                      &i_top, &i_bot );
+                *pi_top += i_top;
+                *pi_bot += i_bot;
+            }
+    }
+    return i_score;
+}
+
+/* Same as RenderX(), except for the last line which is C only anyway */
+static void RenderBands( picture_t *p_outpic, picture_t *p_pic, band_t pf_band )
+{
+    for( int i = 0; i < p_pic->i_planes; i++ )
+    {
+        const int i_mby = ( p_outpic->p[i].i_visible_lines + 7 )/8 - 1;
+        const int i_mbx = p_outpic->p[i].i_visible_pitch/8;
+        const int i_modx = p_outpic->p[i].i_visible_pitch - 8*i_mbx;
+        const int i_dst = p_outpic->p[i].i_pitch;
+        const int i_src = p_pic->p[i].i_pitch;
+
+        for( int y = 0; y < i_mby; y++ )
+            pf_band( &p_outpic->p[i].p_pixels[8*y*i_dst], i_dst,
+                     &p_pic->p[i].p_pixels[8*y*i_src], i_src, i_mbx, i_modx );
+    }
+#ifdef CAN_COMPILE_MMXEXT
+    if( vlc_CPU_MMXEXT() )
+        emms();
+#endif
+}
+
+static void Test( vlc_fourcc_t i_chroma, int i_width, int i_height )
+{
+    picture_t *p_top = NewPicture( i_chroma, i_width, i_height );
+    picture_t *p_bot = NewPicture( i_chroma, i_width, i_height );
+    picture_t *p_ref = NewPicture( i_chroma, i_width, i_height );
+    picture_t *p_out = NewPicture( i_chroma, i_width, i_height );
+
+    FillPicture( p_top, 1 );
+    FillPicture( p_bot, 2 );
+
+    /* IVTC comb metric */
+    int i_ref = CalculateInterlaceScoreLines( p_top, p_bot, CombLine );
+    assert( i_ref > 0 );
+    for( size_t h = 1; h < ARRAY_SIZE(combs); h++ )
+        if( Usable( combs[h].isa ) &&
+            CalculateInterlaceScoreLines( p_top, p_bot,
+                                          combs[h].pf_comb ) != i_ref )
+            Fail( "comb", combs[h].isa );
+#ifdef CAN_COMPILE_MMXEXT
+    if( vlc_CPU_MMXEXT() &&
+        CalculateInterlaceScoreMMX( p_top, p_bot ) != i_ref )
+        Fail( "comb", ISA_MMXEXT );
+#endif
+
+    /* IVTC motion metric */
+    int i_top_ref, i_bot_ref;
+    i_ref = MotionScore( p_top, p_bot, TestForMotionInBlock,
+                         &i_top_ref, &i_bot_ref );
+    assert( i_ref > 0 );
+    for( size_t h = 1; h < ARRAY_SIZE(motions); h++ )
+    {
+        int i_top, i_bot;
+        if( motions[h].isa != ISA_MMXEXT && Usable( motions[h].isa ) &&
+            ( MotionScore( p_top, p_bot, motions[h].pf_motion,
+                           &i_top, &i_bot ) != i_ref ||
+              i_top != i_top_ref || i_bot != i_bot_ref ) )
+            Fail( "motion", motions[h].isa );
+    }
+
+    /* Phosphor dimmer */
+    for( int i_field = 0; i_field < 2; i_field++ )
+        for( int i_strength = 1; i_strength <= 3; i_strength++ )
+            for( int b_chroma = 0; b_chroma < 2; b_chroma++ )
+            {
+                picture_Copy( p_ref, p_top );
+                DarkenField( p_ref, i_field, i_strength, b_chroma );
+                for( size_t h = 1; h < ARRAY_SIZE(darkens); h++ )
+                {
+                    if( !Usable( darkens[h].isa ) )
+                        continue;
+                    picture_Copy( p_out, p_top );
+                    darkens[h].pf_darken( p_out, i_field, i_strength,
+                                          b_chroma );
+                    if( !PicturesEqual( p_ref, p_out ) )
+                        Fail( "phosphor", darkens[h].isa );
+                }
+            }
+
+    /* X */
+    RenderBands( p_ref, p_top, XDeintBand8x8C );
+    for( size_t h = 1; h < ARRAY_SIZE(bands); h++ )
+    {
+        if( bands[h].isa == ISA_MMXEXT || !Usable( bands[h].isa ) )
+            continue;
+        RenderBands( p_out, p_top, bands[h].pf_band );
+        if( !PicturesEqual( p_ref, p_out ) )
+            Fail( "X", bands[h].isa );
+    }
+
+    picture_Release( p_out );
+    picture_Release( p_ref );
+    picture_Release( p_bot );
+    picture_Release( p_top );
+}
+
+static void PrintTime( const char *psz_algo, int isa, mtime_t i_time )
+{
+    printf( "%-8s %-6s: %6.3f ms/frame\n", psz_algo, isa_names[isa],
+            (double)i_time / BENCH_FRAMES / 1000. );
+}
+
+static void Bench( void )
+{
+    picture_t *p_top = NewPicture( VLC_CODEC_I420, BENCH_WIDTH, BENCH_HEIGHT );
+    picture_t *p_bot = NewPicture( VLC_CODEC_I420, BENCH_WIDTH, BENCH_HEIGHT );
+    picture_t *p_out = NewPicture( VLC_CODEC_I420, BENCH_WIDTH, BENCH_HEIGHT );
+    mtime_t i_time;
+
+    FillPicture( p_top, 1 );
+    FillPicture( p_bot, 2 );
+
+    for( size_t h = 0; h < ARRAY_SIZE(combs); h++ )
+    {
+        if( !Usable( combs[h].isa ) )
+            continue;
+        i_time = mdate();
+        for( int i = 0; i < BENCH_FRAMES; i++ )
+            CalculateInterlaceScoreLines( p_top, p_bot, combs[h].pf_comb );
+        PrintTime( "comb", combs[h].isa, mdate() - i_time );
+    }
+#ifdef CAN_COMPILE_MMXEXT
+    if( vlc_CPU_MMXEXT() )
+    {
+        i_time = mdate();
+        for( int i = 0; i < BENCH_FRAMES; i++ )
+            CalculateInterlaceScoreMMX( p_top, p_bot );
+        PrintTime( "comb", ISA_MMXEXT, mdate() - i_time );
+    }
+#endif
+
+    for( size_t h = 0; h < ARRAY_SIZE(motions); h++ )
+    {
+        if( !Usable( motions[h].isa ) )
+            continue;
+        int i_top, i_bot;
+        i_time = mdate();
+        for( int i = 0; i < BENCH_FRAMES; i++ )
+            MotionScore( p_top, p_bot, motions[h].pf_motion, &i_top, &i_bot );
+        PrintTime( "motion", motions[h].isa, mdate() - i_time );
+    }
+
+    for( size_t h = 0; h < ARRAY_SIZE(darkens); h++ )
+    {
+        if( !Usable( darkens[h].isa ) )
+            continue;
+        i_time = mdate();
+        for( int i = 0; i < BENCH_FRAMES; i++ )
+            darkens[h].pf_darken( p_out, i & 1, 1, true );
+        PrintTime( "phosphor", darkens[h].isa, mdate() - i_time );
+    }
+
+    for( size_t h = 0; h < ARRAY_SIZE(bands); h++ )
+    {
+        if( !Usable( bands[h].isa ) )
+            continue;
+        i_time = mdate();
+        for( int i = 0; i < BENCH_FRAMES; i++ )
+            RenderBands( p_out, p_top, bands[h].pf_band );
+        PrintTime( "X", bands[h].isa, mdate() - i_time );
+    }
+
+    picture_Release( p_out );
+    picture_Release( p_bot );
+    picture_Release( p_top );
+}
+
+int main( void )
+{
+    /* Odd sizes leave remainders for the scalar tails */
+    Test( VLC_CODEC_I420, 720, 576 );
+    Test( VLC_CODEC_I420, 1918, 1082 );
+    Test( VLC_CODEC_I422, 706, 480 );
+    Test( VLC_CODEC_I422, 67, 37 );
+
+    if( getenv( "VLC_DEINTERLACE_BENCH" ) != NULL )
+        Bench();
+
+    return 0;
+}
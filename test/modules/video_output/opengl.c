@@ -0,0 +1,275 @@
+/*****************************************************************************
+ * opengl.c: test the OpenGL display helper with a headless context
+ *****************************************************************************
+ * Copyright (C) 2015 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+/* Renders through the pixel buffer upload path on a surfaceless EGL
+ * context, e.g. Mesa llvmpipe with EGL_PLATFORM=surfaceless: the test is
+ * skipped if no such context is available. */
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+
+#include <vlc_common.h>
+#include "../modules/video_output/opengl.c"
+
+/* after the module, which includes <assert.h> too */
+#undef NDEBUG
+#include <assert.h>
+
+#define WIDTH  64
+#define HEIGHT 64
+#define FRAMES 10
+
+#ifndef EGL_PLATFORM_SURFACELESS_MESA
+# define EGL_PLATFORM_SURFACELESS_MESA 0x31DD
+#endif
+
+typedef struct
+{
+    EGLDisplay display;
+    EGLSurface surface;
+    EGLContext context;
+} egl_sys_t;
+
+static int MakeCurrent(vlc_gl_t *gl)
+{
+    egl_sys_t *sys = gl->sys;
+
+    if (!eglMakeCurrent(sys->display, sys->surface, sys->surface,
+                        sys->context))
+        return VLC_EGENERIC;
+    return VLC_SUCCESS;
+}
+
+static void ReleaseCurrent(vlc_gl_t *gl)
+{
+    egl_sys_t *sys = gl->sys;
+
+    eglMakeCurrent(sys->display, EGL_NO_SURFACE, EGL_NO_SURFACE,
+                   EGL_NO_CONTEXT);
+}
+
+static void Swap(vlc_gl_t *gl)
+{
+    (void) gl; /* the frame is read back from the pixel buffer surface */
+}
+
+static void *GetProcAddress(vlc_gl_t *gl, const char *name)
+{
+    (void) gl;
+    return (void *)eglGetProcAddress(name);
+}
+
+static bool OpenEGL(vlc_gl_t *gl, egl_sys_t *sys)
+{
+    PFNEGLGETPLATFORMDISPLAYEXTPROC GetPlatformDisplay =
+        (PFNEGLGETPLATFORMDISPLAYEXTPROC)
+            eglGetProcAddress("eglGetPlatformDisplayEXT");
+    if (GetPlatformDisplay == NULL)
+        return false;
+
+    sys->display = GetPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA,
+                                      EGL_DEFAULT_DISPLAY, NULL);
+    if (sys->display == EGL_NO_DISPLAY
+     || !eglInitialize(sys->display, NULL, NULL))
+        return false;
+
+    static const EGLint config_attr[] = {
+        EGL_SURFACE_TYPE, EGL_PBUFFER_BIT,
+        EGL_RED_SIZE, 8, EGL_GREEN_SIZE, 8, EGL_BLUE_SIZE, 8,
+        EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT,
+        EGL_NONE
+    };
+    static const EGLint surface_attr[] = {
+        EGL_WIDTH, WIDTH, EGL_HEIGHT, HEIGHT, EGL_NONE
+    };
+    EGLConfig config;
+    EGLint count;
+
+    if (!eglBindAPI(EGL_OPENGL_API)
+     || !eglChooseConfig(sys->display, config_attr, &config, 1, &count)
+     || count < 1)
+        goto error;
+
+    sys->surface = eglCreatePbufferSurface(sys->display, config,
+                                           surface_attr);
+    if (sys->surface == EGL_NO_SURFACE)
+        goto error;
+    sys->context = eglCreateContext(sys->display, config, EGL_NO_CONTEXT,
+                                    NULL);
+    if (sys->context == EGL_NO_CONTEXT) {
+        eglDestroySurface(sys->display, sys->surface);
+        goto error;
+    }
+
+    gl->sys = sys;
+    gl->makeCurrent = MakeCurrent;
+    gl->releaseCurrent = ReleaseCurrent;
+    gl->swap = Swap;
+    gl->getProcAddress = GetProcAddress;
+    if (vlc_gl_MakeCurrent(gl) == VLC_SUCCESS)
+        return true;
+
+    eglDestroyContext(sys->display, sys->context);
+    eglDestroySurface(sys->display, sys->surface);
+error:
+    eglTerminate(sys->display);
+    return false;
+}
+
+static void CloseEGL(vlc_gl_t *gl)
+{
+    egl_sys_t *sys = gl->sys;
+
+    vlc_gl_ReleaseCurrent(gl);
+    eglDestroyContext(sys->display, sys->context);
+    eglDestroySurface(sys->display, sys->surface);
+    eglTerminate(sys->display);
+}
+
+/* Left and right halves of the frame */
+static uint8_t Level(unsigned frame, unsigned half)
+{
+    return half ? 235 - 20 * frame : 16 + 20 * frame;
+}
+
+static void Fill(picture_t *picture, unsigned frame, bool yuv)
+{
+    for (int i = 0; i < picture->i_planes; i++) {
+        plane_t *p = &picture->p[i];
+        unsigned half_pitch = p->i_visible_pitch / 2;
+
+        for (int y = 0; y < p->i_visible_lines; y++) {
+            uint8_t *line = &p->p_pixels[y * p->i_pitch];
+
+            if (yuv && i > 0) {
+                memset(line, 128, p->i_visible_pitch);
+                continue;
+            }
+            memset(line, Level(frame, 0), half_pitch);
+            memset(line + half_pitch, Level(frame, 1),
+                   p->i_visible_pitch - half_pitch);
+        }
+    }
+}
+
+static void Check(unsigned frame, bool yuv)
+{
+    static uint8_t rgba[WIDTH * HEIGHT * 4];
+
+    glReadBuffer(GL_BACK);
+    glReadPixels(0, 0, WIDTH, HEIGHT, GL_RGBA, GL_UNSIGNED_BYTE, rgba);
+    for (unsigned half = 0; half < 2; half++) {
+        const uint8_t *px = &rgba[((HEIGHT / 2) * WIDTH
+                                   + (2 * half + 1) * WIDTH / 4) * 4];
+        int expected = Level(frame, half);
+
+        if (yuv) /* limited range luma, neutral chroma */
+            expected = (expected - 16) * 255 / 219;
+        for (int c = 0; c < 3; c++)
+            if (abs(px[c] - expected) > 3) {
+                fprintf(stderr, "frame %u: got %u instead of %d\n",
+                        frame, px[c], expected);
+                abort();
+            }
+    }
+}
+
+static void test_upload(vlc_gl_t *gl, vlc_fourcc_t chroma)
+{
+    video_format_t fmt;
+
+    video_format_Init(&fmt, chroma);
+    video_format_Setup(&fmt, chroma, WIDTH, HEIGHT, WIDTH, HEIGHT, 1, 1);
+
+    vout_display_opengl_t *vgl = vout_display_opengl_New(&fmt, NULL, gl);
+    assert(vgl != NULL);
+
+    const bool yuv = vlc_fourcc_IsYUV(fmt.i_chroma);
+    picture_pool_t *pool = vout_display_opengl_GetPool(vgl, 3);
+    assert(pool != NULL);
+    printf("%4.4s: %u pixel buffers\n", (const char *)&fmt.i_chroma,
+           vgl->pbo_count);
+    assert(vgl->pbo_count == VLCGL_PBO_COUNT);
+
+    glViewport(0, 0, WIDTH, HEIGHT);
+    /* More frames than pixel buffers, to wait for the fences */
+    for (unsigned frame = 0; frame < FRAMES; frame++) {
+        picture_t *picture = picture_pool_Get(pool);
+        assert(picture != NULL);
+
+        Fill(picture, frame, yuv);
+        assert(!vout_display_opengl_Prepare(vgl, picture, NULL));
+        picture_Release(picture);
+        assert(!vout_display_opengl_Display(vgl, &fmt));
+        Check(frame, yuv);
+    }
+
+    /* A picture may outlive the display: it does not point to GL memory */
+    picture_t *picture = picture_pool_Get(pool);
+    assert(picture != NULL);
+    vout_display_opengl_Delete(vgl);
+    Fill(picture, 0, yuv);
+    picture_Release(picture);
+
+    /* All the buffers were deleted with the context current */
+    PFNGLISBUFFERPROC IsBuffer =
+        (PFNGLISBUFFERPROC)vlc_gl_GetProcAddress(gl, "glIsBuffer");
+    assert(IsBuffer != NULL);
+    for (GLuint name = 1; name < 64; name++)
+        assert(!IsBuffer(name));
+    assert(glGetError() == GL_NO_ERROR);
+}
+
+int main(void)
+{
+    vlc_gl_t gl;
+    egl_sys_t sys;
+
+    alarm(10);
+    memset(&gl, 0, sizeof(gl));
+    if (!OpenEGL(&gl, &sys)) {
+        fprintf(stderr, "no surfaceless EGL context, skipping\n");
+        return 77;
+    }
+
+    const char *extensions = (const char *)glGetString(GL_EXTENSIONS);
+    const char *version = (const char *)glGetString(GL_VERSION);
+    printf("OpenGL %s (%s)\n", version, glGetString(GL_RENDERER));
+    if (strverscmp(version, "4.4") < 0
+     && !HasExtension(extensions, "GL_ARB_buffer_storage")) {
+        fprintf(stderr, "no persistently mapped buffers, skipping\n");
+        CloseEGL(&gl);
+        return 77;
+    }
+
+    test_upload(&gl, VLC_CODEC_RGB32);
+    test_upload(&gl, VLC_CODEC_I420);
+
+    CloseEGL(&gl);
+    return 0;
+}